@@ -0,0 +1,149 @@
+/*
+ * Measure the cost of reading the PomodoroPlugin status page while a writer updates it.
+ *
+ * Build and run on Linux or Mac :
+ *     cc -O2 -pthread -I../Include StatusPageBench.c -o StatusPageBench && ./StatusPageBench
+ *
+ * The page is mapped from a temporary file exactly like the editor does. For each writer
+ * rate, a reader thread copies the status in a loop and reports the mean cost of a read
+ * and how many reads had to retry because they overlapped a write. The editor itself only
+ * writes on timer transitions, so the "idle" and "1 kHz" rows are already pessimistic.
+ */
+
+#include "PomodoroStatusPageLayout.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define READS_PER_RUN 20000000ull
+
+typedef struct bench_writer
+{
+	pomodoro_status_page* page;
+	long interval_ns; /* 0 writes as fast as possible */
+	volatile int stop;
+	unsigned long long writes;
+} bench_writer;
+
+static uint64_t now_ns(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+static void* writer_main(void* argument)
+{
+	bench_writer* writer = (bench_writer*)argument;
+	pomodoro_status status;
+	memset(&status, 0, sizeof(status));
+	status.state = POMODORO_STATUS_RUNNING;
+	status.cycle_count = 4;
+
+	while(!writer->stop)
+	{
+		status.version++;
+		status.current_cycle = (int32_t)(status.version % 4) + 1;
+		status.remaining_ms = (int64_t)status.version;
+		status.deadline_unix_ms = (int64_t)status.version;
+		pomodoro_status_page_write(writer->page, &status);
+		writer->writes++;
+
+		if(writer->interval_ns > 0)
+		{
+			struct timespec pause = {0, writer->interval_ns};
+			nanosleep(&pause, NULL);
+		}
+	}
+	return NULL;
+}
+
+/* Return 0 if the page can't be read */
+static int run(pomodoro_status_page* page, const char* label, int with_writer, long interval_ns)
+{
+	bench_writer writer = {page, interval_ns, 0, 0};
+	pthread_t thread;
+	pomodoro_status status;
+	unsigned long long inconsistent = 0;
+	unsigned long long read;
+	uint64_t begin;
+	uint64_t end;
+	int readable = 1;
+
+	memset(&status, 0, sizeof(status));
+
+	if(with_writer)
+	{
+		pthread_create(&thread, NULL, writer_main, &writer);
+	}
+
+	begin = now_ns();
+	for(read = 0; read < READS_PER_RUN; ++read)
+	{
+		if(!pomodoro_status_page_read(page, &status))
+		{
+			readable = 0;
+			break;
+		}
+
+		/* The writer keeps these fields equal, a torn copy would break it */
+		if(status.remaining_ms != (int64_t)status.version || status.deadline_unix_ms != (int64_t)status.version)
+		{
+			inconsistent++;
+		}
+	}
+	end = now_ns();
+
+	if(with_writer)
+	{
+		writer.stop = 1;
+		pthread_join(thread, NULL);
+	}
+
+	if(!readable)
+	{
+		fprintf(stderr, "%s : the status page has an unexpected magic or layout\n", label);
+		return 0;
+	}
+
+	printf("%-22s %8.2f ns/read %12llu writes %6llu torn reads\n", label,
+		(double)(end - begin) / (double)READS_PER_RUN, writer.writes, inconsistent);
+	return 1;
+}
+
+int main(void)
+{
+	char path[] = "/tmp/pomodoro-bench-XXXXXX";
+	pomodoro_status_page* page;
+	const int file = mkstemp(path);
+
+	if(file == -1 || ftruncate(file, POMODORO_STATUS_PAGE_FILE_SIZE) == -1)
+	{
+		perror("page file");
+		return 1;
+	}
+
+	page = (pomodoro_status_page*)mmap(NULL, POMODORO_STATUS_PAGE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if(page == MAP_FAILED)
+	{
+		perror("mmap");
+		return 1;
+	}
+	page->layout = POMODORO_STATUS_PAGE_LAYOUT;
+	page->magic = POMODORO_STATUS_PAGE_MAGIC;
+
+	const int readable = run(page, "idle writer", 0, 0)
+		&& run(page, "writer at 1 kHz", 1, 1000000)
+		&& run(page, "writer at 100 kHz", 1, 10000)
+		&& run(page, "writer flat out", 1, 0);
+
+	munmap(page, POMODORO_STATUS_PAGE_FILE_SIZE);
+	close(file);
+	unlink(path);
+	return readable ? 0 : 1;
+}
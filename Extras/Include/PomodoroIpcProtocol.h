@@ -0,0 +1,100 @@
+/*
+ * Wire protocol of the PomodoroPlugin local IPC endpoint.
+ *
+ * The editor listens on a Unix domain stream socket, by default
+ * "<temp dir>/pomodoro-<user>.sock". Every message has a fixed layout,
+ * native byte order, no padding :
+ * - clients send 8 bytes requests,
+ * - the editor answers every request with one 48 bytes state frame and,
+ *   once subscribed, pushes a state frame each time the timer changes
+ *   (start, pause, stop, end of a timespan or configuration change).
+ *
+ * The remaining time is only exact when the frame is sent. While the timer
+ * is running, compute it from the deadline : deadline_unix_ms - now.
+ *
+ * This header is plain C so it can be used by any external client.
+ */
+
+#ifndef POMODORO_IPC_PROTOCOL_H
+#define POMODORO_IPC_PROTOCOL_H
+
+#include <stdint.h>
+
+#define POMODORO_IPC_MAGIC 0x52444D50u /* "PMDR" */
+#define POMODORO_IPC_VERSION 1
+
+/* Request opcodes */
+enum
+{
+	POMODORO_IPC_OP_GET_STATE = 1,
+	POMODORO_IPC_OP_SUBSCRIBE = 2,
+	POMODORO_IPC_OP_UNSUBSCRIBE = 3,
+	POMODORO_IPC_OP_START = 4,
+	POMODORO_IPC_OP_PAUSE = 5,
+	POMODORO_IPC_OP_STOP = 6
+};
+
+/* Kind of state frame */
+enum
+{
+	POMODORO_IPC_FRAME_REPLY = 1, /* Answer to a request */
+	POMODORO_IPC_FRAME_PUSH = 2 /* Pushed to subscribers on change */
+};
+
+/* Result of a request */
+enum
+{
+	POMODORO_IPC_STATUS_OK = 0, /* Request done, or command accepted */
+	POMODORO_IPC_STATUS_BAD_REQUEST = 1, /* Wrong magic, version or opcode */
+	POMODORO_IPC_STATUS_UNAVAILABLE = 2 /* Command rejected by the editor */
+};
+
+/* Timer state, same values as EPomodoroState */
+enum
+{
+	POMODORO_STATE_STOPPED = 0,
+	POMODORO_STATE_PAUSED = 1,
+	POMODORO_STATE_RUNNING = 2
+};
+
+/* Timespan kind, same values as EPomodoroPhase */
+enum
+{
+	POMODORO_PHASE_WORKING = 0,
+	POMODORO_PHASE_SHORT_RESTING = 1,
+	POMODORO_PHASE_LONG_RESTING = 2
+};
+
+typedef struct pomodoro_ipc_request
+{
+	uint32_t magic; /* POMODORO_IPC_MAGIC */
+	uint8_t version; /* POMODORO_IPC_VERSION */
+	uint8_t opcode; /* POMODORO_IPC_OP_* */
+	uint16_t reserved;
+} pomodoro_ipc_request;
+
+typedef struct pomodoro_ipc_frame
+{
+	uint32_t magic; /* POMODORO_IPC_MAGIC */
+	uint8_t version; /* POMODORO_IPC_VERSION */
+	uint8_t kind; /* POMODORO_IPC_FRAME_* */
+	uint8_t status; /* POMODORO_IPC_STATUS_*, always OK for pushed frames */
+	uint8_t opcode; /* Opcode of the answered request, 0 for pushed frames */
+	uint64_t sequence; /* Snapshot version, increases on every change */
+	uint8_t state; /* POMODORO_STATE_* */
+	uint8_t phase; /* POMODORO_PHASE_* */
+	uint16_t reserved;
+	int32_t current_cycle; /* Starting from 1 */
+	int32_t cycle_count;
+	int32_t phase_length_s; /* Full length of the current timespan */
+	int64_t remaining_ms; /* Remaining time when the frame was sent */
+	int64_t deadline_unix_ms; /* End of the current timespan, 0 unless running */
+} pomodoro_ipc_frame;
+
+#define POMODORO_IPC_REQUEST_SIZE 8
+#define POMODORO_IPC_FRAME_SIZE 48
+
+typedef char pomodoro_ipc_request_size_check[sizeof(pomodoro_ipc_request) == POMODORO_IPC_REQUEST_SIZE ? 1 : -1];
+typedef char pomodoro_ipc_frame_size_check[sizeof(pomodoro_ipc_frame) == POMODORO_IPC_FRAME_SIZE ? 1 : -1];
+
+#endif /* POMODORO_IPC_PROTOCOL_H */
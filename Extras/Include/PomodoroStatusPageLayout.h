@@ -0,0 +1,168 @@
+/*
+ * Shared memory status page of the PomodoroPlugin.
+ *
+ * The editor maps a small file, by default "<user temp dir>/pomodoro-<user>.status",
+ * and writes the timer state into it each time the timer changes (start, pause, stop,
+ * end of a timespan or configuration change). Nothing is written while the timer simply
+ * counts down : compute the remaining time from the deadline, deadline_unix_ms - now.
+ *
+ * Other processes map the same file read only and call pomodoro_status_page_read,
+ * which costs a few plain loads : no system call, no lock. The page is guarded by a
+ * sequence lock, a reader only retries its copy when it overlapped a write. The status
+ * is copied one atomic 64 bit word at a time, ordered by acquire and release fences.
+ *
+ * This header is plain C so it can be used by any external tool.
+ */
+
+#ifndef POMODORO_STATUS_PAGE_LAYOUT_H
+#define POMODORO_STATUS_PAGE_LAYOUT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define POMODORO_STATUS_PAGE_MAGIC 0x53444D50u /* "PMDS" */
+#define POMODORO_STATUS_PAGE_LAYOUT 1
+
+/* Size of the mapped file */
+#define POMODORO_STATUS_PAGE_FILE_SIZE 4096
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#if defined(_M_ARM64)
+		#define POMODORO_STATUS_PAGE_FENCE() __dmb(_ARM64_BARRIER_ISH)
+	#else
+		/* x86 and x64 never reorder loads with loads nor stores with stores */
+		#define POMODORO_STATUS_PAGE_FENCE() _ReadWriteBarrier()
+	#endif
+	#define POMODORO_STATUS_PAGE_LOAD(Pointer) (*(Pointer))
+	#define POMODORO_STATUS_PAGE_STORE(Pointer, Value) (*(Pointer) = (Value))
+	/* Aligned 64 bit volatile accesses are single instructions on every 64 bit target MSVC supports */
+	#define POMODORO_STATUS_PAGE_LOAD_WORD(Pointer) (*(const volatile uint64_t*)(Pointer))
+	#define POMODORO_STATUS_PAGE_STORE_WORD(Pointer, Value) (*(volatile uint64_t*)(Pointer) = (Value))
+	#define POMODORO_STATUS_PAGE_ACQUIRE() POMODORO_STATUS_PAGE_FENCE()
+	#define POMODORO_STATUS_PAGE_RELEASE() POMODORO_STATUS_PAGE_FENCE()
+#else
+	#define POMODORO_STATUS_PAGE_LOAD(Pointer) __atomic_load_n((Pointer), __ATOMIC_RELAXED)
+	#define POMODORO_STATUS_PAGE_STORE(Pointer, Value) __atomic_store_n((Pointer), (Value), __ATOMIC_RELAXED)
+	#define POMODORO_STATUS_PAGE_LOAD_WORD(Pointer) __atomic_load_n((const uint64_t*)(Pointer), __ATOMIC_RELAXED)
+	#define POMODORO_STATUS_PAGE_STORE_WORD(Pointer, Value) __atomic_store_n((uint64_t*)(Pointer), (Value), __ATOMIC_RELAXED)
+	#define POMODORO_STATUS_PAGE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+	#define POMODORO_STATUS_PAGE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+/* Timer state, same values as EPomodoroState */
+enum
+{
+	POMODORO_STATUS_STOPPED = 0,
+	POMODORO_STATUS_PAUSED = 1,
+	POMODORO_STATUS_RUNNING = 2
+};
+
+/* Timespan kind, same values as EPomodoroPhase */
+enum
+{
+	POMODORO_STATUS_WORKING = 0,
+	POMODORO_STATUS_SHORT_RESTING = 1,
+	POMODORO_STATUS_LONG_RESTING = 2
+};
+
+typedef struct pomodoro_status
+{
+	uint64_t version; /* Engine snapshot version, increases on every change */
+	uint8_t state; /* POMODORO_STATUS_STOPPED, PAUSED or RUNNING */
+	uint8_t phase; /* POMODORO_STATUS_WORKING, SHORT_RESTING or LONG_RESTING */
+	uint16_t reserved;
+	int32_t current_cycle; /* Starting from 1 */
+	int32_t cycle_count;
+	int32_t phase_length_s; /* Full length of the current timespan */
+	int64_t remaining_ms; /* Remaining time when the status was written */
+	int64_t deadline_unix_ms; /* End of the current timespan, 0 unless running */
+	int64_t written_unix_ms; /* When the status was written */
+} pomodoro_status;
+
+typedef struct pomodoro_status_page
+{
+	uint32_t magic; /* POMODORO_STATUS_PAGE_MAGIC once the page is initialized */
+	uint32_t layout; /* POMODORO_STATUS_PAGE_LAYOUT */
+	uint32_t writer_pid; /* Process id of the editor writing the page */
+	uint32_t reserved;
+	uint64_t sequence; /* Odd while a write is in progress */
+	pomodoro_status status;
+} pomodoro_status_page;
+
+typedef char pomodoro_status_size_check[sizeof(pomodoro_status) == 48 ? 1 : -1];
+typedef char pomodoro_status_page_size_check[sizeof(pomodoro_status_page) == 72 ? 1 : -1];
+
+/* The status is copied as 64 bit words, each of them loaded and stored atomically */
+#define POMODORO_STATUS_WORD_COUNT (sizeof(pomodoro_status) / sizeof(uint64_t))
+
+/*
+ * Copy a consistent status out of a mapped page.
+ * Return 1 on success, 0 if the page is not initialized or was written by another layout.
+ */
+static inline int pomodoro_status_page_read(const pomodoro_status_page* page, pomodoro_status* out_status)
+{
+	uint64_t words[POMODORO_STATUS_WORD_COUNT];
+	const uint64_t* source = (const uint64_t*)(const void*)&page->status;
+	uint64_t begin;
+	uint64_t end;
+	size_t index;
+
+	if(POMODORO_STATUS_PAGE_LOAD(&page->magic) != POMODORO_STATUS_PAGE_MAGIC
+		|| POMODORO_STATUS_PAGE_LOAD(&page->layout) != POMODORO_STATUS_PAGE_LAYOUT)
+	{
+		return 0;
+	}
+
+	for(;;)
+	{
+		begin = POMODORO_STATUS_PAGE_LOAD(&page->sequence);
+		POMODORO_STATUS_PAGE_ACQUIRE();
+
+		/* The writer only needs a few nanoseconds */
+		if(begin & 1)
+		{
+			continue;
+		}
+
+		/* A copy overlapping a write is torn, never racy : every word is an atomic load */
+		for(index = 0; index < POMODORO_STATUS_WORD_COUNT; ++index)
+		{
+			words[index] = POMODORO_STATUS_PAGE_LOAD_WORD(&source[index]);
+		}
+		POMODORO_STATUS_PAGE_ACQUIRE();
+
+		end = POMODORO_STATUS_PAGE_LOAD(&page->sequence);
+		if(begin == end)
+		{
+			memcpy(out_status, words, sizeof(pomodoro_status));
+			return 1;
+		}
+	}
+}
+
+/*
+ * Write a new status into a mapped page. There must be a single writer at a time.
+ */
+static inline void pomodoro_status_page_write(pomodoro_status_page* page, const pomodoro_status* status)
+{
+	uint64_t words[POMODORO_STATUS_WORD_COUNT];
+	uint64_t* target = (uint64_t*)(void*)&page->status;
+	const uint64_t begin = POMODORO_STATUS_PAGE_LOAD(&page->sequence);
+	size_t index;
+
+	memcpy(words, status, sizeof(pomodoro_status));
+
+	POMODORO_STATUS_PAGE_STORE(&page->sequence, begin + 1);
+	POMODORO_STATUS_PAGE_RELEASE();
+
+	for(index = 0; index < POMODORO_STATUS_WORD_COUNT; ++index)
+	{
+		POMODORO_STATUS_PAGE_STORE_WORD(&target[index], words[index]);
+	}
+
+	POMODORO_STATUS_PAGE_RELEASE();
+	POMODORO_STATUS_PAGE_STORE(&page->sequence, begin + 2);
+}
+
+#endif /* POMODORO_STATUS_PAGE_LAYOUT_H */
@@ -0,0 +1,98 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroClock.h"
+
+double FPomodoroClock::GetSeconds() const
+{
+	return FPlatformTime::Seconds();
+}
+
+FDateTime FPomodoroClock::GetUtcNow() const
+{
+	return FDateTime::UtcNow();
+}
+
+void FPomodoroClock::SetTimer(FPomodoroTimerHandle& Handle, FSimpleDelegate Delegate, const double PeriodSeconds, const double FirstDelaySeconds)
+{
+	ClearTimer(Handle);
+
+	Handle = NextHandle++;
+	Timers.Add(FTimer{Handle, MoveTemp(Delegate), FMath::Max(PeriodSeconds, 0.0), GetSeconds() + FMath::Max(FirstDelaySeconds, 0.0)});
+}
+
+void FPomodoroClock::ClearTimer(FPomodoroTimerHandle& Handle)
+{
+	if(Handle != 0)
+	{
+		Timers.RemoveAll([Handle](const FTimer& Timer)
+		{
+			return Timer.Handle == Handle;
+		});
+		Handle = 0;
+	}
+}
+
+void FPomodoroClock::Advance()
+{
+	const double NowSeconds = GetSeconds();
+
+	TArray<FPomodoroTimerHandle, TInlineAllocator<4>> Due;
+	for(const FTimer& Timer : Timers)
+	{
+		if(Timer.NextSeconds <= NowSeconds)
+		{
+			Due.Add(Timer.Handle);
+		}
+	}
+
+	// The delegates may set or clear timers, so each one is looked up again after a call
+	for(const FPomodoroTimerHandle Handle : Due)
+	{
+		for(FTimer* Timer = FindTimer(Handle); Timer != nullptr && Timer->NextSeconds <= NowSeconds; Timer = FindTimer(Handle))
+		{
+			const bool bEveryAdvance = Timer->PeriodSeconds <= 0.0;
+			Timer->NextSeconds += Timer->PeriodSeconds;
+
+			const FSimpleDelegate Delegate = Timer->Delegate;
+			Delegate.ExecuteIfBound();
+
+			if(bEveryAdvance)
+			{
+				break;
+			}
+		}
+	}
+}
+
+FPomodoroClock::FTimer* FPomodoroClock::FindTimer(const FPomodoroTimerHandle Handle)
+{
+	return Timers.FindByPredicate([Handle](const FTimer& Timer)
+	{
+		return Timer.Handle == Handle;
+	});
+}
+
+FPomodoroTickerClock::FPomodoroTickerClock()
+{
+	const FTickerDelegate Delegate = FTickerDelegate::CreateLambda([this](float DeltaTime)
+	{
+		Advance();
+		return true;
+	});
+
+#if ENGINE_MAJOR_VERSION >= 5
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(Delegate);
+#else
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(Delegate);
+#endif
+}
+
+FPomodoroTickerClock::~FPomodoroTickerClock()
+{
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+#else
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+#endif
+}
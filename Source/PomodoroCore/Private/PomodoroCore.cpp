@@ -0,0 +1,10 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroCore.h"
+
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogPomodoro);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, PomodoroCore)
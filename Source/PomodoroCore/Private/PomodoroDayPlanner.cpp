@@ -0,0 +1,464 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroDayPlanner.h"
+
+#define LOCTEXT_NAMESPACE "FPomodoroDayPlanner"
+
+namespace PomodoroPlanner
+{
+	constexpr int32 MinutesPerDay = 24 * 60;
+
+	/** Choice stored in the window tables */
+	enum EChoice : uint8
+	{
+		Idle = 0,
+		Work = 1,
+		Rest = 2,
+	};
+
+	static int32 ToLengthMinutes(const FTimespan& Timespan)
+	{
+		return FMath::Clamp(FMath::CeilToInt(static_cast<float>(Timespan.GetTotalMinutes())), 1, MinutesPerDay);
+	}
+
+	static int32 ToMinuteOfDay(const FTimespan& TimeOfDay)
+	{
+		return FMath::Clamp(FMath::FloorToInt(static_cast<float>(TimeOfDay.GetTotalMinutes())), 0, MinutesPerDay);
+	}
+
+	static bool ParseTimeOfDay(const FString& Text, FTimespan& OutTimeOfDay)
+	{
+		FString HoursText;
+		FString MinutesText;
+		if(!Text.TrimStartAndEnd().Split(TEXT(":"), &HoursText, &MinutesText) || !HoursText.IsNumeric() || !MinutesText.IsNumeric())
+		{
+			return false;
+		}
+
+		const int32 Hours = FCString::Atoi(*HoursText);
+		const int32 Minutes = FCString::Atoi(*MinutesText);
+		if(Hours < 0 || Minutes < 0 || Minutes > 59 || Hours * 60 + Minutes > MinutesPerDay)
+		{
+			return false;
+		}
+		OutTimeOfDay = FTimespan(Hours, Minutes, 0);
+		return true;
+	}
+
+	static FString FormatTimeOfDay(const FTimespan& TimeOfDay)
+	{
+		const int32 Minutes = ToMinuteOfDay(TimeOfDay);
+		return FString::Printf(TEXT("%02d:%02d"), Minutes / 60, Minutes % 60);
+	}
+
+	static FPomodoroTimeRange GetDefaultWorkingHours()
+	{
+		return FPomodoroTimeRange{FTimespan(9, 0, 0), FTimespan(18, 0, 0)};
+	}
+}
+
+FPomodoroDayPlanner::FPomodoroDayPlanner(const TSharedPtr<IPomodoroConfigStore> InConfigStore)
+	: ConfigStore(InConfigStore)
+	, WorkingMinutes(20)
+	, ShortRestingMinutes(5)
+	, LongRestingMinutes(15)
+	, CycleCount(4)
+	, WorkingHours(PomodoroPlanner::GetDefaultWorkingHours())
+{
+	ReloadConfig();
+}
+
+void FPomodoroDayPlanner::SetTimespans(const FTimespan Working, const FTimespan ShortResting, const FTimespan LongResting, const int32 NewCycleCount)
+{
+	const int32 NewWorkingMinutes = PomodoroPlanner::ToLengthMinutes(Working);
+	const int32 NewShortRestingMinutes = PomodoroPlanner::ToLengthMinutes(ShortResting);
+	const int32 NewLongRestingMinutes = PomodoroPlanner::ToLengthMinutes(LongResting);
+	const int32 ClampedCycleCount = FMath::Max(NewCycleCount, 1);
+
+	if(NewWorkingMinutes == WorkingMinutes && NewShortRestingMinutes == ShortRestingMinutes
+		&& NewLongRestingMinutes == LongRestingMinutes && ClampedCycleCount == CycleCount)
+	{
+		return;
+	}
+
+	WorkingMinutes = NewWorkingMinutes;
+	ShortRestingMinutes = NewShortRestingMinutes;
+	LongRestingMinutes = NewLongRestingMinutes;
+	CycleCount = ClampedCycleCount;
+
+	// Every table depends on the timespans
+	for(FWindow& Window : Windows)
+	{
+		Window.bSolved = false;
+	}
+}
+
+void FPomodoroDayPlanner::SetWorkingHours(const FPomodoroTimeRange& NewWorkingHours)
+{
+	WorkingHours = NewWorkingHours;
+	UpdateWindows();
+}
+
+const FPomodoroTimeRange& FPomodoroDayPlanner::GetWorkingHours() const
+{
+	return WorkingHours;
+}
+
+void FPomodoroDayPlanner::SetCommitments(const TArray<FPomodoroTimeRange>& NewCommitments)
+{
+	Commitments = NewCommitments;
+	UpdateWindows();
+}
+
+const TArray<FPomodoroTimeRange>& FPomodoroDayPlanner::GetCommitments() const
+{
+	return Commitments;
+}
+
+void FPomodoroDayPlanner::Replan(const FPomodoroEngineSnapshot& Snapshot, const FDateTime& Now)
+{
+	// Snapshots read back from the status page don't carry the configuration
+	if(Snapshot.WorkingLength > FTimespan::Zero())
+	{
+		SetTimespans(Snapshot.WorkingLength, Snapshot.ShortRestingLength, Snapshot.LongRestingLength, Snapshot.CycleCount);
+	}
+
+	Plan.Reset();
+	const FDateTime Today = Now.GetDate();
+	FDateTime From = Now;
+
+	// A stopped engine starts again from the first working timespan
+	int32 Cycle = 0;
+	bool bRestDue = false;
+	if(Snapshot.State != Stopped)
+	{
+		Cycle = FMath::Clamp(Snapshot.CurrentCycle - 1, 0, CycleCount - 1);
+		bRestDue = Snapshot.Phase != EPomodoroPhase::Working;
+
+		// The running timespan is kept, a paused one is planned to resume now with its remaining time, the plan goes on from their end
+		const FDateTime End = Snapshot.State == Running ? Snapshot.DeadlineUtc + (FDateTime::Now() - FDateTime::UtcNow()) : Now + Snapshot.Remaining;
+		Plan.Add(FPomodoroPlannedBlock{Snapshot.Phase, Now, End});
+		From = End;
+
+		if(bRestDue)
+		{
+			Cycle = (Cycle + 1) % CycleCount;
+		}
+		bRestDue = !bRestDue;
+	}
+
+	int32 Minute = FMath::CeilToInt(static_cast<float>((From - Today).GetTotalMinutes()));
+	int32 First = 0;
+	while(First < Windows.Num() && Windows[First].EndMinute <= Minute)
+	{
+		++First;
+	}
+
+	// Windows already over are never solved
+	for(int32 Index = Windows.Num() - 1; Index >= First; --Index)
+	{
+		if(!Windows[Index].bSolved)
+		{
+			SolveWindow(Index);
+		}
+	}
+
+	const int32 StateCount = CycleCount * 2;
+	for(int32 Index = First; Index < Windows.Num(); ++Index)
+	{
+		const FWindow& Window = Windows[Index];
+
+		// Time off, commitment or not, stands for the resting timespan due
+		if(Minute < Window.StartMinute)
+		{
+			if(bRestDue)
+			{
+				Cycle = (Cycle + 1) % CycleCount;
+				bRestDue = false;
+			}
+			Minute = Window.StartMinute;
+		}
+
+		const int32 Length = Window.EndMinute - Window.StartMinute;
+		int32 Offset = Minute - Window.StartMinute;
+		while(Offset < Length)
+		{
+			const FDateTime Start = Today + FTimespan::FromMinutes(Window.StartMinute + Offset);
+			switch (Window.Choices[Offset * StateCount + Cycle * 2 + (bRestDue ? 1 : 0)])
+			{
+			case PomodoroPlanner::Work:
+				Offset += WorkingMinutes;
+				Plan.Add(FPomodoroPlannedBlock{EPomodoroPhase::Working, Start, Start + FTimespan::FromMinutes(WorkingMinutes)});
+				bRestDue = true;
+				break;
+
+			case PomodoroPlanner::Rest:
+				{
+					const bool bLongRest = Cycle == CycleCount - 1;
+					const int32 End = FMath::Min(Offset + (bLongRest ? LongRestingMinutes : ShortRestingMinutes), Length);
+					Plan.Add(FPomodoroPlannedBlock{bLongRest ? EPomodoroPhase::LongResting : EPomodoroPhase::ShortResting,
+						Start, Start + FTimespan::FromMinutes(End - Offset)});
+					Offset = End;
+					Cycle = (Cycle + 1) % CycleCount;
+					bRestDue = false;
+				}
+				break;
+
+			default:
+				++Offset;
+				break;
+			}
+		}
+		Minute = Window.EndMinute;
+	}
+
+	UpdatePlanText();
+}
+
+const TArray<FPomodoroPlannedBlock>& FPomodoroDayPlanner::GetPlan() const
+{
+	return Plan;
+}
+
+const FText& FPomodoroDayPlanner::GetPlanText() const
+{
+	return PlanText;
+}
+
+FTimespan FPomodoroDayPlanner::GetPlannedFocusTime() const
+{
+	FTimespan FocusTime = FTimespan::Zero();
+	for(const FPomodoroPlannedBlock& Block : Plan)
+	{
+		if(Block.Phase == EPomodoroPhase::Working)
+		{
+			FocusTime += Block.End - Block.Start;
+		}
+	}
+	return FocusTime;
+}
+
+void FPomodoroDayPlanner::ResetConfig()
+{
+	WorkingHours = PomodoroPlanner::GetDefaultWorkingHours();
+	Commitments.Empty();
+	UpdateWindows();
+}
+
+void FPomodoroDayPlanner::ReloadConfig()
+{
+	// Without store, the empty settings fall back to the standard working hours
+	const FPomodoroPlannerSettings Settings = ConfigStore.IsValid() ? ConfigStore->LoadPlannerSettings() : FPomodoroPlannerSettings();
+
+	WorkingHours = FPomodoroTimeRange{Settings.DayStart, Settings.DayEnd};
+	if(WorkingHours.End <= WorkingHours.Start)
+	{
+		WorkingHours = PomodoroPlanner::GetDefaultWorkingHours();
+	}
+
+	if(!ParseTimeRanges(Settings.Commitments, Commitments))
+	{
+		Commitments.Empty();
+	}
+	UpdateWindows();
+}
+
+void FPomodoroDayPlanner::SaveConfig() const
+{
+	if(ConfigStore.IsValid())
+	{
+		FPomodoroPlannerSettings Settings;
+		Settings.DayStart = WorkingHours.Start;
+		Settings.DayEnd = WorkingHours.End;
+		Settings.Commitments = FormatTimeRanges(Commitments);
+		ConfigStore->SavePlannerSettings(Settings);
+	}
+}
+
+FString FPomodoroDayPlanner::FormatTimeRanges(const TArray<FPomodoroTimeRange>& Ranges)
+{
+	TArray<FString> Items;
+	for(const FPomodoroTimeRange& Range : Ranges)
+	{
+		Items.Add(PomodoroPlanner::FormatTimeOfDay(Range.Start) + TEXT("-") + PomodoroPlanner::FormatTimeOfDay(Range.End));
+	}
+	return FString::Join(Items, TEXT(", "));
+}
+
+bool FPomodoroDayPlanner::ParseTimeRanges(const FString& Text, TArray<FPomodoroTimeRange>& OutRanges)
+{
+	OutRanges.Reset();
+
+	TArray<FString> Items;
+	Text.ParseIntoArray(Items, TEXT(","), true);
+	for(const FString& Item : Items)
+	{
+		FString StartText;
+		FString EndText;
+		FPomodoroTimeRange Range;
+		if(!Item.Split(TEXT("-"), &StartText, &EndText)
+			|| !PomodoroPlanner::ParseTimeOfDay(StartText, Range.Start)
+			|| !PomodoroPlanner::ParseTimeOfDay(EndText, Range.End)
+			|| Range.End <= Range.Start)
+		{
+			return false;
+		}
+		OutRanges.Add(Range);
+	}
+	return true;
+}
+
+void FPomodoroDayPlanner::UpdateWindows()
+{
+	const int32 DayStart = PomodoroPlanner::ToMinuteOfDay(WorkingHours.Start);
+	const int32 DayEnd = PomodoroPlanner::ToMinuteOfDay(WorkingHours.End);
+
+	TArray<TPair<int32, int32>> BusyRanges;
+	for(const FPomodoroTimeRange& Commitment : Commitments)
+	{
+		const int32 Start = FMath::Max(PomodoroPlanner::ToMinuteOfDay(Commitment.Start), DayStart);
+		const int32 End = FMath::Min(PomodoroPlanner::ToMinuteOfDay(Commitment.End), DayEnd);
+		if(End > Start)
+		{
+			BusyRanges.Emplace(Start, End);
+		}
+	}
+	BusyRanges.Sort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	TArray<FWindow> NewWindows;
+	int32 Cursor = DayStart;
+	for(const TPair<int32, int32>& Busy : BusyRanges)
+	{
+		if(Busy.Key > Cursor)
+		{
+			FWindow& Window = NewWindows.AddDefaulted_GetRef();
+			Window.StartMinute = Cursor;
+			Window.EndMinute = Busy.Key;
+		}
+		Cursor = FMath::Max(Cursor, Busy.Value);
+	}
+	if(Cursor < DayEnd)
+	{
+		FWindow& Window = NewWindows.AddDefaulted_GetRef();
+		Window.StartMinute = Cursor;
+		Window.EndMinute = DayEnd;
+	}
+
+	// A table only depends on the windows after it, the unchanged ones ending the day are kept
+	int32 OldIndex = Windows.Num() - 1;
+	for(int32 NewIndex = NewWindows.Num() - 1; NewIndex >= 0 && OldIndex >= 0; --NewIndex, --OldIndex)
+	{
+		if(NewWindows[NewIndex].StartMinute != Windows[OldIndex].StartMinute || NewWindows[NewIndex].EndMinute != Windows[OldIndex].EndMinute)
+		{
+			break;
+		}
+		NewWindows[NewIndex] = MoveTemp(Windows[OldIndex]);
+	}
+	Windows = MoveTemp(NewWindows);
+}
+
+void FPomodoroDayPlanner::SolveWindow(const int32 Index)
+{
+	FWindow& Window = Windows[Index];
+	const int32 Length = Window.EndMinute - Window.StartMinute;
+	const int32 StateCount = CycleCount * 2;
+
+	// Row per minute, the last one is the end of the window. State index is Cycle * 2 + RestDue
+	Window.Values.SetNumUninitialized((Length + 1) * StateCount);
+	Window.Choices.SetNumUninitialized((Length + 1) * StateCount);
+
+	// The commitment ending the window stands for the resting timespan due
+	const FWindow* NextWindow = Index + 1 < Windows.Num() ? &Windows[Index + 1] : nullptr;
+	for(int32 Cycle = 0; Cycle < CycleCount; ++Cycle)
+	{
+		for(int32 RestDue = 0; RestDue < 2; ++RestDue)
+		{
+			const int32 NextCycle = RestDue ? (Cycle + 1) % CycleCount : Cycle;
+			const int32 State = Length * StateCount + Cycle * 2 + RestDue;
+			Window.Values[State] = NextWindow != nullptr ? NextWindow->Values[NextCycle * 2] : 0;
+			Window.Choices[State] = PomodoroPlanner::Idle;
+		}
+	}
+
+	for(int32 Minute = Length - 1; Minute >= 0; --Minute)
+	{
+		const int32 Row = Minute * StateCount;
+		const int32 NextRow = Row + StateCount;
+		for(int32 Cycle = 0; Cycle < CycleCount; ++Cycle)
+		{
+			// Staying idle for a minute is always possible, working or resting wins ties to start early
+			int16 BestValue = Window.Values[NextRow + Cycle * 2];
+			uint8 BestChoice = PomodoroPlanner::Idle;
+			if(Minute + WorkingMinutes <= Length)
+			{
+				const int16 Value = static_cast<int16>(WorkingMinutes + Window.Values[(Minute + WorkingMinutes) * StateCount + Cycle * 2 + 1]);
+				if(Value >= BestValue)
+				{
+					BestValue = Value;
+					BestChoice = PomodoroPlanner::Work;
+				}
+			}
+			Window.Values[Row + Cycle * 2] = BestValue;
+			Window.Choices[Row + Cycle * 2] = BestChoice;
+
+			// A resting timespan is due, it may be cut short by the commitment ending the window
+			BestValue = Window.Values[NextRow + Cycle * 2 + 1];
+			BestChoice = PomodoroPlanner::Idle;
+			{
+				const int32 RestingMinutes = Cycle == CycleCount - 1 ? LongRestingMinutes : ShortRestingMinutes;
+				const int32 End = FMath::Min(Minute + RestingMinutes, Length);
+				const int16 Value = Window.Values[End * StateCount + ((Cycle + 1) % CycleCount) * 2];
+				if(Value >= BestValue)
+				{
+					BestValue = Value;
+					BestChoice = PomodoroPlanner::Rest;
+				}
+			}
+			Window.Values[Row + Cycle * 2 + 1] = BestValue;
+			Window.Choices[Row + Cycle * 2 + 1] = BestChoice;
+		}
+	}
+
+	Window.bSolved = true;
+}
+
+void FPomodoroDayPlanner::UpdatePlanText()
+{
+	if(Plan.Num() == 0)
+	{
+		PlanText = LOCTEXT("EmptyPlan", "Nothing left to plan today");
+		return;
+	}
+
+	FString Lines;
+	for(const FPomodoroPlannedBlock& Block : Plan)
+	{
+		FText PhaseText;
+		switch (Block.Phase)
+		{
+		case EPomodoroPhase::Working:
+			PhaseText = LOCTEXT("PlannedWorking", "Working");
+			break;
+
+		case EPomodoroPhase::ShortResting:
+			PhaseText = LOCTEXT("PlannedShortResting", "Short rest");
+			break;
+
+		case EPomodoroPhase::LongResting:
+			PhaseText = LOCTEXT("PlannedLongResting", "Long rest");
+			break;
+		}
+		Lines += FString::Printf(TEXT("%02d:%02d - %02d:%02d  %s\n"), Block.Start.GetHour(), Block.Start.GetMinute(),
+			Block.End.GetHour(), Block.End.GetMinute(), *PhaseText.ToString());
+	}
+
+	const FTimespan FocusTime = GetPlannedFocusTime();
+	PlanText = FText::Format(LOCTEXT("PlanFormat", "{0}Focus time : {1}h {2}m"), FText::FromString(Lines),
+		static_cast<int32>(FocusTime.GetTotalHours()), FocusTime.GetMinutes());
+}
+
+#undef LOCTEXT_NAMESPACE
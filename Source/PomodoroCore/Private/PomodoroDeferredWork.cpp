@@ -0,0 +1,160 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroDeferredWork.h"
+
+#include "Misc/App.h"
+
+namespace PomodoroDeferredWork
+{
+	/** Frame time the host is expected to hold */
+	constexpr double TargetFrameSeconds = 1.0 / 60.0;
+
+	/** Share of the target frame time a frame may use and still have time to spare */
+	constexpr double BusyShare = 0.75;
+
+	/** Time deferred work may take in a single tick */
+	constexpr double SliceSeconds = 0.001;
+}
+
+FPomodoroDeferredWork* FPomodoroDeferredWork::Instance = nullptr;
+
+FPomodoroDeferredWork::FPomodoroDeferredWork(const TSharedRef<FPomodoroClock> InClock, const FPomodoroIsBusyDelegate InIsBusy)
+	: Clock(InClock)
+	, IsBusy(InIsBusy)
+{
+	check(Instance == nullptr);
+	Instance = this;
+	Clock->SetTimer(TimerHandle, FSimpleDelegate::CreateRaw(this, &FPomodoroDeferredWork::RunSlice), 0.0, 0.0);
+}
+
+FPomodoroDeferredWork::~FPomodoroDeferredWork()
+{
+	Clock->ClearTimer(TimerHandle);
+	FlushAll();
+	Instance = nullptr;
+}
+
+void FPomodoroDeferredWork::Enqueue(const FName Key, const EPomodoroWorkPriority Priority, const double MaxDelaySeconds, TUniqueFunction<void()> Work)
+{
+	if(Instance == nullptr)
+	{
+		Work();
+		return;
+	}
+
+	const double DeadlineSeconds = FPlatformTime::Seconds() + MaxDelaySeconds;
+	for(FItem& Item : Instance->Items)
+	{
+		if(Item.Key == Key)
+		{
+			Item.Priority = FMath::Min(Item.Priority, Priority);
+			Item.DeadlineSeconds = FMath::Min(Item.DeadlineSeconds, DeadlineSeconds);
+			Item.Work = MoveTemp(Work);
+			return;
+		}
+	}
+	Instance->Items.Add({Key, Priority, DeadlineSeconds, MoveTemp(Work)});
+}
+
+void FPomodoroDeferredWork::Flush(const FName Key)
+{
+	if(Instance == nullptr)
+	{
+		return;
+	}
+
+	const int32 Index = Instance->Items.IndexOfByPredicate([Key](const FItem& Item)
+	{
+		return Item.Key == Key;
+	});
+	if(Index != INDEX_NONE)
+	{
+		Instance->RunItem(Index);
+	}
+}
+
+void FPomodoroDeferredWork::FlushAll()
+{
+	// Work may enqueue more work, run until nothing is left
+	while(Items.Num() > 0)
+	{
+		RunItem(FindNext(false, FPlatformTime::Seconds()));
+	}
+}
+
+void FPomodoroDeferredWork::RunSlice()
+{
+	if(Items.Num() == 0)
+	{
+		return;
+	}
+
+	// While playing or after a heavy frame, only what can't wait any longer runs
+	const bool bDueOnly = (IsBusy.IsBound() && IsBusy.Execute()) || !HasSpareBudget();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	double NowSeconds = StartSeconds;
+	do
+	{
+		const int32 Index = FindNext(bDueOnly, NowSeconds);
+		if(Index == INDEX_NONE)
+		{
+			break;
+		}
+		RunItem(Index);
+		NowSeconds = FPlatformTime::Seconds();
+	}
+	while(NowSeconds - StartSeconds < PomodoroDeferredWork::SliceSeconds);
+}
+
+int32 FPomodoroDeferredWork::FindNext(const bool bDueOnly, const double NowSeconds) const
+{
+	// Due items first, then by priority, then by deadline
+	int32 Best = INDEX_NONE;
+	for(int32 Index = 0; Index < Items.Num(); ++Index)
+	{
+		const FItem& Item = Items[Index];
+		const bool bDue = Item.DeadlineSeconds <= NowSeconds;
+		if(bDueOnly && !bDue)
+		{
+			continue;
+		}
+		if(Best == INDEX_NONE)
+		{
+			Best = Index;
+			continue;
+		}
+
+		const FItem& BestItem = Items[Best];
+		const bool bBestDue = BestItem.DeadlineSeconds <= NowSeconds;
+		if(bDue != bBestDue)
+		{
+			Best = bDue ? Index : Best;
+		}
+		else if(Item.Priority != BestItem.Priority)
+		{
+			Best = Item.Priority < BestItem.Priority ? Index : Best;
+		}
+		else if(Item.DeadlineSeconds < BestItem.DeadlineSeconds)
+		{
+			Best = Index;
+		}
+	}
+	return Best;
+}
+
+void FPomodoroDeferredWork::RunItem(const int32 Index)
+{
+	// Removed first, the work may enqueue again under the same key
+	TUniqueFunction<void()> Work = MoveTemp(Items[Index].Work);
+	Items.RemoveAtSwap(Index);
+	Work();
+}
+
+bool FPomodoroDeferredWork::HasSpareBudget()
+{
+	// Idle time means the frame waited for the frame rate limit
+	const double BusySeconds = FApp::GetDeltaTime() - FApp::GetIdleTime();
+	return FApp::GetIdleTime() > 0.0 || BusySeconds < PomodoroDeferredWork::TargetFrameSeconds * PomodoroDeferredWork::BusyShare;
+}
@@ -0,0 +1,700 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroEngine.h"
+
+#define LOCTEXT_NAMESPACE "FPomodoroPluginModule"
+
+FPomodoroEngine::FPomodoroEngine(const TSharedRef<FPomodoroClock> InClock, const TSharedPtr<IPomodoroConfigStore> InConfigStore)
+	: Clock(InClock)
+	, ConfigStore(InConfigStore)
+	, SnapshotChannel(MakeShared<FPomodoroSnapshotChannel, ESPMode::ThreadSafe>())
+{
+	CurrentCycle = 0;
+	RemainingTimespan = FTimespan::Zero();
+	WorkingTime = false;
+	State = Stopped;
+	bFollowing = false;
+
+	UpdateTimerText();
+
+	// Also publish the first snapshot
+	ReloadConfig();
+
+	Clock->SetTimer(PostedCommandsHandle, FSimpleDelegate::CreateRaw(this, &FPomodoroEngine::RunPostedCommands), 0.0, 0.0);
+}
+
+FPomodoroEngine::~FPomodoroEngine()
+{
+	// Nobody is left to run them
+	FPostedCommand Posted;
+	while(PostedCommands.Dequeue(Posted))
+	{
+		Posted.Result.SetValue(false);
+	}
+
+	// Closing the editor is not part of the session
+	SessionLog.Reset();
+
+	// Closing a following editor must not stop the leading one
+	bFollowing = false;
+	Stop();
+	ElapsedTimespanHandle.Clear();
+	SnapshotPublishedEvent.Clear();
+	Clock->ClearTimer(PostedCommandsHandle);
+}
+
+TFuture<bool> FPomodoroEngine::Post(const FPomodoroEngineCommand& Command)
+{
+	FPostedCommand Posted;
+	Posted.Command = Command;
+	TFuture<bool> Result = Posted.Result.GetFuture();
+	PostedCommands.Enqueue(MoveTemp(Posted));
+	return Result;
+}
+
+void FPomodoroEngine::Start()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Start);
+
+	// If pomodoro is already running, do nothing 
+	if(State == Running)
+	{
+		return;
+	}
+
+	// The leading editor owns the clock
+	if(bFollowing)
+	{
+		RemoteStateRequest.ExecuteIfBound(Running);
+		return;
+	}
+
+	const FSimpleDelegate Delegate = FSimpleDelegate::CreateRaw(this, &FPomodoroEngine::OnTick);
+	
+	// If the previous state was "Stopped"
+	if(State == Stopped)
+	{
+		ApplyPendingTimespans();
+		CurrentCycle = 0;
+		WorkingTime = true;
+		RemainingTimespan = WorkingTimespan;
+		UpdateTimerText();
+	}
+
+	// The timespan ends at the tick bringing the remaining time to zero
+	Deadline = ReadUtcNow() + RemainingTimespan;
+	Clock->SetTimer(TimerHandle, Delegate, 1.0, 1.0);
+	
+	State = Running;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::Stop()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Stop);
+
+	// If pomodoro is already stopped, do nothing
+	if(State == Stopped)
+	{
+		return;
+	}
+
+	// The leading editor owns the clock
+	if(bFollowing)
+	{
+		RemoteStateRequest.ExecuteIfBound(Stopped);
+		return;
+	}
+
+	Clock->ClearTimer(TimerHandle);
+	RemainingTimespan = FTimespan::Zero();
+	UpdateTimerText();
+	State = Stopped;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::Pause()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Pause);
+
+	// If pomodoro is already paused, do nothing
+	if(State == Paused)
+	{
+		return;
+	}
+
+	// The leading editor owns the clock
+	if(bFollowing)
+	{
+		RemoteStateRequest.ExecuteIfBound(Paused);
+		return;
+	}
+
+	Clock->ClearTimer(TimerHandle);
+	State = Paused;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::SetCycleCount(const int32 NewCycleCount)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::SetCycleCount, {NewCycleCount});
+
+	CycleCount = NewCycleCount;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::SetWorkingTimespan(const int32 Hour, const int32 Minute, const int32 Second)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::SetWorkingTimespan, {Hour, Minute, Second});
+
+	WorkingTimespan = FTimespan(Hour, Minute, Second);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::SetShortRestingTimespan(const int32 Hour, const int32 Minute, const int32 Second)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::SetShortRestingTimespan, {Hour, Minute, Second});
+
+	ShortRestingTimespan = FTimespan(Hour, Minute, Second);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::SetLongRestingTimespan(const int32 Hour, const int32 Minute, const int32 Second)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::SetLongRestingTimespan, {Hour, Minute, Second});
+
+	LongRestingTimespan = FTimespan(Hour, Minute, Second);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::ResetConfig()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::ResetConfig);
+
+	PendingTimespans.Reset();
+	CycleCount = 4;
+	WorkingTimespan = FTimespan::FromMinutes(25);
+	ShortRestingTimespan = FTimespan::FromMinutes(5);
+	LongRestingTimespan = FTimespan::FromMinutes(20);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::ReloadConfig()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	if(!ConfigStore.IsValid())
+	{
+		// Recorded as the reset it ends up being
+		RecordInput(EPomodoroSessionEvent::ResetConfig);
+		ResetConfig();
+		return;
+	}
+
+	// Recorded with the loaded configuration, the replay doesn't read the config file
+	const FPomodoroEngineSettings Settings = ConfigStore->LoadEngineSettings();
+	RecordInput(EPomodoroSessionEvent::ReloadConfig, {Settings.WorkingTimespan.GetTicks(), Settings.ShortRestingTimespan.GetTicks(),
+		Settings.LongRestingTimespan.GetTicks(), Settings.CycleCount});
+
+	PendingTimespans.Reset();
+	WorkingTimespan = Settings.WorkingTimespan;
+	ShortRestingTimespan = Settings.ShortRestingTimespan;
+	LongRestingTimespan = Settings.LongRestingTimespan;
+	CycleCount = Settings.CycleCount;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::SaveConfig() const
+{
+	if(ConfigStore.IsValid())
+	{
+		FPomodoroEngineSettings Settings;
+		Settings.WorkingTimespan = WorkingTimespan;
+		Settings.ShortRestingTimespan = ShortRestingTimespan;
+		Settings.LongRestingTimespan = LongRestingTimespan;
+		Settings.CycleCount = CycleCount;
+		ConfigStore->SaveEngineSettings(Settings);
+	}
+}
+
+FText FPomodoroEngine::GetTimerText() const
+{
+	return TimerText;
+}
+
+int32 FPomodoroEngine::GetCurrentCycle() const
+{
+	return CurrentCycle + 1;
+}
+
+int32 FPomodoroEngine::GetCycleCount() const
+{
+	return CycleCount;
+}
+
+FTimespan FPomodoroEngine::GetWorkingTimespan() const
+{
+	return WorkingTimespan;
+}
+
+FTimespan FPomodoroEngine::GetShortRestingTimespan() const
+{
+	return ShortRestingTimespan;
+}
+
+FTimespan FPomodoroEngine::GetLongRestingTimespan() const
+{
+	return LongRestingTimespan;
+}
+
+EPomodoroState FPomodoroEngine::GetState() const
+{
+	return State;
+}
+
+bool FPomodoroEngine::IsWorkingTime() const
+{
+	return WorkingTime;
+}
+
+EPomodoroPhase FPomodoroEngine::GetPhase() const
+{
+	if(WorkingTime)
+	{
+		return EPomodoroPhase::Working;
+	}
+	return CurrentCycle == CycleCount - 1 ? EPomodoroPhase::LongResting : EPomodoroPhase::ShortResting;
+}
+
+TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> FPomodoroEngine::GetSnapshotChannel() const
+{
+	return SnapshotChannel;
+}
+
+FSnapshotPublished& FPomodoroEngine::OnSnapshotPublished()
+{
+	return SnapshotPublishedEvent;
+}
+
+void FPomodoroEngine::Follow(const FRequestStateDelegate RequestState)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Follow);
+
+	Clock->ClearTimer(TimerHandle);
+
+	RemoteStateRequest = RequestState;
+	bFollowing = true;
+}
+
+void FPomodoroEngine::Lead()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Lead);
+
+	if(!bFollowing)
+	{
+		return;
+	}
+
+	bFollowing = false;
+	RemoteStateRequest.Unbind();
+
+	// Keep counting down where the previous leading editor stopped
+	if(State == Running)
+	{
+		UpdateRemainingTimespan();
+		UpdateTimerText();
+		AlignTick();
+	}
+	PublishSnapshot();
+}
+
+bool FPomodoroEngine::IsFollowing() const
+{
+	return bFollowing;
+}
+
+void FPomodoroEngine::MirrorSnapshot(const FPomodoroEngineSnapshot& Snapshot)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	if(InputDepth == 1 && SessionLog.IsValid())
+	{
+		SessionLog->AddSnapshotInput(EPomodoroSessionEvent::MirrorSnapshot, Snapshot);
+	}
+
+	if(!bFollowing)
+	{
+		return;
+	}
+
+	ApplySnapshot(Snapshot);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::Synchronize(const FPomodoroEngineSnapshot& Snapshot)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	if(InputDepth == 1 && SessionLog.IsValid())
+	{
+		SessionLog->AddSnapshotInput(EPomodoroSessionEvent::Synchronize, Snapshot);
+	}
+
+	if(bFollowing)
+	{
+		return;
+	}
+
+	// Keep owning the clock, only realign it so the timespan ends at the shared deadline
+	ApplySnapshot(Snapshot);
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::BindOnTimeSpanElapsed(const FElapsedTimespanHandleDelegate Delegate)
+{
+	ElapsedTimespanHandle.Add(Delegate);
+}
+
+void FPomodoroEngine::SetSessionLog(const TSharedPtr<FPomodoroSessionLog> InSessionLog)
+{
+	SessionLog = InSessionLog;
+	if(SessionLog.IsValid())
+	{
+		SessionLog->AddBegin(CaptureSessionState());
+	}
+}
+
+void FPomodoroEngine::RunPostedCommands()
+{
+	// Same order as they were posted, including the ones posted by the commands themselves
+	FPostedCommand Posted;
+	while(PostedCommands.Dequeue(Posted))
+	{
+		// Its sender gave up on a command reached too late, it is not run behind their back
+		const bool bExpired = Posted.Command.ExpireSeconds > 0.0 && FPlatformTime::Seconds() > Posted.Command.ExpireSeconds;
+		Posted.Result.SetValue(!bExpired && Execute(Posted.Command));
+	}
+}
+
+bool FPomodoroEngine::Execute(const FPomodoroEngineCommand& Command)
+{
+	switch (Command.Kind)
+	{
+	case EPomodoroEngineCommand::Start:
+		Start();
+		return bFollowing || State == Running;
+
+	case EPomodoroEngineCommand::Pause:
+		Pause();
+		return bFollowing || State == Paused;
+
+	case EPomodoroEngineCommand::Stop:
+		Stop();
+		return bFollowing || State == Stopped;
+
+	// Same rule as the tab, the configuration only changes while stopped
+	case EPomodoroEngineCommand::Configure:
+		if(bFollowing || State != Stopped)
+		{
+			return false;
+		}
+		if(Command.CycleCount > 0)
+		{
+			SetCycleCount(Command.CycleCount);
+		}
+		if(Command.WorkingTimespan > FTimespan::Zero())
+		{
+			const FTimespan& Length = Command.WorkingTimespan;
+			SetWorkingTimespan(Length.GetHours(), Length.GetMinutes(), Length.GetSeconds());
+		}
+		if(Command.ShortRestingTimespan > FTimespan::Zero())
+		{
+			const FTimespan& Length = Command.ShortRestingTimespan;
+			SetShortRestingTimespan(Length.GetHours(), Length.GetMinutes(), Length.GetSeconds());
+		}
+		if(Command.LongRestingTimespan > FTimespan::Zero())
+		{
+			const FTimespan& Length = Command.LongRestingTimespan;
+			SetLongRestingTimespan(Length.GetHours(), Length.GetMinutes(), Length.GetSeconds());
+		}
+		SaveConfig();
+		return true;
+
+	case EPomodoroEngineCommand::SetNextCycleTimespans:
+		SetNextCycleTimespans(Command.WorkingTimespan, Command.ShortRestingTimespan, Command.LongRestingTimespan);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void FPomodoroEngine::OnTick()
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::Tick);
+
+	// Only display the countdown of the leading editor, it triggers the timespan ends
+	if(bFollowing)
+	{
+		UpdateRemainingTimespan();
+		UpdateTimerText();
+		return;
+	}
+
+	// Update remaining timespan
+	RemainingTimespan -= FTimespan::FromSeconds(1);
+
+	// If current timespan is elapsed
+	if(RemainingTimespan <= FTimespan::Zero())
+	{
+		OnElapsedTimespan();
+	}
+
+	UpdateTimerText();
+}
+
+void FPomodoroEngine::OnElapsedTimespan()
+{
+	// If the elapsed timespan was a working timespan
+	if(WorkingTime)
+	{
+		// If on the last cycle, use a long resting time
+		if(CurrentCycle == CycleCount - 1)
+		{
+			RemainingTimespan = LongRestingTimespan;
+		}
+		// Otherwise, use a short resting time 
+		else
+		{
+			RemainingTimespan = ShortRestingTimespan;
+		}
+	}
+	// If the elapsed timespan was a resting timespan
+	else
+	{
+		CurrentCycle = (CurrentCycle + 1) % CycleCount;
+		if(CurrentCycle == 0)
+		{
+			ApplyPendingTimespans();
+		}
+		RemainingTimespan = WorkingTimespan;
+	}
+
+	// The next timespan starts where this one was due to end, late ticks don't push it back
+	Deadline += RemainingTimespan;
+	if(SessionLog.IsValid())
+	{
+		SessionLog->AddElapsed(WorkingTime);
+	}
+	ElapsedTimespanHandle.Broadcast(WorkingTime);
+	WorkingTime = !WorkingTime;
+	PublishSnapshot();
+}
+
+void FPomodoroEngine::UpdateTimerText()
+{
+	TimerText = FText::Format(FTextFormat::FromString(TEXT("{0} : {1} : {2}")),
+		RemainingTimespan.GetHours() < 10 ?
+			FText::Format(FText::FromString(TEXT("0{0}")), RemainingTimespan.GetHours()) :
+			FText::Format(FText::FromString(TEXT("{0}")), RemainingTimespan.GetHours()),
+		RemainingTimespan.GetMinutes() < 10 ?
+			FText::Format(FText::FromString(TEXT("0{0}")), RemainingTimespan.GetMinutes()) :
+			FText::Format(FText::FromString(TEXT("{0}")), RemainingTimespan.GetMinutes()),
+		RemainingTimespan.GetSeconds() < 10 ?
+			FText::Format(FText::FromString(TEXT("0{0}")), RemainingTimespan.GetSeconds()) :
+			FText::Format(FText::FromString(TEXT("{0}")), RemainingTimespan.GetSeconds())
+	);
+}
+
+void FPomodoroEngine::SetNextCycleTimespans(const FTimespan NewWorkingTimespan, const FTimespan NewShortRestingTimespan, const FTimespan NewLongRestingTimespan)
+{
+	const TGuardValue<int32> InputGuard(InputDepth, InputDepth + 1);
+	RecordInput(EPomodoroSessionEvent::SetNextCycleTimespans,
+		{NewWorkingTimespan.GetTicks(), NewShortRestingTimespan.GetTicks(), NewLongRestingTimespan.GetTicks()});
+
+	PendingTimespans = MakeTuple(NewWorkingTimespan, NewShortRestingTimespan, NewLongRestingTimespan);
+	if(State == Stopped && !bFollowing)
+	{
+		ApplyPendingTimespans();
+		PublishSnapshot();
+	}
+}
+
+void FPomodoroEngine::PublishSnapshot()
+{
+	FPomodoroEngineSnapshot Snapshot;
+	Snapshot.State = State;
+	Snapshot.Phase = GetPhase();
+	Snapshot.CurrentCycle = GetCurrentCycle();
+	Snapshot.CycleCount = CycleCount;
+	Snapshot.Remaining = RemainingTimespan;
+	Snapshot.WorkingLength = WorkingTimespan;
+	Snapshot.ShortRestingLength = ShortRestingTimespan;
+	Snapshot.LongRestingLength = LongRestingTimespan;
+
+	switch (Snapshot.Phase)
+	{
+	case EPomodoroPhase::Working:
+		Snapshot.PhaseLength = WorkingTimespan;
+		break;
+
+	case EPomodoroPhase::ShortResting:
+		Snapshot.PhaseLength = ShortRestingTimespan;
+		break;
+
+	case EPomodoroPhase::LongResting:
+		Snapshot.PhaseLength = LongRestingTimespan;
+		break;
+	}
+
+	// The deadline only makes sense while the timer is counting down
+	if(State == Running)
+	{
+		const FDateTime Now = ReadUtcNow();
+		Snapshot.DeadlineUtc = Deadline;
+		Snapshot.DeadlineSeconds = ReadClockSeconds() + (Snapshot.DeadlineUtc - Now).GetTotalSeconds();
+	}
+
+	SnapshotChannel->Publish(Snapshot);
+	SnapshotPublishedEvent.Broadcast();
+}
+
+void FPomodoroEngine::ApplySnapshot(const FPomodoroEngineSnapshot& Snapshot)
+{
+	State = Snapshot.State;
+	WorkingTime = Snapshot.Phase == EPomodoroPhase::Working;
+	CurrentCycle = Snapshot.CurrentCycle - 1;
+	CycleCount = Snapshot.CycleCount;
+	RemainingTimespan = Snapshot.Remaining;
+	Deadline = Snapshot.DeadlineUtc;
+
+	// The other editor owns the configuration, at least the current timespan length is known
+	if(Snapshot.WorkingLength > FTimespan::Zero())
+	{
+		WorkingTimespan = Snapshot.WorkingLength;
+		ShortRestingTimespan = Snapshot.ShortRestingLength;
+		LongRestingTimespan = Snapshot.LongRestingLength;
+	}
+	else switch (Snapshot.Phase)
+	{
+	case EPomodoroPhase::Working:
+		WorkingTimespan = Snapshot.PhaseLength;
+		break;
+
+	case EPomodoroPhase::ShortResting:
+		ShortRestingTimespan = Snapshot.PhaseLength;
+		break;
+
+	case EPomodoroPhase::LongResting:
+		LongRestingTimespan = Snapshot.PhaseLength;
+		break;
+	}
+
+	if(State == Running)
+	{
+		UpdateRemainingTimespan();
+		AlignTick();
+	}
+	else
+	{
+		Clock->ClearTimer(TimerHandle);
+	}
+
+	UpdateTimerText();
+}
+
+void FPomodoroEngine::RecordInput(const EPomodoroSessionEvent Event, const TArrayView<const int64> Arguments)
+{
+	if(InputDepth == 1 && SessionLog.IsValid())
+	{
+		SessionLog->AddInput(Event, Arguments);
+	}
+}
+
+FDateTime FPomodoroEngine::ReadUtcNow() const
+{
+	const FDateTime Now = Clock->GetUtcNow();
+	if(SessionLog.IsValid())
+	{
+		SessionLog->AddUtcReading(Now);
+	}
+	return Now;
+}
+
+double FPomodoroEngine::ReadClockSeconds() const
+{
+	const double Seconds = Clock->GetSeconds();
+	if(SessionLog.IsValid())
+	{
+		SessionLog->AddSecondsReading(Seconds);
+	}
+	return Seconds;
+}
+
+FPomodoroSessionState FPomodoroEngine::CaptureSessionState() const
+{
+	FPomodoroSessionState SessionState;
+	SessionState.State = State;
+	SessionState.bWorkingTime = WorkingTime;
+	SessionState.bFollowing = bFollowing;
+	SessionState.CurrentCycle = CurrentCycle;
+	SessionState.CycleCount = CycleCount;
+	SessionState.Remaining = RemainingTimespan;
+	SessionState.WorkingTimespan = WorkingTimespan;
+	SessionState.ShortRestingTimespan = ShortRestingTimespan;
+	SessionState.LongRestingTimespan = LongRestingTimespan;
+	SessionState.Deadline = Deadline;
+	SessionState.PendingTimespans = PendingTimespans;
+	return SessionState;
+}
+
+void FPomodoroEngine::RestoreSessionState(const FPomodoroSessionState& SessionState)
+{
+	State = SessionState.State;
+	WorkingTime = SessionState.bWorkingTime;
+	bFollowing = SessionState.bFollowing;
+	CurrentCycle = SessionState.CurrentCycle;
+	CycleCount = SessionState.CycleCount;
+	RemainingTimespan = SessionState.Remaining;
+	WorkingTimespan = SessionState.WorkingTimespan;
+	ShortRestingTimespan = SessionState.ShortRestingTimespan;
+	LongRestingTimespan = SessionState.LongRestingTimespan;
+	Deadline = SessionState.Deadline;
+	PendingTimespans = SessionState.PendingTimespans;
+	UpdateTimerText();
+}
+
+void FPomodoroEngine::ApplyPendingTimespans()
+{
+	if(PendingTimespans.IsSet())
+	{
+		WorkingTimespan = PendingTimespans->Get<0>();
+		ShortRestingTimespan = PendingTimespans->Get<1>();
+		LongRestingTimespan = PendingTimespans->Get<2>();
+		PendingTimespans.Reset();
+	}
+}
+
+void FPomodoroEngine::UpdateRemainingTimespan()
+{
+	const FTimespan Remaining = FMath::Max(Deadline - ReadUtcNow(), FTimespan::Zero());
+	RemainingTimespan = FTimespan::FromSeconds(FMath::CeilToInt(Remaining.GetTotalSeconds()));
+}
+
+void FPomodoroEngine::AlignTick()
+{
+	// Tick when the displayed second changes
+	const double Fraction = FMath::Fractional((Deadline - ReadUtcNow()).GetTotalSeconds());
+	Clock->SetTimer(TimerHandle, FSimpleDelegate::CreateRaw(this, &FPomodoroEngine::OnTick), 1.0, Fraction > 0.0 ? Fraction : 1.0);
+}
+
+#undef LOCTEXT_NAMESPACE
\ No newline at end of file
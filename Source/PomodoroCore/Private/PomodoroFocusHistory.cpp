@@ -0,0 +1,203 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroFocusHistory.h"
+
+#include "PomodoroCore.h"
+#include "PomodoroDeferredWork.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace PomodoroFocusHistory
+{
+	constexpr uint32 Magic = 0x48464D50; // "PMFH"
+	constexpr uint32 Version = 1;
+
+	/** Key of the deferred save */
+	static const FName SaveKey(TEXT("PomodoroFocusHistory"));
+
+	/** The history is saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 60.0;
+}
+
+FPomodoroFocusHistory::FPomodoroFocusHistory(TSharedRef<FPomodoroEngine> InEngine)
+	: Engine(InEngine)
+{
+	Load();
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroFocusHistory::OnEngineSnapshotPublished);
+}
+
+FPomodoroFocusHistory::~FPomodoroFocusHistory()
+{
+	Engine->OnSnapshotPublished().RemoveAll(this);
+	CloseSegment();
+	FPomodoroDeferredWork::Flush(PomodoroFocusHistory::SaveKey);
+}
+
+void FPomodoroFocusHistory::AddFocus(const FDateTime& StartLocal, const FDateTime& EndLocal)
+{
+	if(EndLocal <= StartLocal)
+	{
+		return;
+	}
+
+	const int32 StartDay = GetDay(StartLocal);
+	const int32 EndDay = GetDay(EndLocal);
+
+	// Grow the dense array to cover both ends
+	if(DailySeconds.Num() == 0)
+	{
+		FirstDay = StartDay;
+	}
+	else if(StartDay < FirstDay)
+	{
+		DailySeconds.InsertZeroed(0, FirstDay - StartDay);
+		FirstDay = StartDay;
+	}
+	if(EndDay - FirstDay >= DailySeconds.Num())
+	{
+		DailySeconds.AddZeroed(EndDay - FirstDay + 1 - DailySeconds.Num());
+	}
+
+	// A segment over midnight is split between the days
+	for(int32 Day = StartDay; Day <= EndDay; ++Day)
+	{
+		const FDateTime DayStart(static_cast<int64>(Day) * ETimespan::TicksPerDay);
+		const FDateTime From = FMath::Max(StartLocal, DayStart);
+		const FDateTime To = FMath::Min(EndLocal, DayStart + FTimespan(ETimespan::TicksPerDay));
+		int32& Seconds = DailySeconds[Day - FirstDay];
+		Seconds += FMath::RoundToInt((To - From).GetTotalSeconds());
+		PeakSeconds = FMath::Max(PeakSeconds, Seconds);
+	}
+	++Version;
+}
+
+void FPomodoroFocusHistory::AddRecords(const TConstArrayView<FPomodoroPhaseRecord> Records)
+{
+	// The records are kept in UTC, the days are local
+	const FTimespan UtcOffset = FDateTime::Now() - FDateTime::UtcNow();
+	for(const FPomodoroPhaseRecord& Record : Records)
+	{
+		if(Record.Phase == EPomodoroPhase::Working)
+		{
+			const FDateTime StartLocal = FDateTime::FromUnixTimestamp(Record.StartSeconds) + UtcOffset;
+			AddFocus(StartLocal, StartLocal + FTimespan::FromSeconds(Record.DurationSeconds));
+		}
+	}
+	FPomodoroDeferredWork::Enqueue(PomodoroFocusHistory::SaveKey, EPomodoroWorkPriority::Low, PomodoroFocusHistory::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+int32 FPomodoroFocusHistory::GetFocusSeconds(const int32 Day) const
+{
+	return DailySeconds.IsValidIndex(Day - FirstDay) ? DailySeconds[Day - FirstDay] : 0;
+}
+
+int32 FPomodoroFocusHistory::GetFirstDay() const
+{
+	return DailySeconds.Num() > 0 ? FirstDay : GetDay(FDateTime::Now());
+}
+
+int32 FPomodoroFocusHistory::GetPeakSeconds() const
+{
+	return PeakSeconds;
+}
+
+uint32 FPomodoroFocusHistory::GetVersion() const
+{
+	return Version;
+}
+
+int32 FPomodoroFocusHistory::GetDay(const FDateTime& Local)
+{
+	return static_cast<int32>(Local.GetTicks() / ETimespan::TicksPerDay);
+}
+
+FString FPomodoroFocusHistory::GetHistoryPath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Pomodoro"), TEXT("FocusHistory.bin"));
+}
+
+void FPomodoroFocusHistory::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+
+	// The leading editor records for every editor of this machine
+	const bool bFocusing = Snapshot.State == Running && Snapshot.Phase == EPomodoroPhase::Working && !Engine->IsFollowing();
+	if(bFocusing && !bSegmentOpen)
+	{
+		bSegmentOpen = true;
+		SegmentStartLocal = FDateTime::Now();
+	}
+	else if(!bFocusing && bSegmentOpen)
+	{
+		CloseSegment();
+	}
+}
+
+void FPomodoroFocusHistory::CloseSegment()
+{
+	if(!bSegmentOpen)
+	{
+		return;
+	}
+
+	bSegmentOpen = false;
+	AddFocus(SegmentStartLocal, FDateTime::Now());
+	FPomodoroDeferredWork::Enqueue(PomodoroFocusHistory::SaveKey, EPomodoroWorkPriority::Low, PomodoroFocusHistory::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+void FPomodoroFocusHistory::Load()
+{
+	TArray<uint8> Bytes;
+	if(!FFileHelper::LoadFileToArray(Bytes, *GetHistoryPath(), FILEREAD_Silent))
+	{
+		return;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 FileVersion = 0;
+	Reader << Magic << FileVersion;
+	if(Magic != PomodoroFocusHistory::Magic || FileVersion != PomodoroFocusHistory::Version)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Ignoring the focus history %s, unknown format"), *GetHistoryPath());
+		return;
+	}
+
+	Reader << FirstDay << DailySeconds;
+	if(Reader.IsError())
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Ignoring the focus history %s, truncated"), *GetHistoryPath());
+		FirstDay = 0;
+		DailySeconds.Reset();
+		return;
+	}
+
+	PeakSeconds = 0;
+	for(const int32 Seconds : DailySeconds)
+	{
+		PeakSeconds = FMath::Max(PeakSeconds, Seconds);
+	}
+	++Version;
+}
+
+void FPomodoroFocusHistory::Save()
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = PomodoroFocusHistory::Magic;
+	uint32 FileVersion = PomodoroFocusHistory::Version;
+	Writer << Magic << FileVersion << FirstDay << DailySeconds;
+
+	if(!FFileHelper::SaveArrayToFile(Bytes, *GetHistoryPath()))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't save the focus history to %s"), *GetHistoryPath());
+	}
+}
@@ -0,0 +1,450 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroPercentiles.h"
+
+#include "PomodoroCore.h"
+#include "PomodoroDeferredWork.h"
+#include "PomodoroFocusHistory.h"
+#include "PomodoroVarint.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace PomodoroPercentiles
+{
+	constexpr uint32 Magic = 0x43504D50; // "PMPC"
+	constexpr uint32 Version = 1;
+
+	/** Key of the deferred save */
+	static const FName SaveKey(TEXT("PomodoroPercentiles"));
+
+	/** The sketches are saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 60.0;
+
+	/** An overrun ends at the last input before this much time without any */
+	constexpr double IdleSeconds = 60.0;
+
+	/** Ratio between the bounds of a bucket, the estimate of a bucket is within RelativeAccuracy of its values */
+	static const double Gamma = (1.0 + FPomodoroQuantileSketch::RelativeAccuracy) / (1.0 - FPomodoroQuantileSketch::RelativeAccuracy);
+	static const double LogGamma = FMath::Loge(Gamma);
+
+	static void WriteRaw(TArray<uint8>& Bytes, const void* Value, const int32 Size)
+	{
+		Bytes.Append(static_cast<const uint8*>(Value), Size);
+	}
+
+	static bool ReadRaw(const uint8*& Data, const uint8* End, void* Value, const int32 Size)
+	{
+		if(End - Data < Size)
+		{
+			return false;
+		}
+		FMemory::Memcpy(Value, Data, Size);
+		Data += Size;
+		return true;
+	}
+
+	/**
+	 * @brief Give the bucket of a value : bucket I covers [Gamma^(I-1), Gamma^I[ seconds.
+	 */
+	static int32 GetBucket(const double Value)
+	{
+		if(Value < 1.0)
+		{
+			return 0;
+		}
+		return FMath::Min(FPomodoroQuantileSketch::BucketCount - 1, 1 + FMath::FloorToInt(FMath::Loge(Value) / LogGamma));
+	}
+
+	/**
+	 * @brief Give the value standing for a bucket, 2 * Gamma^I / (1 + Gamma).
+	 *
+	 * Its relative distance to both bounds is RelativeAccuracy, where the middle of the bounds is farther from the lower one.
+	 */
+	static double GetBucketValue(const int32 Bucket)
+	{
+		if(Bucket == 0)
+		{
+			return 0.5;
+		}
+		return 2.0 * FMath::Exp(Bucket * LogGamma) / (1.0 + Gamma);
+	}
+}
+
+void FPomodoroQuantileSketch::Add(double Value)
+{
+	Value = FMath::Max(Value, 0.0);
+	Min = Count == 0 ? Value : FMath::Min(Min, Value);
+	Max = Count == 0 ? Value : FMath::Max(Max, Value);
+	++Counts[PomodoroPercentiles::GetBucket(Value)];
+	++Count;
+}
+
+void FPomodoroQuantileSketch::Merge(const FPomodoroQuantileSketch& Other)
+{
+	if(Other.Count == 0)
+	{
+		return;
+	}
+
+	Min = Count == 0 ? Other.Min : FMath::Min(Min, Other.Min);
+	Max = Count == 0 ? Other.Max : FMath::Max(Max, Other.Max);
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		Counts[Bucket] += Other.Counts[Bucket];
+	}
+	Count += Other.Count;
+}
+
+double FPomodoroQuantileSketch::GetQuantile(const double Quantile) const
+{
+	if(Count == 0)
+	{
+		return 0.0;
+	}
+
+	// Rank of the value wanted, the bucket holding it gives the estimate
+	const double Rank = FMath::Clamp(Quantile, 0.0, 1.0) * static_cast<double>(Count - 1);
+	uint64 Seen = 0;
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		Seen += Counts[Bucket];
+		if(static_cast<double>(Seen) > Rank)
+		{
+			return FMath::Clamp(PomodoroPercentiles::GetBucketValue(Bucket), Min, Max);
+		}
+	}
+	return Max;
+}
+
+uint64 FPomodoroQuantileSketch::GetCount() const
+{
+	return Count;
+}
+
+void FPomodoroQuantileSketch::Encode(TArray<uint8>& Bytes) const
+{
+	int32 UsedCount = 0;
+	for(const uint32 BucketValues : Counts)
+	{
+		UsedCount += BucketValues != 0 ? 1 : 0;
+	}
+
+	// Buckets as distance to the previous used one, a sketch of a day takes a few dozen bytes
+	PomodoroVarint::Write(Bytes, UsedCount);
+	int32 Previous = 0;
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		if(Counts[Bucket] != 0)
+		{
+			PomodoroVarint::Write(Bytes, Bucket - Previous);
+			PomodoroVarint::Write(Bytes, Counts[Bucket]);
+			Previous = Bucket;
+		}
+	}
+	PomodoroPercentiles::WriteRaw(Bytes, &Min, sizeof(Min));
+	PomodoroPercentiles::WriteRaw(Bytes, &Max, sizeof(Max));
+}
+
+bool FPomodoroQuantileSketch::Decode(const uint8*& Data, const uint8* End)
+{
+	*this = FPomodoroQuantileSketch();
+
+	uint64 UsedCount = 0;
+	if(!PomodoroVarint::Read(Data, End, UsedCount) || UsedCount > BucketCount)
+	{
+		return false;
+	}
+
+	uint64 Bucket = 0;
+	for(uint64 Index = 0; Index < UsedCount; ++Index)
+	{
+		uint64 Distance = 0;
+		uint64 BucketValues = 0;
+		if(!PomodoroVarint::Read(Data, End, Distance) || !PomodoroVarint::Read(Data, End, BucketValues))
+		{
+			return false;
+		}
+		Bucket += Distance;
+		if(Bucket >= BucketCount || BucketValues == 0 || BucketValues > MAX_uint32 || (Index > 0 && Distance == 0))
+		{
+			return false;
+		}
+		Counts[Bucket] = static_cast<uint32>(BucketValues);
+		Count += BucketValues;
+	}
+
+	return PomodoroPercentiles::ReadRaw(Data, End, &Min, sizeof(Min))
+		&& PomodoroPercentiles::ReadRaw(Data, End, &Max, sizeof(Max))
+		&& Min <= Max;
+}
+
+void FPomodoroPercentileSet::Add(const int32 Day, const EPomodoroPercentileMetric Metric, const EPomodoroPhase Phase, const double Seconds)
+{
+	Sketches.FindOrAdd(MakeKey(Day, Metric, Phase)).Add(Seconds);
+	++Version;
+}
+
+void FPomodoroPercentileSet::Merge(const FPomodoroPercentileSet& Other)
+{
+	for(const TPair<uint32, FPomodoroQuantileSketch>& Pair : Other.Sketches)
+	{
+		Sketches.FindOrAdd(Pair.Key).Merge(Pair.Value);
+	}
+	++Version;
+}
+
+FPomodoroQuantileSketch FPomodoroPercentileSet::Query(const EPomodoroPercentileMetric Metric, const TOptional<EPomodoroPhase> Phase, const int32 FromDay, const int32 ToDay) const
+{
+	FPomodoroQuantileSketch Merged;
+	for(int32 Day = FromDay; Day <= ToDay; ++Day)
+	{
+		for(int32 PhaseIndex = 0; PhaseIndex < PhaseCount; ++PhaseIndex)
+		{
+			const EPomodoroPhase Kind = static_cast<EPomodoroPhase>(PhaseIndex);
+			if(Phase.IsSet() && Phase.GetValue() != Kind)
+			{
+				continue;
+			}
+			if(const FPomodoroQuantileSketch* Sketch = Sketches.Find(MakeKey(Day, Metric, Kind)))
+			{
+				Merged.Merge(*Sketch);
+			}
+		}
+	}
+	return Merged;
+}
+
+uint32 FPomodoroPercentileSet::GetVersion() const
+{
+	return Version;
+}
+
+void FPomodoroPercentileSet::Save(TArray<uint8>& Bytes) const
+{
+	PomodoroPercentiles::WriteRaw(Bytes, &PomodoroPercentiles::Magic, sizeof(PomodoroPercentiles::Magic));
+	PomodoroPercentiles::WriteRaw(Bytes, &PomodoroPercentiles::Version, sizeof(PomodoroPercentiles::Version));
+
+	// Sorted, the keys are written as distances
+	TArray<uint32> Keys;
+	Sketches.GetKeys(Keys);
+	Keys.Sort();
+
+	PomodoroVarint::Write(Bytes, Keys.Num());
+	uint32 Previous = 0;
+	for(const uint32 Key : Keys)
+	{
+		PomodoroVarint::Write(Bytes, Key - Previous);
+		Sketches[Key].Encode(Bytes);
+		Previous = Key;
+	}
+}
+
+bool FPomodoroPercentileSet::Load(const TArrayView<const uint8> Bytes)
+{
+	Sketches.Reset();
+	++Version;
+
+	const uint8* Data = Bytes.GetData();
+	const uint8* End = Data + Bytes.Num();
+	uint32 Magic = 0;
+	uint32 FileVersion = 0;
+	uint64 SketchCount = 0;
+	if(!PomodoroPercentiles::ReadRaw(Data, End, &Magic, sizeof(Magic)) || !PomodoroPercentiles::ReadRaw(Data, End, &FileVersion, sizeof(FileVersion))
+		|| Magic != PomodoroPercentiles::Magic || FileVersion != PomodoroPercentiles::Version
+		|| !PomodoroVarint::Read(Data, End, SketchCount) || SketchCount > static_cast<uint64>(End - Data))
+	{
+		return false;
+	}
+
+	uint64 Key = 0;
+	for(uint64 Index = 0; Index < SketchCount; ++Index)
+	{
+		uint64 Distance = 0;
+		FPomodoroQuantileSketch Sketch;
+		if(!PomodoroVarint::Read(Data, End, Distance) || !Sketch.Decode(Data, End))
+		{
+			Sketches.Reset();
+			return false;
+		}
+		Key += Distance;
+		if(Key > MAX_uint32)
+		{
+			Sketches.Reset();
+			return false;
+		}
+		Sketches.FindOrAdd(static_cast<uint32>(Key)).Merge(Sketch);
+	}
+	return true;
+}
+
+uint32 FPomodoroPercentileSet::MakeKey(const int32 Day, const EPomodoroPercentileMetric Metric, const EPomodoroPhase Phase)
+{
+	return static_cast<uint32>(Day) << 4 | static_cast<uint32>(Metric) << 2 | static_cast<uint32>(Phase);
+}
+
+FPomodoroPercentiles::FPomodoroPercentiles(TSharedRef<FPomodoroEngine> InEngine)
+	: FPomodoroPercentiles(InEngine, ReadPercentilesFile())
+{
+}
+
+FPomodoroPercentiles::FPomodoroPercentiles(TSharedRef<FPomodoroEngine> InEngine, FPomodoroPercentileSet&& LoadedSet)
+	: Engine(InEngine)
+	, Set(MoveTemp(LoadedSet))
+{
+	LastSnapshot = Engine->GetSnapshotChannel()->Read();
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroPercentiles::OnEngineSnapshotPublished);
+}
+
+FPomodoroPercentiles::~FPomodoroPercentiles()
+{
+	Engine->OnSnapshotPublished().RemoveAll(this);
+	FPomodoroDeferredWork::Flush(PomodoroPercentiles::SaveKey);
+}
+
+const FPomodoroPercentileSet& FPomodoroPercentiles::GetSet() const
+{
+	return Set;
+}
+
+FString FPomodoroPercentiles::GetPercentilesPath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Pomodoro"), TEXT("Percentiles.bin"));
+}
+
+void FPomodoroPercentiles::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+	const FPomodoroEngineSnapshot Previous = LastSnapshot;
+	LastSnapshot = Snapshot;
+
+	// The leading editor samples for every editor of this machine
+	if(Engine->IsFollowing())
+	{
+		bPhaseOpen = false;
+		bOverrunOpen = false;
+		return;
+	}
+
+	const double NowSeconds = FPlatformTime::Seconds();
+	const bool bPhaseChanged = Previous.Phase != Snapshot.Phase || Previous.CurrentCycle != Snapshot.CurrentCycle;
+
+	// A pause ends by resuming or stopping the timer, resuming moves the deadline
+	if(bPhaseOpen && Previous.State == Paused && Snapshot.State != Paused)
+	{
+		const double PauseSeconds = NowSeconds - PauseStartSeconds;
+		PausedSeconds += PauseSeconds;
+		AddSample(EPomodoroPercentileMetric::Pause, Previous.Phase, PauseSeconds);
+	}
+
+	// Stopping resets the timespan, pausing keeps it
+	if(bPhaseOpen && Previous.State == Running && (Snapshot.State == Stopped || (Snapshot.State == Paused && !bPhaseChanged)))
+	{
+		AddSample(EPomodoroPercentileMetric::Interruption, Previous.Phase, NowSeconds - PhaseStartSeconds - PausedSeconds);
+		PauseStartSeconds = NowSeconds;
+	}
+
+	// The timespan ran to its end when the next one starts, it was given up when the timer stops
+	if(bPhaseOpen && (Snapshot.State == Stopped || bPhaseChanged))
+	{
+		bPhaseOpen = false;
+
+		// The user working on through a whole rest is counted up to the next timespan
+		if(bOverrunOpen)
+		{
+			CloseOverrun();
+		}
+
+		// The overrun runs from the real end of the working timespan, its published deadline
+		if(Snapshot.State != Stopped && Previous.State == Running && Previous.Phase == EPomodoroPhase::Working)
+		{
+			bOverrunOpen = true;
+			OverrunStartSeconds = NowSeconds + (Previous.DeadlineUtc - FDateTime::UtcNow()).GetTotalSeconds();
+			LastActivitySeconds = OverrunStartSeconds;
+		}
+	}
+
+	if(!bPhaseOpen && Snapshot.State == Running)
+	{
+		bPhaseOpen = true;
+		PhaseStartSeconds = NowSeconds;
+		PausedSeconds = 0.0;
+	}
+}
+
+void FPomodoroPercentiles::AddUserActivity(const double Seconds)
+{
+	if(!bOverrunOpen || Seconds <= LastActivitySeconds)
+	{
+		return;
+	}
+
+	// The user left, what they do when they come back is not part of the overrun
+	if(Seconds - LastActivitySeconds > PomodoroPercentiles::IdleSeconds)
+	{
+		CloseOverrun();
+		return;
+	}
+	LastActivitySeconds = Seconds;
+}
+
+void FPomodoroPercentiles::AddRecords(const TConstArrayView<FPomodoroPhaseRecord> Records)
+{
+	// The records are kept in UTC, the days are local
+	const FTimespan UtcOffset = FDateTime::Now() - FDateTime::UtcNow();
+	for(const FPomodoroPhaseRecord& Record : Records)
+	{
+		const int32 Day = FPomodoroFocusHistory::GetDay(FDateTime::FromUnixTimestamp(Record.StartSeconds) + UtcOffset);
+		for(int32 Pause = 0; Pause < Record.PauseCount && Record.PausedSeconds > 0; ++Pause)
+		{
+			Set.Add(Day, EPomodoroPercentileMetric::Pause, Record.Phase, static_cast<double>(Record.PausedSeconds) / Record.PauseCount);
+		}
+		if(!Record.bCompleted)
+		{
+			Set.Add(Day, EPomodoroPercentileMetric::Interruption, Record.Phase, Record.DurationSeconds);
+		}
+	}
+	RequestSave();
+}
+
+void FPomodoroPercentiles::AddSample(const EPomodoroPercentileMetric Metric, const EPomodoroPhase Phase, const double Seconds)
+{
+	Set.Add(FPomodoroFocusHistory::GetDay(FDateTime::Now()), Metric, Phase, Seconds);
+	RequestSave();
+}
+
+void FPomodoroPercentiles::CloseOverrun()
+{
+	bOverrunOpen = false;
+	AddSample(EPomodoroPercentileMetric::Overrun, EPomodoroPhase::Working, LastActivitySeconds - OverrunStartSeconds);
+}
+
+void FPomodoroPercentiles::RequestSave()
+{
+	FPomodoroDeferredWork::Enqueue(PomodoroPercentiles::SaveKey, EPomodoroWorkPriority::Low, PomodoroPercentiles::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+FPomodoroPercentileSet FPomodoroPercentiles::ReadPercentilesFile()
+{
+	FPomodoroPercentileSet Loaded;
+	TArray<uint8> Bytes;
+	if(FFileHelper::LoadFileToArray(Bytes, *GetPercentilesPath(), FILEREAD_Silent) && !Loaded.Load(Bytes))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Ignoring the percentiles %s, unknown format or truncated"), *GetPercentilesPath());
+	}
+	return Loaded;
+}
+
+void FPomodoroPercentiles::Save()
+{
+	TArray<uint8> Bytes;
+	Set.Save(Bytes);
+
+	if(!FFileHelper::SaveArrayToFile(Bytes, *GetPercentilesPath()))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't save the percentiles to %s"), *GetPercentilesPath());
+	}
+}
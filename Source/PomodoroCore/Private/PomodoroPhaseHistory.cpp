@@ -0,0 +1,764 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroPhaseHistory.h"
+
+#include "PomodoroCore.h"
+#include "PomodoroDeferredWork.h"
+#include "PomodoroVarint.h"
+#include "Algo/BinarySearch.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace PomodoroPhaseHistory
+{
+	constexpr uint32 Magic = 0x48504D50; // "PMPH"
+	constexpr uint32 Version = 2;
+
+	/** Version 1 records have no pause columns, they are sealed again when loaded */
+	constexpr uint32 VersionWithoutPauses = 1;
+
+	/** The head is sealed into a segment once it holds this many records, a few days of use */
+	constexpr int32 SealRecords = 64;
+
+	/** Neighbour segments are merged up to this many records, about a year of use */
+	constexpr int32 MaxSegmentRecords = 4096;
+
+	/** An imported record starting this close to a recorded one of the same kind is the same timespan */
+	constexpr int64 DuplicateSeconds = 60;
+
+	/** Key of the deferred save */
+	static const FName SaveKey(TEXT("PomodoroPhaseHistory"));
+
+	/** The head is saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 60.0;
+
+	/**
+	 * @brief Move an unreadable history file aside, so the next save doesn't overwrite what may still be recovered.
+	 * @param Path Path of the history file.
+	 * @param Reason Why the file can't be read, for the log.
+	 */
+	static void SetAside(const FString& Path, const TCHAR* Reason)
+	{
+		const FString CorruptPath = Path + FDateTime::Now().ToString(TEXT(".%Y%m%d-%H%M%S.corrupt"));
+		if(IFileManager::Get().Move(*CorruptPath, *Path, false))
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("The phase history %s is %s, moved to %s and started again"), *Path, Reason, *CorruptPath);
+		}
+		else
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("The phase history %s is %s and can't be moved aside, it will be overwritten"), *Path, Reason);
+		}
+	}
+
+	/**
+	 * @brief Encode records column by column, so the compression sees long runs of alike bytes.
+	 *
+	 * Start times are stored as delta-of-delta: regular timespans give small, mostly repeated values.
+	 * Durations are stored as the difference with the previous one, zero for most of them.
+	 */
+	static void Encode(const TArrayView<const FPomodoroPhaseRecord> Records, TArray<uint8>& Bytes)
+	{
+		int64 PreviousStart = 0;
+		int64 PreviousDelta = 0;
+		for(int32 Index = 0; Index < Records.Num(); ++Index)
+		{
+			const int64 Delta = Records[Index].StartSeconds - PreviousStart;
+			PomodoroVarint::Write(Bytes, PomodoroVarint::ZigZag(Index == 0 ? Records[Index].StartSeconds : Delta - PreviousDelta));
+			PreviousDelta = Index == 0 ? 0 : Delta;
+			PreviousStart = Records[Index].StartSeconds;
+		}
+
+		int32 PreviousDuration = 0;
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			PomodoroVarint::Write(Bytes, PomodoroVarint::ZigZag(static_cast<int64>(Record.DurationSeconds) - PreviousDuration));
+			PreviousDuration = Record.DurationSeconds;
+		}
+
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			PomodoroVarint::Write(Bytes, static_cast<uint64>(FMath::Max(0, Record.PausedSeconds)));
+		}
+
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			PomodoroVarint::Write(Bytes, static_cast<uint64>(FMath::Max(0, Record.PauseCount)));
+		}
+
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			Bytes.Add(static_cast<uint8>(Record.Phase) | (Record.bCompleted ? 0x80 : 0));
+		}
+	}
+
+	/**
+	 * @brief Decode the records written by Encode.
+	 * @return False if the bytes are invalid, the records already decoded are kept.
+	 */
+	static bool Decode(const uint8* Data, const int32 Size, const int32 Count, TArray<FPomodoroPhaseRecord>& Records, const bool bHasPauses = true)
+	{
+		// Every record takes at least a byte per column, a larger count comes from a corrupted file
+		if(Count < 0 || static_cast<int64>(Count) * (bHasPauses ? 5 : 3) > Size)
+		{
+			return false;
+		}
+
+		const uint8* End = Data + Size;
+		const int32 First = Records.AddDefaulted(Count);
+
+		int64 PreviousStart = 0;
+		int64 PreviousDelta = 0;
+		for(int32 Index = 0; Index < Count; ++Index)
+		{
+			uint64 Value = 0;
+			if(!PomodoroVarint::Read(Data, End, Value))
+			{
+				Records.SetNum(First);
+				return false;
+			}
+			const int64 Delta = Index == 0 ? PomodoroVarint::UnZigZag(Value) : PreviousDelta + PomodoroVarint::UnZigZag(Value);
+			PreviousDelta = Index == 0 ? 0 : Delta;
+			PreviousStart += Delta;
+			Records[First + Index].StartSeconds = PreviousStart;
+		}
+
+		int64 PreviousDuration = 0;
+		for(int32 Index = 0; Index < Count; ++Index)
+		{
+			uint64 Value = 0;
+			if(!PomodoroVarint::Read(Data, End, Value))
+			{
+				Records.SetNum(First);
+				return false;
+			}
+			PreviousDuration += PomodoroVarint::UnZigZag(Value);
+			Records[First + Index].DurationSeconds = static_cast<int32>(PreviousDuration);
+		}
+
+		for(int32 Column = 0; Column < (bHasPauses ? 2 : 0); ++Column)
+		{
+			for(int32 Index = 0; Index < Count; ++Index)
+			{
+				uint64 Value = 0;
+				if(!PomodoroVarint::Read(Data, End, Value) || Value > MAX_int32)
+				{
+					Records.SetNum(First);
+					return false;
+				}
+				int32& Field = Column == 0 ? Records[First + Index].PausedSeconds : Records[First + Index].PauseCount;
+				Field = static_cast<int32>(Value);
+			}
+		}
+
+		if(End - Data != Count)
+		{
+			Records.SetNum(First);
+			return false;
+		}
+		for(int32 Index = 0; Index < Count; ++Index)
+		{
+			const uint8 Flags = *Data++;
+			Records[First + Index].Phase = static_cast<EPomodoroPhase>(FMath::Min<uint8>(Flags & 0x7F, static_cast<uint8>(EPomodoroPhase::LongResting)));
+			Records[First + Index].bCompleted = (Flags & 0x80) != 0;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Encode and compress records into a segment.
+	 */
+	static TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> BuildSegment(const TArrayView<const FPomodoroPhaseRecord> Records)
+	{
+		const TSharedRef<FPomodoroPhaseSegment, ESPMode::ThreadSafe> Segment = MakeShared<FPomodoroPhaseSegment, ESPMode::ThreadSafe>();
+		Segment->Count = Records.Num();
+		Segment->MinSeconds = MAX_int64;
+		Segment->MaxSeconds = MIN_int64;
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			Segment->MinSeconds = FMath::Min(Segment->MinSeconds, Record.StartSeconds);
+			Segment->MaxSeconds = FMath::Max(Segment->MaxSeconds, Record.StartSeconds);
+		}
+
+		TArray<uint8> Raw;
+		Encode(Records, Raw);
+		Segment->RawSize = Raw.Num();
+
+		// A payload as large as the raw size is stored uncompressed
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Raw.Num());
+		Segment->Payload.SetNumUninitialized(CompressedSize);
+		if(FCompression::CompressMemory(NAME_Zlib, Segment->Payload.GetData(), CompressedSize, Raw.GetData(), Raw.Num())
+			&& CompressedSize < Raw.Num())
+		{
+			Segment->Payload.SetNum(CompressedSize);
+		}
+		else
+		{
+			Segment->Payload = MoveTemp(Raw);
+		}
+		return Segment;
+	}
+
+	/**
+	 * @brief Decompress and decode the records of a segment.
+	 * @return False if the segment is invalid.
+	 */
+	static bool DecodeSegment(const FPomodoroPhaseSegment& Segment, TArray<FPomodoroPhaseRecord>& Records, const bool bHasPauses = true)
+	{
+		if(Segment.Payload.Num() == Segment.RawSize)
+		{
+			return Decode(Segment.Payload.GetData(), Segment.RawSize, Segment.Count, Records, bHasPauses);
+		}
+
+		TArray<uint8> Raw;
+		Raw.SetNumUninitialized(Segment.RawSize);
+		if(!FCompression::UncompressMemory(NAME_Zlib, Raw.GetData(), Raw.Num(), Segment.Payload.GetData(), Segment.Payload.Num()))
+		{
+			return false;
+		}
+		return Decode(Raw.GetData(), Raw.Num(), Segment.Count, Records, bHasPauses);
+	}
+}
+
+FPomodoroPhaseHistory::FPomodoroPhaseHistory(TSharedRef<FPomodoroEngine> InEngine)
+	: FPomodoroPhaseHistory(InEngine, ReadHistoryFile())
+{
+}
+
+FPomodoroPhaseHistory::FPomodoroPhaseHistory(TSharedRef<FPomodoroEngine> InEngine, FPomodoroPhaseHistoryFile&& Loaded, const FString& InPath)
+	: Engine(InEngine)
+	, Path(InPath)
+	, Segments(MoveTemp(Loaded.Segments))
+	, Head(MoveTemp(Loaded.Head))
+	, SealedCount(Loaded.SealedCount)
+{
+	LastSnapshot = Engine->GetSnapshotChannel()->Read();
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroPhaseHistory::OnEngineSnapshotPublished);
+}
+
+FPomodoroPhaseHistory::~FPomodoroPhaseHistory()
+{
+	Engine->OnSnapshotPublished().RemoveAll(this);
+	if(bPhaseOpen)
+	{
+		ClosePhase(false, FPlatformTime::Seconds());
+	}
+
+	// The compaction works on this history, and saves once done
+	if(Compaction.IsValid())
+	{
+		Compaction.Wait();
+	}
+	FPomodoroDeferredWork::Flush(PomodoroPhaseHistory::SaveKey);
+}
+
+void FPomodoroPhaseHistory::Append(const FPomodoroPhaseRecord& Record)
+{
+	int32 HeadCount;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Head.Add(Record);
+		HeadCount = Head.Num();
+	}
+	++Version;
+	PhaseRecordedEvent.Broadcast(Record);
+
+	if(HeadCount >= PomodoroPhaseHistory::SealRecords && (!Compaction.IsValid() || Compaction.IsReady()))
+	{
+		Compaction = Async(EAsyncExecution::ThreadPool, [this]()
+		{
+			Compact();
+		});
+		return;
+	}
+
+	FPomodoroDeferredWork::Enqueue(PomodoroPhaseHistory::SaveKey, EPomodoroWorkPriority::Low, PomodoroPhaseHistory::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+void FPomodoroPhaseHistory::Import(TArray<FPomodoroPhaseRecord> Records, TUniqueFunction<void(TArray<FPomodoroPhaseRecord>&&)> OnImported)
+{
+	// Run after the running compaction, and holds the place of the next one : both rewrite the segments
+	TFuture<void> Previous = MoveTemp(Compaction);
+	Compaction = Async(EAsyncExecution::ThreadPool, [this, Previous = MoveTemp(Previous), Records = MoveTemp(Records), OnImported = MoveTemp(OnImported)]() mutable
+	{
+		if(Previous.IsValid())
+		{
+			Previous.Wait();
+		}
+		OnImported(Merge(MoveTemp(Records)));
+	});
+}
+
+void FPomodoroPhaseHistory::ForEachRecord(const FDateTime& FromUtc, const FDateTime& ToUtc, TFunctionRef<void(const FPomodoroPhaseRecord&)> Visitor) const
+{
+	const int64 FromSeconds = FromUtc.ToUnixTimestamp();
+	const int64 ToSeconds = ToUtc.ToUnixTimestamp();
+
+	// Only the segments overlapping the range are decoded, outside of the lock
+	TArray<FSegmentRef, TInlineAllocator<8>> Touched;
+	TArray<FPomodoroPhaseRecord> HeadRecords;
+	{
+		FScopeLock ScopeLock(&Lock);
+		for(const FSegmentRef& Segment : Segments)
+		{
+			if(Segment->MaxSeconds >= FromSeconds && Segment->MinSeconds < ToSeconds)
+			{
+				Touched.Add(Segment);
+			}
+		}
+		HeadRecords = Head;
+	}
+
+	TArray<FPomodoroPhaseRecord> Records;
+	for(const FSegmentRef& Segment : Touched)
+	{
+		Records.Reset();
+		if(!PomodoroPhaseHistory::DecodeSegment(*Segment, Records))
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("Skipping a corrupted block of the phase history"));
+			continue;
+		}
+		for(const FPomodoroPhaseRecord& Record : Records)
+		{
+			if(Record.StartSeconds >= FromSeconds && Record.StartSeconds < ToSeconds)
+			{
+				Visitor(Record);
+			}
+		}
+	}
+
+	for(const FPomodoroPhaseRecord& Record : HeadRecords)
+	{
+		if(Record.StartSeconds >= FromSeconds && Record.StartSeconds < ToSeconds)
+		{
+			Visitor(Record);
+		}
+	}
+}
+
+FPhaseRecorded& FPomodoroPhaseHistory::OnPhaseRecorded()
+{
+	return PhaseRecordedEvent;
+}
+
+TOptional<FPomodoroPhaseRecord> FPomodoroPhaseHistory::GetLastRecord() const
+{
+	TSharedPtr<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> LastSegment;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if(Head.Num() > 0)
+		{
+			return Head.Last();
+		}
+		if(Segments.Num() > 0)
+		{
+			LastSegment = Segments.Last();
+		}
+	}
+
+	// Only the last segment is decoded
+	TArray<FPomodoroPhaseRecord> Records;
+	if(LastSegment.IsValid() && PomodoroPhaseHistory::DecodeSegment(*LastSegment, Records) && Records.Num() > 0)
+	{
+		return Records.Last();
+	}
+	return TOptional<FPomodoroPhaseRecord>();
+}
+
+int32 FPomodoroPhaseHistory::GetRecordCount() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return SealedCount + Head.Num();
+}
+
+uint32 FPomodoroPhaseHistory::GetVersion() const
+{
+	return Version;
+}
+
+TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> FPomodoroPhaseHistory::BuildSegment(const TArrayView<const FPomodoroPhaseRecord> Records)
+{
+	return PomodoroPhaseHistory::BuildSegment(Records);
+}
+
+bool FPomodoroPhaseHistory::DecodeSegment(const FPomodoroPhaseSegment& Segment, TArray<FPomodoroPhaseRecord>& OutRecords)
+{
+	return PomodoroPhaseHistory::DecodeSegment(Segment, OutRecords);
+}
+
+FString FPomodoroPhaseHistory::GetHistoryPath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Pomodoro"), TEXT("PhaseHistory.bin"));
+}
+
+void FPomodoroPhaseHistory::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+	const FPomodoroEngineSnapshot Previous = LastSnapshot;
+	LastSnapshot = Snapshot;
+
+	// The leading editor records for every editor of this machine
+	if(Engine->IsFollowing())
+	{
+		bPhaseOpen = false;
+		bRunning = false;
+		return;
+	}
+
+	const double NowSeconds = FPlatformTime::Seconds();
+	if(bPhaseOpen && (Snapshot.State == Stopped || Previous.Phase != Snapshot.Phase || Previous.CurrentCycle != Snapshot.CurrentCycle))
+	{
+		ClosePhase(Snapshot.State != Stopped, NowSeconds);
+	}
+
+	if(bPhaseOpen && Previous.State == Running && Snapshot.State == Paused)
+	{
+		++OpenRecord.PauseCount;
+	}
+
+	if(Snapshot.State != Running)
+	{
+		if(bRunning)
+		{
+			RunSeconds += NowSeconds - RunStartSeconds;
+			bRunning = false;
+		}
+		return;
+	}
+
+	if(!bPhaseOpen)
+	{
+		bPhaseOpen = true;
+		OpenRecord = FPomodoroPhaseRecord();
+		OpenRecord.StartSeconds = FDateTime::UtcNow().ToUnixTimestamp();
+		OpenRecord.Phase = Snapshot.Phase;
+		OpenSeconds = NowSeconds;
+		RunSeconds = 0.0;
+	}
+	if(!bRunning)
+	{
+		bRunning = true;
+		RunStartSeconds = NowSeconds;
+	}
+}
+
+void FPomodoroPhaseHistory::ClosePhase(const bool bCompleted, const double NowSeconds)
+{
+	if(bRunning)
+	{
+		RunSeconds += NowSeconds - RunStartSeconds;
+		bRunning = false;
+	}
+
+	bPhaseOpen = false;
+	OpenRecord.DurationSeconds = FMath::RoundToInt(RunSeconds);
+	OpenRecord.PausedSeconds = FMath::Max(0, FMath::RoundToInt(NowSeconds - OpenSeconds - RunSeconds));
+	OpenRecord.bCompleted = bCompleted;
+	Append(OpenRecord);
+}
+
+void FPomodoroPhaseHistory::Compact()
+{
+	// Only this task changes the segments, the writers keep appending to the head meanwhile
+	TArray<FPomodoroPhaseRecord> Sealing;
+	TArray<FSegmentRef> Sealed;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Sealing = Head;
+		Sealed = Segments;
+	}
+	if(Sealing.Num() > 0)
+	{
+		Sealed.Add(PomodoroPhaseHistory::BuildSegment(Sealing));
+	}
+
+	// Small neighbours are merged, full segments are never decoded again
+	TArray<FSegmentRef> Merged;
+	TArray<FPomodoroPhaseRecord> Records;
+	for(const FSegmentRef& Segment : Sealed)
+	{
+		if(Merged.Num() > 0 && Merged.Last()->Count + Segment->Count <= PomodoroPhaseHistory::MaxSegmentRecords)
+		{
+			Records.Reset();
+			if(PomodoroPhaseHistory::DecodeSegment(*Merged.Last(), Records) && PomodoroPhaseHistory::DecodeSegment(*Segment, Records))
+			{
+				Merged.Last() = PomodoroPhaseHistory::BuildSegment(Records);
+				continue;
+			}
+		}
+		Merged.Add(Segment);
+	}
+
+	int32 PayloadBytes = 0;
+	for(const FSegmentRef& Segment : Merged)
+	{
+		PayloadBytes += Segment->Payload.Num();
+	}
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		Head.RemoveAt(0, Sealing.Num(), false);
+		Segments = MoveTemp(Merged);
+		SealedCount += Sealing.Num();
+		UE_LOG(LogPomodoro, Verbose, TEXT("Phase history compacted, %d records in %d blocks of %d bytes"), SealedCount, Segments.Num(), PayloadBytes);
+	}
+	++Version;
+
+	Save();
+}
+
+TArray<FPomodoroPhaseRecord> FPomodoroPhaseHistory::Merge(TArray<FPomodoroPhaseRecord> Imported)
+{
+	// The head is sealed with the rest, the writers keep appending to it meanwhile
+	TArray<FPomodoroPhaseRecord> Sealing;
+	TArray<FSegmentRef> Sealed;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Sealing = Head;
+		Sealed = Segments;
+	}
+
+	TArray<FPomodoroPhaseRecord> Existing;
+	for(const FSegmentRef& Segment : Sealed)
+	{
+		if(!PomodoroPhaseHistory::DecodeSegment(*Segment, Existing))
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("Skipping a corrupted block of the phase history"));
+		}
+	}
+	Existing.Append(Sealing);
+
+	const auto ByStart = [](const FPomodoroPhaseRecord& A, const FPomodoroPhaseRecord& B)
+	{
+		return A.StartSeconds < B.StartSeconds;
+	};
+	Existing.StableSort(ByStart);
+	Imported.StableSort(ByStart);
+
+	// Another tool records the timespans of this one a few seconds apart, but the timespans of an export are distinct but for its exact copies
+	TArray<FPomodoroPhaseRecord> Added;
+	for(int32 ImportedIndex = 0; ImportedIndex < Imported.Num(); ++ImportedIndex)
+	{
+		const FPomodoroPhaseRecord& Record = Imported[ImportedIndex];
+		bool bDuplicate = false;
+		for(int32 Index = ImportedIndex - 1; Index >= 0 && Imported[Index].StartSeconds == Record.StartSeconds; --Index)
+		{
+			bDuplicate |= Imported[Index].DurationSeconds == Record.DurationSeconds && Imported[Index].Phase == Record.Phase;
+		}
+		if(bDuplicate)
+		{
+			continue;
+		}
+
+		const int32 First = Algo::LowerBoundBy(Existing, Record.StartSeconds - PomodoroPhaseHistory::DuplicateSeconds + 1, [](const FPomodoroPhaseRecord& Other)
+		{
+			return Other.StartSeconds;
+		});
+		for(int32 Index = First; Index < Existing.Num() && Existing[Index].StartSeconds < Record.StartSeconds + PomodoroPhaseHistory::DuplicateSeconds; ++Index)
+		{
+			bDuplicate |= Existing[Index].Phase == Record.Phase;
+		}
+		if(!bDuplicate)
+		{
+			Added.Add(Record);
+		}
+	}
+	if(Added.Num() == 0)
+	{
+		return Added;
+	}
+
+	TArray<FPomodoroPhaseRecord> Records = MoveTemp(Existing);
+	Records.Append(Added);
+	Records.StableSort(ByStart);
+
+	// Full segments from the start, built in parallel
+	const int32 SegmentCount = FMath::DivideAndRoundUp(Records.Num(), PomodoroPhaseHistory::MaxSegmentRecords);
+	TArray<TOptional<FSegmentRef>> Built;
+	Built.SetNum(SegmentCount);
+	ParallelFor(SegmentCount, [&Records, &Built](const int32 Index)
+	{
+		const int32 First = Index * PomodoroPhaseHistory::MaxSegmentRecords;
+		const int32 Count = FMath::Min(PomodoroPhaseHistory::MaxSegmentRecords, Records.Num() - First);
+		Built[Index] = PomodoroPhaseHistory::BuildSegment(TArrayView<const FPomodoroPhaseRecord>(Records.GetData() + First, Count));
+	});
+
+	TArray<FSegmentRef> Merged;
+	Merged.Reserve(SegmentCount);
+	for(const TOptional<FSegmentRef>& Segment : Built)
+	{
+		Merged.Add(Segment.GetValue());
+	}
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		Head.RemoveAt(0, Sealing.Num(), false);
+		Segments = MoveTemp(Merged);
+		SealedCount = Records.Num();
+		UE_LOG(LogPomodoro, Log, TEXT("Phase history imported %d records, %d records in %d blocks"), Added.Num(), SealedCount, Segments.Num());
+	}
+	++Version;
+
+	Save();
+	return Added;
+}
+
+FPomodoroPhaseHistoryFile FPomodoroPhaseHistory::ReadHistoryFile()
+{
+	FPomodoroPhaseHistoryFile Loaded;
+	TArray<uint8> Bytes;
+	if(!FFileHelper::LoadFileToArray(Bytes, *GetHistoryPath(), FILEREAD_Silent))
+	{
+		return Loaded;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 FileVersion = 0;
+	Reader << Magic << FileVersion;
+	const bool bHasPauses = FileVersion != PomodoroPhaseHistory::VersionWithoutPauses;
+	if(Magic != PomodoroPhaseHistory::Magic || (FileVersion != PomodoroPhaseHistory::Version && bHasPauses))
+	{
+		PomodoroPhaseHistory::SetAside(GetHistoryPath(), TEXT("of an unknown format"));
+		return Loaded;
+	}
+
+	// Every size is checked against what is left, a truncated file is never trusted
+	const auto ReadPayload = [&Reader](TArray<uint8>& Payload)
+	{
+		int32 Size = 0;
+		Reader << Size;
+		if(Reader.IsError() || Size < 0 || Size > Reader.TotalSize() - Reader.Tell())
+		{
+			Reader.SetError();
+			return;
+		}
+		Payload.SetNumUninitialized(Size);
+		Reader.Serialize(Payload.GetData(), Size);
+	};
+
+	int32 SegmentCount = 0;
+	Reader << SegmentCount;
+	TArray<FSegmentRef> LoadedSegments;
+	int32 LoadedCount = 0;
+	for(int32 Index = 0; Index < SegmentCount && !Reader.IsError(); ++Index)
+	{
+		const TSharedRef<FPomodoroPhaseSegment, ESPMode::ThreadSafe> Segment = MakeShared<FPomodoroPhaseSegment, ESPMode::ThreadSafe>();
+		Reader << Segment->MinSeconds << Segment->MaxSeconds << Segment->Count << Segment->RawSize;
+		ReadPayload(Segment->Payload);
+		if(Segment->Count < 0 || Segment->RawSize < 0)
+		{
+			Reader.SetError();
+		}
+		LoadedCount += Segment->Count;
+
+		// Older blocks are sealed again with the pause columns, once
+		TArray<FPomodoroPhaseRecord> Records;
+		if(!bHasPauses && !Reader.IsError())
+		{
+			if(!PomodoroPhaseHistory::DecodeSegment(*Segment, Records, false))
+			{
+				Reader.SetError();
+				break;
+			}
+			LoadedSegments.Add(PomodoroPhaseHistory::BuildSegment(Records));
+			continue;
+		}
+		LoadedSegments.Add(Segment);
+	}
+
+	int32 HeadCount = 0;
+	TArray<uint8> HeadBytes;
+	Reader << HeadCount;
+	ReadPayload(HeadBytes);
+
+	TArray<FPomodoroPhaseRecord> LoadedHead;
+	if(Reader.IsError() || SegmentCount < 0 || HeadCount < 0
+		|| !PomodoroPhaseHistory::Decode(HeadBytes.GetData(), HeadBytes.Num(), HeadCount, LoadedHead, bHasPauses))
+	{
+		PomodoroPhaseHistory::SetAside(GetHistoryPath(), TEXT("truncated"));
+		return Loaded;
+	}
+
+	// Blocks are decoded lazily afterwards, a block failing to decompress now would silently be dropped by the next merge
+	std::atomic<bool> bCorrupted{false};
+	ParallelFor(LoadedSegments.Num(), [&LoadedSegments, &bCorrupted](const int32 Index)
+	{
+		TArray<FPomodoroPhaseRecord> Records;
+		if(!PomodoroPhaseHistory::DecodeSegment(*LoadedSegments[Index], Records))
+		{
+			bCorrupted.store(true, std::memory_order_relaxed);
+		}
+	});
+	if(bCorrupted.load(std::memory_order_relaxed))
+	{
+		PomodoroPhaseHistory::SetAside(GetHistoryPath(), TEXT("corrupted"));
+		return Loaded;
+	}
+
+	Loaded.Segments = MoveTemp(LoadedSegments);
+	Loaded.SealedCount = LoadedCount;
+	Loaded.Head = MoveTemp(LoadedHead);
+	return Loaded;
+}
+
+void FPomodoroPhaseHistory::Save()
+{
+	// Held from the copy to the write, an older copy never overwrites a newer file
+	FScopeLock FileScopeLock(&FileLock);
+
+	TArray<FSegmentRef> SavedSegments;
+	TArray<FPomodoroPhaseRecord> SavedHead;
+	{
+		FScopeLock ScopeLock(&Lock);
+		SavedSegments = Segments;
+		SavedHead = Head;
+	}
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = PomodoroPhaseHistory::Magic;
+	uint32 FileVersion = PomodoroPhaseHistory::Version;
+	int32 SegmentCount = SavedSegments.Num();
+	Writer << Magic << FileVersion << SegmentCount;
+
+	const auto WritePayload = [&Writer](const TArray<uint8>& Payload)
+	{
+		int32 Size = Payload.Num();
+		Writer << Size;
+		Writer.Serialize(const_cast<uint8*>(Payload.GetData()), Size);
+	};
+
+	for(const FSegmentRef& Segment : SavedSegments)
+	{
+		int64 MinSeconds = Segment->MinSeconds;
+		int64 MaxSeconds = Segment->MaxSeconds;
+		int32 Count = Segment->Count;
+		int32 RawSize = Segment->RawSize;
+		Writer << MinSeconds << MaxSeconds << Count << RawSize;
+		WritePayload(Segment->Payload);
+	}
+
+	// The head is small, it is kept encoded but not compressed
+	int32 HeadCount = SavedHead.Num();
+	TArray<uint8> HeadBytes;
+	PomodoroPhaseHistory::Encode(SavedHead, HeadBytes);
+	Writer << HeadCount;
+	WritePayload(HeadBytes);
+
+	// Written aside then moved, an interrupted save never loses the years already recorded
+	const FString TempPath = Path + TEXT(".tmp");
+	if(!FFileHelper::SaveArrayToFile(Bytes, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't save the phase history to %s"), *Path);
+	}
+}
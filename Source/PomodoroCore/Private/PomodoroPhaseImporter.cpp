@@ -0,0 +1,893 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroPhaseImporter.h"
+
+#include "PomodoroCore.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Runtime/Launch/Resources/Version.h"
+#if ENGINE_MAJOR_VERSION >= 5
+#include "HAL/PlatformFileManager.h"
+#else
+#include "HAL/PlatformFilemanager.h"
+#endif
+
+namespace PomodoroPhaseImporter
+{
+	/** Smaller chunks cost more to schedule than to parse */
+	constexpr int64 MinChunkBytes = 1 << 20;
+
+	/** Chunks per worker, so a slow chunk doesn't leave the other workers idle */
+	constexpr int32 ChunksPerWorker = 4;
+
+	/** Longer timespans are not Pomodoro timespans, a whole day tracked for instance */
+	constexpr int64 MaxDurationSeconds = 24 * 60 * 60;
+
+	/** Earlier times are parsing mistakes */
+	constexpr int64 MinStartSeconds = 631152000; // 1990-01-01
+
+	/**
+	 * @brief Value a column or a key holds
+	 */
+	enum class EField : uint8
+	{
+		Start,
+		End,
+		Duration,
+		DurationMinutes,
+		Phase,
+		Completed,
+		Paused,
+		PauseCount,
+		None,
+	};
+
+	constexpr int32 FieldCount = static_cast<int32>(EField::None);
+
+	/**
+	 * @brief Values of a record, by field.
+	 */
+	typedef FString FValues[FieldCount];
+
+	/**
+	 * @brief Records read from a chunk.
+	 */
+	struct FChunk
+	{
+		TArray<FPomodoroPhaseRecord> Records;
+		int32 SkippedCount = 0;
+	};
+
+	/**
+	 * @brief Give the value of a column or a key from its name, the names of the common tools are recognized.
+	 */
+	static EField GetField(const FString& Name)
+	{
+		// Only the letters are compared, "Start Time" and "start_time" are the same
+		FString Key;
+		for(const TCHAR Character : Name)
+		{
+			if(FChar::IsAlnum(Character))
+			{
+				Key.AppendChar(FChar::ToLower(Character));
+			}
+		}
+
+		static const TMap<FString, EField> Fields =
+		{
+			{TEXT("start"), EField::Start}, {TEXT("starttime"), EField::Start}, {TEXT("started"), EField::Start},
+			{TEXT("startedat"), EField::Start}, {TEXT("startdate"), EField::Start}, {TEXT("begin"), EField::Start},
+			{TEXT("from"), EField::Start}, {TEXT("timestamp"), EField::Start},
+			{TEXT("end"), EField::End}, {TEXT("endtime"), EField::End}, {TEXT("ended"), EField::End},
+			{TEXT("endedat"), EField::End}, {TEXT("enddate"), EField::End}, {TEXT("stop"), EField::End},
+			{TEXT("finishedat"), EField::End}, {TEXT("to"), EField::End},
+			{TEXT("duration"), EField::Duration}, {TEXT("durationseconds"), EField::Duration},
+			{TEXT("seconds"), EField::Duration}, {TEXT("length"), EField::Duration},
+			{TEXT("minutes"), EField::DurationMinutes}, {TEXT("durationminutes"), EField::DurationMinutes},
+			{TEXT("type"), EField::Phase}, {TEXT("phase"), EField::Phase}, {TEXT("kind"), EField::Phase},
+			{TEXT("mode"), EField::Phase}, {TEXT("category"), EField::Phase},
+			{TEXT("completed"), EField::Completed}, {TEXT("complete"), EField::Completed},
+			{TEXT("finished"), EField::Completed}, {TEXT("status"), EField::Completed},
+			{TEXT("paused"), EField::Paused}, {TEXT("pausedseconds"), EField::Paused}, {TEXT("pause"), EField::Paused},
+			{TEXT("pausecount"), EField::PauseCount}, {TEXT("pauses"), EField::PauseCount}, {TEXT("interruptions"), EField::PauseCount},
+		};
+		const EField* Field = Fields.Find(Key);
+		return Field != nullptr ? *Field : EField::None;
+	}
+
+	static void AppendUtf8(FString& Out, const uint8* Begin, const uint8* End)
+	{
+		if(End > Begin)
+		{
+			const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Begin), static_cast<int32>(End - Begin));
+			Out.Append(Converted.Get(), Converted.Length());
+		}
+	}
+
+	/**
+	 * @brief Read a Unix time in seconds from a number or an ISO 8601 text, local unless it gives its offset.
+	 */
+	static bool ParseTime(const FString& Value, const FTimespan LocalOffset, int64& OutSeconds)
+	{
+		if(Value.IsNumeric())
+		{
+			// Milliseconds for anything past the year 5138 in seconds
+			double Number = FCString::Atod(*Value);
+			Number = Number > 1e11 ? Number / 1000.0 : Number;
+			OutSeconds = static_cast<int64>(Number);
+			return true;
+		}
+
+		// "2023-04-01 09:30:00" is read as "2023-04-01T09:30:00"
+		FString Iso = Value;
+		int32 Space = INDEX_NONE;
+		if(Iso.FindChar(TEXT(' '), Space) && Space == 10)
+		{
+			Iso[Space] = TEXT('T');
+		}
+		// Without an offset after the date, the time is a local time
+		FDateTime Time;
+		if(FDateTime::ParseIso8601(*Iso, Time))
+		{
+			const FString TimeOfDay = Iso.Mid(10);
+			int32 Sign = INDEX_NONE;
+			const bool bHasOffset = TimeOfDay.FindChar(TEXT('Z'), Sign) || TimeOfDay.FindChar(TEXT('z'), Sign)
+				|| TimeOfDay.FindChar(TEXT('+'), Sign) || TimeOfDay.FindChar(TEXT('-'), Sign);
+			OutSeconds = (bHasOffset ? Time : Time - LocalOffset).ToUnixTimestamp();
+			return true;
+		}
+		if(FDateTime::Parse(Value, Time))
+		{
+			OutSeconds = (Time - LocalOffset).ToUnixTimestamp();
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Read a length in seconds from a number or a [h:]mm:ss text.
+	 */
+	static bool ParseDuration(const FString& Value, const double UnitSeconds, int64& OutSeconds)
+	{
+		if(Value.IsNumeric())
+		{
+			OutSeconds = FMath::RoundToInt64(FCString::Atod(*Value) * UnitSeconds);
+			return true;
+		}
+
+		TArray<FString> Parts;
+		Value.ParseIntoArray(Parts, TEXT(":"));
+		if(Parts.Num() < 2 || Parts.Num() > 3)
+		{
+			return false;
+		}
+		OutSeconds = 0;
+		for(const FString& Part : Parts)
+		{
+			if(!Part.IsNumeric())
+			{
+				return false;
+			}
+			OutSeconds = OutSeconds * 60 + FCString::Atoi64(*Part);
+		}
+		return true;
+	}
+
+	static EPomodoroPhase ParsePhase(const FString& Value)
+	{
+		if(Value.Contains(TEXT("long")))
+		{
+			return EPomodoroPhase::LongResting;
+		}
+		if(Value.Contains(TEXT("break")) || Value.Contains(TEXT("rest")) || Value.Contains(TEXT("pause")))
+		{
+			return EPomodoroPhase::ShortResting;
+		}
+		return EPomodoroPhase::Working;
+	}
+
+	static bool ParseCompleted(const FString& Value)
+	{
+		return Value.IsEmpty() || Value == TEXT("1") || Value.Equals(TEXT("true"), ESearchCase::IgnoreCase)
+			|| Value.Equals(TEXT("yes"), ESearchCase::IgnoreCase) || Value.Equals(TEXT("done"), ESearchCase::IgnoreCase)
+			|| Value.Equals(TEXT("completed"), ESearchCase::IgnoreCase) || Value.Equals(TEXT("finished"), ESearchCase::IgnoreCase);
+	}
+
+	/**
+	 * @brief Make a timespan from the values of a record.
+	 * @return False if the record misses its start or its length.
+	 */
+	static bool MakeRecord(const FValues& Values, const FTimespan LocalOffset, FPomodoroPhaseRecord& OutRecord)
+	{
+		int64 Start = 0;
+		if(!ParseTime(Values[static_cast<int32>(EField::Start)], LocalOffset, Start) || Start < MinStartSeconds)
+		{
+			return false;
+		}
+
+		// The length is given, or the end
+		int64 Duration = -1;
+		int64 End = 0;
+		if(!ParseDuration(Values[static_cast<int32>(EField::Duration)], 1.0, Duration)
+			&& !ParseDuration(Values[static_cast<int32>(EField::DurationMinutes)], 60.0, Duration)
+			&& ParseTime(Values[static_cast<int32>(EField::End)], LocalOffset, End))
+		{
+			Duration = End - Start;
+		}
+		if(Duration < 0 || Duration > MaxDurationSeconds)
+		{
+			return false;
+		}
+
+		int64 Paused = 0;
+		int64 PauseCount = 0;
+		ParseDuration(Values[static_cast<int32>(EField::Paused)], 1.0, Paused);
+		ParseDuration(Values[static_cast<int32>(EField::PauseCount)], 1.0, PauseCount);
+
+		OutRecord.StartSeconds = Start;
+		OutRecord.DurationSeconds = static_cast<int32>(Duration);
+		OutRecord.PausedSeconds = static_cast<int32>(FMath::Clamp<int64>(Paused, 0, MaxDurationSeconds));
+		OutRecord.PauseCount = static_cast<int32>(FMath::Clamp<int64>(PauseCount, 0, MaxDurationSeconds));
+		OutRecord.Phase = ParsePhase(Values[static_cast<int32>(EField::Phase)].ToLower());
+		OutRecord.bCompleted = ParseCompleted(Values[static_cast<int32>(EField::Completed)]);
+		return true;
+	}
+
+	/**
+	 * @brief Split a CSV line into its fields.
+	 * @param Visitor Called with the index and the unquoted text of each field.
+	 */
+	static void SplitCsvLine(const uint8* Data, const uint8* End, const uint8 Delimiter, TFunctionRef<void(int32, FString&&)> Visitor)
+	{
+		int32 Index = 0;
+		while(Data <= End)
+		{
+			FString Field;
+			if(Data < End && *Data == '"')
+			{
+				// Quotes inside a quoted field are doubled
+				const uint8* Run = ++Data;
+				while(Data < End && !(*Data == '"' && (Data + 1 >= End || Data[1] != '"')))
+				{
+					if(*Data == '"')
+					{
+						AppendUtf8(Field, Run, ++Data);
+						Run = ++Data;
+						continue;
+					}
+					++Data;
+				}
+				AppendUtf8(Field, Run, Data);
+				while(Data < End && *Data != Delimiter)
+				{
+					++Data;
+				}
+			}
+			else
+			{
+				const uint8* Run = Data;
+				while(Data < End && *Data != Delimiter)
+				{
+					++Data;
+				}
+				AppendUtf8(Field, Run, Data);
+				Field.TrimStartAndEndInline();
+			}
+			Visitor(Index++, MoveTemp(Field));
+			++Data;
+		}
+	}
+
+	static void ParseCsvChunk(const uint8* Data, const uint8* End, const uint8 Delimiter, const TArray<EField>& Columns, const FTimespan LocalOffset,
+		FChunk& OutChunk)
+	{
+		while(Data < End)
+		{
+			// A line break inside quotes belongs to the field
+			const uint8* LineEnd = Data;
+			bool bQuoted = false;
+			while(LineEnd < End && (bQuoted || *LineEnd != '\n'))
+			{
+				bQuoted ^= *LineEnd == '"';
+				++LineEnd;
+			}
+			const uint8* Next = LineEnd + 1;
+			if(LineEnd > Data && LineEnd[-1] == '\r')
+			{
+				--LineEnd;
+			}
+
+			if(LineEnd > Data)
+			{
+				FValues Values;
+				SplitCsvLine(Data, LineEnd, Delimiter, [&Columns, &Values](const int32 Index, FString&& Field)
+				{
+					if(Columns.IsValidIndex(Index) && Columns[Index] != EField::None)
+					{
+						Values[static_cast<int32>(Columns[Index])] = MoveTemp(Field);
+					}
+				});
+
+				FPomodoroPhaseRecord Record;
+				if(MakeRecord(Values, LocalOffset, Record))
+				{
+					OutChunk.Records.Add(Record);
+				}
+				else
+				{
+					++OutChunk.SkippedCount;
+				}
+			}
+			Data = Next;
+		}
+	}
+
+	static void SkipWhitespace(const uint8*& Data, const uint8* End)
+	{
+		while(Data < End && (*Data == ' ' || *Data == '\t' || *Data == '\r' || *Data == '\n'))
+		{
+			++Data;
+		}
+	}
+
+	/**
+	 * @brief Read a JSON string, the cursor on its opening quote.
+	 */
+	static bool ReadJsonString(const uint8*& Data, const uint8* End, FString& OutText)
+	{
+		const uint8* Run = ++Data;
+		while(Data < End && *Data != '"')
+		{
+			if(*Data != '\\')
+			{
+				++Data;
+				continue;
+			}
+
+			AppendUtf8(OutText, Run, Data);
+			if(End - Data < 2)
+			{
+				return false;
+			}
+			const uint8 Escaped = Data[1];
+			Data += 2;
+			switch (Escaped)
+			{
+			case 'n':
+				OutText.AppendChar(TEXT('\n'));
+				break;
+
+			case 't':
+				OutText.AppendChar(TEXT('\t'));
+				break;
+
+			case 'r':
+			case 'b':
+			case 'f':
+				break;
+
+			case 'u':
+				{
+					if(End - Data < 4)
+					{
+						return false;
+					}
+					uint32 Code = 0;
+					for(int32 Digit = 0; Digit < 4; ++Digit)
+					{
+						Code = Code * 16 + FParse::HexDigit(static_cast<TCHAR>(Data[Digit]));
+					}
+					OutText.AppendChar(static_cast<TCHAR>(Code));
+					Data += 4;
+				}
+				break;
+
+			default:
+				OutText.AppendChar(static_cast<TCHAR>(Escaped));
+				break;
+			}
+			Run = Data;
+		}
+		AppendUtf8(OutText, Run, Data);
+		++Data;
+		return Data <= End;
+	}
+
+	/**
+	 * @brief Skip a nested object or array, its values aren't imported.
+	 */
+	static void SkipJsonNested(const uint8*& Data, const uint8* End)
+	{
+		int32 Depth = 0;
+		while(Data < End)
+		{
+			if(*Data == '"')
+			{
+				FString Ignored;
+				ReadJsonString(Data, End, Ignored);
+				continue;
+			}
+			Depth += (*Data == '{' || *Data == '[') ? 1 : (*Data == '}' || *Data == ']') ? -1 : 0;
+			++Data;
+			if(Depth == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @brief Read the flat objects of a chunk, the chunk starting between two objects.
+	 *
+	 * An array value is entered rather than skipped, so the records of an export wrapped in an object
+	 * like {"sessions": [...]} are read too.
+	 */
+	static void ParseJsonChunk(const uint8* Data, const uint8* End, const FTimespan LocalOffset, FChunk& OutChunk)
+	{
+		while(true)
+		{
+			while(Data < End && *Data != '{')
+			{
+				++Data;
+			}
+			if(Data >= End)
+			{
+				return;
+			}
+			++Data;
+
+			FValues Values;
+			bool bValid = false;
+			bool bWrapper = false;
+			while(Data < End)
+			{
+				SkipWhitespace(Data, End);
+				if(Data < End && *Data == ',')
+				{
+					++Data;
+					continue;
+				}
+				if(Data >= End || *Data != '"')
+				{
+					bValid = Data < End && *Data == '}';
+					++Data;
+					break;
+				}
+
+				FString Key;
+				FString Value;
+				ReadJsonString(Data, End, Key);
+				SkipWhitespace(Data, End);
+				if(Data >= End || *Data != ':')
+				{
+					break;
+				}
+				++Data;
+				SkipWhitespace(Data, End);
+				if(Data < End && *Data == '"')
+				{
+					ReadJsonString(Data, End, Value);
+				}
+				else if(Data < End && *Data == '[')
+				{
+					bWrapper = true;
+					break;
+				}
+				else if(Data < End && *Data == '{')
+				{
+					SkipJsonNested(Data, End);
+				}
+				else
+				{
+					const uint8* Run = Data;
+					while(Data < End && *Data != ',' && *Data != '}' && *Data != ' ' && *Data != '\r' && *Data != '\n')
+					{
+						++Data;
+					}
+					AppendUtf8(Value, Run, Data);
+					Value = Value == TEXT("null") ? FString() : Value;
+				}
+
+				const EField Field = GetField(Key);
+				if(Field != EField::None)
+				{
+					Values[static_cast<int32>(Field)] = MoveTemp(Value);
+				}
+			}
+
+			FPomodoroPhaseRecord Record;
+			if(bValid && MakeRecord(Values, LocalOffset, Record))
+			{
+				OutChunk.Records.Add(Record);
+			}
+			else if(!bWrapper)
+			{
+				++OutChunk.SkippedCount;
+			}
+		}
+	}
+
+	/**
+	 * @brief Give the end of the first CSV record ending from a position.
+	 * @param bQuoted Is the position inside quotes.
+	 */
+	static int64 FindCsvBoundary(const uint8* Data, const int64 Size, int64 Position, bool bQuoted)
+	{
+		for(; Position < Size; ++Position)
+		{
+			bQuoted ^= Data[Position] == '"';
+			if(!bQuoted && Data[Position] == '\n')
+			{
+				return Position + 1;
+			}
+		}
+		return Size;
+	}
+
+	/**
+	 * @brief Where a JSON scanner is : outside strings, inside one, or right after a backslash inside one
+	 */
+	enum class EJsonScan : uint8
+	{
+		Outside,
+		InString,
+		Escaped,
+	};
+
+	constexpr int32 JsonScanCount = 3;
+
+	/**
+	 * @brief Move a JSON scanner past a character, the depth only counts the brackets outside strings.
+	 */
+	static EJsonScan StepJson(const EJsonScan Scan, const uint8 Character, int32& Depth)
+	{
+		switch (Scan)
+		{
+		case EJsonScan::InString:
+			return Character == '\\' ? EJsonScan::Escaped : Character == '"' ? EJsonScan::Outside : EJsonScan::InString;
+
+		case EJsonScan::Escaped:
+			return EJsonScan::InString;
+
+		default:
+			Depth += (Character == '{' || Character == '[') ? 1 : (Character == '}' || Character == ']') ? -1 : 0;
+			return Character == '"' ? EJsonScan::InString : EJsonScan::Outside;
+		}
+	}
+
+	/**
+	 * @brief How a part of a JSON content moves a scanner, for each place the scanner may enter it in
+	 */
+	struct FJsonPartScan
+	{
+		EJsonScan EndScan[JsonScanCount];
+		int32 DepthChange[JsonScanCount];
+	};
+
+	static FJsonPartScan ScanJsonPart(const uint8* Data, const uint8* End)
+	{
+		FJsonPartScan Part;
+		for(int32 Start = 0; Start < JsonScanCount; ++Start)
+		{
+			Part.EndScan[Start] = static_cast<EJsonScan>(Start);
+			Part.DepthChange[Start] = 0;
+		}
+		for(; Data < End; ++Data)
+		{
+			for(int32 Start = 0; Start < JsonScanCount; ++Start)
+			{
+				Part.EndScan[Start] = StepJson(Part.EndScan[Start], *Data, Part.DepthChange[Start]);
+			}
+		}
+		return Part;
+	}
+
+	/**
+	 * @brief Give the depth of the records of a JSON content.
+	 *
+	 * The records are the items of a top level array, the items of the first array value of a top level
+	 * object like {"sessions": [...]}, or else the top level objects themselves, one per line for instance.
+	 */
+	static int32 FindJsonRecordDepth(const uint8* Data, const int64 Size, const int64 Begin)
+	{
+		EJsonScan Scan = EJsonScan::Outside;
+		int32 Depth = 0;
+		bool bInObject = false;
+		for(int64 Position = Begin; Position < Size; ++Position)
+		{
+			const uint8 Character = Data[Position];
+			const bool bOutside = Scan == EJsonScan::Outside;
+			Scan = StepJson(Scan, Character, Depth);
+			if(!bOutside)
+			{
+				continue;
+			}
+
+			if(!bInObject)
+			{
+				if(Character == '[')
+				{
+					return 1;
+				}
+				bInObject = Character == '{';
+			}
+			else if(Character == '[' && Depth == 2)
+			{
+				return 2;
+			}
+			else if(Depth == 0)
+			{
+				return 0;
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Give the end of the first JSON record closing from a position.
+	 * @param Scan Where the scanner is at the position.
+	 * @param Depth Depth at the position.
+	 * @param RecordDepth Depth of the records, see FindJsonRecordDepth.
+	 */
+	static int64 FindJsonBoundary(const uint8* Data, const int64 Size, int64 Position, EJsonScan Scan, int32 Depth, const int32 RecordDepth)
+	{
+		for(; Position < Size; ++Position)
+		{
+			const bool bOutside = Scan == EJsonScan::Outside;
+			Scan = StepJson(Scan, Data[Position], Depth);
+			if(bOutside && Data[Position] == '}' && Depth == RecordDepth)
+			{
+				return Position + 1;
+			}
+		}
+		return Size;
+	}
+
+	/**
+	 * @brief Move the even cuts of a content forward to the next record boundaries.
+	 *
+	 * Whether a cut falls inside quotes, and at which depth, depends on everything before it. Each part is
+	 * scanned in parallel for how it changes that state, then the parts are chained in order, which only
+	 * costs a few operations per part, and the boundaries are searched in parallel from the known states.
+	 * @param Bounds The cuts, the first one at a record start and the last one at the end of the content.
+	 */
+	static void MoveToBoundaries(const uint8* Data, const int64 Size, const EPomodoroImportFormat Format, TArray<int64>& Bounds)
+	{
+		const int32 CutCount = Bounds.Num() - 2;
+		if(CutCount <= 0)
+		{
+			return;
+		}
+
+		if(Format == EPomodoroImportFormat::Csv)
+		{
+			// Doubled quotes inside a quoted field cancel out, the quote parity tells if a position is quoted
+			TArray<bool> OddQuotes;
+			OddQuotes.SetNumZeroed(CutCount);
+			ParallelFor(CutCount, [Data, &Bounds, &OddQuotes](const int32 Index)
+			{
+				int64 Quotes = 0;
+				for(int64 Position = Bounds[Index]; Position < Bounds[Index + 1]; ++Position)
+				{
+					Quotes += Data[Position] == '"' ? 1 : 0;
+				}
+				OddQuotes[Index] = (Quotes & 1) != 0;
+			});
+
+			TArray<bool> Quoted;
+			Quoted.SetNumZeroed(CutCount + 1);
+			for(int32 Index = 0; Index < CutCount; ++Index)
+			{
+				Quoted[Index + 1] = Quoted[Index] ^ OddQuotes[Index];
+			}
+
+			ParallelFor(CutCount, [Data, Size, &Bounds, &Quoted](const int32 Index)
+			{
+				Bounds[Index + 1] = FindCsvBoundary(Data, Size, Bounds[Index + 1], Quoted[Index + 1]);
+			});
+			return;
+		}
+
+		const int32 RecordDepth = FindJsonRecordDepth(Data, Size, Bounds[0]);
+
+		TArray<FJsonPartScan> Parts;
+		Parts.SetNum(CutCount);
+		ParallelFor(CutCount, [Data, &Bounds, &Parts](const int32 Index)
+		{
+			Parts[Index] = ScanJsonPart(Data + Bounds[Index], Data + Bounds[Index + 1]);
+		});
+
+		TArray<EJsonScan> Scans;
+		TArray<int32> Depths;
+		Scans.SetNum(CutCount + 1);
+		Depths.SetNum(CutCount + 1);
+		Scans[0] = EJsonScan::Outside;
+		Depths[0] = 0;
+		for(int32 Index = 0; Index < CutCount; ++Index)
+		{
+			const int32 Start = static_cast<int32>(Scans[Index]);
+			Scans[Index + 1] = Parts[Index].EndScan[Start];
+			Depths[Index + 1] = Depths[Index] + Parts[Index].DepthChange[Start];
+		}
+
+		ParallelFor(CutCount, [Data, Size, RecordDepth, &Bounds, &Scans, &Depths](const int32 Index)
+		{
+			Bounds[Index + 1] = FindJsonBoundary(Data, Size, Bounds[Index + 1], Scans[Index + 1], Depths[Index + 1], RecordDepth);
+		});
+	}
+
+	/**
+	 * @brief Map the file, or read it when the platform can't map files, and parse it.
+	 */
+	static void ParseFile(const FString& Path, FPomodoroImportResult& OutResult, TArray<FPomodoroPhaseRecord>& OutRecords)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		const EPomodoroImportFormat Format = FPomodoroPhaseImporter::GetFormat(Path);
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const TUniquePtr<IMappedFileHandle> Handle(PlatformFile.OpenMapped(*Path));
+		const TUniquePtr<IMappedFileRegion> Region(Handle.IsValid() && Handle->GetFileSize() > 0 ? Handle->MapRegion(0, Handle->GetFileSize()) : nullptr);
+		if(Region.IsValid())
+		{
+			OutResult.Bytes = Region->GetMappedSize();
+			FPomodoroPhaseImporter::Parse(Region->GetMappedPtr(), Region->GetMappedSize(), Format, OutRecords, OutResult.SkippedCount);
+		}
+		else
+		{
+			TArray<uint8> Content;
+			if(!FFileHelper::LoadFileToArray(Content, *Path, FILEREAD_Silent))
+			{
+				OutResult.Error = TEXT("can't read the file");
+				return;
+			}
+			OutResult.Bytes = Content.Num();
+			FPomodoroPhaseImporter::Parse(Content.GetData(), Content.Num(), Format, OutRecords, OutResult.SkippedCount);
+		}
+
+		OutResult.ParsedCount = OutRecords.Num();
+		OutResult.ParseSeconds = FPlatformTime::Seconds() - StartSeconds;
+	}
+}
+
+TFuture<FPomodoroImportResult> FPomodoroPhaseImporter::ImportFile(const FString& Path, TSharedRef<FPomodoroPhaseHistory> History,
+	TUniqueFunction<void(const TArray<FPomodoroPhaseRecord>&)> OnAdded)
+{
+	const TSharedRef<TPromise<FPomodoroImportResult>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<FPomodoroImportResult>, ESPMode::ThreadSafe>();
+	TFuture<FPomodoroImportResult> Future = Promise->GetFuture();
+
+	// The history pointer isn't thread safe : only moved through the worker, and used back on the game thread
+	TWeakPtr<FPomodoroPhaseHistory> WeakHistory = History;
+	Async(EAsyncExecution::ThreadPool, [Path, Promise, WeakHistory = MoveTemp(WeakHistory), OnAdded = MoveTemp(OnAdded)]() mutable
+	{
+		FPomodoroImportResult Result;
+		TArray<FPomodoroPhaseRecord> Records;
+		PomodoroPhaseImporter::ParseFile(Path, Result, Records);
+		UE_LOG(LogPomodoro, Log, TEXT("Read %d timespans from %s in %.2f ms, %d records skipped"),
+			Result.ParsedCount, *Path, Result.ParseSeconds * 1000.0, Result.SkippedCount);
+
+		AsyncTask(ENamedThreads::GameThread, [Promise, WeakHistory = MoveTemp(WeakHistory), Result, Records = MoveTemp(Records), OnAdded = MoveTemp(OnAdded)]() mutable
+		{
+			const TSharedPtr<FPomodoroPhaseHistory> PinnedHistory = WeakHistory.Pin();
+			if(!PinnedHistory.IsValid() || !Result.Error.IsEmpty() || Records.Num() == 0)
+			{
+				Promise->SetValue(Result);
+				return;
+			}
+
+			PinnedHistory->Import(MoveTemp(Records), [Promise, Result, OnAdded = MoveTemp(OnAdded)](TArray<FPomodoroPhaseRecord>&& Added) mutable
+			{
+				// The other aggregates of the records live on the game thread
+				Result.AddedCount = Added.Num();
+				Result.DuplicateCount = Result.ParsedCount - Added.Num();
+				AsyncTask(ENamedThreads::GameThread, [Promise, Result, OnAdded = MoveTemp(OnAdded), Added = MoveTemp(Added)]()
+				{
+					if(OnAdded && Added.Num() > 0)
+					{
+						OnAdded(Added);
+					}
+					Promise->SetValue(Result);
+				});
+			});
+		});
+	});
+	return Future;
+}
+
+void FPomodoroPhaseImporter::Parse(const uint8* Data, const int64 Size, const EPomodoroImportFormat Format, TArray<FPomodoroPhaseRecord>& OutRecords, int32& OutSkippedCount)
+{
+	Parse(Data, Size, Format, 0, OutRecords, OutSkippedCount);
+}
+
+void FPomodoroPhaseImporter::Parse(const uint8* Data, const int64 Size, const EPomodoroImportFormat Format, int32 ChunkCount,
+	TArray<FPomodoroPhaseRecord>& OutRecords, int32& OutSkippedCount)
+{
+	using namespace PomodoroPhaseImporter;
+
+	OutRecords.Reset();
+	OutSkippedCount = 0;
+
+	// UTF-8 byte order mark
+	int64 Begin = Size >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF ? 3 : 0;
+
+	// The CSV header names the columns, its most frequent separator separates them
+	uint8 Delimiter = ',';
+	TArray<EField> Columns;
+	if(Format == EPomodoroImportFormat::Csv)
+	{
+		const int64 HeaderEnd = FindCsvBoundary(Data, Size, Begin, false);
+		int32 Counts[3] = {};
+		for(int64 Position = Begin; Position < HeaderEnd; ++Position)
+		{
+			Counts[0] += Data[Position] == ',' ? 1 : 0;
+			Counts[1] += Data[Position] == ';' ? 1 : 0;
+			Counts[2] += Data[Position] == '\t' ? 1 : 0;
+		}
+		Delimiter = Counts[1] > Counts[0] && Counts[1] >= Counts[2] ? ';' : Counts[2] > Counts[0] ? '\t' : ',';
+
+		const uint8* LineEnd = Data + HeaderEnd;
+		while(LineEnd > Data + Begin && (LineEnd[-1] == '\n' || LineEnd[-1] == '\r'))
+		{
+			--LineEnd;
+		}
+		SplitCsvLine(Data + Begin, LineEnd, Delimiter, [&Columns](const int32 Index, FString&& Name)
+		{
+			Columns.Add(GetField(Name));
+		});
+		Begin = HeaderEnd;
+	}
+
+	// Chunks of about the same size, each moved forward to the next record boundary
+	if(ChunkCount <= 0)
+	{
+		const int32 MaxChunks = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() * ChunksPerWorker);
+		ChunkCount = static_cast<int32>(FMath::Clamp<int64>((Size - Begin) / MinChunkBytes, 1, MaxChunks));
+	}
+	TArray<int64> Bounds;
+	Bounds.SetNum(ChunkCount + 1);
+	for(int32 Index = 0; Index <= ChunkCount; ++Index)
+	{
+		Bounds[Index] = Begin + (Size - Begin) * Index / ChunkCount;
+	}
+	MoveToBoundaries(Data, Size, Format, Bounds);
+
+	// Times without offset are read in the current time zone, to the minute
+	const FTimespan LocalOffset = FTimespan::FromMinutes(FMath::RoundToDouble((FDateTime::Now() - FDateTime::UtcNow()).GetTotalMinutes()));
+
+	TArray<FChunk> Chunks;
+	Chunks.SetNum(ChunkCount);
+	ParallelFor(ChunkCount, [Data, Format, Delimiter, LocalOffset, &Columns, &Bounds, &Chunks](const int32 Index)
+	{
+		const uint8* ChunkBegin = Data + Bounds[Index];
+		const uint8* ChunkEnd = Data + Bounds[Index + 1];
+		if(Format == EPomodoroImportFormat::Csv)
+		{
+			ParseCsvChunk(ChunkBegin, ChunkEnd, Delimiter, Columns, LocalOffset, Chunks[Index]);
+		}
+		else
+		{
+			ParseJsonChunk(ChunkBegin, ChunkEnd, LocalOffset, Chunks[Index]);
+		}
+	});
+
+	int32 RecordCount = 0;
+	for(const FChunk& Chunk : Chunks)
+	{
+		RecordCount += Chunk.Records.Num();
+	}
+	OutRecords.Reserve(RecordCount);
+	for(FChunk& Chunk : Chunks)
+	{
+		OutRecords.Append(MoveTemp(Chunk.Records));
+		OutSkippedCount += Chunk.SkippedCount;
+	}
+}
+
+EPomodoroImportFormat FPomodoroPhaseImporter::GetFormat(const FString& Path)
+{
+	const FString Extension = FPaths::GetExtension(Path);
+	return Extension.Equals(TEXT("json"), ESearchCase::IgnoreCase) || Extension.Equals(TEXT("jsonl"), ESearchCase::IgnoreCase)
+		? EPomodoroImportFormat::Json : EPomodoroImportFormat::Csv;
+}
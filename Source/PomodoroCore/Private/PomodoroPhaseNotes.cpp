@@ -0,0 +1,359 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroPhaseNotes.h"
+
+#include "PomodoroCore.h"
+#include "PomodoroDeferredWork.h"
+#include "PomodoroVarint.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Reverse.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace PomodoroPhaseNotes
+{
+	constexpr uint32 Magic = 0x4E504D50; // "PMPN"
+	constexpr uint32 Version = 1;
+
+	/** Key of the deferred save */
+	static const FName SaveKey(TEXT("PomodoroPhaseNotes"));
+
+	/** The notes are saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 10.0;
+
+	/** Longer terms are cut, a prefix this long already finds the note */
+	constexpr int32 MaxTermLength = 32;
+
+	/**
+	 * @brief Keep the notes of both sorted arrays.
+	 */
+	static void Intersect(TArray<int32>& Notes, const TArray<int32>& Other)
+	{
+		int32 Kept = 0;
+		int32 OtherIndex = 0;
+		for(const int32 Note : Notes)
+		{
+			while(OtherIndex < Other.Num() && Other[OtherIndex] < Note)
+			{
+				++OtherIndex;
+			}
+			if(OtherIndex < Other.Num() && Other[OtherIndex] == Note)
+			{
+				Notes[Kept++] = Note;
+			}
+		}
+		Notes.SetNum(Kept, false);
+	}
+
+	/**
+	 * @brief Write a note in the file format.
+	 */
+	static void WriteNote(FMemoryWriter& Writer, const FPomodoroPhaseNote& Note)
+	{
+		int64 StartSeconds = Note.StartSeconds;
+		uint8 Phase = static_cast<uint8>(Note.Phase);
+		FString Text = Note.Text;
+		Writer << StartSeconds << Phase << Text;
+	}
+}
+
+void FPomodoroNoteIndex::Add(const int32 Note, const FString& Text)
+{
+	TArray<FString> Words;
+	Tokenize(Text, Words);
+	for(const FString& Word : Words)
+	{
+		int32 Position = LowerBound(Word);
+		if(!Terms.IsValidIndex(Position) || !Terms[Position].Term.Equals(Word, ESearchCase::CaseSensitive))
+		{
+			// New terms get rarer as the vocabulary fills up, the insertion only moves the array then
+			FTerm& Term = Terms.InsertDefaulted_GetRef(Position);
+			Term.Term = Word;
+		}
+
+		// A word repeated in a note is listed once
+		FTerm& Term = Terms[Position];
+		if(Term.LastNote == Note)
+		{
+			continue;
+		}
+		check(Note > Term.LastNote);
+		PomodoroVarint::Write(Term.Postings, static_cast<uint64>(Note - Term.LastNote));
+		Term.LastNote = Note;
+	}
+}
+
+void FPomodoroNoteIndex::Reset()
+{
+	Terms.Reset();
+}
+
+void FPomodoroNoteIndex::Search(const FString& Query, TArray<int32>& OutNotes) const
+{
+	OutNotes.Reset();
+
+	TArray<FString> Words;
+	Query.ParseIntoArrayWS(Words);
+	bool bFirstWord = true;
+	for(const FString& Word : Words)
+	{
+		const bool bPrefix = Word.EndsWith(TEXT("*"));
+		TArray<FString> QueryTerms;
+		Tokenize(bPrefix ? Word.LeftChop(1) : Word, QueryTerms);
+		for(int32 TermIndex = 0; TermIndex < QueryTerms.Num(); ++TermIndex)
+		{
+			// Only the last part of a word like "nav-m*" is a prefix
+			const FString& QueryTerm = QueryTerms[TermIndex];
+			const bool bTermPrefix = bPrefix && TermIndex == QueryTerms.Num() - 1;
+
+			TArray<int32> Matches;
+			for(int32 Position = LowerBound(QueryTerm); Position < Terms.Num(); ++Position)
+			{
+				const FString& Term = Terms[Position].Term;
+				if(bTermPrefix ? !Term.StartsWith(QueryTerm, ESearchCase::CaseSensitive) : !Term.Equals(QueryTerm, ESearchCase::CaseSensitive))
+				{
+					break;
+				}
+				Decode(Terms[Position], Matches);
+			}
+
+			// Several terms starting with the prefix may list the same note
+			if(bTermPrefix)
+			{
+				Matches.Sort();
+				int32 Kept = 0;
+				for(int32 Index = 0; Index < Matches.Num(); ++Index)
+				{
+					if(Kept == 0 || Matches[Kept - 1] != Matches[Index])
+					{
+						Matches[Kept++] = Matches[Index];
+					}
+				}
+				Matches.SetNum(Kept, false);
+			}
+
+			if(bFirstWord)
+			{
+				OutNotes = MoveTemp(Matches);
+				bFirstWord = false;
+			}
+			else
+			{
+				PomodoroPhaseNotes::Intersect(OutNotes, Matches);
+			}
+			if(OutNotes.Num() == 0)
+			{
+				return;
+			}
+		}
+	}
+}
+
+void FPomodoroNoteIndex::Tokenize(const FString& Text, TArray<FString>& OutTerms)
+{
+	OutTerms.Reset();
+	FString Term;
+	for(const TCHAR Character : Text)
+	{
+		if(FChar::IsAlnum(Character))
+		{
+			if(Term.Len() < PomodoroPhaseNotes::MaxTermLength)
+			{
+				Term.AppendChar(FChar::ToLower(Character));
+			}
+		}
+		else if(!Term.IsEmpty())
+		{
+			OutTerms.Add(MoveTemp(Term));
+			Term.Reset();
+		}
+	}
+	if(!Term.IsEmpty())
+	{
+		OutTerms.Add(MoveTemp(Term));
+	}
+}
+
+int32 FPomodoroNoteIndex::LowerBound(const FString& Text) const
+{
+	return Algo::LowerBoundBy(Terms, Text, [](const FTerm& Term) -> const FString&
+	{
+		return Term.Term;
+	}, [](const FString& A, const FString& B)
+	{
+		return A.Compare(B, ESearchCase::CaseSensitive) < 0;
+	});
+}
+
+void FPomodoroNoteIndex::Decode(const FTerm& Term, TArray<int32>& OutNotes)
+{
+	const uint8* Data = Term.Postings.GetData();
+	const uint8* End = Data + Term.Postings.Num();
+	int32 Note = INDEX_NONE;
+	uint64 Gap = 0;
+	while(Data < End && PomodoroVarint::Read(Data, End, Gap))
+	{
+		Note += static_cast<int32>(Gap);
+		OutNotes.Add(Note);
+	}
+}
+
+FPomodoroPhaseNotes::FPomodoroPhaseNotes(TSharedRef<FPomodoroPhaseHistory> InHistory)
+	: FPomodoroPhaseNotes(InHistory, ReadNotesFile())
+{
+}
+
+FPomodoroPhaseNotes::FPomodoroPhaseNotes(TSharedRef<FPomodoroPhaseHistory> InHistory, FPomodoroPhaseNotesFile&& Loaded, const FString& InPath)
+	: History(InHistory)
+	, Path(InPath)
+	, Notes(MoveTemp(Loaded.Notes))
+	, Index(MoveTemp(Loaded.Index))
+	, SavedCount(Notes.Num())
+	, bFileValid(Loaded.bValid)
+{
+	// After a restart, the notes still go to the last timespan run
+	LastPhase = History->GetLastRecord();
+	History->OnPhaseRecorded().AddRaw(this, &FPomodoroPhaseNotes::OnPhaseRecorded);
+}
+
+FPomodoroPhaseNotes::~FPomodoroPhaseNotes()
+{
+	History->OnPhaseRecorded().RemoveAll(this);
+	FPomodoroDeferredWork::Flush(PomodoroPhaseNotes::SaveKey);
+}
+
+bool FPomodoroPhaseNotes::AddNoteToLastPhase(const FString& Text)
+{
+	if(!LastPhase.IsSet() || Text.TrimStartAndEnd().IsEmpty())
+	{
+		return false;
+	}
+
+	AddNote(LastPhase->StartSeconds, LastPhase->Phase, Text);
+	return true;
+}
+
+void FPomodoroPhaseNotes::AddNote(const int64 StartSeconds, const EPomodoroPhase Phase, const FString& Text)
+{
+	FPomodoroPhaseNote& Note = Notes.AddDefaulted_GetRef();
+	Note.StartSeconds = StartSeconds;
+	Note.Phase = Phase;
+	Note.Text = Text.TrimStartAndEnd().Left(MaxNoteLength);
+	Index.Add(Notes.Num() - 1, Note.Text);
+
+	FPomodoroDeferredWork::Enqueue(PomodoroPhaseNotes::SaveKey, EPomodoroWorkPriority::Low, PomodoroPhaseNotes::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+const TOptional<FPomodoroPhaseRecord>& FPomodoroPhaseNotes::GetLastPhase() const
+{
+	return LastPhase;
+}
+
+void FPomodoroPhaseNotes::Search(const FString& Query, const int32 MaxResults, TArray<int32>& OutNotes) const
+{
+	Index.Search(Query, OutNotes);
+
+	// The notes are numbered in the order they were written
+	Algo::Reverse(OutNotes);
+	if(OutNotes.Num() > MaxResults)
+	{
+		OutNotes.SetNum(MaxResults, false);
+	}
+}
+
+const FPomodoroPhaseNote& FPomodoroPhaseNotes::GetNote(const int32 Note) const
+{
+	return Notes[Note];
+}
+
+int32 FPomodoroPhaseNotes::GetNoteCount() const
+{
+	return Notes.Num();
+}
+
+FString FPomodoroPhaseNotes::GetNotesPath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Pomodoro"), TEXT("PhaseNotes.bin"));
+}
+
+FPomodoroPhaseNotesFile FPomodoroPhaseNotes::ReadNotesFile(const FString& Path)
+{
+	FPomodoroPhaseNotesFile Loaded;
+	TArray<uint8> Bytes;
+	if(!FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent))
+	{
+		return Loaded;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 FileVersion = 0;
+	Reader << Magic << FileVersion;
+	if(Reader.IsError() || Magic != PomodoroPhaseNotes::Magic || FileVersion != PomodoroPhaseNotes::Version)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Ignoring the phase notes %s, unknown format"), *Path);
+		return Loaded;
+	}
+
+	// An interrupted append leaves a partial note at the end, the notes before it are kept
+	while(Reader.Tell() < Reader.TotalSize())
+	{
+		FPomodoroPhaseNote Note;
+		uint8 Phase = 0;
+		Reader << Note.StartSeconds << Phase << Note.Text;
+		if(Reader.IsError() || Phase > static_cast<uint8>(EPomodoroPhase::LongResting))
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("Phase notes %s truncated after %d notes"), *Path, Loaded.Notes.Num());
+			return Loaded;
+		}
+		Note.Phase = static_cast<EPomodoroPhase>(Phase);
+		Loaded.Index.Add(Loaded.Notes.Num(), Note.Text);
+		Loaded.Notes.Add(MoveTemp(Note));
+	}
+
+	Loaded.bValid = true;
+	return Loaded;
+}
+
+void FPomodoroPhaseNotes::OnPhaseRecorded(const FPomodoroPhaseRecord& Record)
+{
+	LastPhase = Record;
+}
+
+void FPomodoroPhaseNotes::Save()
+{
+	if(bFileValid && SavedCount == Notes.Num())
+	{
+		return;
+	}
+
+	// Only the new notes are appended, a damaged file is written again from the start
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	const int32 First = bFileValid ? SavedCount : 0;
+	if(!bFileValid)
+	{
+		uint32 Magic = PomodoroPhaseNotes::Magic;
+		uint32 FileVersion = PomodoroPhaseNotes::Version;
+		Writer << Magic << FileVersion;
+	}
+	for(int32 Note = First; Note < Notes.Num(); ++Note)
+	{
+		PomodoroPhaseNotes::WriteNote(Writer, Notes[Note]);
+	}
+
+	if(!FFileHelper::SaveArrayToFile(Bytes, *Path, &IFileManager::Get(), bFileValid ? FILEWRITE_Append : FILEWRITE_None))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't save the phase notes to %s"), *Path);
+		return;
+	}
+	SavedCount = Notes.Num();
+	bFileValid = true;
+}
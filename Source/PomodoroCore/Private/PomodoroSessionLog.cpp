@@ -0,0 +1,608 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSessionLog.h"
+
+#include "PomodoroCore.h"
+#include "PomodoroDeferredWork.h"
+#include "PomodoroEngine.h"
+#include "PomodoroVarint.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace PomodoroSessionLog
+{
+	constexpr uint32 Magic = 0x4C534D50; // "PMSL"
+	constexpr uint32 Version = 1;
+
+	/** Key of the deferred saves, numbered for each log */
+	static const FName SaveKey(TEXT("PomodoroSessionLog"));
+	static int32 LogCount = 0;
+
+	/** The events are saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 30.0;
+
+	/** Logs kept at startup : the newest ones, written within the last days */
+	constexpr int32 MaxKeptSessions = 100;
+	constexpr int32 MaxSessionAgeDays = 30;
+
+	/** Flags of the begin event */
+	constexpr uint8 WorkingTimeFlag = 0x01;
+	constexpr uint8 FollowingFlag = 0x02;
+	constexpr uint8 PendingTimespansFlag = 0x04;
+
+	static void WriteSigned(TArray<uint8>& Bytes, const int64 Value)
+	{
+		PomodoroVarint::Write(Bytes, PomodoroVarint::ZigZag(Value));
+	}
+
+	static bool ReadSigned(const uint8*& Data, const uint8* End, int64& Value)
+	{
+		uint64 Encoded = 0;
+		if(!PomodoroVarint::Read(Data, End, Encoded))
+		{
+			return false;
+		}
+		Value = PomodoroVarint::UnZigZag(Encoded);
+		return true;
+	}
+
+	static bool ReadRaw(const uint8*& Data, const uint8* End, void* Value, const int32 Size)
+	{
+		if(End - Data < Size)
+		{
+			return false;
+		}
+		FMemory::Memcpy(Value, Data, Size);
+		Data += Size;
+		return true;
+	}
+
+	/**
+	 * @brief Give the number of integer arguments an input is recorded with.
+	 * @param Event The input.
+	 * @return Number of arguments.
+	 */
+	static int32 GetArgumentCount(const EPomodoroSessionEvent Event)
+	{
+		switch (Event)
+		{
+		case EPomodoroSessionEvent::SetCycleCount:
+			return 1;
+
+		case EPomodoroSessionEvent::SetWorkingTimespan:
+		case EPomodoroSessionEvent::SetShortRestingTimespan:
+		case EPomodoroSessionEvent::SetLongRestingTimespan:
+		case EPomodoroSessionEvent::SetNextCycleTimespans:
+			return 3;
+
+		case EPomodoroSessionEvent::ReloadConfig:
+			return 4;
+
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	 * @brief Event of a parsed log.
+	 */
+	struct FEvent
+	{
+		EPomodoroSessionEvent Kind = EPomodoroSessionEvent::Begin;
+		int64 Arguments[4] = {};
+		FPomodoroSessionState State;
+		FPomodoroEngineSnapshot Snapshot;
+		FDateTime Utc;
+		double Seconds = 0.0;
+	};
+
+	/**
+	 * @brief Parse a session log.
+	 * @param Log Content of the log file.
+	 * @param OutEvents The events, in order.
+	 * @param OutError Why the log can't be parsed.
+	 * @return False if the log is malformed.
+	 */
+	static bool ParseEvents(const TArrayView<const uint8> Log, TArray<FEvent>& OutEvents, FString& OutError)
+	{
+		const uint8* Data = Log.GetData();
+		const uint8* End = Data + Log.Num();
+
+		uint32 FileMagic = 0;
+		uint32 FileVersion = 0;
+		if(!ReadRaw(Data, End, &FileMagic, sizeof(FileMagic)) || !ReadRaw(Data, End, &FileVersion, sizeof(FileVersion))
+			|| FileMagic != Magic || FileVersion != Version)
+		{
+			OutError = TEXT("unknown format");
+			return false;
+		}
+
+		int64 UtcTicks = 0;
+		while(Data < End)
+		{
+			FEvent& Event = OutEvents.AddDefaulted_GetRef();
+			const uint8 Kind = *Data++;
+			if(Kind >= static_cast<uint8>(EPomodoroSessionEvent::Count) || (OutEvents.Num() == 1 && Kind != static_cast<uint8>(EPomodoroSessionEvent::Begin)))
+			{
+				OutError = FString::Printf(TEXT("unexpected event %d at byte %d"), Kind, static_cast<int32>(Data - 1 - Log.GetData()));
+				return false;
+			}
+			Event.Kind = static_cast<EPomodoroSessionEvent>(Kind);
+
+			bool bValid = true;
+			switch (Event.Kind)
+			{
+			case EPomodoroSessionEvent::Begin:
+				{
+					FPomodoroSessionState& State = Event.State;
+					uint8 StateValue = 0;
+					uint8 Flags = 0;
+					int64 Values[7] = {};
+					bValid = ReadRaw(Data, End, &StateValue, 1) && ReadRaw(Data, End, &Flags, 1) && StateValue <= Running;
+					for(int64& Value : Values)
+					{
+						bValid = bValid && ReadSigned(Data, End, Value);
+					}
+					State.State = static_cast<EPomodoroState>(StateValue);
+					State.bWorkingTime = (Flags & WorkingTimeFlag) != 0;
+					State.bFollowing = (Flags & FollowingFlag) != 0;
+					State.CurrentCycle = static_cast<int32>(Values[0]);
+					State.CycleCount = static_cast<int32>(Values[1]);
+					State.Remaining = FTimespan(Values[2]);
+					State.WorkingTimespan = FTimespan(Values[3]);
+					State.ShortRestingTimespan = FTimespan(Values[4]);
+					State.LongRestingTimespan = FTimespan(Values[5]);
+					State.Deadline = FDateTime(Values[6]);
+					if(Flags & PendingTimespansFlag)
+					{
+						int64 Pending[3] = {};
+						for(int64& Value : Pending)
+						{
+							bValid = bValid && ReadSigned(Data, End, Value);
+						}
+						State.PendingTimespans = MakeTuple(FTimespan(Pending[0]), FTimespan(Pending[1]), FTimespan(Pending[2]));
+					}
+				}
+				break;
+
+			case EPomodoroSessionEvent::MirrorSnapshot:
+			case EPomodoroSessionEvent::Synchronize:
+				bValid = ReadRaw(Data, End, &Event.Snapshot, sizeof(FPomodoroEngineSnapshot));
+				break;
+
+			case EPomodoroSessionEvent::UtcReading:
+				{
+					int64 Delta = 0;
+					bValid = ReadSigned(Data, End, Delta);
+					UtcTicks += Delta;
+					Event.Utc = FDateTime(UtcTicks);
+				}
+				break;
+
+			case EPomodoroSessionEvent::SecondsReading:
+				bValid = ReadRaw(Data, End, &Event.Seconds, sizeof(double));
+				break;
+
+			default:
+				for(int32 Argument = 0; Argument < GetArgumentCount(Event.Kind); ++Argument)
+				{
+					bValid = bValid && ReadSigned(Data, End, Event.Arguments[Argument]);
+				}
+				break;
+			}
+
+			// A log cut by a crash ends with a partial event, everything before it is still valid
+			if(!bValid)
+			{
+				OutEvents.Pop();
+				break;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Clock serving the readings recorded while handling an input, the time doesn't pass otherwise.
+	 */
+	class FReplayClock final : public FPomodoroClock
+	{
+	public:
+		virtual double GetSeconds() const override
+		{
+			if(NextSecondsReading < SecondsReadings.Num())
+			{
+				LastSeconds = SecondsReadings[NextSecondsReading++];
+			}
+			else
+			{
+				bMissedReading = true;
+			}
+			return LastSeconds;
+		}
+
+		virtual FDateTime GetUtcNow() const override
+		{
+			if(NextUtcReading < UtcReadings.Num())
+			{
+				LastUtc = UtcReadings[NextUtcReading++];
+			}
+			else
+			{
+				bMissedReading = true;
+			}
+			return LastUtc;
+		}
+
+		/**
+		 * @brief Serve the readings of the next input.
+		 */
+		void Serve(TArray<FDateTime>&& InUtcReadings, TArray<double>&& InSecondsReadings)
+		{
+			UtcReadings = MoveTemp(InUtcReadings);
+			SecondsReadings = MoveTemp(InSecondsReadings);
+			NextUtcReading = 0;
+			NextSecondsReading = 0;
+			bMissedReading = false;
+		}
+
+		/**
+		 * @brief Tell whether the engine read the clock exactly as many times as recorded.
+		 */
+		bool ServedAll() const
+		{
+			return !bMissedReading && NextUtcReading == UtcReadings.Num() && NextSecondsReading == SecondsReadings.Num();
+		}
+
+	private:
+		TArray<FDateTime> UtcReadings;
+		TArray<double> SecondsReadings;
+		mutable int32 NextUtcReading = 0;
+		mutable int32 NextSecondsReading = 0;
+		mutable bool bMissedReading = false;
+		mutable FDateTime LastUtc;
+		mutable double LastSeconds = 0.0;
+	};
+
+	/**
+	 * Configuration store serving the recorded configuration, nothing is saved.
+	 */
+	class FReplayConfigStore final : public IPomodoroConfigStore
+	{
+	public:
+		/** Configuration served at the next engine reload */
+		FPomodoroEngineSettings EngineSettings;
+
+		virtual FPomodoroEngineSettings LoadEngineSettings() const override
+		{
+			return EngineSettings;
+		}
+
+		virtual void SaveEngineSettings(const FPomodoroEngineSettings& Settings) override
+		{
+		}
+
+		virtual FPomodoroPlannerSettings LoadPlannerSettings() const override
+		{
+			return FPomodoroPlannerSettings();
+		}
+
+		virtual void SavePlannerSettings(const FPomodoroPlannerSettings& Settings) override
+		{
+		}
+	};
+}
+
+FPomodoroSessionLog::FPomodoroSessionLog(const FString& InPath)
+	: Path(InPath)
+	, SaveKey(PomodoroSessionLog::SaveKey, ++PomodoroSessionLog::LogCount)
+{
+	Pending.Append(reinterpret_cast<const uint8*>(&PomodoroSessionLog::Magic), sizeof(PomodoroSessionLog::Magic));
+	Pending.Append(reinterpret_cast<const uint8*>(&PomodoroSessionLog::Version), sizeof(PomodoroSessionLog::Version));
+}
+
+FPomodoroSessionLog::~FPomodoroSessionLog()
+{
+	FPomodoroDeferredWork::Flush(SaveKey);
+	Save();
+}
+
+void FPomodoroSessionLog::AddBegin(const FPomodoroSessionState& State)
+{
+	using namespace PomodoroSessionLog;
+
+	uint8 Flags = 0;
+	Flags |= State.bWorkingTime ? WorkingTimeFlag : 0;
+	Flags |= State.bFollowing ? FollowingFlag : 0;
+	Flags |= State.PendingTimespans.IsSet() ? PendingTimespansFlag : 0;
+
+	Pending.Add(static_cast<uint8>(EPomodoroSessionEvent::Begin));
+	Pending.Add(static_cast<uint8>(State.State));
+	Pending.Add(Flags);
+	WriteSigned(Pending, State.CurrentCycle);
+	WriteSigned(Pending, State.CycleCount);
+	WriteSigned(Pending, State.Remaining.GetTicks());
+	WriteSigned(Pending, State.WorkingTimespan.GetTicks());
+	WriteSigned(Pending, State.ShortRestingTimespan.GetTicks());
+	WriteSigned(Pending, State.LongRestingTimespan.GetTicks());
+	WriteSigned(Pending, State.Deadline.GetTicks());
+	if(State.PendingTimespans.IsSet())
+	{
+		WriteSigned(Pending, State.PendingTimespans->Get<0>().GetTicks());
+		WriteSigned(Pending, State.PendingTimespans->Get<1>().GetTicks());
+		WriteSigned(Pending, State.PendingTimespans->Get<2>().GetTicks());
+	}
+	RequestSave();
+}
+
+void FPomodoroSessionLog::AddInput(const EPomodoroSessionEvent Event, const TArrayView<const int64> Arguments)
+{
+	check(Arguments.Num() == PomodoroSessionLog::GetArgumentCount(Event));
+
+	Pending.Add(static_cast<uint8>(Event));
+	for(const int64 Argument : Arguments)
+	{
+		PomodoroSessionLog::WriteSigned(Pending, Argument);
+	}
+	RequestSave();
+}
+
+void FPomodoroSessionLog::AddSnapshotInput(const EPomodoroSessionEvent Event, const FPomodoroEngineSnapshot& Snapshot)
+{
+	Pending.Add(static_cast<uint8>(Event));
+	Pending.Append(reinterpret_cast<const uint8*>(&Snapshot), sizeof(FPomodoroEngineSnapshot));
+	RequestSave();
+}
+
+void FPomodoroSessionLog::AddUtcReading(const FDateTime& Time)
+{
+	Pending.Add(static_cast<uint8>(EPomodoroSessionEvent::UtcReading));
+	PomodoroSessionLog::WriteSigned(Pending, Time.GetTicks() - LastUtcTicks);
+	LastUtcTicks = Time.GetTicks();
+	RequestSave();
+}
+
+void FPomodoroSessionLog::AddSecondsReading(const double Seconds)
+{
+	Pending.Add(static_cast<uint8>(EPomodoroSessionEvent::SecondsReading));
+	Pending.Append(reinterpret_cast<const uint8*>(&Seconds), sizeof(double));
+	RequestSave();
+}
+
+void FPomodoroSessionLog::AddElapsed(const bool bWorkingTime)
+{
+	Pending.Add(static_cast<uint8>(bWorkingTime ? EPomodoroSessionEvent::WorkingElapsed : EPomodoroSessionEvent::RestingElapsed));
+	RequestSave();
+}
+
+void FPomodoroSessionLog::Save()
+{
+	bSaveRequested = false;
+	if(Pending.Num() == 0)
+	{
+		return;
+	}
+
+	// Kept pending on failure, the next save tries again
+	if(!FFileHelper::SaveArrayToFile(Pending, *Path, &IFileManager::Get(), bFileCreated ? FILEWRITE_Append : FILEWRITE_None))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't save the session log to %s"), *Path);
+		return;
+	}
+	bFileCreated = true;
+	Pending.Reset();
+}
+
+const FString& FPomodoroSessionLog::GetPath() const
+{
+	return Path;
+}
+
+FString FPomodoroSessionLog::GetSessionDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Pomodoro"), TEXT("Sessions"));
+}
+
+FString FPomodoroSessionLog::MakeSessionPath()
+{
+	// Editors of the same project started within a second each get their log, names still sort by time
+	return FPaths::Combine(GetSessionDirectory(), FString::Printf(TEXT("Session-%s-%u.bin"),
+		*FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S")), FPlatformProcess::GetCurrentProcessId()));
+}
+
+void FPomodoroSessionLog::PruneSessions()
+{
+	using namespace PomodoroSessionLog;
+
+	TArray<TPair<FDateTime, FString>> Sessions;
+	IFileManager::Get().IterateDirectoryStat(*GetSessionDirectory(), [&Sessions](const TCHAR* FilePath, const FFileStatData& StatData)
+	{
+		if(!StatData.bIsDirectory && FPaths::GetExtension(FilePath) == TEXT("bin"))
+		{
+			Sessions.Emplace(StatData.ModificationTime, FilePath);
+		}
+		return true;
+	});
+
+	// Newest first, the ones past the count or the age go
+	Sessions.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B)
+	{
+		return A.Key > B.Key;
+	});
+	const FDateTime OldestKept = FDateTime::UtcNow() - FTimespan::FromDays(MaxSessionAgeDays);
+	int32 DeletedCount = 0;
+	for(int32 Index = 0; Index < Sessions.Num(); ++Index)
+	{
+		if((Index >= MaxKeptSessions || Sessions[Index].Key < OldestKept) && IFileManager::Get().Delete(*Sessions[Index].Value, false, false, true))
+		{
+			++DeletedCount;
+		}
+	}
+	if(DeletedCount > 0)
+	{
+		UE_LOG(LogPomodoro, Log, TEXT("Deleted %d old session logs"), DeletedCount);
+	}
+}
+
+void FPomodoroSessionLog::RequestSave()
+{
+	if(bSaveRequested)
+	{
+		return;
+	}
+	bSaveRequested = true;
+	FPomodoroDeferredWork::Enqueue(SaveKey, EPomodoroWorkPriority::Low, PomodoroSessionLog::SaveDelaySeconds, [this]()
+	{
+		Save();
+	});
+}
+
+FPomodoroReplayResult FPomodoroSessionReplay::Replay(const TArrayView<const uint8> Log)
+{
+	using namespace PomodoroSessionLog;
+
+	FPomodoroReplayResult Result;
+	TArray<FEvent> Events;
+	if(!ParseEvents(Log, Events, Result.Error))
+	{
+		return Result;
+	}
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	const TSharedRef<FReplayClock> Clock = MakeShared<FReplayClock>();
+	const TSharedRef<FReplayConfigStore> ConfigStore = MakeShared<FReplayConfigStore>();
+	{
+		const TSharedRef<FPomodoroEngine> Engine = MakeShared<FPomodoroEngine>(Clock, ConfigStore);
+		Engine->BindOnTimeSpanElapsed(FElapsedTimespanHandleDelegate::CreateLambda([&Result](const bool bWorkingTime)
+		{
+			Result.ReplayedElapsed.Add(bWorkingTime);
+		}));
+
+		int32 Index = 0;
+		while(Index < Events.Num())
+		{
+			const FEvent& Input = Events[Index++];
+
+			// The readings and the timespan ends following an input were made while handling it
+			TArray<FDateTime> UtcReadings;
+			TArray<double> SecondsReadings;
+			for(; Index < Events.Num() && Events[Index].Kind >= EPomodoroSessionEvent::UtcReading; ++Index)
+			{
+				switch (Events[Index].Kind)
+				{
+				case EPomodoroSessionEvent::UtcReading:
+					UtcReadings.Add(Events[Index].Utc);
+					break;
+
+				case EPomodoroSessionEvent::SecondsReading:
+					SecondsReadings.Add(Events[Index].Seconds);
+					break;
+
+				default:
+					Result.RecordedElapsed.Add(Events[Index].Kind == EPomodoroSessionEvent::WorkingElapsed);
+					break;
+				}
+			}
+			Clock->Serve(MoveTemp(UtcReadings), MoveTemp(SecondsReadings));
+
+			const int64* Arguments = Input.Arguments;
+			switch (Input.Kind)
+			{
+			case EPomodoroSessionEvent::Begin:
+				Engine->RestoreSessionState(Input.State);
+				continue;
+
+			case EPomodoroSessionEvent::Start:
+				Engine->Start();
+				break;
+
+			case EPomodoroSessionEvent::Pause:
+				Engine->Pause();
+				break;
+
+			case EPomodoroSessionEvent::Stop:
+				Engine->Stop();
+				break;
+
+			case EPomodoroSessionEvent::SetCycleCount:
+				Engine->SetCycleCount(static_cast<int32>(Arguments[0]));
+				break;
+
+			case EPomodoroSessionEvent::SetWorkingTimespan:
+				Engine->SetWorkingTimespan(static_cast<int32>(Arguments[0]), static_cast<int32>(Arguments[1]), static_cast<int32>(Arguments[2]));
+				break;
+
+			case EPomodoroSessionEvent::SetShortRestingTimespan:
+				Engine->SetShortRestingTimespan(static_cast<int32>(Arguments[0]), static_cast<int32>(Arguments[1]), static_cast<int32>(Arguments[2]));
+				break;
+
+			case EPomodoroSessionEvent::SetLongRestingTimespan:
+				Engine->SetLongRestingTimespan(static_cast<int32>(Arguments[0]), static_cast<int32>(Arguments[1]), static_cast<int32>(Arguments[2]));
+				break;
+
+			case EPomodoroSessionEvent::ResetConfig:
+				Engine->ResetConfig();
+				break;
+
+			case EPomodoroSessionEvent::ReloadConfig:
+				ConfigStore->EngineSettings.WorkingTimespan = FTimespan(Arguments[0]);
+				ConfigStore->EngineSettings.ShortRestingTimespan = FTimespan(Arguments[1]);
+				ConfigStore->EngineSettings.LongRestingTimespan = FTimespan(Arguments[2]);
+				ConfigStore->EngineSettings.CycleCount = static_cast<int32>(Arguments[3]);
+				Engine->ReloadConfig();
+				break;
+
+			case EPomodoroSessionEvent::SetNextCycleTimespans:
+				Engine->SetNextCycleTimespans(FTimespan(Arguments[0]), FTimespan(Arguments[1]), FTimespan(Arguments[2]));
+				break;
+
+			case EPomodoroSessionEvent::Follow:
+				Engine->Follow(FRequestStateDelegate());
+				break;
+
+			case EPomodoroSessionEvent::Lead:
+				Engine->Lead();
+				break;
+
+			case EPomodoroSessionEvent::MirrorSnapshot:
+				Engine->MirrorSnapshot(Input.Snapshot);
+				break;
+
+			case EPomodoroSessionEvent::Synchronize:
+				Engine->Synchronize(Input.Snapshot);
+				break;
+
+			case EPomodoroSessionEvent::Tick:
+				Engine->OnTick();
+				break;
+
+			default:
+				// Readings or timespan ends without input, only possible in a forged log
+				Result.Error = TEXT("event outside of any input");
+				return Result;
+			}
+			++Result.InputCount;
+
+			if(!Clock->ServedAll() || Result.ReplayedElapsed != Result.RecordedElapsed)
+			{
+				Result.DivergedInput = Result.InputCount - 1;
+				break;
+			}
+		}
+	}
+	Result.ReplaySeconds = FPlatformTime::Seconds() - StartSeconds;
+	return Result;
+}
+
+FPomodoroReplayResult FPomodoroSessionReplay::ReplayFile(const FString& Path)
+{
+	TArray<uint8> Log;
+	if(!FFileHelper::LoadFileToArray(Log, *Path))
+	{
+		FPomodoroReplayResult Result;
+		Result.Error = TEXT("can't read the file");
+		return Result;
+	}
+	return Replay(Log);
+}
@@ -0,0 +1,70 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSnapshot.h"
+
+void FPomodoroSnapshotChannel::Publish(const FPomodoroEngineSnapshot& NewSnapshot)
+{
+	const uint64 Begin = Sequence.load(std::memory_order_relaxed);
+
+	// Mark the publication as in progress before touching the data
+	Sequence.store(Begin + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	FPomodoroEngineSnapshot Versioned = NewSnapshot;
+	Versioned.Version = (Begin + 2) / 2;
+
+	uint64 Buffer[WordCount];
+	FMemory::Memcpy(Buffer, &Versioned, sizeof(FPomodoroEngineSnapshot));
+	for(int32 Index = 0; Index < WordCount; ++Index)
+	{
+		Words[Index].store(Buffer[Index], std::memory_order_relaxed);
+	}
+
+	Sequence.store(Begin + 2, std::memory_order_release);
+}
+
+FPomodoroEngineSnapshot FPomodoroSnapshotChannel::Read() const
+{
+	uint64 Buffer[WordCount];
+	for(;;)
+	{
+		const uint64 Begin = Sequence.load(std::memory_order_acquire);
+
+		// A publication is in progress, the writer only needs a few nanoseconds
+		if(Begin & 1)
+		{
+			FPlatformProcess::Sleep(0.0f);
+			continue;
+		}
+
+		for(int32 Index = 0; Index < WordCount; ++Index)
+		{
+			Buffer[Index] = Words[Index].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// Nothing was published while copying, the copy is consistent
+		if(Sequence.load(std::memory_order_relaxed) == Begin)
+		{
+			FPomodoroEngineSnapshot Copy;
+			FMemory::Memcpy(&Copy, Buffer, sizeof(FPomodoroEngineSnapshot));
+			return Copy;
+		}
+	}
+}
+
+bool FPomodoroSnapshotChannel::ReadIfChanged(FPomodoroEngineSnapshot& InOutSnapshot) const
+{
+	if(GetVersion() == InOutSnapshot.Version)
+	{
+		return false;
+	}
+	InOutSnapshot = Read();
+	return true;
+}
+
+uint64 FPomodoroSnapshotChannel::GetVersion() const
+{
+	return Sequence.load(std::memory_order_acquire) / 2;
+}
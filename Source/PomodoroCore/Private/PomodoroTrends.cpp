@@ -0,0 +1,314 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroTrends.h"
+
+#include "PomodoroFocusHistory.h"
+#include "Async/Async.h"
+
+FPomodoroTrends::FPomodoroTrends(TSharedRef<FPomodoroPhaseHistory> InHistory)
+	: History(InHistory)
+{
+	UtcOffset = FDateTime::Now() - FDateTime::UtcNow();
+
+	// Decoded once off the game thread, only the new records are aggregated afterwards
+	StartDecoding();
+	History->OnPhaseRecorded().AddRaw(this, &FPomodoroTrends::AddRecord);
+}
+
+FPomodoroTrends::~FPomodoroTrends()
+{
+	History->OnPhaseRecorded().RemoveAll(this);
+
+	// The decode reads this history
+	if(Decoding.IsValid())
+	{
+		Decoding.Wait();
+	}
+}
+
+void FPomodoroTrends::Update()
+{
+	if(!Decoding.IsValid())
+	{
+		// Imported records are merged without being broadcast, the count tells an import from a compaction
+		const uint32 HistoryVersion = History->GetVersion();
+		if(HistoryVersion != AggregatedVersion)
+		{
+			AggregatedVersion = HistoryVersion;
+			if(History->GetRecordCount() != Aggregates.RecordCount)
+			{
+				StartDecoding();
+			}
+		}
+		return;
+	}
+	if(!Decoding.IsReady())
+	{
+		return;
+	}
+
+	// A record appended or a compaction meanwhile may or may not be in the decoded records
+	if(History->GetVersion() != DecodingVersion)
+	{
+		StartDecoding();
+		return;
+	}
+
+	Aggregates = Decoding.Get();
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		InvalidateLevels(static_cast<EPomodoroTrendBucket>(Bucket), INDEX_NONE);
+	}
+	AggregatedVersion = DecodingVersion;
+	Decoding = TFuture<FAggregates>();
+	++Version;
+}
+
+bool FPomodoroTrends::IsDecoding() const
+{
+	return Decoding.IsValid();
+}
+
+float FPomodoroTrends::GetValue(const EPomodoroTrendMetric Metric, const EPomodoroTrendBucket Bucket, const int32 Number) const
+{
+	const TArray<FValues>& BucketValues = Aggregates.Values[static_cast<int32>(Bucket)];
+	const int32 Index = Number - Aggregates.FirstNumbers[static_cast<int32>(Bucket)];
+	return BucketValues.IsValidIndex(Index) ? BucketValues[Index].Values[static_cast<int32>(Metric)] : 0.0f;
+}
+
+int32 FPomodoroTrends::GetFirstBucket(const EPomodoroTrendBucket Bucket) const
+{
+	return Aggregates.Values[static_cast<int32>(Bucket)].Num() > 0 ? Aggregates.FirstNumbers[static_cast<int32>(Bucket)] : GetCurrentBucket(Bucket);
+}
+
+int32 FPomodoroTrends::GetCurrentBucket(const EPomodoroTrendBucket Bucket)
+{
+	return GetBucketOfDay(Bucket, FPomodoroFocusHistory::GetDay(FDateTime::Now()));
+}
+
+void FPomodoroTrends::GetDownsampled(const EPomodoroTrendMetric Metric, const EPomodoroTrendBucket Bucket, const int32 FromBucket, const int32 ToBucket,
+	const int32 MaxPoints, TArray<FPomodoroTrendPoint>& OutPoints) const
+{
+	OutPoints.Reset();
+	const auto MakePoint = [this, Metric, Bucket](const int32 Number)
+	{
+		FPomodoroTrendPoint Point;
+		Point.Bucket = Number;
+		Point.Value = GetValue(Metric, Bucket, Number);
+		return Point;
+	};
+
+	// Few enough buckets, every one is a point
+	const int32 Count = ToBucket - FromBucket + 1;
+	const int32 PointCount = FMath::Max(4, MaxPoints);
+	if(Count <= PointCount)
+	{
+		for(int32 Number = FromBucket; Number <= ToBucket; ++Number)
+		{
+			OutPoints.Add(MakePoint(Number));
+		}
+		return;
+	}
+
+	// Smallest level whose bins touched by the window, and the first and last buckets, fit in the points
+	int32 Level = 1;
+	while(Level + 1 < LevelCount && ((Count - 1) >> Level) + 4 > PointCount)
+	{
+		++Level;
+	}
+
+	// Bins are aligned on the bucket numbers, the points don't change while the window scrolls
+	OutPoints.Reserve(((Count - 1) >> Level) + 4);
+	OutPoints.Add(MakePoint(FromBucket));
+	for(int32 Bin = FromBucket >> Level; Bin <= ToBucket >> Level; ++Bin)
+	{
+		const FPomodoroTrendPoint Selected = GetSelectedPoint(Metric, Bucket, Level, Bin);
+		if(Selected.Bucket > FromBucket && Selected.Bucket < ToBucket)
+		{
+			OutPoints.Add(Selected);
+		}
+	}
+	OutPoints.Add(MakePoint(ToBucket));
+}
+
+uint32 FPomodoroTrends::GetVersion() const
+{
+	return Version;
+}
+
+int32 FPomodoroTrends::GetBucketOfDay(const EPomodoroTrendBucket Bucket, const int32 Day)
+{
+	// Day 0, 0001-01-01, is a Monday
+	return Bucket == EPomodoroTrendBucket::Week ? Day / 7 : Day;
+}
+
+int32 FPomodoroTrends::GetFirstDayOfBucket(const EPomodoroTrendBucket Bucket, const int32 Number)
+{
+	return Bucket == EPomodoroTrendBucket::Week ? Number * 7 : Number;
+}
+
+void FPomodoroTrends::StartDecoding()
+{
+	// The history outlives the decode, the destructor waits for it
+	DecodingVersion = History->GetVersion();
+	const FPomodoroPhaseHistory* Source = History.Get();
+	const FTimespan Offset = UtcOffset;
+	Decoding = Async(EAsyncExecution::ThreadPool, [Source, Offset]()
+	{
+		FAggregates Result;
+		Source->ForEachRecord(FDateTime(1970, 1, 1), FDateTime::MaxValue(), [&Result, Offset](const FPomodoroPhaseRecord& Record)
+		{
+			Aggregate(Result, Record, Offset);
+		});
+		return Result;
+	});
+}
+
+FPomodoroTrendPoint FPomodoroTrends::GetSelectedPoint(const EPomodoroTrendMetric Metric, const EPomodoroTrendBucket Bucket, const int32 Level, const int32 Bin) const
+{
+	const TArray<FValues>& BucketValues = Aggregates.Values[static_cast<int32>(Bucket)];
+	const int32 FirstNumber = Aggregates.FirstNumbers[static_cast<int32>(Bucket)];
+	const int32 LastNumber = FirstNumber + BucketValues.Num() - 1;
+	const int32 FirstBin = FirstNumber >> Level;
+	const int32 LastBin = LastNumber >> Level;
+
+	// Nothing is recorded around the history, any bucket of the bin is zero
+	if(BucketValues.Num() == 0 || Bin < FirstBin || Bin > LastBin)
+	{
+		FPomodoroTrendPoint Point;
+		Point.Bucket = Bin << Level;
+		return Point;
+	}
+
+	const auto GetBucketValue = [&BucketValues, FirstNumber, Metric](const int32 Number)
+	{
+		return BucketValues[Number - FirstNumber].Values[static_cast<int32>(Metric)];
+	};
+
+	// The bins are selected in order, each from the point of the bin before it and the average of the bin after it
+	FLevelCache& Cache = Levels[static_cast<int32>(Metric)][static_cast<int32>(Bucket)][Level];
+	if(Cache.Points.Num() == 0)
+	{
+		Cache.FirstBin = FirstBin;
+	}
+	while(Cache.FirstBin + Cache.Points.Num() <= Bin)
+	{
+		const int32 Current = Cache.FirstBin + Cache.Points.Num();
+		const int32 From = FMath::Max(Current << Level, FirstNumber);
+		const int32 To = FMath::Min(((Current + 1) << Level) - 1, LastNumber);
+
+		// The history is surrounded by zeros, the first and last bins lean on them
+		FPomodoroTrendPoint Previous;
+		Previous.Bucket = FirstNumber - 1;
+		if(Cache.Points.Num() > 0)
+		{
+			Previous = Cache.Points.Last();
+		}
+		double NextX = LastNumber + 1;
+		double NextValue = 0.0;
+		if(Current < LastBin)
+		{
+			const int32 NextTo = FMath::Min(To + (1 << Level), LastNumber);
+			for(int32 Number = To + 1; Number <= NextTo; ++Number)
+			{
+				NextValue += GetBucketValue(Number);
+			}
+			NextX = 0.5 * (To + 1 + NextTo);
+			NextValue /= NextTo - To;
+		}
+
+		// Keep the bucket making the largest triangle with the previous point and the next average
+		FPomodoroTrendPoint Selected;
+		double BestArea = -1.0;
+		for(int32 Number = From; Number <= To; ++Number)
+		{
+			const float Value = GetBucketValue(Number);
+			const double Area = FMath::Abs((Previous.Bucket - NextX) * (Value - Previous.Value) - (Previous.Bucket - Number) * (NextValue - Previous.Value));
+			if(Area > BestArea)
+			{
+				BestArea = Area;
+				Selected.Bucket = Number;
+				Selected.Value = Value;
+			}
+		}
+		Cache.Points.Add(Selected);
+	}
+	return Cache.Points[Bin - Cache.FirstBin];
+}
+
+void FPomodoroTrends::InvalidateLevels(const EPomodoroTrendBucket Bucket, const int32 Number)
+{
+	for(int32 Metric = 0; Metric < MetricCount; ++Metric)
+	{
+		for(int32 Level = 1; Level < LevelCount; ++Level)
+		{
+			// The bin before sees a new next average, the bins after a new previous point, and the last bin selected leant on the end of the history
+			FLevelCache& Cache = Levels[Metric][static_cast<int32>(Bucket)][Level];
+			const int32 Kept = Number == INDEX_NONE ? 0 : FMath::Min(Number >> Level, Cache.FirstBin + Cache.Points.Num()) - 1 - Cache.FirstBin;
+			Cache.Points.SetNum(FMath::Clamp(Kept, 0, Cache.Points.Num()), false);
+		}
+	}
+}
+
+void FPomodoroTrends::AddRecord(const FPomodoroPhaseRecord& Record)
+{
+	// The running decode is started again with this record
+	if(Decoding.IsValid())
+	{
+		return;
+	}
+
+	int32 FirstNumbers[BucketCount];
+	FMemory::Memcpy(FirstNumbers, Aggregates.FirstNumbers, sizeof(FirstNumbers));
+	const int32 Day = Aggregate(Aggregates, Record, UtcOffset);
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		// A record before the first bucket moves every bin
+		const EPomodoroTrendBucket TrendBucket = static_cast<EPomodoroTrendBucket>(Bucket);
+		InvalidateLevels(TrendBucket, Aggregates.FirstNumbers[Bucket] == FirstNumbers[Bucket] ? GetBucketOfDay(TrendBucket, Day) : INDEX_NONE);
+	}
+	AggregatedVersion = History->GetVersion();
+	++Version;
+}
+
+int32 FPomodoroTrends::Aggregate(FAggregates& Target, const FPomodoroPhaseRecord& Record, const FTimespan Offset)
+{
+	FValues Added;
+	if(Record.Phase == EPomodoroPhase::Working)
+	{
+		Added.Values[static_cast<int32>(EPomodoroTrendMetric::Focus)] = Record.DurationSeconds / 60.0f;
+		Added.Values[static_cast<int32>(EPomodoroTrendMetric::Interruptions)] = Record.PauseCount + (Record.bCompleted ? 0 : 1);
+	}
+	Added.Values[static_cast<int32>(EPomodoroTrendMetric::Pause)] = Record.PausedSeconds / 60.0f;
+
+	const int32 Day = FPomodoroFocusHistory::GetDay(FDateTime::FromUnixTimestamp(Record.StartSeconds) + Offset);
+	for(int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+	{
+		// Grow the dense array to cover the bucket
+		const int32 Number = GetBucketOfDay(static_cast<EPomodoroTrendBucket>(Bucket), Day);
+		TArray<FValues>& BucketValues = Target.Values[Bucket];
+		int32& FirstNumber = Target.FirstNumbers[Bucket];
+		if(BucketValues.Num() == 0)
+		{
+			FirstNumber = Number;
+		}
+		else if(Number < FirstNumber)
+		{
+			BucketValues.InsertDefaulted(0, FirstNumber - Number);
+			FirstNumber = Number;
+		}
+		if(Number - FirstNumber >= BucketValues.Num())
+		{
+			BucketValues.SetNum(Number - FirstNumber + 1);
+		}
+
+		FValues& Values = BucketValues[Number - FirstNumber];
+		for(int32 Metric = 0; Metric < MetricCount; ++Metric)
+		{
+			Values.Values[Metric] += Added.Values[Metric];
+		}
+	}
+	++Target.RecordCount;
+	return Day;
+}
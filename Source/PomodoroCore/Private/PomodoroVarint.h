@@ -0,0 +1,51 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Variable length integers of the binary files : 7 bits per byte, low bits first, the high bit set on every
+ * byte but the last. Signed values are zigzag mapped first so small negative values stay short.
+ */
+namespace PomodoroVarint
+{
+	inline uint64 ZigZag(const int64 Value)
+	{
+		return (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+	}
+
+	inline int64 UnZigZag(const uint64 Value)
+	{
+		return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1);
+	}
+
+	inline void Write(TArray<uint8>& Bytes, uint64 Value)
+	{
+		while(Value >= 0x80)
+		{
+			Bytes.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+		Bytes.Add(static_cast<uint8>(Value));
+	}
+
+	/**
+	 * @brief Read a value and move past it.
+	 * @return False if the data ends within the value or the value is longer than 64 bits.
+	 */
+	inline bool Read(const uint8*& Data, const uint8* End, uint64& Value)
+	{
+		Value = 0;
+		for(int32 Shift = 0; Shift < 64 && Data < End; Shift += 7)
+		{
+			const uint8 Byte = *Data++;
+			Value |= static_cast<uint64>(Byte & 0x7F) << Shift;
+			if((Byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,153 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "PomodoroPercentiles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PomodoroPercentilesTests
+{
+	static const double Quantiles[] = {0.0, 0.1, 0.5, 0.9, 0.95, 0.99, 1.0};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroQuantileSketchRoundTripTest, "Pomodoro.Core.Percentiles.SketchRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroQuantileSketchRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPercentilesTests;
+
+	FPomodoroQuantileSketch Sketch;
+	for(int32 Value = 1; Value <= 1000; ++Value)
+	{
+		Sketch.Add(Value);
+	}
+	TestTrue(TEXT("Median within the accuracy"), FMath::Abs(Sketch.GetQuantile(0.5) - 500.0) <= 500.0 * FPomodoroQuantileSketch::RelativeAccuracy + 1.0);
+
+	// Two sketches in a row, each decode stops at the end of its sketch
+	TArray<uint8> Bytes;
+	Sketch.Encode(Bytes);
+	FPomodoroQuantileSketch Empty;
+	Empty.Encode(Bytes);
+
+	const uint8* Data = Bytes.GetData();
+	const uint8* End = Data + Bytes.Num();
+	FPomodoroQuantileSketch Decoded;
+	FPomodoroQuantileSketch DecodedEmpty;
+	TestTrue(TEXT("Sketch decodes"), Decoded.Decode(Data, End));
+	TestTrue(TEXT("Empty sketch decodes"), DecodedEmpty.Decode(Data, End));
+	TestTrue(TEXT("Every byte is read"), Data == End);
+
+	TestEqual(TEXT("Count"), Decoded.GetCount(), Sketch.GetCount());
+	TestEqual(TEXT("Empty count"), DecodedEmpty.GetCount(), static_cast<uint64>(0));
+	for(const double Quantile : Quantiles)
+	{
+		TestEqual(FString::Printf(TEXT("Quantile %.2f"), Quantile), Decoded.GetQuantile(Quantile), Sketch.GetQuantile(Quantile));
+	}
+
+	// A truncated sketch is rejected
+	const uint8* Truncated = Bytes.GetData();
+	TestFalse(TEXT("Truncated sketch is rejected"), Decoded.Decode(Truncated, Truncated + 3));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroQuantileSketchAccuracyTest, "Pomodoro.Core.Percentiles.SketchAccuracy",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroQuantileSketchAccuracyTest::RunTest(const FString& Parameters)
+{
+	// From a second to about three days, every bucket holds several values
+	FPomodoroQuantileSketch Sketch;
+	TArray<double> Values;
+	for(int32 Step = 0; Step <= 1260; ++Step)
+	{
+		Values.Add(FMath::Pow(1.01, Step));
+		Sketch.Add(Values.Last());
+	}
+
+	// The quantile is read from the bucket of the value at its rank
+	for(int32 Percent = 0; Percent <= 100; ++Percent)
+	{
+		const double Quantile = Percent / 100.0;
+		const double Expected = Values[FMath::FloorToInt(Quantile * (Values.Num() - 1))];
+		const double Error = FMath::Abs(Sketch.GetQuantile(Quantile) - Expected) / Expected;
+		TestTrue(FString::Printf(TEXT("Quantile %.2f within the accuracy (%.4f)"), Quantile, Error),
+			Error <= FPomodoroQuantileSketch::RelativeAccuracy + 1e-9);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroQuantileSketchMergeTest, "Pomodoro.Core.Percentiles.SketchMerge",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroQuantileSketchMergeTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPercentilesTests;
+
+	// The merge of two streams is the sketch of both
+	FRandomStream Random(42);
+	FPomodoroQuantileSketch Whole;
+	FPomodoroQuantileSketch Parts[2];
+	for(int32 Index = 0; Index < 5000; ++Index)
+	{
+		const double Value = Random.FRandRange(0.0, 3600.0);
+		Whole.Add(Value);
+		Parts[Index % 2].Add(Value);
+	}
+	FPomodoroQuantileSketch Merged;
+	Merged.Merge(Parts[0]);
+	Merged.Merge(Parts[1]);
+	Merged.Merge(FPomodoroQuantileSketch());
+
+	TestEqual(TEXT("Count"), Merged.GetCount(), Whole.GetCount());
+	for(const double Quantile : Quantiles)
+	{
+		TestEqual(FString::Printf(TEXT("Quantile %.2f"), Quantile), Merged.GetQuantile(Quantile), Whole.GetQuantile(Quantile));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroPercentileSetRoundTripTest, "Pomodoro.Core.Percentiles.SetRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroPercentileSetRoundTripTest::RunTest(const FString& Parameters)
+{
+	FPomodoroPercentileSet Set;
+	FPomodoroPercentileSet Other;
+	for(int32 Day = 0; Day < 30; ++Day)
+	{
+		for(int32 Sample = 0; Sample < 10; ++Sample)
+		{
+			Set.Add(730000 + Day, EPomodoroPercentileMetric::Pause, EPomodoroPhase::Working, 10.0 * (Sample + 1));
+			Set.Add(730000 + Day, EPomodoroPercentileMetric::Interruption, EPomodoroPhase::ShortResting, 60.0 + Day);
+			Other.Add(730000 + Day, EPomodoroPercentileMetric::Pause, EPomodoroPhase::Working, 5.0 * (Sample + 1));
+		}
+	}
+
+	TArray<uint8> Bytes;
+	Set.Save(Bytes);
+	FPomodoroPercentileSet Loaded;
+	if(!TestTrue(TEXT("Set loads"), Loaded.Load(Bytes)))
+	{
+		return false;
+	}
+	for(int32 Metric = 0; Metric < FPomodoroPercentileSet::MetricCount; ++Metric)
+	{
+		const FPomodoroQuantileSketch Saved = Set.Query(static_cast<EPomodoroPercentileMetric>(Metric), TOptional<EPomodoroPhase>(), 730000, 730029);
+		const FPomodoroQuantileSketch Read = Loaded.Query(static_cast<EPomodoroPercentileMetric>(Metric), TOptional<EPomodoroPhase>(), 730000, 730029);
+		TestEqual(TEXT("Count"), Read.GetCount(), Saved.GetCount());
+		TestEqual(TEXT("Median"), Read.GetQuantile(0.5), Saved.GetQuantile(0.5));
+	}
+
+	// Merging another set adds its sketches day by day
+	Loaded.Merge(Other);
+	TestEqual(TEXT("Merged count"), Loaded.Query(EPomodoroPercentileMetric::Pause, EPomodoroPhase::Working, 730000, 730029).GetCount(), static_cast<uint64>(600));
+
+	// Invalid content leaves the set empty
+	Bytes.SetNum(Bytes.Num() / 2);
+	TestFalse(TEXT("Truncated set is rejected"), Loaded.Load(Bytes));
+	TestEqual(TEXT("Rejected set is empty"), Loaded.Query(EPomodoroPercentileMetric::Pause, TOptional<EPomodoroPhase>(), 730000, 730029).GetCount(), static_cast<uint64>(0));
+	return true;
+}
+
+#endif
@@ -0,0 +1,167 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "PomodoroClock.h"
+#include "PomodoroEngine.h"
+#include "PomodoroPhaseHistory.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PomodoroPhaseHistoryTests
+{
+	/**
+	 * @brief Make irregular records, as a few years of use give: gaps, stops, pauses and every kind of timespan.
+	 */
+	static TArray<FPomodoroPhaseRecord> MakeRecords(const int32 Count)
+	{
+		FRandomStream Random(1234);
+		TArray<FPomodoroPhaseRecord> Records;
+		int64 StartSeconds = 1672531200; // 2023-01-01
+		for(int32 Index = 0; Index < Count; ++Index)
+		{
+			FPomodoroPhaseRecord& Record = Records.AddDefaulted_GetRef();
+			Record.StartSeconds = StartSeconds;
+			Record.Phase = static_cast<EPomodoroPhase>(Index % 3);
+			Record.bCompleted = Random.FRand() > 0.2f;
+			Record.DurationSeconds = Record.bCompleted ? (Record.Phase == EPomodoroPhase::Working ? 1500 : 300) : Random.RandRange(0, 1500);
+			Record.PauseCount = Random.FRand() > 0.7f ? Random.RandRange(1, 4) : 0;
+			Record.PausedSeconds = Record.PauseCount * Random.RandRange(5, 600);
+			StartSeconds += Record.DurationSeconds + Record.PausedSeconds + (Random.FRand() > 0.9f ? Random.RandRange(3600, 86400 * 3) : 0);
+		}
+		return Records;
+	}
+
+	static bool AreSame(const FPomodoroPhaseRecord& A, const FPomodoroPhaseRecord& B)
+	{
+		return A.StartSeconds == B.StartSeconds && A.DurationSeconds == B.DurationSeconds && A.PausedSeconds == B.PausedSeconds
+			&& A.PauseCount == B.PauseCount && A.Phase == B.Phase && A.bCompleted == B.bCompleted;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroPhaseSegmentRoundTripTest, "Pomodoro.Core.PhaseHistory.SegmentRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroPhaseSegmentRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPhaseHistoryTests;
+
+	const TArray<FPomodoroPhaseRecord> Records = MakeRecords(2000);
+	const TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> Segment = FPomodoroPhaseHistory::BuildSegment(Records);
+	TestEqual(TEXT("Record count"), Segment->Count, Records.Num());
+	TestEqual(TEXT("Earliest start"), Segment->MinSeconds, Records[0].StartSeconds);
+	TestEqual(TEXT("Latest start"), Segment->MaxSeconds, Records.Last().StartSeconds);
+	TestTrue(TEXT("Payload is compressed"), Segment->Payload.Num() < Segment->RawSize);
+
+	// Decoded records are appended after the ones already there, as the compaction merges segments
+	TArray<FPomodoroPhaseRecord> Decoded;
+	Decoded.AddDefaulted();
+	if(!TestTrue(TEXT("Segment decodes"), FPomodoroPhaseHistory::DecodeSegment(*Segment, Decoded))
+		|| !TestEqual(TEXT("Decoded count"), Decoded.Num(), Records.Num() + 1))
+	{
+		return false;
+	}
+	for(int32 Index = 0; Index < Records.Num(); ++Index)
+	{
+		if(!AreSame(Records[Index], Decoded[Index + 1]))
+		{
+			AddError(FString::Printf(TEXT("Record %d differs once decoded"), Index));
+			return false;
+		}
+	}
+
+	// An empty segment is valid
+	TArray<FPomodoroPhaseRecord> Empty;
+	TestTrue(TEXT("Empty segment decodes"), FPomodoroPhaseHistory::DecodeSegment(*FPomodoroPhaseHistory::BuildSegment(TArray<FPomodoroPhaseRecord>()), Empty));
+	TestEqual(TEXT("Empty segment count"), Empty.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroPhaseSegmentCorruptionTest, "Pomodoro.Core.PhaseHistory.SegmentCorruption",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroPhaseSegmentCorruptionTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPhaseHistoryTests;
+
+	const TArray<FPomodoroPhaseRecord> Records = MakeRecords(100);
+	const TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> Segment = FPomodoroPhaseHistory::BuildSegment(Records);
+
+	// A count not matching the encoded records is rejected, the output is left as it was
+	FPomodoroPhaseSegment WrongCount = *Segment;
+	++WrongCount.Count;
+	TArray<FPomodoroPhaseRecord> Decoded;
+	Decoded.AddDefaulted();
+	TestFalse(TEXT("Wrong count is rejected"), FPomodoroPhaseHistory::DecodeSegment(WrongCount, Decoded));
+	TestEqual(TEXT("Output kept"), Decoded.Num(), 1);
+
+	// So is a truncated payload
+	FPomodoroPhaseSegment Truncated = *Segment;
+	Truncated.Payload.SetNum(Truncated.Payload.Num() / 2);
+	TestFalse(TEXT("Truncated payload is rejected"), FPomodoroPhaseHistory::DecodeSegment(Truncated, Decoded));
+	TestEqual(TEXT("Output kept"), Decoded.Num(), 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroPhaseHistoryImportTest, "Pomodoro.Core.PhaseHistory.Import",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroPhaseHistoryImportTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPhaseHistoryTests;
+
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PomodoroPhaseHistoryImportTest.bin"));
+	const TSharedRef<FPomodoroEngine> Engine = MakeShared<FPomodoroEngine>(MakeShared<FPomodoroClock>(), nullptr);
+	{
+		const TSharedRef<FPomodoroPhaseHistory> History = MakeShared<FPomodoroPhaseHistory>(Engine, FPomodoroPhaseHistoryFile(), Path);
+		const auto Import = [&History](const TArray<FPomodoroPhaseRecord>& Records)
+		{
+			const TSharedRef<TPromise<TArray<FPomodoroPhaseRecord>>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<TArray<FPomodoroPhaseRecord>>, ESPMode::ThreadSafe>();
+			TFuture<TArray<FPomodoroPhaseRecord>> Future = Promise->GetFuture();
+			History->Import(Records, [Promise](TArray<FPomodoroPhaseRecord>&& Added)
+			{
+				Promise->SetValue(MoveTemp(Added));
+			});
+			return TArray<FPomodoroPhaseRecord>(Future.Get());
+		};
+
+		// Exact copies inside the export are dropped, a near one is another timespan
+		const TArray<FPomodoroPhaseRecord> Records = MakeRecords(300);
+		TArray<FPomodoroPhaseRecord> Exported = Records;
+		for(int32 Index = 0; Index < 10; ++Index)
+		{
+			Exported.Add(Records[Index * 7]);
+		}
+		FPomodoroPhaseRecord Near = Records[100];
+		Near.StartSeconds += 30;
+		Near.DurationSeconds += 10;
+		Exported.Add(Near);
+
+		const TArray<FPomodoroPhaseRecord> Added = Import(Exported);
+		TestEqual(TEXT("Records added"), Added.Num(), Records.Num() + 1);
+		TestEqual(TEXT("Records in the history"), History->GetRecordCount(), Records.Num() + 1);
+		TestTrue(TEXT("First record kept"), Added.Num() > 0 && AreSame(Added[0], Records[0]));
+
+		// The timespans already recorded are dropped, a second import adds nothing
+		TestEqual(TEXT("Records added again"), Import(Exported).Num(), 0);
+		TestEqual(TEXT("Records in the history after the second import"), History->GetRecordCount(), Records.Num() + 1);
+
+		int32 Visited = 0;
+		int64 PreviousStart = MIN_int64;
+		bool bOrdered = true;
+		History->ForEachRecord(FDateTime(1970, 1, 1), FDateTime::MaxValue(), [&Visited, &PreviousStart, &bOrdered](const FPomodoroPhaseRecord& Record)
+		{
+			bOrdered &= Record.StartSeconds >= PreviousStart;
+			PreviousStart = Record.StartSeconds;
+			++Visited;
+		});
+		TestEqual(TEXT("Records visited"), Visited, Records.Num() + 1);
+		TestTrue(TEXT("Records in time order"), bOrdered);
+	}
+	IFileManager::Get().Delete(*Path);
+	IFileManager::Get().Delete(*(Path + TEXT(".tmp")));
+	return true;
+}
+
+#endif
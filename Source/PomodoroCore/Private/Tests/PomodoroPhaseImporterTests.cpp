@@ -0,0 +1,200 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "PomodoroPhaseImporter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PomodoroPhaseImporterTests
+{
+	static void Parse(const ANSICHAR* Text, const EPomodoroImportFormat Format, TArray<FPomodoroPhaseRecord>& OutRecords, int32& OutSkippedCount)
+	{
+		FPomodoroPhaseImporter::Parse(reinterpret_cast<const uint8*>(Text), FCStringAnsi::Strlen(Text), Format, OutRecords, OutSkippedCount);
+	}
+
+	static bool IsSameRecord(const FPomodoroPhaseRecord& A, const FPomodoroPhaseRecord& B)
+	{
+		return A.StartSeconds == B.StartSeconds && A.DurationSeconds == B.DurationSeconds && A.PausedSeconds == B.PausedSeconds
+			&& A.PauseCount == B.PauseCount && A.Phase == B.Phase && A.bCompleted == B.bCompleted;
+	}
+
+	/**
+	 * @brief Check that every number of chunks, up to a cut after each byte, reads what a single chunk reads.
+	 */
+	static void TestEveryChunkCount(FAutomationTestBase& Test, const ANSICHAR* Text, const EPomodoroImportFormat Format, const int32 ExpectedCount)
+	{
+		const uint8* Data = reinterpret_cast<const uint8*>(Text);
+		const int32 Size = FCStringAnsi::Strlen(Text);
+
+		TArray<FPomodoroPhaseRecord> Expected;
+		int32 ExpectedSkipped = 0;
+		FPomodoroPhaseImporter::Parse(Data, Size, Format, 1, Expected, ExpectedSkipped);
+		Test.TestEqual(TEXT("Records read in a single chunk"), Expected.Num(), ExpectedCount);
+
+		for(int32 ChunkCount = 2; ChunkCount <= Size; ++ChunkCount)
+		{
+			TArray<FPomodoroPhaseRecord> Records;
+			int32 SkippedCount = 0;
+			FPomodoroPhaseImporter::Parse(Data, Size, Format, ChunkCount, Records, SkippedCount);
+
+			bool bSame = Records.Num() == Expected.Num() && SkippedCount == ExpectedSkipped;
+			for(int32 Index = 0; bSame && Index < Records.Num(); ++Index)
+			{
+				bSame = IsSameRecord(Records[Index], Expected[Index]);
+			}
+			if(!bSame)
+			{
+				Test.AddError(FString::Printf(TEXT("%d chunks read %d records and skipped %d, a single chunk %d and %d"),
+					ChunkCount, Records.Num(), SkippedCount, Expected.Num(), ExpectedSkipped));
+				return;
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroImportCsvTest, "Pomodoro.Core.PhaseImporter.Csv",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroImportCsvTest::RunTest(const FString& Parameters)
+{
+	// Columns by name in any order, quoted fields, times as Unix seconds, milliseconds or ISO 8601 with an offset
+	const ANSICHAR* Csv =
+		"Type,Start Time,Duration,Completed,Pauses\n"
+		"pomodoro,1700000000,1500,yes,2\n"
+		"\"short break\",1700001600000,5:00,true,0\n"
+		"Long Break,2023-11-14T23:00:00Z,900,no,0\n"
+		"pomodoro,,1500,yes,0\n"
+		"pomodoro,1700010000,not a length,yes,0\n";
+
+	TArray<FPomodoroPhaseRecord> Records;
+	int32 SkippedCount = 0;
+	PomodoroPhaseImporterTests::Parse(Csv, EPomodoroImportFormat::Csv, Records, SkippedCount);
+	if(!TestEqual(TEXT("Records read"), Records.Num(), 3))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Records skipped"), SkippedCount, 2);
+
+	TestEqual(TEXT("Start in seconds"), Records[0].StartSeconds, static_cast<int64>(1700000000));
+	TestEqual(TEXT("Duration"), Records[0].DurationSeconds, 1500);
+	TestEqual(TEXT("Pause count"), Records[0].PauseCount, 2);
+	TestTrue(TEXT("Working"), Records[0].Phase == EPomodoroPhase::Working);
+	TestTrue(TEXT("Completed"), Records[0].bCompleted);
+
+	TestEqual(TEXT("Start in milliseconds"), Records[1].StartSeconds, static_cast<int64>(1700001600));
+	TestEqual(TEXT("Duration as mm:ss"), Records[1].DurationSeconds, 300);
+	TestTrue(TEXT("Short resting"), Records[1].Phase == EPomodoroPhase::ShortResting);
+
+	TestEqual(TEXT("ISO 8601 start"), Records[2].StartSeconds, static_cast<int64>(1700002800));
+	TestTrue(TEXT("Long resting"), Records[2].Phase == EPomodoroPhase::LongResting);
+	TestFalse(TEXT("Not completed"), Records[2].bCompleted);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroImportCsvQuotedLinesTest, "Pomodoro.Core.PhaseImporter.CsvQuotedLines",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroImportCsvQuotedLinesTest::RunTest(const FString& Parameters)
+{
+	// A quoted note over several lines stays in its record, a time without offset is a local time
+	const ANSICHAR* Csv =
+		"start,duration,note\n"
+		"1700000000,1500,\"first line\nsecond line, with a comma\"\n"
+		"2023-11-14 23:00:00,300,\"\"\"quoted\"\"\nthird line\"\n";
+
+	TArray<FPomodoroPhaseRecord> Records;
+	int32 SkippedCount = 0;
+	PomodoroPhaseImporterTests::Parse(Csv, EPomodoroImportFormat::Csv, Records, SkippedCount);
+	if(!TestEqual(TEXT("Records read"), Records.Num(), 2))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Records skipped"), SkippedCount, 0);
+	TestEqual(TEXT("Duration after a quoted line break"), Records[1].DurationSeconds, 300);
+
+	const FTimespan LocalOffset = FDateTime::Now() - FDateTime::UtcNow();
+	const int64 Expected = (FDateTime(2023, 11, 14, 23, 0, 0) - LocalOffset).ToUnixTimestamp();
+	TestTrue(TEXT("Time without offset read as local"), FMath::Abs(Records[1].StartSeconds - Expected) <= 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroImportJsonTest, "Pomodoro.Core.PhaseImporter.Json",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroImportJsonTest::RunTest(const FString& Parameters)
+{
+	// An array of objects, the length given by the end, unknown keys and nested objects ignored
+	const ANSICHAR* Json =
+		"[\n"
+		"  {\"start\": 1700000000, \"end\": 1700001500, \"type\": \"work\", \"meta\": {\"id\": 7}},\n"
+		"  {\"started_at\": \"2023-11-14T22:40:00Z\", \"minutes\": 5, \"mode\": \"break\", \"completed\": false},\n"
+		"  {\"note\": \"not a timespan\"}\n"
+		"]\n";
+
+	TArray<FPomodoroPhaseRecord> Records;
+	int32 SkippedCount = 0;
+	PomodoroPhaseImporterTests::Parse(Json, EPomodoroImportFormat::Json, Records, SkippedCount);
+	if(!TestEqual(TEXT("Records read"), Records.Num(), 2))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Records skipped"), SkippedCount, 1);
+
+	TestEqual(TEXT("Start"), Records[0].StartSeconds, static_cast<int64>(1700000000));
+	TestEqual(TEXT("Duration from the end"), Records[0].DurationSeconds, 1500);
+	TestTrue(TEXT("Working"), Records[0].Phase == EPomodoroPhase::Working);
+
+	TestEqual(TEXT("ISO 8601 start"), Records[1].StartSeconds, static_cast<int64>(1700001600));
+	TestEqual(TEXT("Duration in minutes"), Records[1].DurationSeconds, 300);
+	TestTrue(TEXT("Short resting"), Records[1].Phase == EPomodoroPhase::ShortResting);
+	TestFalse(TEXT("Not completed"), Records[1].bCompleted);
+
+	// An object per line gives the same records
+	const ANSICHAR* Lines =
+		"{\"start\": 1700000000, \"end\": 1700001500, \"type\": \"work\"}\n"
+		"{\"started_at\": \"2023-11-14T22:40:00Z\", \"minutes\": 5, \"mode\": \"break\", \"completed\": false}\n";
+	TArray<FPomodoroPhaseRecord> LineRecords;
+	PomodoroPhaseImporterTests::Parse(Lines, EPomodoroImportFormat::Json, LineRecords, SkippedCount);
+	TestEqual(TEXT("Records read per line"), LineRecords.Num(), 2);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroImportChunksTest, "Pomodoro.Core.PhaseImporter.Chunks",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroImportChunksTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroPhaseImporterTests;
+
+	// Cuts inside quoted fields holding line breaks, doubled quotes and delimiters
+	const ANSICHAR* Csv =
+		"Type;Start;Duration;Note\r\n"
+		"work;1700000000;1500;\"first line\r\nsecond; line\"\r\n"
+		"break;1700001600;300;\"\"\"quoted\"\"\n\"\"\"\n\n\"\r\n"
+		"work;not a time;1500;\"\"\r\n"
+		"work;1700001900;1500;\"a;b\"\";c\"\n"
+		"long break;1700003400;900;plain\n";
+	TestEveryChunkCount(*this, Csv, EPomodoroImportFormat::Csv, 4);
+
+	// Cuts inside strings holding escaped quotes and brackets, and inside nested objects and arrays
+	const ANSICHAR* Json =
+		"{\"meta\": {\"app\": \"timer {v2}\", \"tags\": [{\"id\": 1}]},\n"
+		" \"sessions\": [\n"
+		"  {\"start\": 1700000000, \"end\": 1700001500, \"type\": \"work\", \"note\": \"a \\\"}{\\\" b\"},\n"
+		"  {\"start\": 1700001600, \"duration\": 300, \"details\": {\"inner\": {\"deep\": \"]\"}}, \"type\": \"break\"},\n"
+		"  {\"note\": \"not a timespan, \\\\\"},\n"
+		"  {\"start\": \"2023-11-14T23:00:00Z\", \"minutes\": 15, \"type\": \"long break\"}\n"
+		" ]\n"
+		"}\n";
+	TestEveryChunkCount(*this, Json, EPomodoroImportFormat::Json, 3);
+
+	// An object per line
+	const ANSICHAR* Lines =
+		"{\"start\": 1700000000, \"duration\": 1500, \"tags\": {\"a\": [1, {\"b\": \"}\"}]}}\n"
+		"{\"start\": 1700001600, \"duration\": 300, \"type\": \"break\\\\\"}\n"
+		"{\"start\": 1700001900, \"duration\": 1500}\n";
+	TestEveryChunkCount(*this, Lines, EPomodoroImportFormat::Json, 3);
+	return true;
+}
+
+#endif
@@ -0,0 +1,131 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "PomodoroClock.h"
+#include "PomodoroEngine.h"
+#include "PomodoroPhaseNotes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroNoteIndexSearchTest, "Pomodoro.Core.PhaseNotes.Search",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroNoteIndexSearchTest::RunTest(const FString& Parameters)
+{
+	FPomodoroNoteIndex Index;
+	Index.Add(0, TEXT("Fixed the navmesh build"));
+	Index.Add(1, TEXT("Navigation bug in the nav-mesh, build again"));
+	Index.Add(2, TEXT("Review, review and REVIEW the build system"));
+	Index.Add(3, TEXT("Lunch"));
+
+	const auto Search = [&Index](const TCHAR* Query)
+	{
+		TArray<int32> Notes;
+		Index.Search(Query, Notes);
+		return Notes;
+	};
+
+	// Terms, whatever their case
+	TestTrue(TEXT("Term"), Search(TEXT("build")) == TArray<int32>({0, 1, 2}));
+	TestTrue(TEXT("Term in upper case"), Search(TEXT("BUILD")) == TArray<int32>({0, 1, 2}));
+	TestTrue(TEXT("Single note"), Search(TEXT("lunch")) == TArray<int32>({3}));
+	TestEqual(TEXT("Unknown term"), Search(TEXT("shader")).Num(), 0);
+	TestEqual(TEXT("Term prefix alone"), Search(TEXT("nav")).Num(), 1);
+
+	// Prefixes, a note holding several matching terms is found once
+	TestTrue(TEXT("Prefix"), Search(TEXT("nav*")) == TArray<int32>({0, 1}));
+	TestTrue(TEXT("Prefix of a split word"), Search(TEXT("nav-m*")) == TArray<int32>({1}));
+	TestEqual(TEXT("Unknown prefix"), Search(TEXT("q*")).Num(), 0);
+
+	// Every word must match
+	TestTrue(TEXT("Two words"), Search(TEXT("build nav*")) == TArray<int32>({0, 1}));
+	TestTrue(TEXT("Two terms"), Search(TEXT("review build")) == TArray<int32>({2}));
+	TestEqual(TEXT("Words of different notes"), Search(TEXT("lunch build")).Num(), 0);
+
+	// A word repeated in a note or a query counts once
+	TestTrue(TEXT("Word repeated in a note"), Search(TEXT("review")) == TArray<int32>({2}));
+	TestTrue(TEXT("Word repeated in a query"), Search(TEXT("build build")) == TArray<int32>({0, 1, 2}));
+	TestEqual(TEXT("Empty query"), Search(TEXT("  ")).Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroPhaseNotesRoundTripTest, "Pomodoro.Core.PhaseNotes.SaveThenLoad",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroPhaseNotesRoundTripTest::RunTest(const FString& Parameters)
+{
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PomodoroPhaseNotesTest.bin"));
+	const FString HistoryPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PomodoroPhaseNotesTestHistory.bin"));
+	IFileManager::Get().Delete(*Path);
+
+	const TSharedRef<FPomodoroEngine> Engine = MakeShared<FPomodoroEngine>(MakeShared<FPomodoroClock>(), nullptr);
+	const TSharedRef<FPomodoroPhaseHistory> History = MakeShared<FPomodoroPhaseHistory>(Engine, FPomodoroPhaseHistoryFile(), HistoryPath);
+
+	// Saved once destroyed
+	{
+		FPomodoroPhaseNotes Notes(History, FPomodoroPhaseNotesFile(), Path);
+		Notes.AddNote(1700000000, EPomodoroPhase::Working, TEXT("First note about the renderer"));
+		Notes.AddNote(1700001800, EPomodoroPhase::Working, TEXT("  Second note, shader work  "));
+		Notes.AddNote(1700003600, EPomodoroPhase::LongResting, TEXT("Third"));
+	}
+
+	FPomodoroPhaseNotesFile Loaded = FPomodoroPhaseNotes::ReadNotesFile(Path);
+	TestTrue(TEXT("File is valid"), Loaded.bValid);
+	if(!TestEqual(TEXT("Notes read"), Loaded.Notes.Num(), 3))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Start"), Loaded.Notes[1].StartSeconds, static_cast<int64>(1700001800));
+	TestEqual(TEXT("Text trimmed"), Loaded.Notes[1].Text, FString(TEXT("Second note, shader work")));
+	TestTrue(TEXT("Phase"), Loaded.Notes[2].Phase == EPomodoroPhase::LongResting);
+
+	// The index comes with the file, the newest notes are found first
+	{
+		FPomodoroPhaseNotes Notes(History, MoveTemp(Loaded), Path);
+		TArray<int32> Found;
+		Notes.Search(TEXT("note"), 10, Found);
+		TestTrue(TEXT("Loaded notes are indexed"), Found == TArray<int32>({1, 0}));
+		Notes.Search(TEXT("note"), 1, Found);
+		TestTrue(TEXT("Results are limited"), Found == TArray<int32>({1}));
+	}
+
+	// An interrupted append leaves a partial note, the ones before it are kept
+	TArray<uint8> Bytes;
+	if(!TestTrue(TEXT("File is written"), FFileHelper::LoadFileToArray(Bytes, *Path)))
+	{
+		return false;
+	}
+	Bytes.SetNum(Bytes.Num() - 3);
+	FFileHelper::SaveArrayToFile(Bytes, *Path);
+
+	FPomodoroPhaseNotesFile Truncated = FPomodoroPhaseNotes::ReadNotesFile(Path);
+	TestFalse(TEXT("Truncated file is not valid"), Truncated.bValid);
+	TestEqual(TEXT("Notes before the partial one"), Truncated.Notes.Num(), 2);
+
+	// The next save writes the file again rather than appending after the partial note
+	{
+		FPomodoroPhaseNotes Notes(History, MoveTemp(Truncated), Path);
+		Notes.AddNote(1700005400, EPomodoroPhase::ShortResting, TEXT("Fourth"));
+	}
+	const FPomodoroPhaseNotesFile Rewritten = FPomodoroPhaseNotes::ReadNotesFile(Path);
+	TestTrue(TEXT("Rewritten file is valid"), Rewritten.bValid);
+	if(TestEqual(TEXT("Notes after the rewrite"), Rewritten.Notes.Num(), 3))
+	{
+		TestEqual(TEXT("Note added after the truncation"), Rewritten.Notes[2].Text, FString(TEXT("Fourth")));
+	}
+
+	// An unknown file is ignored
+	FFileHelper::SaveStringToFile(TEXT("not notes"), *Path);
+	const FPomodoroPhaseNotesFile Unknown = FPomodoroPhaseNotes::ReadNotesFile(Path);
+	TestFalse(TEXT("Unknown file is not valid"), Unknown.bValid);
+	TestEqual(TEXT("Unknown file has no notes"), Unknown.Notes.Num(), 0);
+
+	IFileManager::Get().Delete(*Path);
+	IFileManager::Get().Delete(*HistoryPath);
+	return true;
+}
+
+#endif
@@ -0,0 +1,112 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "PomodoroClock.h"
+#include "PomodoroEngine.h"
+#include "PomodoroSessionLog.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PomodoroSessionLogTests
+{
+	/**
+	 * @brief Clock only moving when the test steps it.
+	 */
+	class FSteppedClock final : public FPomodoroClock
+	{
+	public:
+		virtual double GetSeconds() const override
+		{
+			return Seconds;
+		}
+
+		virtual FDateTime GetUtcNow() const override
+		{
+			return Utc;
+		}
+
+		/**
+		 * @brief Move the time forward and run the due timers.
+		 */
+		void Step(const double DeltaSeconds)
+		{
+			Seconds += DeltaSeconds;
+			Utc += FTimespan::FromSeconds(DeltaSeconds);
+			Advance();
+		}
+
+	private:
+		double Seconds = 1000.0;
+		FDateTime Utc = FDateTime(2024, 1, 1, 9, 0, 0);
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroSessionLogReplayTest, "Pomodoro.Core.SessionLog.WriteThenReplay",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroSessionLogReplayTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroSessionLogTests;
+
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("PomodoroSessionLogTest.bin"));
+	const TSharedRef<FSteppedClock> Clock = MakeShared<FSteppedClock>();
+	TArray<bool> Elapsed;
+	{
+		// Short timespans, a few cycles run in a hundred ticks
+		const TSharedRef<FPomodoroEngine> Engine = MakeShared<FPomodoroEngine>(Clock, nullptr);
+		const TSharedRef<FPomodoroSessionLog> Log = MakeShared<FPomodoroSessionLog>(Path);
+		Engine->SetSessionLog(Log);
+		Engine->BindOnTimeSpanElapsed(FElapsedTimespanHandleDelegate::CreateLambda([&Elapsed](const bool bWorkingTime)
+		{
+			Elapsed.Add(bWorkingTime);
+		}));
+		Engine->SetCycleCount(2);
+		Engine->SetWorkingTimespan(0, 0, 5);
+		Engine->SetShortRestingTimespan(0, 0, 3);
+		Engine->SetLongRestingTimespan(0, 0, 4);
+
+		Engine->Start();
+		for(int32 Step = 0; Step < 12; ++Step)
+		{
+			Clock->Step(1.0);
+		}
+		Engine->Pause();
+		Clock->Step(2.5);
+		Engine->Start();
+		for(int32 Step = 0; Step < 20; ++Step)
+		{
+			Clock->Step(1.0);
+		}
+		Engine->Stop();
+
+		Engine->SetSessionLog(nullptr);
+		Log->Save();
+	}
+
+	const FPomodoroReplayResult Result = FPomodoroSessionReplay::ReplayFile(Path);
+	IFileManager::Get().Delete(*Path);
+
+	TestTrue(TEXT("Log is readable"), Result.Error.IsEmpty());
+	TestTrue(TEXT("Inputs were replayed"), Result.InputCount > 0);
+	TestTrue(TEXT("Timespans ended"), Elapsed.Num() > 0);
+	TestTrue(TEXT("Recorded timespan ends"), Result.RecordedElapsed == Elapsed);
+	TestTrue(TEXT("Session is reproduced"), Result.IsReproduced());
+	TestEqual(TEXT("Diverged input"), Result.DivergedInput, static_cast<int32>(INDEX_NONE));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroSessionLogInvalidTest, "Pomodoro.Core.SessionLog.InvalidLog",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroSessionLogInvalidTest::RunTest(const FString& Parameters)
+{
+	const uint8 Garbage[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+	const FPomodoroReplayResult Result = FPomodoroSessionReplay::Replay(Garbage);
+	TestFalse(TEXT("Garbage is rejected"), Result.Error.IsEmpty());
+	TestFalse(TEXT("Garbage is not reproduced"), Result.IsReproduced());
+	return true;
+}
+
+#endif
@@ -0,0 +1,116 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+/**
+ * @brief Identify a timer of a clock, 0 when no timer is set.
+ */
+using FPomodoroTimerHandle = uint64;
+
+/**
+ * Source of time and of the looping timers the engine runs on.
+ *
+ * Nothing happens by itself : Advance runs the due timers, at the current time of the clock.
+ * A manual clock only has to override the time getters and call Advance to drive an engine.
+ * Everything happens on a single thread.
+ */
+class POMODOROCORE_API FPomodoroClock
+{
+public:
+	virtual ~FPomodoroClock() = default;
+
+	/**
+	 * @brief Give the current monotonic time.
+	 * @return Seconds since an arbitrary origin.
+	 */
+	virtual double GetSeconds() const;
+
+	/**
+	 * @brief Give the current UTC time.
+	 * @return The current UTC time.
+	 */
+	virtual FDateTime GetUtcNow() const;
+
+	/**
+	 * @brief Call a delegate periodically, the same way the timer manager does.
+	 *
+	 * A period of zero calls the delegate at every Advance. Calls missed since the last Advance
+	 * are all made, so a long frame doesn't lose time.
+	 * @param Handle Handle of the timer, the timer it identifies is replaced.
+	 * @param Delegate Delegate to call.
+	 * @param PeriodSeconds Time between two calls.
+	 * @param FirstDelaySeconds Time before the first call.
+	 */
+	void SetTimer(FPomodoroTimerHandle& Handle, FSimpleDelegate Delegate, double PeriodSeconds, double FirstDelaySeconds);
+
+	/**
+	 * @brief Remove a timer.
+	 * @param Handle Handle of the timer, reset to 0.
+	 */
+	void ClearTimer(FPomodoroTimerHandle& Handle);
+
+	/**
+	 * @brief Call the due timers.
+	 */
+	void Advance();
+
+private:
+	/**
+	 * @brief Looping timer.
+	 */
+	struct FTimer
+	{
+		FPomodoroTimerHandle Handle;
+		FSimpleDelegate Delegate;
+		double PeriodSeconds;
+		double NextSeconds;
+	};
+
+	/**
+	 * @brief Timers currently set.
+	 */
+	TArray<FTimer> Timers;
+
+	/**
+	 * @brief Handle given to the next timer.
+	 */
+	FPomodoroTimerHandle NextHandle = 1;
+
+	/**
+	 * @brief Find a timer.
+	 * @param Handle Handle of the timer.
+	 * @return The timer, null if it is not set.
+	 */
+	FTimer* FindTimer(FPomodoroTimerHandle Handle);
+};
+
+/**
+ * Clock advanced by the core ticker, once per frame, in the editor as well as in game builds and tools.
+ */
+class POMODOROCORE_API FPomodoroTickerClock final : public FPomodoroClock
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroTickerClock, start advancing with the core ticker.
+	 */
+	FPomodoroTickerClock();
+
+	/**
+	 * @brief Standard destructor for FPomodoroTickerClock.
+	 */
+	virtual ~FPomodoroTickerClock() override;
+
+private:
+	/**
+	 * @brief Handle of the core ticker delegate.
+	 */
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::FDelegateHandle TickerHandle;
+#else
+	FDelegateHandle TickerHandle;
+#endif
+};
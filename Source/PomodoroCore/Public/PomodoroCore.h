@@ -0,0 +1,7 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+POMODOROCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogPomodoro, Log, All);
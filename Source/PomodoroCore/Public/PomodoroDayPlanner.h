@@ -0,0 +1,210 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroSnapshot.h"
+#include "PomodoroSettings.h"
+
+/**
+ * Range of the day, as times of day.
+ */
+struct FPomodoroTimeRange
+{
+	FTimespan Start;
+	FTimespan End;
+};
+
+/**
+ * A timespan of the day plan.
+ */
+struct FPomodoroPlannedBlock
+{
+	EPomodoroPhase Phase = EPomodoroPhase::Working;
+	FDateTime Start;
+	FDateTime End;
+};
+
+/**
+ * Plan the working and resting timespans of the day around fixed commitments.
+ *
+ * The free windows of the working hours are filled with timespans following the engine rules : a resting
+ * timespan after each working one, the long one closing each cycle. A commitment stands for the resting timespan
+ * due when it starts. The plan maximizes the focus time with a dynamic programming solver over the minutes
+ * of each window, solved backward from the end of the day.
+ *
+ * A window table only depends on the windows after it, so editing a commitment only solves the windows
+ * before it again, and planning again from the current time after an interruption only walks the tables.
+ */
+class POMODOROCORE_API FPomodoroDayPlanner final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroDayPlanner, load the last saved configuration.
+	 * @param InConfigStore Where the configuration is saved, none to only use the standard one.
+	 */
+	explicit FPomodoroDayPlanner(TSharedPtr<IPomodoroConfigStore> InConfigStore = nullptr);
+
+	/**
+	 * @brief Set the timespans to plan, like the engine ones.
+	 * @param Working Length of a working timespan.
+	 * @param ShortResting Length of a short resting timespan.
+	 * @param LongResting Length of a long resting timespan.
+	 * @param NewCycleCount Number of working timespans in a cycle.
+	 */
+	void SetTimespans(FTimespan Working, FTimespan ShortResting, FTimespan LongResting, int32 NewCycleCount);
+
+	/**
+	 * @brief Set the working hours of the day.
+	 * @param NewWorkingHours Start and end of the working day.
+	 */
+	void SetWorkingHours(const FPomodoroTimeRange& NewWorkingHours);
+
+	/**
+	 * @brief Used to get the working hours of the day.
+	 * @return Start and end of the working day.
+	 */
+	const FPomodoroTimeRange& GetWorkingHours() const;
+
+	/**
+	 * @brief Set the fixed commitments of the day, in any order.
+	 * @param NewCommitments Commitments the timespans are planned around.
+	 */
+	void SetCommitments(const TArray<FPomodoroTimeRange>& NewCommitments);
+
+	/**
+	 * @brief Used to get the fixed commitments of the day.
+	 * @return The commitments, as set.
+	 */
+	const TArray<FPomodoroTimeRange>& GetCommitments() const;
+
+	/**
+	 * @brief Plan the rest of the day from the engine state.
+	 * @param Snapshot Engine state. A running timespan is kept until its deadline, a paused one resumes now
+	 * with its remaining time, and a stopped engine starts from the first working timespan.
+	 * @param Now Current local time.
+	 */
+	void Replan(const FPomodoroEngineSnapshot& Snapshot, const FDateTime& Now);
+
+	/**
+	 * @brief Used to get the last plan.
+	 * @return The planned timespans, in order.
+	 */
+	const TArray<FPomodoroPlannedBlock>& GetPlan() const;
+
+	/**
+	 * @brief Used to get the last plan, formatted for display.
+	 * @return One line per planned timespan.
+	 */
+	const FText& GetPlanText() const;
+
+	/**
+	 * @brief Used to get the focus time of the last plan.
+	 * @return Total length of the planned working timespans.
+	 */
+	FTimespan GetPlannedFocusTime() const;
+
+	/**
+	 * @brief Reset the current configuration of this planner
+	 */
+	void ResetConfig();
+
+	/**
+	 * @brief Reload the current configuration of this planner to the last one saved
+	 */
+	void ReloadConfig();
+
+	/**
+	 * @brief Save the current configuration of this planner
+	 */
+	void SaveConfig() const;
+
+	/**
+	 * @brief Format time ranges as "09:00-10:30, 14:00-15:00".
+	 * @param Ranges The ranges to format.
+	 * @return The formatted ranges.
+	 */
+	static FString FormatTimeRanges(const TArray<FPomodoroTimeRange>& Ranges);
+
+	/**
+	 * @brief Parse time ranges formatted as "09:00-10:30, 14:00-15:00".
+	 * @param Text The text to parse.
+	 * @param OutRanges The ranges parsed.
+	 * @return False if the text is malformed.
+	 */
+	static bool ParseTimeRanges(const FString& Text, TArray<FPomodoroTimeRange>& OutRanges);
+
+private:
+	/**
+	 * @brief Free range of the working hours, between two commitments, with its solved table.
+	 *
+	 * The tables hold, for each minute of the window and each engine state, the best focus time
+	 * until the end of the day and the choice reaching it.
+	 */
+	struct FWindow
+	{
+		int32 StartMinute = 0;
+		int32 EndMinute = 0;
+		TArray<int16> Values;
+		TArray<uint8> Choices;
+		bool bSolved = false;
+	};
+
+	/**
+	 * @brief Where the configuration is saved.
+	 */
+	TSharedPtr<IPomodoroConfigStore> ConfigStore;
+
+	/**
+	 * @brief Planned timespan lengths, in minutes.
+	 */
+	int32 WorkingMinutes;
+	int32 ShortRestingMinutes;
+	int32 LongRestingMinutes;
+
+	/**
+	 * @brief Number of working timespans in a cycle.
+	 */
+	int32 CycleCount;
+
+	/**
+	 * @brief Start and end of the working day.
+	 */
+	FPomodoroTimeRange WorkingHours;
+
+	/**
+	 * @brief Commitments, as set.
+	 */
+	TArray<FPomodoroTimeRange> Commitments;
+
+	/**
+	 * @brief Free windows of the day, in order.
+	 */
+	TArray<FWindow> Windows;
+
+	/**
+	 * @brief Last plan.
+	 */
+	TArray<FPomodoroPlannedBlock> Plan;
+
+	/**
+	 * @brief Last plan, formatted for display.
+	 */
+	FText PlanText;
+
+	/**
+	 * @brief Compute the free windows again, keeping the tables of the unchanged windows ending the day.
+	 */
+	void UpdateWindows();
+
+	/**
+	 * @brief Fill the table of a window, the next windows must be solved.
+	 * @param Index Index of the window.
+	 */
+	void SolveWindow(int32 Index);
+
+	/**
+	 * @brief Format the last plan for display.
+	 */
+	void UpdatePlanText();
+};
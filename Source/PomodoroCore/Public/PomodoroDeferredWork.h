@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroClock.h"
+
+DECLARE_DELEGATE_RetVal(bool, FPomodoroIsBusyDelegate)
+
+/**
+ * @brief Priority of a deferred work item, among the items due at the same time
+ */
+enum class EPomodoroWorkPriority : uint8
+{
+	/** Seen by the user, like a notification */
+	High = 0,
+
+	/** Default priority */
+	Normal = 1,
+
+	/** Only kept on disk, like a config save */
+	Low = 2,
+};
+
+/**
+ * Run the work the plugin can postpone, like saves, when the frames have time to spare.
+ *
+ * Items run each time the clock advances, within a small time slice, and only when the last frame left idle time
+ * or wasn't busier than the target frame time. While the host is busy, during a play session in the editor for instance,
+ * only the items past their deadline run.
+ * An item enqueued again under the same key replaces the pending one and keeps the earliest deadline,
+ * so repeated saves are coalesced. Everything pending runs when the scheduler is destroyed.
+ *
+ * Enqueue and flush through the static functions : without scheduler, in a commandlet for instance, the work runs at once.
+ * Everything happens on the game thread.
+ */
+class POMODOROCORE_API FPomodoroDeferredWork final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroDeferredWork, becomes the scheduler used by Enqueue.
+	 * @param InClock Clock the items run on.
+	 * @param InIsBusy Tell whether the host is busy, only the items past their deadline run then.
+	 */
+	FPomodoroDeferredWork(TSharedRef<FPomodoroClock> InClock, FPomodoroIsBusyDelegate InIsBusy);
+
+	/**
+	 * @brief Standard destructor for FPomodoroDeferredWork, run everything pending.
+	 */
+	~FPomodoroDeferredWork();
+
+	/**
+	 * @brief Postpone some work.
+	 * @param Key Identify the work, a pending item with the same key is replaced.
+	 * @param Priority Priority among the items due at the same time.
+	 * @param MaxDelaySeconds The work runs at the latest after this delay, whatever the frame load.
+	 * @param Work The work.
+	 */
+	static void Enqueue(FName Key, EPomodoroWorkPriority Priority, double MaxDelaySeconds, TUniqueFunction<void()> Work);
+
+	/**
+	 * @brief Run a pending item now, used when the object it works on goes away.
+	 * @param Key Key of the item.
+	 */
+	static void Flush(FName Key);
+
+	/**
+	 * @brief Run every pending item now.
+	 */
+	void FlushAll();
+
+private:
+	/**
+	 * @brief Pending work.
+	 */
+	struct FItem
+	{
+		FName Key;
+		EPomodoroWorkPriority Priority;
+		double DeadlineSeconds;
+		TUniqueFunction<void()> Work;
+	};
+
+	/**
+	 * @brief Scheduler used by the static functions, null when none exists.
+	 */
+	static FPomodoroDeferredWork* Instance;
+
+	/**
+	 * @brief Clock the items run on.
+	 */
+	TSharedRef<FPomodoroClock> Clock;
+
+	/**
+	 * @brief Tell whether the host is busy.
+	 */
+	FPomodoroIsBusyDelegate IsBusy;
+
+	/**
+	 * @brief Handle of the timer running the items.
+	 */
+	FPomodoroTimerHandle TimerHandle = 0;
+
+	/**
+	 * @brief Pending items, in no particular order.
+	 */
+	TArray<FItem> Items;
+
+	/**
+	 * @brief Run the next items, within a time slice, each time the clock advances.
+	 */
+	void RunSlice();
+
+	/**
+	 * @brief Give the next item to run.
+	 * @param bDueOnly Only consider the items past their deadline.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 * @return Index of the item, INDEX_NONE when none.
+	 */
+	int32 FindNext(bool bDueOnly, double NowSeconds) const;
+
+	/**
+	 * @brief Remove an item and run it.
+	 * @param Index Index of the item.
+	 */
+	void RunItem(int32 Index);
+
+	/**
+	 * @brief Tell whether the last frame left time to spare.
+	 * @return True if deferred work can run without showing in the frame time.
+	 */
+	static bool HasSpareBudget();
+};
@@ -0,0 +1,503 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "PomodoroClock.h"
+#include "PomodoroSettings.h"
+#include "PomodoroSessionLog.h"
+#include "PomodoroState.h"
+#include "PomodoroSnapshot.h"
+
+DECLARE_EVENT_OneParam(FPomodoroEngine, FTimespanElapsed, bool)
+
+DECLARE_EVENT(FPomodoroEngine, FSnapshotPublished)
+
+DECLARE_DELEGATE_OneParam(FRequestStateDelegate, EPomodoroState)
+
+DECLARE_DELEGATE_OneParam(FElapsedTimespanHandleDelegate, bool)
+
+/**
+ * @brief Kind of a command posted to the engine.
+ */
+enum class EPomodoroEngineCommand : uint8
+{
+	Start,
+	Pause,
+	Stop,
+
+	/** Change the configuration and save it, only accepted while stopped */
+	Configure,
+
+	/** Change the timespan lengths at the next cycle boundary */
+	SetNextCycleTimespans
+};
+
+/**
+ * @brief Command posted to the engine from any thread.
+ */
+struct FPomodoroEngineCommand
+{
+	/** What the command does */
+	EPomodoroEngineCommand Kind = EPomodoroEngineCommand::Start;
+
+	/** New number of cycles, left unchanged when zero */
+	int32 CycleCount = 0;
+
+	/** New timespan lengths, left unchanged when zero */
+	FTimespan WorkingTimespan;
+	FTimespan ShortRestingTimespan;
+	FTimespan LongRestingTimespan;
+
+	/** FPlatformTime seconds past which the command is rejected instead of run, never when zero */
+	double ExpireSeconds = 0.0;
+};
+
+/**
+ * Controls the pomodoro behavior
+ *
+ * The engine and its getters belong to the game thread. Every transition is published
+ * to the snapshot channel, which is what other threads read, and other threads drive
+ * the engine by posting commands.
+ */
+class POMODOROCORE_API FPomodoroEngine final : public TSharedFromThis<FPomodoroEngine>
+{
+	public:
+	/**
+	 * @brief Standard constructor for FPomodoroEngine, load the last saved configuration.
+	 * @param InClock Clock the timer runs on.
+	 * @param InConfigStore Where the configuration is saved, none to only use the standard one.
+	 */
+	FPomodoroEngine(TSharedRef<FPomodoroClock> InClock, TSharedPtr<IPomodoroConfigStore> InConfigStore);
+	
+	/**
+	 * @brief Standard destructor for FPomodoroEngine, the commands still posted are rejected.
+	 */
+	~FPomodoroEngine();
+
+	/**
+	 * @brief Post a command, from any thread.
+	 *
+	 * Commands are queued without locking and run in order on the game thread, the next time the clock advances.
+	 * @param Command The command.
+	 * @return Future set once the command ran : true if it was applied, or forwarded to the leading editor,
+	 * false if it was rejected or had expired.
+	 */
+	TFuture<bool> Post(const FPomodoroEngineCommand& Command);
+
+	/**
+	 * @brief Start the engine.
+	 *
+	 * The configuration is not allowed in this state.
+	 */
+	void Start();
+
+	/**
+	 * @brief Stop the engine.
+	 *
+	 * In this state the engine will start from the very beginning.
+	 * The configuration is allowed in this state.
+	 */
+	void Stop();
+	
+	/**
+	 * @brief Pause the engine.
+	 *
+	 * In this state the engine is ready to start where it was previously paused.
+	 * Editing the configuration is not allowed in this state.
+	 */
+	void Pause();
+
+	
+	/**
+	 * @brief Used to configure the number of cycle of engine
+	 * @param NewCycleCount New number of cycle the engine will do before looping.
+	 */
+	void SetCycleCount(int32 NewCycleCount);
+
+	/**
+	 * @brief Used to configure the working timespan length
+	 * @param Hour Hour part of the working timespan length.
+	 * @param Minute Minute part of the working timespan length.
+	 * @param Second Second part of the working timespan length.
+	 */
+	void SetWorkingTimespan(int32 Hour, int32 Minute, int32 Second);
+
+	/**
+	 * @brief Used to configure the short resting timespan length
+	 * @param Hour Hour part of the short resting timespan length.
+	 * @param Minute Minute part of the short resting timespan length.
+	 * @param Second Second part of the short resting timespan length.
+	 */
+	void SetShortRestingTimespan(int32 Hour, int32 Minute, int32 Second);
+	
+	/**
+	 * @brief Used to configure the long resting timespan length
+	 * @param Hour Hour part of the long resting timespan length.
+	 * @param Minute Minute part of the long resting timespan length.
+	 * @param Second Second part of the long resting timespan length.
+	 */
+	void SetLongRestingTimespan(int32 Hour, int32 Minute, int32 Second);
+
+	/**
+	 * @brief Reset the engine configuration to standard config. 
+	 */
+	void ResetConfig();
+
+	/**
+	 * @brief Reload the last saved engine configuration. 
+	 */
+	void ReloadConfig();
+
+	/**
+	 * @brief Save the current engine configuration in file to be used again. 
+	 */
+	void SaveConfig() const;
+
+	
+	/**
+	 * @brief Return a text representation of the remaining timespan.
+	 * @return Text representation of the remaining timespan.
+	 */
+	FText GetTimerText() const;
+
+	/**
+	 * @brief Indicate current cycle the engine is running.
+	 * @return Current cycle the engine is running.
+	 */
+	int32 GetCurrentCycle() const;
+	
+	/**
+	 * @brief Indicate how many cycle the engine got (last one is used for long resting time)
+	 * @return How many cycle the engine got.
+	 */
+	int32 GetCycleCount() const;
+
+	/**
+	 * @brief Give the working timespan
+	 * @return A timespan representing the working timespan
+	 */
+	FTimespan GetWorkingTimespan() const;
+
+	/**
+	 * @brief Give the short resting timespan
+	 * @return A timespan representing the short resting timespan
+	 */
+	FTimespan GetShortRestingTimespan() const;
+	
+	/**
+	 * @brief Give the long resting timespan
+	 * @return A timespan representing the long resting timespan
+	 */
+	FTimespan GetLongRestingTimespan() const;
+	
+	/**
+	 * @brief Give the current state of the engine.
+	 * @return An enum representing current state.
+	 */
+	EPomodoroState GetState() const;
+	
+	/**
+	 * @brief Indicate if the current timespan is a working timespan.
+	 * @return True if current timespan is a working timespan, otherwise false.
+	 */
+	bool IsWorkingTime() const;
+
+	/**
+	 * @brief Give the kind of the current timespan.
+	 * @return An enum representing the current timespan kind.
+	 */
+	EPomodoroPhase GetPhase() const;
+
+	/**
+	 * @brief Give the channel the engine state is published to on every transition.
+	 *
+	 * The channel can be read from any thread without locking.
+	 * @return The snapshot channel of this engine.
+	 */
+	TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> GetSnapshotChannel() const;
+
+	/**
+	 * @brief Event broadcast on the game thread right after a new snapshot is published.
+	 * @return The snapshot published event.
+	 */
+	FSnapshotPublished& OnSnapshotPublished();
+
+
+	/**
+	 * @brief Stop owning the clock and mirror the timer of another editor instead.
+	 *
+	 * While following, Start, Pause and Stop are forwarded to the leading editor,
+	 * no timespan elapses locally and no notification is triggered.
+	 * @param RequestState Delegate forwarding the requested state to the leading editor.
+	 */
+	void Follow(FRequestStateDelegate RequestState);
+
+	/**
+	 * @brief Own the clock again, continuing from the last mirrored state.
+	 */
+	void Lead();
+
+	/**
+	 * @brief Indicate if the engine mirrors the timer of another editor.
+	 * @return True if the engine is following another editor.
+	 */
+	bool IsFollowing() const;
+
+	/**
+	 * @brief Apply the state of the leading editor, only used while following.
+	 * @param Snapshot Snapshot of the leading editor engine.
+	 */
+	void MirrorSnapshot(const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Realign the engine on the state of a remote engine, while keeping its own clock.
+	 *
+	 * Used to share a timer between several machines : the timespan ends at the given deadline
+	 * and is notified locally. Ignored while following another editor.
+	 * @param Snapshot Snapshot of the remote engine, its deadline converted to the local clock.
+	 */
+	void Synchronize(const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Change the timespan lengths at the next cycle boundary, or right away when stopped.
+	 * @param NewWorkingTimespan Length of the working timespan.
+	 * @param NewShortRestingTimespan Length of the short resting timespan.
+	 * @param NewLongRestingTimespan Length of the long resting timespan.
+	 */
+	void SetNextCycleTimespans(FTimespan NewWorkingTimespan, FTimespan NewShortRestingTimespan, FTimespan NewLongRestingTimespan);
+
+	
+	/**
+	 * @brief Used to bind object to TimespanElapsed event.
+	 * @param Delegate The delegate generated from the bound object.
+	 */
+	void BindOnTimeSpanElapsed(FElapsedTimespanHandleDelegate Delegate);
+
+	/**
+	 * @brief Record every input of the engine from now on, to reproduce the session later.
+	 * @param InSessionLog Log the inputs are recorded to, null to stop recording.
+	 */
+	void SetSessionLog(TSharedPtr<FPomodoroSessionLog> InSessionLog);
+
+private:
+	friend class FPomodoroSessionReplay;
+
+	/**
+	 * @brief Command waiting for the game thread, with the promise of its result.
+	 */
+	struct FPostedCommand
+	{
+		FPomodoroEngineCommand Command;
+		TPromise<bool> Result;
+	};
+
+	/**
+	 * @brief Current cycle the engine is running
+	 */
+	int CurrentCycle;
+	
+	/**
+	 * @brief Indicate how many cycle the engine got (last one is used for long resting time)
+	 */
+	int CycleCount;
+
+	/**
+	 * @brief Indicate if the current timespan is a working timespan
+	 */
+	bool WorkingTime;
+
+	/**
+	 * @brief Indicate the current state of the timer.
+	 */
+	EPomodoroState State;
+
+	/**
+	 * @brief Clock the timer runs on.
+	 */
+	TSharedRef<FPomodoroClock> Clock;
+
+	/**
+	 * @brief Where the configuration is saved.
+	 */
+	TSharedPtr<IPomodoroConfigStore> ConfigStore;
+
+	/**
+	 * @brief Handle used to control engine start, stop and pause.
+	 */
+	FPomodoroTimerHandle TimerHandle = 0;
+
+	/**
+	 * @brief Handle of the timer running the posted commands.
+	 */
+	FPomodoroTimerHandle PostedCommandsHandle = 0;
+	
+	/**
+	 * @brief Delegate for TimespanElapsed event.
+	 */
+	FTimespanElapsed ElapsedTimespanHandle;
+
+	/**
+	 * @brief Indicate how many time remains before the timespan end.
+	 */
+	FTimespan RemainingTimespan;
+
+	/**
+	 * @brief Text representation of RemainingTimespan. 
+	 */
+	FText TimerText;
+
+	/**
+	 * @brief Represent the lenght of working timespan.
+	 */
+	FTimespan WorkingTimespan;
+
+	/**
+	 * @brief Represent the lenght of short resting timespan.
+	 */
+	FTimespan ShortRestingTimespan;
+	
+	/**
+	 * @brief Represent the lenght of long resting timespan.
+	 */
+	FTimespan LongRestingTimespan;
+
+	/**
+	 * @brief Channel the engine state is published to.
+	 */
+	TSharedRef<FPomodoroSnapshotChannel, ESPMode::ThreadSafe> SnapshotChannel;
+
+	/**
+	 * @brief Event for snapshot publication.
+	 */
+	FSnapshotPublished SnapshotPublishedEvent;
+
+	/**
+	 * @brief Indicate if the engine mirrors the timer of another editor.
+	 */
+	bool bFollowing;
+
+	/**
+	 * @brief Forward the requested state to the leading editor while following.
+	 */
+	FRequestStateDelegate RemoteStateRequest;
+
+	/**
+	 * @brief End of the running timespan, the one of the leading editor while following.
+	 */
+	FDateTime Deadline;
+
+	/**
+	 * @brief Timespan lengths waiting for the next cycle : working, short resting and long resting.
+	 */
+	TOptional<TTuple<FTimespan, FTimespan, FTimespan>> PendingTimespans;
+
+	/**
+	 * @brief Commands posted by any thread, drained by the game thread.
+	 */
+	TQueue<FPostedCommand, EQueueMode::Mpsc> PostedCommands;
+
+	/**
+	 * @brief Log the inputs are recorded to, if any.
+	 */
+	TSharedPtr<FPomodoroSessionLog> SessionLog;
+
+	/**
+	 * @brief Number of inputs being handled, only the outermost one is recorded.
+	 */
+	int32 InputDepth = 0;
+	
+	
+	/**
+	 * @brief Triggered every second to update engine.
+	 */
+	void OnTick();
+	
+	/**
+	 * @brief Called when the timespan is elapsed.
+	 *
+	 * This function will update the pomodoro to use the appropriate next timespan.
+	 * Also it will trigger all the event that relate on elapsed timespan event.
+	 */
+	void OnElapsedTimespan();
+
+	/**
+	 * @brief Record an input, unless it is called while handling another one.
+	 *
+	 * Must be called first thing, under a guard incrementing InputDepth.
+	 * @param Event The input.
+	 * @param Arguments Integer arguments of the input.
+	 */
+	void RecordInput(EPomodoroSessionEvent Event, TArrayView<const int64> Arguments = TArrayView<const int64>());
+
+	/**
+	 * @brief Read the UTC time from the clock, recorded when the session is.
+	 * @return The current UTC time.
+	 */
+	FDateTime ReadUtcNow() const;
+
+	/**
+	 * @brief Read the monotonic time from the clock, recorded when the session is.
+	 * @return The current monotonic time.
+	 */
+	double ReadClockSeconds() const;
+
+	/**
+	 * @brief Give the whole state of the engine, for a recording to start from.
+	 * @return The state of the engine.
+	 */
+	FPomodoroSessionState CaptureSessionState() const;
+
+	/**
+	 * @brief Restore a state given by CaptureSessionState, when replaying a recording.
+	 * @param SessionState The state of the engine.
+	 */
+	void RestoreSessionState(const FPomodoroSessionState& SessionState);
+
+	/**
+	 * @brief Run the posted commands, each time the clock advances.
+	 */
+	void RunPostedCommands();
+
+	/**
+	 * @brief Run a posted command.
+	 * @param Command The command.
+	 * @return True if the command was applied, or forwarded to the leading editor.
+	 */
+	bool Execute(const FPomodoroEngineCommand& Command);
+
+	/**
+	 * @brief Called to update the Timer text
+	 */
+	void UpdateTimerText();
+
+	/**
+	 * @brief Publish the current state to the snapshot channel.
+	 *
+	 * Must be called after any change of state, timespan or configuration.
+	 */
+	void PublishSnapshot();
+
+	/**
+	 * @brief Apply the state, timespan and deadline of another engine, and align the tick on its deadline.
+	 * @param Snapshot Snapshot of the other engine.
+	 */
+	void ApplySnapshot(const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Apply the timespan lengths waiting for the next cycle, if any.
+	 */
+	void ApplyPendingTimespans();
+
+	/**
+	 * @brief Compute the remaining time from the deadline, in whole seconds like the countdown.
+	 */
+	void UpdateRemainingTimespan();
+
+	/**
+	 * @brief Arm the tick so it fires each time the displayed second changes, the last one at the deadline.
+	 */
+	void AlignTick();
+};
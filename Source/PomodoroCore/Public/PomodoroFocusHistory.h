@@ -0,0 +1,132 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "PomodoroPhaseHistory.h"
+
+/**
+ * Focus time of every day, aggregated as the working timespans run.
+ *
+ * Days are local days, numbered from 0001-01-01. The aggregates are a dense array from the first
+ * recorded day, so a range of days is read without any search, and they are saved in a small binary
+ * file of the project Saved directory once a working timespan stops, when the editor has time to spare.
+ */
+class POMODOROCORE_API FPomodoroFocusHistory final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroFocusHistory, load the saved history.
+	 * @param InEngine Engine observed.
+	 */
+	FPomodoroFocusHistory(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Standard destructor for FPomodoroFocusHistory, save the running segment.
+	 */
+	~FPomodoroFocusHistory();
+
+	/**
+	 * @brief Add focus time, split over the local days it covers.
+	 * @param StartLocal Local time the focus started at.
+	 * @param EndLocal Local time the focus ended at.
+	 */
+	void AddFocus(const FDateTime& StartLocal, const FDateTime& EndLocal);
+
+	/**
+	 * @brief Add the working timespans of records imported from another tool, and request a save.
+	 * @param Records The records, the other kinds are ignored.
+	 */
+	void AddRecords(TConstArrayView<FPomodoroPhaseRecord> Records);
+
+	/**
+	 * @brief Give the focus time of a day.
+	 * @param Day Day number, see GetDay.
+	 * @return Focus seconds of the day, running segment excluded.
+	 */
+	int32 GetFocusSeconds(int32 Day) const;
+
+	/**
+	 * @brief Give the first day holding focus time.
+	 * @return Day number of the first recorded day, today when nothing is recorded.
+	 */
+	int32 GetFirstDay() const;
+
+	/**
+	 * @brief Give the largest focus time of a day.
+	 * @return Focus seconds of the busiest day.
+	 */
+	int32 GetPeakSeconds() const;
+
+	/**
+	 * @brief Cheap change detection.
+	 * @return Incremented each time focus time is added.
+	 */
+	uint32 GetVersion() const;
+
+	/**
+	 * @brief Give the day number of a local time.
+	 * @param Local The local time.
+	 * @return Days since 0001-01-01.
+	 */
+	static int32 GetDay(const FDateTime& Local);
+
+	/**
+	 * @brief Give the path of the history file.
+	 * @return Path in the project Saved directory.
+	 */
+	static FString GetHistoryPath();
+
+private:
+	/**
+	 * @brief Engine observed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Day number of DailySeconds[0].
+	 */
+	int32 FirstDay = 0;
+
+	/**
+	 * @brief Focus seconds of each day from FirstDay.
+	 */
+	TArray<int32> DailySeconds;
+
+	/**
+	 * @brief Largest value of DailySeconds.
+	 */
+	int32 PeakSeconds = 0;
+
+	/**
+	 * @brief Incremented each time focus time is added.
+	 */
+	uint32 Version = 0;
+
+	/**
+	 * @brief Local start of the running segment, while a working timespan runs.
+	 */
+	bool bSegmentOpen = false;
+	FDateTime SegmentStartLocal;
+
+	/**
+	 * @brief Open or close the segment following the engine state.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Add the running segment to the history and save it.
+	 */
+	void CloseSegment();
+
+	/**
+	 * @brief Load the history file.
+	 */
+	void Load();
+
+	/**
+	 * @brief Save the history file.
+	 */
+	void Save();
+};
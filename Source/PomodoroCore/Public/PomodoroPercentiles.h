@@ -0,0 +1,292 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "PomodoroPhaseHistory.h"
+
+/**
+ * @brief Duration a percentile sketch measures
+ */
+enum class EPomodoroPercentileMetric : uint8
+{
+	/** Length of each pause */
+	Pause = 0,
+
+	/** Time the user kept working past the end of a working timespan, until a minute without input */
+	Overrun = 1,
+
+	/** Time a timespan ran before being paused or stopped */
+	Interruption = 2,
+};
+
+/**
+ * Streaming quantile sketch of durations in seconds, with a bounded relative error.
+ *
+ * Values are counted in logarithmic buckets: a value is one logarithm and one increment away from
+ * being added, and the quantiles are read back within RelativeAccuracy of the true value, whatever
+ * the number of values. Two sketches merge by adding their counts, the result is the sketch of both streams.
+ */
+class POMODOROCORE_API FPomodoroQuantileSketch final
+{
+public:
+	/** Relative error of the quantiles */
+	static constexpr double RelativeAccuracy = 0.02;
+
+	/** Number of buckets, covering values up to about four days */
+	static constexpr int32 BucketCount = 320;
+
+	/**
+	 * @brief Add a value.
+	 * @param Value Duration in seconds, the values under a second share one bucket.
+	 */
+	void Add(double Value);
+
+	/**
+	 * @brief Add the values of another sketch.
+	 * @param Other The sketch merged.
+	 */
+	void Merge(const FPomodoroQuantileSketch& Other);
+
+	/**
+	 * @brief Give a quantile of the values added.
+	 * @param Quantile Between 0 and 1, 0.95 for the 95th percentile.
+	 * @return The quantile, 0 if the sketch is empty.
+	 */
+	double GetQuantile(double Quantile) const;
+
+	/**
+	 * @brief Give the number of values added.
+	 * @return Number of values.
+	 */
+	uint64 GetCount() const;
+
+	/**
+	 * @brief Append the sketch, only the used buckets are written.
+	 * @param Bytes Bytes the sketch is appended to.
+	 */
+	void Encode(TArray<uint8>& Bytes) const;
+
+	/**
+	 * @brief Read a sketch written by Encode.
+	 * @param Data Start of the sketch, moved past it.
+	 * @param End End of the bytes.
+	 * @return False if the bytes are invalid.
+	 */
+	bool Decode(const uint8*& Data, const uint8* End);
+
+private:
+	/**
+	 * @brief Number of values of each bucket, bucket 0 holds the values under a second.
+	 */
+	uint32 Counts[BucketCount] = {};
+
+	/**
+	 * @brief Number of values added.
+	 */
+	uint64 Count = 0;
+
+	/**
+	 * @brief Smallest and largest values added, the quantiles are kept between them.
+	 */
+	double Min = 0.0;
+	double Max = 0.0;
+};
+
+/**
+ * Quantile sketches of each day, metric and timespan kind.
+ *
+ * Only the sketches holding values exist. A set merges with another one, from other days or other
+ * users, so the percentiles of a week or a team are read by merging a few sketches, never samples.
+ */
+class POMODOROCORE_API FPomodoroPercentileSet final
+{
+public:
+	/**
+	 * @brief Add a value to the sketch of a day.
+	 * @param Day Day number, see FPomodoroFocusHistory::GetDay.
+	 * @param Metric Duration measured.
+	 * @param Phase Kind of the timespan the value comes from.
+	 * @param Seconds The value.
+	 */
+	void Add(int32 Day, EPomodoroPercentileMetric Metric, EPomodoroPhase Phase, double Seconds);
+
+	/**
+	 * @brief Add the sketches of another set.
+	 * @param Other The set merged.
+	 */
+	void Merge(const FPomodoroPercentileSet& Other);
+
+	/**
+	 * @brief Merge the sketches of a range of days.
+	 * @param Metric Duration wanted.
+	 * @param Phase Kind of timespan wanted, every kind if unset.
+	 * @param FromDay First day, included.
+	 * @param ToDay Last day, included.
+	 * @return The merged sketch.
+	 */
+	FPomodoroQuantileSketch Query(EPomodoroPercentileMetric Metric, TOptional<EPomodoroPhase> Phase, int32 FromDay, int32 ToDay) const;
+
+	/**
+	 * @brief Cheap change detection.
+	 * @return Incremented each time a value is added.
+	 */
+	uint32 GetVersion() const;
+
+	/**
+	 * @brief Write the set in the percentiles file format.
+	 * @param Bytes The file content.
+	 */
+	void Save(TArray<uint8>& Bytes) const;
+
+	/**
+	 * @brief Read a set written by Save, the one of another user to merge for instance.
+	 * @param Bytes The file content.
+	 * @return False if the content is invalid, the set is then left empty.
+	 */
+	bool Load(TArrayView<const uint8> Bytes);
+
+	/** Number of metrics and timespan kinds */
+	static constexpr int32 MetricCount = 3;
+	static constexpr int32 PhaseCount = 3;
+
+private:
+	/**
+	 * @brief Sketches by day, metric and timespan kind, see MakeKey.
+	 */
+	TMap<uint32, FPomodoroQuantileSketch> Sketches;
+
+	/**
+	 * @brief Incremented each time a value is added.
+	 */
+	uint32 Version = 0;
+
+	/**
+	 * @brief Give the key of a sketch.
+	 */
+	static uint32 MakeKey(int32 Day, EPomodoroPercentileMetric Metric, EPomodoroPhase Phase);
+};
+
+/**
+ * Percentiles of the pauses, overruns and interruptions, sampled at the transitions of the engine and the inputs of the user.
+ *
+ * The sketches are kept per local day in a small binary file of the project Saved directory,
+ * saved when the editor has time to spare. Game thread only.
+ */
+class POMODOROCORE_API FPomodoroPercentiles final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroPercentiles, load the saved sketches.
+	 * @param InEngine Engine observed.
+	 */
+	FPomodoroPercentiles(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Constructor for FPomodoroPercentiles, start from sketches already read.
+	 * @param InEngine Engine observed.
+	 * @param LoadedSet The saved sketches, see ReadPercentilesFile.
+	 */
+	FPomodoroPercentiles(TSharedRef<FPomodoroEngine> InEngine, FPomodoroPercentileSet&& LoadedSet);
+
+	/**
+	 * @brief Standard destructor for FPomodoroPercentiles, save the sketches.
+	 */
+	~FPomodoroPercentiles();
+
+	/**
+	 * @brief Give the sketches of this user.
+	 * @return The sketches.
+	 */
+	const FPomodoroPercentileSet& GetSet() const;
+
+	/**
+	 * @brief Sample records imported from another tool, and request a save.
+	 *
+	 * A record only gives its pauses, as its average pause length, and its run before it was stopped.
+	 * @param Records The records.
+	 */
+	void AddRecords(TConstArrayView<FPomodoroPhaseRecord> Records);
+
+	/**
+	 * @brief Note an input of the user, to measure how long they keep working once a working timespan ended.
+	 * @param Seconds FPlatformTime seconds of the input.
+	 */
+	void AddUserActivity(double Seconds);
+
+	/**
+	 * @brief Give the path of the percentiles file.
+	 * @return Path in the project Saved directory.
+	 */
+	static FString GetPercentilesPath();
+
+	/**
+	 * @brief Read the percentiles file, from any thread.
+	 * @return The saved sketches, empty if there are none or the file is invalid.
+	 */
+	static FPomodoroPercentileSet ReadPercentilesFile();
+
+private:
+	/**
+	 * @brief Engine observed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Sketches of this user.
+	 */
+	FPomodoroPercentileSet Set;
+
+	/**
+	 * @brief Snapshot seen last, to detect the transitions.
+	 */
+	FPomodoroEngineSnapshot LastSnapshot;
+
+	/**
+	 * @brief FPlatformTime seconds the open timespan started at, and the time it spent paused.
+	 */
+	bool bPhaseOpen = false;
+	double PhaseStartSeconds = 0.0;
+	double PausedSeconds = 0.0;
+
+	/**
+	 * @brief FPlatformTime seconds the last working timespan ended at, and of the last input since, while its overrun is measured.
+	 */
+	bool bOverrunOpen = false;
+	double OverrunStartSeconds = 0.0;
+	double LastActivitySeconds = 0.0;
+
+	/**
+	 * @brief FPlatformTime seconds the running pause started at.
+	 */
+	double PauseStartSeconds = 0.0;
+
+	/**
+	 * @brief Sample the transitions of the engine state.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Add a value to today's sketch and request a save.
+	 * @param Metric Duration measured.
+	 * @param Phase Kind of the timespan.
+	 * @param Seconds The value.
+	 */
+	void AddSample(EPomodoroPercentileMetric Metric, EPomodoroPhase Phase, double Seconds);
+
+	/**
+	 * @brief Sample the overrun being measured, up to the last input of the user.
+	 */
+	void CloseOverrun();
+
+	/**
+	 * @brief Save the percentiles file later, through the deferred work.
+	 */
+	void RequestSave();
+
+	/**
+	 * @brief Save the percentiles file.
+	 */
+	void Save();
+};
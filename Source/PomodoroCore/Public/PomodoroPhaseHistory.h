@@ -0,0 +1,283 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "Async/Future.h"
+#include <atomic>
+
+/**
+ * @brief A timespan the leading editor ran, as kept in the phase history
+ */
+struct FPomodoroPhaseRecord
+{
+	/** UTC Unix time the timespan started at */
+	int64 StartSeconds = 0;
+
+	/** Time the timespan actually ran, pauses excluded */
+	int32 DurationSeconds = 0;
+
+	/** Time the timespan spent paused */
+	int32 PausedSeconds = 0;
+
+	/** Number of times the timespan was paused */
+	int32 PauseCount = 0;
+
+	/** Kind of the timespan */
+	EPomodoroPhase Phase = EPomodoroPhase::Working;
+
+	/** True if the timespan ran to its end, false if it was stopped */
+	bool bCompleted = false;
+};
+
+/**
+ * @brief Sealed block of the phase history, never modified once built
+ */
+struct FPomodoroPhaseSegment
+{
+	/** Earliest and latest record start, a query outside of them skips the block */
+	int64 MinSeconds = 0;
+	int64 MaxSeconds = 0;
+
+	/** Number of records of the block */
+	int32 Count = 0;
+
+	/** Size of the encoded records before compression */
+	int32 RawSize = 0;
+
+	/** Compressed encoded records */
+	TArray<uint8> Payload;
+};
+
+DECLARE_EVENT_OneParam(FPomodoroPhaseHistory, FPhaseRecorded, const FPomodoroPhaseRecord&)
+
+/**
+ * @brief Content of the history file, read on any thread before the history is built
+ */
+struct FPomodoroPhaseHistoryFile
+{
+	/** Sealed segments, oldest first */
+	TArray<TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe>> Segments;
+
+	/** Number of records in the segments */
+	int32 SealedCount = 0;
+
+	/** Records not sealed yet, oldest first */
+	TArray<FPomodoroPhaseRecord> Head;
+};
+
+/**
+ * Every timespan run, kept over years in a compact file of the project Saved directory.
+ *
+ * New records are appended to a small head. Once it holds enough records, a background task seals it
+ * into a segment: start times are stored as varint delta-of-delta, durations as varint deltas, then the
+ * block is compressed. The same task merges the small segments into larger ones, so the file holds few
+ * blocks, and swaps the new list in under a short lock, the writers never wait for the encoding.
+ * Queries decode only the segments overlapping the requested time range.
+ *
+ * Records are appended on the game thread, queries may run on any thread.
+ */
+class POMODOROCORE_API FPomodoroPhaseHistory final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroPhaseHistory, load the saved history.
+	 * @param InEngine Engine observed.
+	 */
+	FPomodoroPhaseHistory(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Constructor for FPomodoroPhaseHistory, start from a history file already read.
+	 * @param InEngine Engine observed.
+	 * @param Loaded The file content, see ReadHistoryFile.
+	 * @param InPath File the history is saved to.
+	 */
+	FPomodoroPhaseHistory(TSharedRef<FPomodoroEngine> InEngine, FPomodoroPhaseHistoryFile&& Loaded, const FString& InPath = GetHistoryPath());
+
+	/**
+	 * @brief Standard destructor for FPomodoroPhaseHistory, record the running timespan and save.
+	 */
+	~FPomodoroPhaseHistory();
+
+	/**
+	 * @brief Append a record, may start a compaction.
+	 * @param Record The record, expected to start after the previous ones.
+	 */
+	void Append(const FPomodoroPhaseRecord& Record);
+
+	/**
+	 * @brief Merge records imported from another tool, on the thread pool once the running compaction is done.
+	 *
+	 * The records are merged in time order. An imported record starting within DuplicateSeconds of a recorded one
+	 * of the same kind is dropped, importing the same export twice adds nothing. Inside the import, only the exact
+	 * copies, with the same start, length and kind, are dropped.
+	 * @param Records The records, in any order.
+	 * @param OnImported Called on the thread pool with the records added, oldest first.
+	 */
+	void Import(TArray<FPomodoroPhaseRecord> Records, TUniqueFunction<void(TArray<FPomodoroPhaseRecord>&&)> OnImported);
+
+	/**
+	 * @brief Event broadcast on the game thread each time a record is appended.
+	 * @return The phase recorded event.
+	 */
+	FPhaseRecorded& OnPhaseRecorded();
+
+	/**
+	 * @brief Visit the records starting in a time range, oldest first.
+	 * @param FromUtc Start of the range, included.
+	 * @param ToUtc End of the range, excluded.
+	 * @param Visitor Called for each record.
+	 */
+	void ForEachRecord(const FDateTime& FromUtc, const FDateTime& ToUtc, TFunctionRef<void(const FPomodoroPhaseRecord&)> Visitor) const;
+
+	/**
+	 * @brief Give the last record appended, or the last one sealed when the head is empty.
+	 * @return The record, unset if the history is empty.
+	 */
+	TOptional<FPomodoroPhaseRecord> GetLastRecord() const;
+
+	/**
+	 * @brief Give the number of records, sealed or not.
+	 * @return Number of records.
+	 */
+	int32 GetRecordCount() const;
+
+	/**
+	 * @brief Cheap change detection.
+	 * @return Incremented each time records are added or compacted.
+	 */
+	uint32 GetVersion() const;
+
+	/**
+	 * @brief Give the path of the history file.
+	 * @return Path in the project Saved directory.
+	 */
+	static FString GetHistoryPath();
+
+	/**
+	 * @brief Read the history file, from any thread. An unreadable one is moved aside before anything is saved over it.
+	 * @return The file content, empty if there is none.
+	 */
+	static FPomodoroPhaseHistoryFile ReadHistoryFile();
+
+	/**
+	 * @brief Encode and compress records into a segment, from any thread.
+	 * @param Records The records, oldest first.
+	 * @return The sealed segment.
+	 */
+	static TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> BuildSegment(TArrayView<const FPomodoroPhaseRecord> Records);
+
+	/**
+	 * @brief Decompress and decode the records of a segment, from any thread.
+	 * @param Segment The segment.
+	 * @param OutRecords Records the decoded ones are appended to, left as they were if the segment is invalid.
+	 * @return False if the segment is invalid.
+	 */
+	static bool DecodeSegment(const FPomodoroPhaseSegment& Segment, TArray<FPomodoroPhaseRecord>& OutRecords);
+
+private:
+	typedef TSharedRef<const FPomodoroPhaseSegment, ESPMode::ThreadSafe> FSegmentRef;
+
+	/**
+	 * @brief Engine observed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief File the history is saved to.
+	 */
+	FString Path;
+
+	/**
+	 * @brief Guard the head and the segment list, only held to copy or swap them.
+	 */
+	mutable FCriticalSection Lock;
+
+	/**
+	 * @brief Serialize the writes of the history file.
+	 */
+	FCriticalSection FileLock;
+
+	/**
+	 * @brief Sealed segments, oldest first.
+	 */
+	TArray<FSegmentRef> Segments;
+
+	/**
+	 * @brief Records not sealed yet, oldest first.
+	 */
+	TArray<FPomodoroPhaseRecord> Head;
+
+	/**
+	 * @brief Number of records in the segments.
+	 */
+	int32 SealedCount = 0;
+
+	/**
+	 * @brief Incremented each time records are added or compacted.
+	 */
+	std::atomic<uint32> Version{0};
+
+	/**
+	 * @brief Broadcast each time a record is appended.
+	 */
+	FPhaseRecorded PhaseRecordedEvent;
+
+	/**
+	 * @brief Running compaction, only one at a time.
+	 */
+	TFuture<void> Compaction;
+
+	/**
+	 * @brief Timespan being run, while the leading editor runs one.
+	 */
+	bool bPhaseOpen = false;
+	FPomodoroPhaseRecord OpenRecord;
+
+	/**
+	 * @brief FPlatformTime seconds the open timespan started at.
+	 */
+	double OpenSeconds = 0.0;
+
+	/**
+	 * @brief FPlatformTime seconds the last run of the open timespan started at, and the time run before it.
+	 */
+	bool bRunning = false;
+	double RunStartSeconds = 0.0;
+	double RunSeconds = 0.0;
+
+	/**
+	 * @brief Snapshot seen last, to detect the transitions.
+	 */
+	FPomodoroEngineSnapshot LastSnapshot;
+
+	/**
+	 * @brief Open and close the records following the engine state.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Append the open timespan.
+	 * @param bCompleted True if the timespan ran to its end.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 */
+	void ClosePhase(bool bCompleted, double NowSeconds);
+
+	/**
+	 * @brief Seal the head and merge the small segments, runs on the thread pool.
+	 */
+	void Compact();
+
+	/**
+	 * @brief Rebuild the segments with the imported records, runs on the thread pool.
+	 * @param Imported The records imported.
+	 * @return The records added, the duplicates left out.
+	 */
+	TArray<FPomodoroPhaseRecord> Merge(TArray<FPomodoroPhaseRecord> Imported);
+
+	/**
+	 * @brief Save the history file, from any thread.
+	 */
+	void Save();
+};
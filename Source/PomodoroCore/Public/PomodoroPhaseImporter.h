@@ -0,0 +1,98 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroPhaseHistory.h"
+#include "Async/Future.h"
+
+/**
+ * @brief Format of an export of another timer
+ */
+enum class EPomodoroImportFormat : uint8
+{
+	/** A header line naming the columns, then a timespan per line */
+	Csv = 0,
+
+	/** An array of flat objects, or an object per line */
+	Json = 1,
+};
+
+/**
+ * @brief Outcome of an import
+ */
+struct FPomodoroImportResult
+{
+	/** Size of the file read */
+	int64 Bytes = 0;
+
+	/** Number of timespans read */
+	int32 ParsedCount = 0;
+
+	/** Number of records which aren't timespans, or miss their start or length */
+	int32 SkippedCount = 0;
+
+	/** Number of timespans added to the history */
+	int32 AddedCount = 0;
+
+	/** Number of timespans dropped, already in the history or copies of another one of the file */
+	int32 DuplicateCount = 0;
+
+	/** Time spent mapping and parsing the file */
+	double ParseSeconds = 0.0;
+
+	/** Why the file can't be imported, empty if it was */
+	FString Error;
+};
+
+/**
+ * Import the history exported by other Pomodoro and time tracking tools.
+ *
+ * The file is memory mapped and cut at record boundaries into chunks parsed in parallel, the records
+ * are then merged into the phase history on the thread pool : the game thread only starts the merge.
+ * Columns and keys are recognized by name, like "start", "end", "duration", "type" or "completed".
+ * Times are Unix times, in seconds or milliseconds, or ISO 8601 texts read as local times when they have no offset.
+ * CSV fields can be quoted, and then hold line breaks.
+ */
+class POMODOROCORE_API FPomodoroPhaseImporter final
+{
+public:
+	/**
+	 * @brief Import a file into the history, call on the game thread.
+	 * @param Path Path of the export, the format is given by its extension.
+	 * @param History History the records are merged into.
+	 * @param OnAdded Called on the game thread with the records added to the history, before the outcome is set.
+	 * @return Outcome of the import, set on the game thread once the records are merged.
+	 */
+	static TFuture<FPomodoroImportResult> ImportFile(const FString& Path, TSharedRef<FPomodoroPhaseHistory> History,
+		TUniqueFunction<void(const TArray<FPomodoroPhaseRecord>&)> OnAdded = nullptr);
+
+	/**
+	 * @brief Parse an export, in parallel.
+	 * @param Data Content of the export, UTF-8.
+	 * @param Size Size of the content.
+	 * @param Format Format of the content.
+	 * @param OutRecords The timespans read, in the order of the file.
+	 * @param OutSkippedCount Number of records which aren't timespans.
+	 */
+	static void Parse(const uint8* Data, int64 Size, EPomodoroImportFormat Format, TArray<FPomodoroPhaseRecord>& OutRecords, int32& OutSkippedCount);
+
+	/**
+	 * @brief Parse an export, cut into a given number of chunks.
+	 * @param Data Content of the export, UTF-8.
+	 * @param Size Size of the content.
+	 * @param Format Format of the content.
+	 * @param ChunkCount Number of even cuts before they are moved to the record boundaries, 0 to pick it from the size and the workers.
+	 * @param OutRecords The timespans read, in the order of the file.
+	 * @param OutSkippedCount Number of records which aren't timespans.
+	 */
+	static void Parse(const uint8* Data, int64 Size, EPomodoroImportFormat Format, int32 ChunkCount, TArray<FPomodoroPhaseRecord>& OutRecords,
+		int32& OutSkippedCount);
+
+	/**
+	 * @brief Give the format of a file.
+	 * @param Path Path of the file.
+	 * @return Json for a .json or .jsonl file, Csv otherwise.
+	 */
+	static EPomodoroImportFormat GetFormat(const FString& Path);
+};
@@ -0,0 +1,238 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroPhaseHistory.h"
+
+/**
+ * @brief A note attached to a timespan of the phase history
+ */
+struct FPomodoroPhaseNote
+{
+	/** UTC Unix time the timespan started at, as in its phase record */
+	int64 StartSeconds = 0;
+
+	/** Kind of the timespan */
+	EPomodoroPhase Phase = EPomodoroPhase::Working;
+
+	/** Text of the note */
+	FString Text;
+};
+
+/**
+ * Inverted index of the note words, updated as the notes are added.
+ *
+ * The dictionary is an array of terms kept sorted, so the terms starting with a prefix are a contiguous
+ * range found by binary search. Each term has a posting list of the notes holding it, in increasing order,
+ * stored as varint gaps : adding a note appends a byte or two to the lists of its words.
+ */
+class POMODOROCORE_API FPomodoroNoteIndex final
+{
+public:
+	/**
+	 * @brief Index a note.
+	 * @param Note Number of the note, greater than the ones already indexed.
+	 * @param Text Text of the note.
+	 */
+	void Add(int32 Note, const FString& Text);
+
+	/**
+	 * @brief Empty the index.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Find the notes holding every word of a query, case insensitive.
+	 * @param Query Words separated by spaces, a word ending with * matches every term it starts.
+	 * @param OutNotes Numbers of the notes found, in increasing order.
+	 */
+	void Search(const FString& Query, TArray<int32>& OutNotes) const;
+
+	/**
+	 * @brief Split a text into the terms indexed.
+	 * @param Text The text.
+	 * @param OutTerms Lower case words, in order.
+	 */
+	static void Tokenize(const FString& Text, TArray<FString>& OutTerms);
+
+private:
+	/**
+	 * @brief A term and its posting list.
+	 */
+	struct FTerm
+	{
+		FString Term;
+
+		/** Gaps between the note numbers, as varints */
+		TArray<uint8> Postings;
+
+		/** Last note of the list, the next gap is computed from it */
+		int32 LastNote = INDEX_NONE;
+	};
+
+	/**
+	 * @brief Terms, sorted.
+	 */
+	TArray<FTerm> Terms;
+
+	/**
+	 * @brief Give the first term not less than a text.
+	 */
+	int32 LowerBound(const FString& Text) const;
+
+	/**
+	 * @brief Decode the posting list of a term into a sorted array.
+	 */
+	static void Decode(const FTerm& Term, TArray<int32>& OutNotes);
+};
+
+/**
+ * @brief Content of the notes file, read and indexed on any thread before the notes are built
+ */
+struct FPomodoroPhaseNotesFile
+{
+	/** Notes, oldest first */
+	TArray<FPomodoroPhaseNote> Notes;
+
+	/** Index of the note words */
+	FPomodoroNoteIndex Index;
+
+	/** Set when the file holds only valid notes, otherwise the next save writes it again */
+	bool bValid = false;
+};
+
+/**
+ * Notes attached to the timespans, stored next to the phase history and searched through an inverted index.
+ *
+ * A note goes to the last timespan recorded, the one whose end just fired. Notes are appended to a file
+ * of the project Saved directory when the editor has time to spare, the index is rebuilt when the file is read.
+ * Game thread only.
+ */
+class POMODOROCORE_API FPomodoroPhaseNotes final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroPhaseNotes, load the saved notes.
+	 * @param InHistory History the notes are attached to.
+	 */
+	FPomodoroPhaseNotes(TSharedRef<FPomodoroPhaseHistory> InHistory);
+
+	/**
+	 * @brief Constructor for FPomodoroPhaseNotes, start from a notes file already read.
+	 * @param InHistory History the notes are attached to.
+	 * @param Loaded The file content, see ReadNotesFile.
+	 * @param InPath File the notes are saved to.
+	 */
+	FPomodoroPhaseNotes(TSharedRef<FPomodoroPhaseHistory> InHistory, FPomodoroPhaseNotesFile&& Loaded, const FString& InPath = GetNotesPath());
+
+	/**
+	 * @brief Standard destructor for FPomodoroPhaseNotes, save the notes.
+	 */
+	~FPomodoroPhaseNotes();
+
+	/**
+	 * @brief Attach a note to the last timespan recorded.
+	 * @param Text Text of the note, cut to MaxNoteLength.
+	 * @return False if no timespan is recorded, or the text is empty.
+	 */
+	bool AddNoteToLastPhase(const FString& Text);
+
+	/**
+	 * @brief Attach a note to a timespan.
+	 * @param StartSeconds UTC Unix time the timespan started at.
+	 * @param Phase Kind of the timespan.
+	 * @param Text Text of the note, cut to MaxNoteLength.
+	 */
+	void AddNote(int64 StartSeconds, EPomodoroPhase Phase, const FString& Text);
+
+	/**
+	 * @brief Give the last timespan recorded, the one a note goes to.
+	 * @return The record, unset if the history is empty.
+	 */
+	const TOptional<FPomodoroPhaseRecord>& GetLastPhase() const;
+
+	/**
+	 * @brief Find the notes matching a query, newest first.
+	 * @param Query Words separated by spaces, a word ending with * matches every term it starts.
+	 * @param MaxResults Maximum number of notes to find.
+	 * @param OutNotes Numbers of the notes found.
+	 */
+	void Search(const FString& Query, int32 MaxResults, TArray<int32>& OutNotes) const;
+
+	/**
+	 * @brief Give a note.
+	 * @param Note Number of the note.
+	 * @return The note.
+	 */
+	const FPomodoroPhaseNote& GetNote(int32 Note) const;
+
+	/**
+	 * @brief Give the number of notes.
+	 * @return Number of notes.
+	 */
+	int32 GetNoteCount() const;
+
+	/**
+	 * @brief Give the path of the notes file.
+	 * @return Path in the project Saved directory.
+	 */
+	static FString GetNotesPath();
+
+	/**
+	 * @brief Read and index the notes file, from any thread. The notes before a truncated one are kept.
+	 * @param Path Path of the file.
+	 * @return The file content, empty if there is none or its format is unknown.
+	 */
+	static FPomodoroPhaseNotesFile ReadNotesFile(const FString& Path = GetNotesPath());
+
+	/** Longer notes are cut */
+	static constexpr int32 MaxNoteLength = 280;
+
+private:
+	/**
+	 * @brief History the notes are attached to.
+	 */
+	TSharedPtr<FPomodoroPhaseHistory> History;
+
+	/**
+	 * @brief File the notes are saved to.
+	 */
+	FString Path;
+
+	/**
+	 * @brief Notes, oldest first.
+	 */
+	TArray<FPomodoroPhaseNote> Notes;
+
+	/**
+	 * @brief Index of the note words.
+	 */
+	FPomodoroNoteIndex Index;
+
+	/**
+	 * @brief Last timespan recorded.
+	 */
+	TOptional<FPomodoroPhaseRecord> LastPhase;
+
+	/**
+	 * @brief Number of notes in the file, the next save appends the others.
+	 */
+	int32 SavedCount = 0;
+
+	/**
+	 * @brief Set once the file holds valid notes, otherwise the next save writes it again.
+	 */
+	bool bFileValid = false;
+
+	/**
+	 * @brief Remember the last timespan recorded.
+	 * @param Record The record.
+	 */
+	void OnPhaseRecorded(const FPomodoroPhaseRecord& Record);
+
+	/**
+	 * @brief Append the new notes to the file.
+	 */
+	void Save();
+};
@@ -0,0 +1,249 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroState.h"
+#include "PomodoroSnapshot.h"
+
+/**
+ * @brief Kind of an event of a session log.
+ */
+enum class EPomodoroSessionEvent : uint8
+{
+	/** Full state of the engine, when the recording starts */
+	Begin = 0,
+
+	/** Inputs of the engine, the calls made from outside of it */
+	Start,
+	Pause,
+	Stop,
+	SetCycleCount,
+	SetWorkingTimespan,
+	SetShortRestingTimespan,
+	SetLongRestingTimespan,
+	ResetConfig,
+	ReloadConfig,
+	SetNextCycleTimespans,
+	Follow,
+	Lead,
+	MirrorSnapshot,
+	Synchronize,
+
+	/** Arrival of the tick counting the seconds down */
+	Tick,
+
+	/** Readings of the clock made by the engine while handling the last input */
+	UtcReading,
+	SecondsReading,
+
+	/** Timespan ends broadcast by the engine, the outputs a replay must reproduce */
+	WorkingElapsed,
+	RestingElapsed,
+
+	Count
+};
+
+/**
+ * @brief State of the engine a recording starts from.
+ */
+struct FPomodoroSessionState
+{
+	EPomodoroState State = Stopped;
+	bool bWorkingTime = false;
+	bool bFollowing = false;
+
+	/** Current cycle, starting from 0 */
+	int32 CurrentCycle = 0;
+	int32 CycleCount = 0;
+
+	FTimespan Remaining;
+	FTimespan WorkingTimespan;
+	FTimespan ShortRestingTimespan;
+	FTimespan LongRestingTimespan;
+	FDateTime Deadline;
+
+	/** Timespan lengths waiting for the next cycle : working, short resting and long resting */
+	TOptional<TTuple<FTimespan, FTimespan, FTimespan>> PendingTimespans;
+};
+
+/**
+ * Record every input of an engine, with the clock readings it made and the timespan ends it broadcast.
+ *
+ * The log is a compact stream of events appended to a file, saved through the deferred work.
+ * Replaying it on a fresh engine reproduces the session exactly, see FPomodoroSessionReplay.
+ * Everything happens on the game thread.
+ */
+class POMODOROCORE_API FPomodoroSessionLog final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroSessionLog, start a new log.
+	 * @param InPath Path of the log file, replaced.
+	 */
+	explicit FPomodoroSessionLog(const FString& InPath);
+
+	/**
+	 * @brief Standard destructor for FPomodoroSessionLog, save what is still pending.
+	 */
+	~FPomodoroSessionLog();
+
+	/**
+	 * @brief Record the state the following events apply to.
+	 * @param State State of the engine.
+	 */
+	void AddBegin(const FPomodoroSessionState& State);
+
+	/**
+	 * @brief Record an input of the engine.
+	 * @param Event The input.
+	 * @param Arguments Integer arguments of the input, timespans as ticks, as many as the input takes.
+	 */
+	void AddInput(EPomodoroSessionEvent Event, TArrayView<const int64> Arguments = TArrayView<const int64>());
+
+	/**
+	 * @brief Record an input of the engine carrying a snapshot of another engine.
+	 * @param Event MirrorSnapshot or Synchronize.
+	 * @param Snapshot The snapshot.
+	 */
+	void AddSnapshotInput(EPomodoroSessionEvent Event, const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Record a reading of the UTC time.
+	 * @param Time The time read.
+	 */
+	void AddUtcReading(const FDateTime& Time);
+
+	/**
+	 * @brief Record a reading of the monotonic time.
+	 * @param Seconds The time read.
+	 */
+	void AddSecondsReading(double Seconds);
+
+	/**
+	 * @brief Record a timespan end.
+	 * @param bWorkingTime True if the ended timespan was a working timespan.
+	 */
+	void AddElapsed(bool bWorkingTime);
+
+	/**
+	 * @brief Append the pending events to the file.
+	 */
+	void Save();
+
+	/**
+	 * @brief Give the path of the log file.
+	 * @return Path of the log file.
+	 */
+	const FString& GetPath() const;
+
+	/**
+	 * @brief Give the directory the session logs of the project are kept in.
+	 * @return Path of the directory.
+	 */
+	static FString GetSessionDirectory();
+
+	/**
+	 * @brief Give the path of a new session log, named after the current time and the editor process.
+	 * @return Path of the log file.
+	 */
+	static FString MakeSessionPath();
+
+	/**
+	 * @brief Delete the session logs past the hundred newest or a month old, from any thread.
+	 */
+	static void PruneSessions();
+
+private:
+	/**
+	 * @brief Path of the log file.
+	 */
+	FString Path;
+
+	/**
+	 * @brief Key of the deferred save, one per log so two logs never replace each other's save.
+	 */
+	FName SaveKey;
+
+	/**
+	 * @brief Events not saved yet, the file header first if the file isn't written yet.
+	 */
+	TArray<uint8> Pending;
+
+	/**
+	 * @brief Ticks of the last UTC reading, the readings are stored as deltas.
+	 */
+	int64 LastUtcTicks = 0;
+
+	/**
+	 * @brief Set once the file is created, the next saves append to it.
+	 */
+	bool bFileCreated = false;
+
+	/**
+	 * @brief Set while a save is waiting in the deferred work.
+	 */
+	bool bSaveRequested = false;
+
+	/**
+	 * @brief Save the pending events later, through the deferred work.
+	 */
+	void RequestSave();
+};
+
+/**
+ * @brief Outcome of a session replay.
+ */
+struct FPomodoroReplayResult
+{
+	/** Number of inputs replayed */
+	int32 InputCount = 0;
+
+	/** Timespan ends recorded, true for a working timespan */
+	TArray<bool> RecordedElapsed;
+
+	/** Timespan ends broadcast by the replaying engine */
+	TArray<bool> ReplayedElapsed;
+
+	/** First input the replay diverged at, INDEX_NONE if it didn't */
+	int32 DivergedInput = INDEX_NONE;
+
+	/** Why the log can't be replayed, empty if it can */
+	FString Error;
+
+	/** Time the replay took */
+	double ReplaySeconds = 0.0;
+
+	/**
+	 * @brief Tell whether the replay reproduced the recorded session.
+	 * @return True if every input led to the recorded clock readings and timespan ends.
+	 */
+	bool IsReproduced() const
+	{
+		return Error.IsEmpty() && DivergedInput == INDEX_NONE && RecordedElapsed == ReplayedElapsed;
+	}
+};
+
+/**
+ * Drive a fresh engine from a session log, on a virtual clock serving the recorded readings.
+ *
+ * Nothing waits : the ticks are delivered as fast as the engine handles them,
+ * so a day of use replays in a few milliseconds.
+ */
+class POMODOROCORE_API FPomodoroSessionReplay final
+{
+public:
+	/**
+	 * @brief Replay a session log.
+	 * @param Log Content of the log file.
+	 * @return Outcome of the replay.
+	 */
+	static FPomodoroReplayResult Replay(TArrayView<const uint8> Log);
+
+	/**
+	 * @brief Replay a session log file.
+	 * @param Path Path of the log file.
+	 * @return Outcome of the replay.
+	 */
+	static FPomodoroReplayResult ReplayFile(const FString& Path);
+};
@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Configuration of the engine.
+ */
+struct FPomodoroEngineSettings
+{
+	/** Length of the working timespan */
+	FTimespan WorkingTimespan;
+
+	/** Length of the short resting timespan */
+	FTimespan ShortRestingTimespan;
+
+	/** Length of the long resting timespan */
+	FTimespan LongRestingTimespan;
+
+	/** Number of cycles before looping */
+	int32 CycleCount = 0;
+};
+
+/**
+ * @brief Configuration of the day planner.
+ */
+struct FPomodoroPlannerSettings
+{
+	/** Start of the working day, as a time of day */
+	FTimespan DayStart;
+
+	/** End of the working day, as a time of day */
+	FTimespan DayEnd;
+
+	/** Fixed commitments, as "HH:MM-HH:MM" ranges separated by commas */
+	FString Commitments;
+};
+
+/**
+ * Where the core components read and write their configuration.
+ *
+ * The core doesn't know how the configuration is stored, the editor keeps it in the project config.
+ * Without store, the components start from their standard configuration and don't save it.
+ */
+class POMODOROCORE_API IPomodoroConfigStore
+{
+public:
+	virtual ~IPomodoroConfigStore() = default;
+
+	/**
+	 * @brief Read the last saved engine configuration.
+	 * @return The engine configuration.
+	 */
+	virtual FPomodoroEngineSettings LoadEngineSettings() const = 0;
+
+	/**
+	 * @brief Save the engine configuration.
+	 * @param Settings The engine configuration.
+	 */
+	virtual void SaveEngineSettings(const FPomodoroEngineSettings& Settings) = 0;
+
+	/**
+	 * @brief Read the last saved day planner configuration.
+	 * @return The day planner configuration.
+	 */
+	virtual FPomodoroPlannerSettings LoadPlannerSettings() const = 0;
+
+	/**
+	 * @brief Save the day planner configuration.
+	 * @param Settings The day planner configuration.
+	 */
+	virtual void SavePlannerSettings(const FPomodoroPlannerSettings& Settings) = 0;
+};
@@ -0,0 +1,146 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroState.h"
+#include <atomic>
+
+/**
+ * @brief Plain copy of the engine state, safe to hand over to any thread.
+ *
+ * The remaining time is only exact at publication time. While the engine is running,
+ * readers should rely on the deadline to compute the current remaining time.
+ */
+struct FPomodoroEngineSnapshot
+{
+	/** Incremented each time a snapshot is published, 0 means nothing was published yet */
+	uint64 Version = 0;
+
+	/** State of the engine */
+	EPomodoroState State = Stopped;
+
+	/** Kind of the current timespan */
+	EPomodoroPhase Phase = EPomodoroPhase::Working;
+
+	/** Current cycle, starting from 1 */
+	int32 CurrentCycle = 1;
+
+	/** Number of cycles before looping */
+	int32 CycleCount = 0;
+
+	/** Remaining time of the current timespan when the snapshot was published */
+	FTimespan Remaining;
+
+	/** Full length of the current timespan */
+	FTimespan PhaseLength;
+
+	/** Configured timespan lengths, zero when unknown (read back from the status page) */
+	FTimespan WorkingLength;
+	FTimespan ShortRestingLength;
+	FTimespan LongRestingLength;
+
+	/** UTC time at which the current timespan ends, only valid while running */
+	FDateTime DeadlineUtc;
+
+	/** FPlatformTime::Seconds() at which the current timespan ends, only valid while running */
+	double DeadlineSeconds = 0.0;
+
+	/**
+	 * @brief Compute the remaining time of the current timespan at the given moment.
+	 * @param NowUtc The moment to compute the remaining time at.
+	 * @return The remaining time, never negative.
+	 */
+	FTimespan GetRemaining(const FDateTime& NowUtc) const
+	{
+		if(State != Running)
+		{
+			return Remaining;
+		}
+		return FMath::Max(DeadlineUtc - NowUtc, FTimespan::Zero());
+	}
+};
+
+namespace PomodoroTime
+{
+	/**
+	 * @brief Convert a UTC time to milliseconds since the Unix epoch, as used by external tools.
+	 * @param Time The UTC time to convert.
+	 * @return Milliseconds since 1970-01-01.
+	 */
+	inline int64 ToUnixMilliseconds(const FDateTime& Time)
+	{
+		return (Time - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+	}
+
+	/**
+	 * @brief Convert milliseconds since the Unix epoch, as used by external tools, to a UTC time.
+	 * @param Milliseconds Milliseconds since 1970-01-01.
+	 * @return The UTC time.
+	 */
+	inline FDateTime FromUnixMilliseconds(const int64 Milliseconds)
+	{
+		return FDateTime(1970, 1, 1) + FTimespan(Milliseconds * ETimespan::TicksPerMillisecond);
+	}
+}
+
+/**
+ * @brief Single writer / multiple readers channel publishing engine snapshots.
+ *
+ * The snapshot is guarded by a sequence lock : the writer never waits and readers
+ * never block, they only retry the copy when it overlapped a publication.
+ * The snapshot is stored as relaxed atomic words, so a copy overlapping a publication
+ * is a torn read that gets discarded rather than a data race.
+ */
+class POMODOROCORE_API FPomodoroSnapshotChannel final
+{
+public:
+	/**
+	 * @brief Publish a new snapshot, the version is assigned by the channel.
+	 *
+	 * Must only be called from a single thread (the game thread).
+	 * @param Snapshot The new snapshot.
+	 */
+	void Publish(const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Read a consistent copy of the last published snapshot, from any thread.
+	 * @return The last published snapshot.
+	 */
+	FPomodoroEngineSnapshot Read() const;
+
+	/**
+	 * @brief Copy the last published snapshot over an older copy, from any thread.
+	 *
+	 * Polling readers only pay for a version check while nothing is published.
+	 * @param InOutSnapshot The copy to refresh, kept as is when it is the last published snapshot.
+	 * @return True if the copy was refreshed.
+	 */
+	bool ReadIfChanged(FPomodoroEngineSnapshot& InOutSnapshot) const;
+
+	/**
+	 * @brief Cheap change detection, from any thread.
+	 * @return Version of the last published snapshot.
+	 */
+	uint64 GetVersion() const;
+
+private:
+	static_assert(TIsTriviallyCopyable<FPomodoroEngineSnapshot>::Value, "The snapshot is copied word by word");
+	static_assert(sizeof(FPomodoroEngineSnapshot) % sizeof(uint64) == 0, "The snapshot is copied word by word");
+
+	/** Number of words the snapshot is stored in */
+	static constexpr int32 WordCount = sizeof(FPomodoroEngineSnapshot) / sizeof(uint64);
+
+	/**
+	 * @brief Odd while a publication is in progress.
+	 *
+	 * Aligning it aligns and pads the whole channel to cache lines : the reference count of the channel
+	 * and the neighbour allocations can change without invalidating what the polling readers cache.
+	 */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> Sequence{0};
+
+	/**
+	 * @brief Last published snapshot, word by word.
+	 */
+	std::atomic<uint64> Words[WordCount] = {};
+};
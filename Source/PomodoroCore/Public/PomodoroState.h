@@ -0,0 +1,31 @@
+﻿#pragma once
+
+/**
+ * @brief Represent timer state
+ */
+enum EPomodoroState : uint8
+{
+	/** Timer is currently stopped */
+	Stopped = 0,
+	
+	/** Timer is currently paused */
+	Paused = 1,
+
+	/** Timer is currently running */
+	Running = 2,
+};
+
+/**
+ * @brief Represent the kind of timespan the timer is going through
+ */
+enum class EPomodoroPhase : uint8
+{
+	/** Working timespan */
+	Working = 0,
+
+	/** Short resting timespan, between two working timespans of a cycle */
+	ShortResting = 1,
+
+	/** Long resting timespan, after the last working timespan of the cycles */
+	LongResting = 2,
+};
@@ -0,0 +1,257 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroPhaseHistory.h"
+#include "Async/Future.h"
+
+/**
+ * @brief Value a trend chart shows
+ */
+enum class EPomodoroTrendMetric : uint8
+{
+	/** Minutes of working timespans run */
+	Focus = 0,
+
+	/** Minutes the timespans spent paused */
+	Pause = 1,
+
+	/** Pauses and stops of working timespans */
+	Interruptions = 2,
+};
+
+/**
+ * @brief Time a trend chart point covers
+ */
+enum class EPomodoroTrendBucket : uint8
+{
+	/** A local day */
+	Day = 0,
+
+	/** A week, from Monday */
+	Week = 1,
+};
+
+/**
+ * @brief A point of a downsampled series
+ */
+struct FPomodoroTrendPoint
+{
+	/** Bucket number, a day number or a week number */
+	int32 Bucket = 0;
+
+	/** Value of the bucket */
+	float Value = 0.0f;
+};
+
+/**
+ * Daily and weekly aggregates of the phase history, and their downsampled series.
+ *
+ * The records are decoded once on the thread pool, then each new record only updates its bucket.
+ * If the history changed while it was decoded, or records were merged into it by an import, it is decoded again.
+ *
+ * Series are downsampled with Largest-Triangle-Three-Buckets on bins of 2^Level buckets aligned on the bucket numbers,
+ * the selected point of each bin cached per level. A window takes the level giving about the number of points a chart asks for,
+ * and a new record only selects again its bin and the bins after the one before it, so the tail.
+ *
+ * Game thread only.
+ */
+class POMODOROCORE_API FPomodoroTrends final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroTrends, start aggregating the whole history on the thread pool.
+	 * @param InHistory History aggregated.
+	 */
+	FPomodoroTrends(TSharedRef<FPomodoroPhaseHistory> InHistory);
+
+	/**
+	 * @brief Standard destructor for FPomodoroTrends, wait for the running decode.
+	 */
+	~FPomodoroTrends();
+
+	/**
+	 * @brief Take the aggregates of a finished decode, decode again if the history changed meanwhile or records were imported.
+	 */
+	void Update();
+
+	/**
+	 * @brief Indicate if the history is being decoded, the aggregates are empty or outdated until then.
+	 * @return True while decoding.
+	 */
+	bool IsDecoding() const;
+
+	/**
+	 * @brief Give the value of a bucket.
+	 * @param Metric Value wanted.
+	 * @param Bucket Time a bucket covers.
+	 * @param Number Bucket number.
+	 * @return The value, 0 outside of the history.
+	 */
+	float GetValue(EPomodoroTrendMetric Metric, EPomodoroTrendBucket Bucket, int32 Number) const;
+
+	/**
+	 * @brief Give the first bucket holding records.
+	 * @param Bucket Time a bucket covers.
+	 * @return Bucket number of the first record, the current bucket when nothing is recorded.
+	 */
+	int32 GetFirstBucket(EPomodoroTrendBucket Bucket) const;
+
+	/**
+	 * @brief Give the current bucket.
+	 * @param Bucket Time a bucket covers.
+	 * @return Bucket number of today.
+	 */
+	static int32 GetCurrentBucket(EPomodoroTrendBucket Bucket);
+
+	/**
+	 * @brief Downsample a window of a series with the cached Largest-Triangle-Three-Buckets selection, its first and last buckets always kept.
+	 * @param Metric Value wanted.
+	 * @param Bucket Time a bucket covers.
+	 * @param FromBucket First bucket of the window.
+	 * @param ToBucket Last bucket of the window.
+	 * @param MaxPoints Number of points wanted at most, every bucket is kept when the window has fewer.
+	 * @param OutPoints The points, in bucket order.
+	 */
+	void GetDownsampled(EPomodoroTrendMetric Metric, EPomodoroTrendBucket Bucket, int32 FromBucket, int32 ToBucket, int32 MaxPoints,
+		TArray<FPomodoroTrendPoint>& OutPoints) const;
+
+	/**
+	 * @brief Cheap change detection.
+	 * @return Incremented each time a record is aggregated.
+	 */
+	uint32 GetVersion() const;
+
+	/**
+	 * @brief Give the bucket number of a day.
+	 * @param Bucket Time a bucket covers.
+	 * @param Day Day number, see FPomodoroFocusHistory::GetDay.
+	 * @return The bucket number.
+	 */
+	static int32 GetBucketOfDay(EPomodoroTrendBucket Bucket, int32 Day);
+
+	/**
+	 * @brief Give the first day of a bucket.
+	 * @param Bucket Time a bucket covers.
+	 * @param Number Bucket number.
+	 * @return The day number.
+	 */
+	static int32 GetFirstDayOfBucket(EPomodoroTrendBucket Bucket, int32 Number);
+
+	/** Number of metrics and buckets */
+	static constexpr int32 MetricCount = 3;
+	static constexpr int32 BucketCount = 2;
+
+	/** Number of downsampling levels, the last one with bins of 2^(LevelCount - 1) buckets */
+	static constexpr int32 LevelCount = 16;
+
+private:
+	/**
+	 * @brief Values of a bucket.
+	 */
+	struct FValues
+	{
+		float Values[MetricCount] = {};
+	};
+
+	/**
+	 * @brief Values of every bucket, built on the thread pool then swapped in.
+	 */
+	struct FAggregates
+	{
+		/** Bucket number of Values[Bucket][0], for each bucket */
+		int32 FirstNumbers[BucketCount] = {};
+
+		/** Values of each bucket from the first, for each bucket */
+		TArray<FValues> Values[BucketCount];
+
+		/** Number of records aggregated */
+		int32 RecordCount = 0;
+	};
+
+	/**
+	 * @brief Point selected in each bin of a level, from the bin of the first bucket.
+	 */
+	struct FLevelCache
+	{
+		/** Bin number of Points[0] */
+		int32 FirstBin = 0;
+
+		/** Selected points, only the bins before the invalidated ones */
+		TArray<FPomodoroTrendPoint> Points;
+	};
+
+	/**
+	 * @brief History aggregated.
+	 */
+	TSharedPtr<FPomodoroPhaseHistory> History;
+
+	/**
+	 * @brief Values of every bucket.
+	 */
+	FAggregates Aggregates;
+
+	/**
+	 * @brief Selected points of each level, level 0 keeping every bucket is not cached, for each metric and bucket.
+	 */
+	mutable FLevelCache Levels[MetricCount][BucketCount][LevelCount];
+
+	/**
+	 * @brief Running decode of the history, and the history version it started from.
+	 */
+	TFuture<FAggregates> Decoding;
+	uint32 DecodingVersion = 0;
+
+	/**
+	 * @brief History version the aggregates were last checked against.
+	 */
+	uint32 AggregatedVersion = 0;
+
+	/**
+	 * @brief Incremented each time a record is aggregated.
+	 */
+	uint32 Version = 0;
+
+	/**
+	 * @brief Offset from the UTC to the local time, the records being kept in UTC.
+	 */
+	FTimespan UtcOffset;
+
+	/**
+	 * @brief Start decoding the whole history on the thread pool.
+	 */
+	void StartDecoding();
+
+	/**
+	 * @brief Aggregate a record recorded while the chart shows.
+	 * @param Record The record.
+	 */
+	void AddRecord(const FPomodoroPhaseRecord& Record);
+
+	/**
+	 * @brief Give the point selected in a bin, selecting it and the bins before it if needed.
+	 * @param Metric Value wanted.
+	 * @param Bucket Time a bucket covers.
+	 * @param Level Level of the bin, its bins hold 2^Level buckets.
+	 * @param Bin Bin number.
+	 * @return The point, the first bucket of the bin outside of the history.
+	 */
+	FPomodoroTrendPoint GetSelectedPoint(EPomodoroTrendMetric Metric, EPomodoroTrendBucket Bucket, int32 Level, int32 Bin) const;
+
+	/**
+	 * @brief Forget the selected points of the bins a bucket change affects : its bin, the one before it and the bins after.
+	 * @param Bucket Time a bucket covers.
+	 * @param Number Bucket number changed, INDEX_NONE to forget every bin.
+	 */
+	void InvalidateLevels(EPomodoroTrendBucket Bucket, int32 Number);
+
+	/**
+	 * @brief Add a record to the bucket values.
+	 * @param Target The values.
+	 * @param Record The record.
+	 * @param Offset Offset from the UTC to the local time.
+	 * @return Day number of the record, in local time.
+	 */
+	static int32 Aggregate(FAggregates& Target, const FPomodoroPhaseRecord& Record, FTimespan Offset);
+};
@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class PomodoroPlugin : ModuleRules
@@ -10,6 +11,8 @@ public class PomodoroPlugin : ModuleRules
 		
 		PublicIncludePaths.AddRange(
 			new string[] {
+				// Plain C headers shared with external tools
+				Path.Combine(ModuleDirectory, "..", "..", "Extras", "Include"),
 				// ... add public include paths required here ...
 			}
 			);
@@ -26,6 +29,7 @@ public class PomodoroPlugin : ModuleRules
 			new string[]
 			{
 				"Core",
+				"PomodoroCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -42,9 +46,17 @@ public class PomodoroPlugin : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"Sockets",
+				"Networking",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
+
+		if (Target.Platform == UnrealTargetPlatform.Win64)
+		{
+			// Native sockets polled by the sync relay and the HTTP server
+			PublicSystemLibraries.Add("ws2_32.lib");
+		}
 		
 		
 		DynamicallyLoadedModuleNames.AddRange(
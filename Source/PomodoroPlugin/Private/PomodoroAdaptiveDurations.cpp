@@ -0,0 +1,323 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroAdaptiveDurations.h"
+
+#include "PomodoroConfig.h"
+#include "PomodoroDeferredWork.h"
+
+#define LOCTEXT_NAMESPACE "FPomodoroAdaptiveDurations"
+
+namespace PomodoroAdaptive
+{
+	/** Key of the deferred config save */
+	static const FName SaveKey(TEXT("PomodoroAdaptiveDurations"));
+
+	/** The statistics are saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 30.0;
+
+	/** Weight kept by the previous values when a timespan completes, about the last ten timespans matter */
+	constexpr double Decay = 0.9;
+
+	/** Weight of working timespans needed before suggesting anything */
+	constexpr double MinimumWeight = 3.0;
+
+	/** Completion rate above which the working timespan is lengthened */
+	constexpr double LengthenCompletion = 0.8;
+
+	/** Standard deviations of focus added to the learned mean when it is rarely interrupted */
+	constexpr double LengthenDeviations = 1.0;
+
+	/** Standard deviations of focus removed from the learned mean when it is often interrupted */
+	constexpr double ShortenDeviations = 0.5;
+
+	/** Bounds of the suggested lengths, in minutes */
+	constexpr int32 MinWorkingMinutes = 10;
+	constexpr int32 MaxWorkingMinutes = 60;
+	constexpr int32 MinShortRestingMinutes = 2;
+	constexpr int32 MaxShortRestingMinutes = 15;
+	constexpr int32 MinLongRestingMinutes = 5;
+	constexpr int32 MaxLongRestingMinutes = 45;
+
+	static FTimespan ToTimespan(const double Minutes, const int32 MinMinutes, const int32 MaxMinutes)
+	{
+		return FTimespan::FromMinutes(FMath::Clamp(FMath::RoundToInt(static_cast<float>(Minutes)), MinMinutes, MaxMinutes));
+	}
+}
+
+void FPomodoroRunningStatistics::Add(const double Value, const double Decay)
+{
+	Weight = Weight * Decay + 1.0;
+	const double Delta = Value - Mean;
+	Mean += Delta / Weight;
+	SquaredDeviations = SquaredDeviations * Decay + Delta * (Value - Mean);
+}
+
+double FPomodoroRunningStatistics::GetVariance() const
+{
+	return Weight > 0.0 ? FMath::Max(SquaredDeviations / Weight, 0.0) : 0.0;
+}
+
+double FPomodoroRunningStatistics::GetStandardDeviation() const
+{
+	return FMath::Sqrt(GetVariance());
+}
+
+FPomodoroAdaptiveDurations::FPomodoroAdaptiveDurations(TSharedRef<FPomodoroEngine> InEngine)
+	: Engine(InEngine)
+	, Mode(EPomodoroAdaptiveMode::Off)
+	, MaxWorkingMinutes(PomodoroAdaptive::MaxWorkingMinutes)
+{
+	LastSnapshot = Engine->GetSnapshotChannel()->Read();
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroAdaptiveDurations::OnEngineSnapshotPublished);
+	ReloadConfig();
+}
+
+FPomodoroAdaptiveDurations::~FPomodoroAdaptiveDurations()
+{
+	Engine->OnSnapshotPublished().RemoveAll(this);
+	FPomodoroDeferredWork::Flush(PomodoroAdaptive::SaveKey);
+}
+
+void FPomodoroAdaptiveDurations::SetMode(const EPomodoroAdaptiveMode NewMode)
+{
+	Mode = NewMode;
+	bTrackingPhase = false;
+	UpdateSuggestion();
+	if(Mode == EPomodoroAdaptiveMode::Apply)
+	{
+		ApplySuggestion();
+	}
+}
+
+EPomodoroAdaptiveMode FPomodoroAdaptiveDurations::GetMode() const
+{
+	return Mode;
+}
+
+bool FPomodoroAdaptiveDurations::GetSuggestion(FTimespan& OutWorkingTimespan, FTimespan& OutShortRestingTimespan, FTimespan& OutLongRestingTimespan) const
+{
+	if(!bHasSuggestion)
+	{
+		return false;
+	}
+
+	OutWorkingTimespan = SuggestedWorkingTimespan;
+	OutShortRestingTimespan = SuggestedShortRestingTimespan;
+	OutLongRestingTimespan = SuggestedLongRestingTimespan;
+	return true;
+}
+
+void FPomodoroAdaptiveDurations::ApplySuggestion() const
+{
+	if(bHasSuggestion)
+	{
+		Engine->SetNextCycleTimespans(SuggestedWorkingTimespan, SuggestedShortRestingTimespan, SuggestedLongRestingTimespan);
+	}
+}
+
+const FText& FPomodoroAdaptiveDurations::GetSummaryText() const
+{
+	return SummaryText;
+}
+
+void FPomodoroAdaptiveDurations::ResetStatistics()
+{
+	for(FPomodoroRunningStatistics* Statistics : {&FocusRun, &Completion, &Interruptions, &ShortRest, &LongRest})
+	{
+		*Statistics = FPomodoroRunningStatistics();
+	}
+	bTrackingPhase = false;
+	UpdateSuggestion();
+}
+
+void FPomodoroAdaptiveDurations::ReloadConfig()
+{
+	TTuple<int32, TArray<float>, int32> Data = NewObject<UPomodoroConfig>()->LoadAdaptiveConfig();
+
+	Mode = static_cast<EPomodoroAdaptiveMode>(FMath::Clamp(Data.Get<0>(), 0, static_cast<int32>(EPomodoroAdaptiveMode::Apply)));
+	MaxWorkingMinutes = FMath::Clamp(Data.Get<2>(), PomodoroAdaptive::MinWorkingMinutes, PomodoroAdaptive::MaxWorkingMinutes);
+
+	// Three values per statistics, in the order they are saved, ignored if the layout doesn't match
+	const TArray<float>& Values = Data.Get<1>();
+	const TArray<FPomodoroRunningStatistics*, TInlineAllocator<5>> Saved = {&FocusRun, &Completion, &Interruptions, &ShortRest, &LongRest};
+	for(int32 Index = 0; Index < Saved.Num(); ++Index)
+	{
+		*Saved[Index] = FPomodoroRunningStatistics();
+		if(Values.Num() == Saved.Num() * 3)
+		{
+			Saved[Index]->Weight = Values[Index * 3];
+			Saved[Index]->Mean = Values[Index * 3 + 1];
+			Saved[Index]->SquaredDeviations = Values[Index * 3 + 2];
+		}
+	}
+	bTrackingPhase = false;
+	UpdateSuggestion();
+}
+
+void FPomodoroAdaptiveDurations::SaveConfig() const
+{
+	TArray<float> Values;
+	for(const FPomodoroRunningStatistics* Statistics : {&FocusRun, &Completion, &Interruptions, &ShortRest, &LongRest})
+	{
+		Values.Add(static_cast<float>(Statistics->Weight));
+		Values.Add(static_cast<float>(Statistics->Mean));
+		Values.Add(static_cast<float>(Statistics->SquaredDeviations));
+	}
+	NewObject<UPomodoroConfig>()->SaveAdaptiveConfig(static_cast<int32>(Mode), Values);
+}
+
+void FPomodoroAdaptiveDurations::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+	const FPomodoroEngineSnapshot Previous = LastSnapshot;
+	LastSnapshot = Snapshot;
+
+	// The leading editor learns for every editor of this machine
+	if(Mode == EPomodoroAdaptiveMode::Off || Engine->IsFollowing())
+	{
+		return;
+	}
+
+	const double NowSeconds = FPlatformTime::Seconds();
+	if(Snapshot.State == Stopped)
+	{
+		// Cleared first : applying the suggestion to the stopped engine publishes a snapshot, which comes back here
+		const bool bWasTrackingPhase = bTrackingPhase;
+		bTrackingPhase = false;
+		if(bWasTrackingPhase)
+		{
+			CompletePhase(Previous.Phase, Previous.PhaseLength, true, NowSeconds);
+		}
+		return;
+	}
+
+	if(!bTrackingPhase)
+	{
+		// Only timespans followed from their start are learned from
+		if(Previous.State == Stopped && Snapshot.State == Running)
+		{
+			BeginPhase(NowSeconds);
+		}
+		return;
+	}
+
+	if(Previous.Phase != Snapshot.Phase || Previous.CurrentCycle != Snapshot.CurrentCycle)
+	{
+		CompletePhase(Previous.Phase, Previous.PhaseLength, false, NowSeconds);
+		BeginPhase(NowSeconds);
+		return;
+	}
+
+	if(Previous.State == Running && Snapshot.State == Paused)
+	{
+		if(!bInterrupted)
+		{
+			FocusRunSeconds = NowSeconds - PhaseStartSeconds;
+			bInterrupted = true;
+		}
+		++PauseCount;
+	}
+}
+
+void FPomodoroAdaptiveDurations::BeginPhase(const double NowSeconds)
+{
+	bTrackingPhase = true;
+	PhaseStartSeconds = NowSeconds;
+	FocusRunSeconds = 0.0;
+	bInterrupted = false;
+	PauseCount = 0;
+}
+
+void FPomodoroAdaptiveDurations::CompletePhase(const EPomodoroPhase Phase, const FTimespan PhaseLength, const bool bStopped, const double NowSeconds)
+{
+	const double ElapsedMinutes = (NowSeconds - PhaseStartSeconds) / 60.0;
+	switch (Phase)
+	{
+	case EPomodoroPhase::Working:
+		{
+			double RunMinutes = PhaseLength.GetTotalMinutes();
+			if(bInterrupted)
+			{
+				RunMinutes = FocusRunSeconds / 60.0;
+			}
+			else if(bStopped)
+			{
+				RunMinutes = ElapsedMinutes;
+			}
+			FocusRun.Add(RunMinutes, PomodoroAdaptive::Decay);
+			Completion.Add(bInterrupted || bStopped ? 0.0 : 1.0, PomodoroAdaptive::Decay);
+			Interruptions.Add(PauseCount + (bStopped ? 1 : 0), PomodoroAdaptive::Decay);
+		}
+		break;
+
+	// A stopped rest says nothing about the rest needed
+	case EPomodoroPhase::ShortResting:
+		if(!bStopped)
+		{
+			ShortRest.Add(ElapsedMinutes, PomodoroAdaptive::Decay);
+		}
+		break;
+
+	case EPomodoroPhase::LongResting:
+		if(!bStopped)
+		{
+			LongRest.Add(ElapsedMinutes, PomodoroAdaptive::Decay);
+		}
+		break;
+	}
+
+	UpdateSuggestion();
+	if(Mode == EPomodoroAdaptiveMode::Apply)
+	{
+		ApplySuggestion();
+	}
+
+	// A cycle boundary is reached, the statistics are kept for the next sessions
+	if(Phase == EPomodoroPhase::LongResting || bStopped)
+	{
+		FPomodoroDeferredWork::Enqueue(PomodoroAdaptive::SaveKey, EPomodoroWorkPriority::Low, PomodoroAdaptive::SaveDelaySeconds, [this]()
+		{
+			SaveConfig();
+		});
+	}
+}
+
+void FPomodoroAdaptiveDurations::UpdateSuggestion()
+{
+	bHasSuggestion = Mode != EPomodoroAdaptiveMode::Off && FocusRun.Weight >= PomodoroAdaptive::MinimumWeight;
+	if(!bHasSuggestion)
+	{
+		SummaryText = Mode == EPomodoroAdaptiveMode::Off ? FText::GetEmpty()
+			: LOCTEXT("Learning", "Learning from the next timespans...");
+		return;
+	}
+
+	// Rarely interrupted focus may last up to the longer runs learned, otherwise stop a bit before the usual interruption.
+	// Completed timespans are learned at their applied length, the configured maximum stops them from ratcheting up.
+	const double WorkingMinutes = Completion.Mean >= PomodoroAdaptive::LengthenCompletion
+		? FocusRun.Mean + PomodoroAdaptive::LengthenDeviations * FocusRun.GetStandardDeviation()
+		: FocusRun.Mean - PomodoroAdaptive::ShortenDeviations * FocusRun.GetStandardDeviation();
+	SuggestedWorkingTimespan = PomodoroAdaptive::ToTimespan(WorkingMinutes,
+		PomodoroAdaptive::MinWorkingMinutes, MaxWorkingMinutes);
+
+	// Rests taken longer than planned ask for longer rests
+	SuggestedShortRestingTimespan = PomodoroAdaptive::ToTimespan(
+		ShortRest.Weight > 0.0 ? ShortRest.Mean : LastSnapshot.ShortRestingLength.GetTotalMinutes(),
+		PomodoroAdaptive::MinShortRestingMinutes, PomodoroAdaptive::MaxShortRestingMinutes);
+	SuggestedLongRestingTimespan = PomodoroAdaptive::ToTimespan(
+		LongRest.Weight > 0.0 ? LongRest.Mean : LastSnapshot.LongRestingLength.GetTotalMinutes(),
+		PomodoroAdaptive::MinLongRestingMinutes, PomodoroAdaptive::MaxLongRestingMinutes);
+
+	FNumberFormattingOptions Options;
+	Options.MaximumFractionalDigits = 1;
+	SummaryText = FText::Format(LOCTEXT("Summary",
+		"Focus before interruption : {0} min (+/- {1})\nCompleted without interruption : {2}\nInterruptions per timespan : {3}\nSuggested : {4} / {5} / {6} min"),
+		FText::AsNumber(FocusRun.Mean, &Options), FText::AsNumber(FocusRun.GetStandardDeviation(), &Options),
+		FText::AsPercent(Completion.Mean), FText::AsNumber(Interruptions.Mean, &Options),
+		static_cast<int32>(SuggestedWorkingTimespan.GetTotalMinutes()),
+		static_cast<int32>(SuggestedShortRestingTimespan.GetTotalMinutes()),
+		static_cast<int32>(SuggestedLongRestingTimespan.GetTotalMinutes()));
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -5,18 +5,24 @@
 
 UPomodoroConfig::UPomodoroConfig()
 {
+	// Keys missing from an older configuration file keep their default value
+	WorkingTime = FTimespan(0, 20, 0);
+	ShortRestingTimespan = FTimespan(0, 5, 0);
+	LongRestingTimespan = FTimespan(0, 15, 0);
+	CycleLength = 4;
+	NotificationSound = true;
+	SyncEnabled = false;
+	DayStart = FTimespan(9, 0, 0);
+	DayEnd = FTimespan(18, 0, 0);
+	AdaptiveMode = 0;
+	AdaptiveMaxWorkingMinutes = 45;
+	HttpPort = 0;
+	CountdownTenths = false;
+
 	if(FPaths::FileExists(ConfigPath))
 	{
 		LoadConfig(StaticClass(), *ConfigPath);
 	}
-	else
-	{
-		WorkingTime = FTimespan(0, 20, 0);
-		ShortRestingTimespan = FTimespan(0, 5, 0);
-		LongRestingTimespan = FTimespan(0, 15, 0);
-		CycleLength = 4;
-		NotificationSound = true;
-	}
 }
 
 void UPomodoroConfig::SaveEngineConfig(const FTimespan NewWorkingTimespan, const FTimespan NewShortRestingTimespan, const FTimespan NewLongRestingTimespan, const int32 NewCycleLenght)
@@ -55,3 +61,116 @@ TTuple<ECheckBoxState> UPomodoroConfig::LoadNotificationConfig() const
 	return TTuple<ECheckBoxState>(SoundNotification);
 }
 
+
+void UPomodoroConfig::SaveSyncConfig(const ECheckBoxState ActivateSync, const FString& NewRelayAddress, const FString& NewGroupName)
+{
+	SyncEnabled = ActivateSync == ECheckBoxState::Checked;
+	SyncRelayAddress = NewRelayAddress;
+	SyncGroup = NewGroupName;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<ECheckBoxState, FString, FString> UPomodoroConfig::LoadSyncConfig() const
+{
+	return TTuple<ECheckBoxState, FString, FString>(
+		SyncEnabled ? ECheckBoxState::Checked : ECheckBoxState::Unchecked, SyncRelayAddress, SyncGroup);
+}
+
+void UPomodoroConfig::SavePlannerConfig(const FTimespan NewDayStart, const FTimespan NewDayEnd, const FString& NewCommitments)
+{
+	DayStart = NewDayStart;
+	DayEnd = NewDayEnd;
+	Commitments = NewCommitments;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<FTimespan, FTimespan, FString> UPomodoroConfig::LoadPlannerConfig() const
+{
+	return TTuple<FTimespan, FTimespan, FString>(DayStart, DayEnd, Commitments);
+}
+
+void UPomodoroConfig::SaveAdaptiveConfig(const int32 NewAdaptiveMode, const TArray<float>& NewAdaptiveStatistics)
+{
+	AdaptiveMode = NewAdaptiveMode;
+	AdaptiveStatistics = NewAdaptiveStatistics;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<int32, TArray<float>, int32> UPomodoroConfig::LoadAdaptiveConfig() const
+{
+	return TTuple<int32, TArray<float>, int32>(AdaptiveMode, AdaptiveStatistics, AdaptiveMaxWorkingMinutes);
+}
+
+void UPomodoroConfig::SaveTaskConfig(const FString& NewTaskFile, const FString& NewCurrentTask, const TMap<FString, FTimespan>& NewTaskFocusTimes)
+{
+	TaskFile = NewTaskFile;
+	CurrentTask = NewCurrentTask;
+	TaskFocusTimes = NewTaskFocusTimes;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<FString, FString, TMap<FString, FTimespan>> UPomodoroConfig::LoadTaskConfig() const
+{
+	return TTuple<FString, FString, TMap<FString, FTimespan>>(TaskFile, CurrentTask, TaskFocusTimes);
+}
+
+void UPomodoroConfig::SaveHttpConfig(const int32 NewHttpPort)
+{
+	HttpPort = NewHttpPort;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<int32> UPomodoroConfig::LoadHttpConfig() const
+{
+	return TTuple<int32>(HttpPort);
+}
+
+void UPomodoroConfig::SaveCountdownConfig(const ECheckBoxState ShowTenths)
+{
+	CountdownTenths = ShowTenths == ECheckBoxState::Checked;
+	SaveConfig(CPF_Config, *ConfigPath);
+}
+
+TTuple<ECheckBoxState> UPomodoroConfig::LoadCountdownConfig() const
+{
+	return TTuple<ECheckBoxState>(CountdownTenths ? ECheckBoxState::Checked : ECheckBoxState::Unchecked);
+}
+
+FString UPomodoroConfig::GetConfigFilePath()
+{
+	return FPaths::ProjectConfigDir() + TEXT("PomodoroConfig.ini");
+}
+
+FPomodoroEngineSettings FPomodoroConfigStore::LoadEngineSettings() const
+{
+	const TTuple<FTimespan, FTimespan, FTimespan, int32> Data = NewObject<UPomodoroConfig>()->LoadEngineConfig();
+
+	FPomodoroEngineSettings Settings;
+	Settings.WorkingTimespan = Data.Get<0>();
+	Settings.ShortRestingTimespan = Data.Get<1>();
+	Settings.LongRestingTimespan = Data.Get<2>();
+	Settings.CycleCount = Data.Get<3>();
+	return Settings;
+}
+
+void FPomodoroConfigStore::SaveEngineSettings(const FPomodoroEngineSettings& Settings)
+{
+	NewObject<UPomodoroConfig>()->SaveEngineConfig(Settings.WorkingTimespan, Settings.ShortRestingTimespan,
+		Settings.LongRestingTimespan, Settings.CycleCount);
+}
+
+FPomodoroPlannerSettings FPomodoroConfigStore::LoadPlannerSettings() const
+{
+	const TTuple<FTimespan, FTimespan, FString> Data = NewObject<UPomodoroConfig>()->LoadPlannerConfig();
+
+	FPomodoroPlannerSettings Settings;
+	Settings.DayStart = Data.Get<0>();
+	Settings.DayEnd = Data.Get<1>();
+	Settings.Commitments = Data.Get<2>();
+	return Settings;
+}
+
+void FPomodoroConfigStore::SavePlannerSettings(const FPomodoroPlannerSettings& Settings)
+{
+	NewObject<UPomodoroConfig>()->SavePlannerConfig(Settings.DayStart, Settings.DayEnd, Settings.Commitments);
+}
@@ -0,0 +1,619 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroHttpServer.h"
+
+#include "PomodoroPlugin.h"
+#include "HAL/RunnableThread.h"
+
+namespace PomodoroHttp
+{
+	/** Longest sleep of the server loop without request or stream to time, only a safety net since it is woken up */
+	constexpr double IdleWaitSeconds = 60.0;
+
+	/** Maximum number of connected clients, event streams included */
+	constexpr int32 MaxClients = 1024;
+
+	/** A request larger than this is dropped, none of the endpoints needs a body */
+	constexpr int32 MaxRequestBytes = 8 * 1024;
+
+	/** A client not reading its stream is dropped past this amount of pending bytes */
+	constexpr int32 MaxPendingBytes = 64 * 1024;
+
+	/** A client not sending a full request within this delay is dropped */
+	constexpr double RequestTimeoutSeconds = 10.0;
+
+	/** Idle event streams get a comment at this interval */
+	constexpr double KeepAliveSeconds = 15.0;
+
+	/** Bounds of the configuration values */
+	constexpr int32 MaxTimespanSeconds = 24 * 3600 - 1;
+	constexpr int32 MaxCycleCount = 99;
+
+	static const ANSICHAR* const StateNames[] = {"stopped", "paused", "running"};
+	static const ANSICHAR* const PhaseNames[] = {"working", "short_resting", "long_resting"};
+
+	static void Append(TArray<uint8>& Bytes, const ANSICHAR* Text)
+	{
+		Bytes.Append(reinterpret_cast<const uint8*>(Text), FCStringAnsi::Strlen(Text));
+	}
+
+	template <typename... ArgTypes>
+	static void Appendf(TArray<uint8>& Bytes, const ANSICHAR* Format, ArgTypes... Args)
+	{
+		ANSICHAR Buffer[512];
+		const int32 Length = FCStringAnsi::Snprintf(Buffer, sizeof(Buffer), Format, Args...);
+		Bytes.Append(reinterpret_cast<const uint8*>(Buffer), FMath::Clamp(Length, 0, static_cast<int32>(sizeof(Buffer)) - 1));
+	}
+
+	static void AppendHeaders(TArray<uint8>& Bytes, const ANSICHAR* Status, const int32 ContentLength)
+	{
+		Appendf(Bytes, "HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n"
+			"Cache-Control: no-store\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n", Status, ContentLength);
+	}
+
+	static void AppendError(TArray<uint8>& Bytes, const ANSICHAR* Status)
+	{
+		// The body repeats the status, scripts read it without parsing the headers
+		ANSICHAR Body[128];
+		const int32 Length = FMath::Clamp(FCStringAnsi::Snprintf(Body, sizeof(Body), "{\"error\":\"%s\"}", Status), 0, static_cast<int32>(sizeof(Body)) - 1);
+		AppendHeaders(Bytes, Status, Length);
+		Bytes.Append(reinterpret_cast<const uint8*>(Body), Length);
+	}
+
+	static int64 ToMilliseconds(const FTimespan& Timespan)
+	{
+		return Timespan.GetTicks() / ETimespan::TicksPerMillisecond;
+	}
+
+	static bool IsLoopbackHost(const FString& Host)
+	{
+		// Host names are followed by an optional port, IPv6 addresses are bracketed
+		FString Name = Host;
+		int32 Separator = INDEX_NONE;
+		if(Host.StartsWith(TEXT("[")))
+		{
+			Host.FindChar(TEXT(']'), Separator);
+			Name = Separator != INDEX_NONE ? Host.Left(Separator + 1) : FString();
+		}
+		else if(Host.FindLastChar(TEXT(':'), Separator))
+		{
+			Name = Host.Left(Separator);
+		}
+		return Name == TEXT("localhost") || Name == TEXT("127.0.0.1") || Name == TEXT("[::1]");
+	}
+
+	static bool IsLoopbackOrigin(const FString& Origin)
+	{
+		int32 SchemeEnd = INDEX_NONE;
+		return Origin.FindChar(TEXT('/'), SchemeEnd) && Origin.Mid(SchemeEnd, 2) == TEXT("//")
+			&& (Origin.StartsWith(TEXT("http:")) || Origin.StartsWith(TEXT("https:"))) && IsLoopbackHost(Origin.Mid(SchemeEnd + 2));
+	}
+}
+
+FPomodoroHttpServer::FPomodoroHttpServer(TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> InSnapshotChannel,
+	FPomodoroHttpCommandHandler InCommandHandler)
+	: SnapshotChannel(MoveTemp(InSnapshotChannel))
+	, CommandHandler(MoveTemp(InCommandHandler))
+	, WakeUp(MakeShared<FWakeUp, ESPMode::ThreadSafe>())
+{
+}
+
+FPomodoroHttpServer::~FPomodoroHttpServer()
+{
+	Close();
+}
+
+bool FPomodoroHttpServer::Listen(const int32 Port)
+{
+	Close();
+
+	// Not reusable, a port already served by another editor must fail to bind
+	ListenSocket = PomodoroSockets::Listen(Port, true, false, 64);
+	if(ListenSocket == PomodoroSockets::InvalidHandle)
+	{
+		UE_LOG(LogPomodoro, Log, TEXT("HTTP port %d is not available, the HTTP endpoint is disabled"), Port);
+		return false;
+	}
+
+	WakeSocket = PomodoroSockets::OpenWakeSocket();
+	if(WakeSocket == PomodoroSockets::InvalidHandle)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't create the wake socket of the HTTP endpoint, it is disabled"));
+		Close();
+		return false;
+	}
+	{
+		FScopeLock ScopeLock(&WakeUp->Lock);
+		WakeUp->Socket = WakeSocket;
+	}
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("PomodoroHttpServer"), 0, TPri_BelowNormal);
+	if(Thread == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	UE_LOG(LogPomodoro, Log, TEXT("HTTP endpoint listening on http://127.0.0.1:%d"), Port);
+	return true;
+}
+
+void FPomodoroHttpServer::Close()
+{
+	if(Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	for(FClient& Client : Clients)
+	{
+		Disconnect(Client);
+	}
+	Clients.Empty();
+
+	PomodoroSockets::Close(ListenSocket);
+
+	{
+		FScopeLock ScopeLock(&WakeUp->Lock);
+		WakeUp->Socket = PomodoroSockets::InvalidHandle;
+	}
+	PomodoroSockets::Close(WakeSocket);
+}
+
+void FPomodoroHttpServer::NotifySnapshotChanged()
+{
+	if(WakeSocket != PomodoroSockets::InvalidHandle)
+	{
+		PomodoroSockets::Wake(WakeSocket);
+	}
+}
+
+uint32 FPomodoroHttpServer::Run()
+{
+	while(!bStopping)
+	{
+		PollEntries.Reset();
+		PollEntries.Add({ListenSocket});
+		PollEntries.Add({WakeSocket});
+
+		// Requests time out and quiet streams get a keepalive, the wait ends for the earliest of them
+		const double WaitSeconds = FPlatformTime::Seconds();
+		double WakeSeconds = WaitSeconds + PomodoroHttp::IdleWaitSeconds;
+		for(const FClient& Client : Clients)
+		{
+			PollEntries.Add({Client.Socket, Client.Output.Num() > 0});
+			if(Client.bSubscribed && Client.Output.Num() == 0)
+			{
+				WakeSeconds = FMath::Min(WakeSeconds, Client.SentSeconds + PomodoroHttp::KeepAliveSeconds);
+			}
+			else if(!Client.bSubscribed && !Client.bCloseWhenFlushed)
+			{
+				WakeSeconds = FMath::Min(WakeSeconds, Client.ConnectedSeconds + PomodoroHttp::RequestTimeoutSeconds);
+			}
+		}
+
+		// Sleep until a connection, a request, a writable socket, a transition or a deadline
+		if(!PomodoroSockets::Poll(PollEntries, FMath::Max(0, FMath::CeilToInt((WakeSeconds - WaitSeconds) * 1000.0))))
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("HTTP endpoint stopped, its sockets can't be waited for"));
+			break;
+		}
+
+		if(PollEntries[1].bReady)
+		{
+			PomodoroSockets::DrainWake(WakeSocket);
+		}
+		if(bStopping)
+		{
+			break;
+		}
+
+		const double NowSeconds = FPlatformTime::Seconds();
+		const bool bChanged = UpdateAnswers();
+
+		// Clients are removed from the end with a swap, the indices still match the poll entries
+		for(int32 Index = Clients.Num() - 1; Index >= 0; --Index)
+		{
+			FClient& Client = Clients[Index];
+
+			bool bKeep = true;
+			if(!Client.bSubscribed)
+			{
+				bKeep = ReadClient(Client, NowSeconds);
+			}
+			else
+			{
+				// Event streams never send anything after their request, a readable stream was closed by the client
+				if(PollEntries[Index + 2].bReady)
+				{
+					uint8 Buffer[256];
+					int32 BytesRead = 0;
+					do
+					{
+						BytesRead = PomodoroSockets::Recv(Client.Socket, Buffer, sizeof(Buffer));
+					}
+					while(BytesRead > 0);
+					bKeep = BytesRead == 0;
+				}
+
+				if(bChanged)
+				{
+					Client.Output.Append(EventFrame);
+				}
+				else if(Client.Output.Num() == 0 && NowSeconds - Client.SentSeconds >= PomodoroHttp::KeepAliveSeconds)
+				{
+					// Keeps proxies from closing the stream, and reveals the clients gone away
+					PomodoroHttp::Append(Client.Output, ": keepalive\n\n");
+				}
+			}
+
+			if(bKeep && Client.Output.Num() > 0)
+			{
+				bKeep = Client.Output.Num() <= PomodoroHttp::MaxPendingBytes && FlushClient(Client, NowSeconds);
+			}
+			if(bKeep && Client.bCloseWhenFlushed && Client.Output.Num() == 0 && !Client.PendingCommand.IsValid())
+			{
+				bKeep = false;
+			}
+			if(!bKeep)
+			{
+				Disconnect(Client);
+				Clients.RemoveAtSwap(Index);
+			}
+		}
+
+		if(PollEntries[0].bReady)
+		{
+			AcceptClients(NowSeconds);
+		}
+	}
+	return 0;
+}
+
+void FPomodoroHttpServer::Stop()
+{
+	bStopping = true;
+	NotifySnapshotChanged();
+}
+
+void FPomodoroHttpServer::AcceptClients(const double NowSeconds)
+{
+	for(;;)
+	{
+		PomodoroSockets::FHandle Socket = PomodoroSockets::Accept(ListenSocket);
+		if(Socket == PomodoroSockets::InvalidHandle)
+		{
+			return;
+		}
+
+		if(Clients.Num() >= PomodoroHttp::MaxClients)
+		{
+			PomodoroSockets::Close(Socket);
+			continue;
+		}
+
+		FClient& Client = Clients.AddDefaulted_GetRef();
+		Client.Socket = Socket;
+		Client.ConnectedSeconds = NowSeconds;
+		Client.SentSeconds = NowSeconds;
+	}
+}
+
+bool FPomodoroHttpServer::UpdateAnswers()
+{
+	if(!SnapshotChannel->ReadIfChanged(Snapshot) && StateResponse.Num() > 0)
+	{
+		return false;
+	}
+
+	// Serialized once into the same buffers, every client gets a copy of these bytes
+	StateJson.Reset();
+	PomodoroHttp::Appendf(StateJson, "{\"sequence\":%llu,\"state\":\"%s\",\"phase\":\"%s\",\"current_cycle\":%d,\"cycle_count\":%d,"
+		"\"phase_length_ms\":%lld,\"remaining_ms\":%lld,\"deadline_unix_ms\":%lld}",
+		static_cast<unsigned long long>(Snapshot.Version),
+		PomodoroHttp::StateNames[FMath::Min<int32>(Snapshot.State, UE_ARRAY_COUNT(PomodoroHttp::StateNames) - 1)],
+		PomodoroHttp::PhaseNames[FMath::Min<int32>(static_cast<int32>(Snapshot.Phase), UE_ARRAY_COUNT(PomodoroHttp::PhaseNames) - 1)],
+		Snapshot.CurrentCycle, Snapshot.CycleCount,
+		static_cast<long long>(PomodoroHttp::ToMilliseconds(Snapshot.PhaseLength)),
+		static_cast<long long>(PomodoroHttp::ToMilliseconds(Snapshot.Remaining)),
+		static_cast<long long>(Snapshot.State == Running ? PomodoroTime::ToUnixMilliseconds(Snapshot.DeadlineUtc) : 0));
+
+	StateResponse.Reset();
+	PomodoroHttp::AppendHeaders(StateResponse, "200 OK", StateJson.Num());
+	StateResponse.Append(StateJson);
+
+	ANSICHAR ConfigJson[256];
+	const int32 ConfigLength = FMath::Clamp(FCStringAnsi::Snprintf(ConfigJson, sizeof(ConfigJson),
+		"{\"working_s\":%d,\"short_resting_s\":%d,\"long_resting_s\":%d,\"cycle_count\":%d}",
+		static_cast<int32>(Snapshot.WorkingLength.GetTotalSeconds()), static_cast<int32>(Snapshot.ShortRestingLength.GetTotalSeconds()),
+		static_cast<int32>(Snapshot.LongRestingLength.GetTotalSeconds()), Snapshot.CycleCount), 0, static_cast<int32>(sizeof(ConfigJson)) - 1);
+	ConfigResponse.Reset();
+	PomodoroHttp::AppendHeaders(ConfigResponse, "200 OK", ConfigLength);
+	ConfigResponse.Append(reinterpret_cast<const uint8*>(ConfigJson), ConfigLength);
+
+	EventFrame.Reset();
+	PomodoroHttp::Appendf(EventFrame, "id: %llu\nevent: state\ndata: ", static_cast<unsigned long long>(Snapshot.Version));
+	EventFrame.Append(StateJson);
+	PomodoroHttp::Append(EventFrame, "\n\n");
+	return true;
+}
+
+bool FPomodoroHttpServer::ReadClient(FClient& Client, const double NowSeconds)
+{
+	uint8 Buffer[1024];
+	int32 BytesRead = 0;
+	do
+	{
+		// Negative when the client closed the connection, would block only reads nothing
+		BytesRead = PomodoroSockets::Recv(Client.Socket, Buffer, sizeof(Buffer));
+		if(BytesRead < 0)
+		{
+			return false;
+		}
+		Client.Input.Append(Buffer, BytesRead);
+		if(Client.Input.Num() > PomodoroHttp::MaxRequestBytes)
+		{
+			return false;
+		}
+	}
+	while(BytesRead == sizeof(Buffer));
+
+	// A single request is answered per connection, anything after it is ignored
+	if(Client.bCloseWhenFlushed)
+	{
+		Client.Input.Reset();
+
+		// The answer to a control request waits for the game thread to run it, it carries the state it led to
+		if(Client.PendingCommand.IsValid() && Client.PendingCommand->bDone)
+		{
+			if(Client.PendingCommand->bAccepted)
+			{
+				PomodoroHttp::AppendHeaders(Client.Output, "202 Accepted", StateJson.Num());
+				Client.Output.Append(StateJson);
+			}
+			else
+			{
+				PomodoroHttp::AppendError(Client.Output, "503 Service Unavailable");
+			}
+			Client.PendingCommand.Reset();
+		}
+		return true;
+	}
+
+	int32 HeaderEnd = INDEX_NONE;
+	for(int32 Index = 0; Index + 4 <= Client.Input.Num(); ++Index)
+	{
+		if(FMemory::Memcmp(Client.Input.GetData() + Index, "\r\n\r\n", 4) == 0)
+		{
+			HeaderEnd = Index;
+			break;
+		}
+	}
+	if(HeaderEnd == INDEX_NONE)
+	{
+		return NowSeconds - Client.ConnectedSeconds < PomodoroHttp::RequestTimeoutSeconds;
+	}
+
+	const FString Header(HeaderEnd, reinterpret_cast<const ANSICHAR*>(Client.Input.GetData()));
+	Client.Input.Reset();
+	Client.bCloseWhenFlushed = true;
+
+	TArray<FString> Lines;
+	Header.ParseIntoArray(Lines, TEXT("\r\n"));
+	TArray<FString> RequestLine;
+	if(Lines.Num() > 0)
+	{
+		Lines[0].ParseIntoArrayWS(RequestLine);
+	}
+	if(RequestLine.Num() != 3 || !RequestLine[2].StartsWith(TEXT("HTTP/1.")))
+	{
+		PomodoroHttp::AppendError(Client.Output, "400 Bad Request");
+		return true;
+	}
+
+	FString Host;
+	FString Origin;
+	for(int32 Index = 1; Index < Lines.Num(); ++Index)
+	{
+		FString Name;
+		FString Value;
+		if(Lines[Index].Split(TEXT(":"), &Name, &Value))
+		{
+			Name.TrimStartAndEndInline();
+			Value.TrimStartAndEndInline();
+			if(Name == TEXT("Host"))
+			{
+				Host = Value;
+			}
+			else if(Name == TEXT("Origin"))
+			{
+				Origin = Value;
+			}
+		}
+	}
+
+	HandleRequest(Client, RequestLine[0], RequestLine[1], Host, Origin);
+	return true;
+}
+
+void FPomodoroHttpServer::HandleRequest(FClient& Client, const FString& Method, const FString& Target, const FString& Host, const FString& Origin)
+{
+	FString Path;
+	FString Query;
+	if(!Target.Split(TEXT("?"), &Path, &Query))
+	{
+		Path = Target;
+	}
+
+	// A page of a rebound host name would otherwise read and drive the timer
+	if(!PomodoroHttp::IsLoopbackHost(Host))
+	{
+		PomodoroHttp::AppendError(Client.Output, "403 Forbidden");
+		return;
+	}
+
+	if(Method == TEXT("GET"))
+	{
+		if(Path == TEXT("/state"))
+		{
+			Client.Output.Append(StateResponse);
+		}
+		else if(Path == TEXT("/config"))
+		{
+			Client.Output.Append(ConfigResponse);
+		}
+		else if(Path == TEXT("/events"))
+		{
+			PomodoroHttp::Append(Client.Output, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-store\r\n"
+				"Access-Control-Allow-Origin: *\r\nConnection: keep-alive\r\n\r\nretry: 2000\n\n");
+			Client.Output.Append(EventFrame);
+			Client.bSubscribed = true;
+			Client.bCloseWhenFlushed = false;
+		}
+		else
+		{
+			PomodoroHttp::AppendError(Client.Output, "404 Not Found");
+		}
+		return;
+	}
+
+	if(Method != TEXT("POST"))
+	{
+		PomodoroHttp::AppendError(Client.Output, "405 Method Not Allowed");
+		return;
+	}
+
+	// Browsers tell the origin of the page, only local dashboards control the timer
+	if(!Origin.IsEmpty() && !PomodoroHttp::IsLoopbackOrigin(Origin))
+	{
+		PomodoroHttp::AppendError(Client.Output, "403 Forbidden");
+		return;
+	}
+
+	FPomodoroHttpCommand Command;
+	if(Path == TEXT("/start"))
+	{
+		Command.Kind = EPomodoroHttpCommand::Start;
+	}
+	else if(Path == TEXT("/pause"))
+	{
+		Command.Kind = EPomodoroHttpCommand::Pause;
+	}
+	else if(Path == TEXT("/stop"))
+	{
+		Command.Kind = EPomodoroHttpCommand::Stop;
+	}
+	else if(Path == TEXT("/config"))
+	{
+		if(!ParseConfigQuery(Query, Command))
+		{
+			PomodoroHttp::AppendError(Client.Output, "400 Bad Request");
+			return;
+		}
+		if(Snapshot.State != Stopped)
+		{
+			PomodoroHttp::AppendError(Client.Output, "409 Conflict");
+			return;
+		}
+	}
+	else
+	{
+		PomodoroHttp::AppendError(Client.Output, "404 Not Found");
+		return;
+	}
+
+	TFuture<bool> Result = CommandHandler.IsBound() ? CommandHandler.Execute(Command) : TFuture<bool>();
+	if(!Result.IsValid())
+	{
+		PomodoroHttp::AppendError(Client.Output, "503 Service Unavailable");
+		return;
+	}
+
+	// Answered once applied on the game thread, the server keeps serving the other clients meanwhile
+	const TSharedRef<FCommandOutcome, ESPMode::ThreadSafe> Outcome = MakeShared<FCommandOutcome, ESPMode::ThreadSafe>();
+	Client.PendingCommand = Outcome;
+	Result.Then([Outcome, WakeUp = WakeUp](TFuture<bool> Accepted)
+	{
+		Outcome->bAccepted = Accepted.Get();
+		Outcome->bDone = true;
+
+		FScopeLock ScopeLock(&WakeUp->Lock);
+		if(WakeUp->Socket != PomodoroSockets::InvalidHandle)
+		{
+			PomodoroSockets::Wake(WakeUp->Socket);
+		}
+	});
+}
+
+bool FPomodoroHttpServer::ParseConfigQuery(const FString& Query, FPomodoroHttpCommand& OutCommand)
+{
+	OutCommand.Kind = EPomodoroHttpCommand::Configure;
+
+	TArray<FString> Pairs;
+	Query.ParseIntoArray(Pairs, TEXT("&"));
+	for(const FString& Pair : Pairs)
+	{
+		FString Name;
+		FString Value;
+		if(!Pair.Split(TEXT("="), &Name, &Value) || !Value.IsNumeric())
+		{
+			return false;
+		}
+
+		const int32 Number = FCString::Atoi(*Value);
+		if(Name == TEXT("cycle_count"))
+		{
+			if(Number < 1 || Number > PomodoroHttp::MaxCycleCount)
+			{
+				return false;
+			}
+			OutCommand.CycleCount = Number;
+			continue;
+		}
+
+		FTimespan* Timespan = Name == TEXT("working_s") ? &OutCommand.WorkingTimespan
+			: Name == TEXT("short_resting_s") ? &OutCommand.ShortRestingTimespan
+			: Name == TEXT("long_resting_s") ? &OutCommand.LongRestingTimespan
+			: nullptr;
+		if(Timespan == nullptr || Number < 1 || Number > PomodoroHttp::MaxTimespanSeconds)
+		{
+			return false;
+		}
+		*Timespan = FTimespan::FromSeconds(Number);
+	}
+	return Pairs.Num() > 0;
+}
+
+bool FPomodoroHttpServer::FlushClient(FClient& Client, const double NowSeconds)
+{
+	int32 Sent = 0;
+	while(Sent < Client.Output.Num())
+	{
+		// A full socket is retried once writable, a negative count means the client is gone
+		const int32 BytesSent = PomodoroSockets::Send(Client.Socket, Client.Output.GetData() + Sent, Client.Output.Num() - Sent);
+		if(BytesSent < 0)
+		{
+			return false;
+		}
+		if(BytesSent == 0)
+		{
+			break;
+		}
+		Sent += BytesSent;
+	}
+
+	if(Sent > 0)
+	{
+		Client.Output.RemoveAt(0, Sent, false);
+		Client.SentSeconds = NowSeconds;
+	}
+	return true;
+}
+
+void FPomodoroHttpServer::Disconnect(FClient& Client)
+{
+	PomodoroSockets::Close(Client.Socket);
+}
@@ -0,0 +1,355 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroInstanceCoordinator.h"
+
+#if WITH_POMODORO_IPC
+
+#include "PomodoroPlugin.h"
+#include "PomodoroPaths.h"
+#include "PomodoroIpcProtocol.h"
+#include "Async/Async.h"
+#include "HAL/RunnableThread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if PLATFORM_MAC
+	#define POMODORO_SEND_FLAGS MSG_DONTWAIT
+#else
+	#define POMODORO_SEND_FLAGS (MSG_DONTWAIT | MSG_NOSIGNAL)
+#endif
+
+namespace PomodoroCoordinator
+{
+	/** Time between two connection attempts, only while another editor is becoming the leading one */
+	constexpr int32 ReconnectDelayMilliseconds = 250;
+
+	static bool SendRequest(const int32 Socket, const uint8 Opcode)
+	{
+		pomodoro_ipc_request Request;
+		Request.magic = POMODORO_IPC_MAGIC;
+		Request.version = POMODORO_IPC_VERSION;
+		Request.opcode = Opcode;
+		Request.reserved = 0;
+		return send(Socket, &Request, POMODORO_IPC_REQUEST_SIZE, POMODORO_SEND_FLAGS) == POMODORO_IPC_REQUEST_SIZE;
+	}
+}
+
+FPomodoroInstanceCoordinator::FPomodoroInstanceCoordinator(TSharedRef<FPomodoroEngine> InEngine, FSimpleDelegate InOnBecameLeader)
+	: Engine(InEngine)
+	, OnBecameLeader(MoveTemp(InOnBecameLeader))
+{
+}
+
+FPomodoroInstanceCoordinator::~FPomodoroInstanceCoordinator()
+{
+	Shutdown();
+}
+
+void FPomodoroInstanceCoordinator::Start()
+{
+	if(TryLock())
+	{
+		BecomeLeader();
+		return;
+	}
+
+	if(pipe(WakePipe) == -1)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't follow the leading editor (errno %d), running a separate timer"), errno);
+		BecomeLeader();
+		return;
+	}
+	fcntl(WakePipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(WakePipe[1], F_SETFL, O_NONBLOCK);
+
+	UE_LOG(LogPomodoro, Log, TEXT("Another editor owns the timer, following it"));
+	Engine->Follow(FRequestStateDelegate::CreateSP(AsShared(), &FPomodoroInstanceCoordinator::RequestState));
+
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("PomodoroInstanceCoordinator"), 0, TPri_BelowNormal);
+}
+
+void FPomodoroInstanceCoordinator::Shutdown()
+{
+	if(Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	DisconnectFromLeader();
+	LeaderPage.Close();
+
+	for(int32& Descriptor : WakePipe)
+	{
+		if(Descriptor != -1)
+		{
+			close(Descriptor);
+			Descriptor = -1;
+		}
+	}
+
+	// Closing the lock file releases the leadership
+	if(LockDescriptor != -1)
+	{
+		close(LockDescriptor);
+		LockDescriptor = -1;
+	}
+}
+
+bool FPomodoroInstanceCoordinator::IsLeader() const
+{
+	return bLeader;
+}
+
+uint32 FPomodoroInstanceCoordinator::Run()
+{
+	while(!bStopping)
+	{
+		if(ConnectToLeader())
+		{
+			FollowLeader();
+			DisconnectFromLeader();
+			LeaderPage.Close();
+			continue;
+		}
+
+		if(bStopping)
+		{
+			break;
+		}
+
+		// The leading editor is gone, the first follower taking the lock leads
+		if(TryLock())
+		{
+			const TWeakPtr<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe> WeakThis = AsShared();
+			AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+			{
+				if(const TSharedPtr<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe> This = WeakThis.Pin())
+				{
+					This->BecomeLeader();
+				}
+			});
+			break;
+		}
+
+		// Another editor took the lock but doesn't listen yet, this only lasts while it starts
+		WaitForWakeUp(PomodoroCoordinator::ReconnectDelayMilliseconds);
+	}
+	return 0;
+}
+
+void FPomodoroInstanceCoordinator::Stop()
+{
+	bStopping = true;
+	if(WakePipe[1] != -1)
+	{
+		const uint8 Byte = 0;
+		const ssize_t Ignored = write(WakePipe[1], &Byte, 1);
+		(void)Ignored;
+	}
+}
+
+bool FPomodoroInstanceCoordinator::TryLock()
+{
+	if(LockDescriptor != -1)
+	{
+		return true;
+	}
+
+	const int32 Descriptor = open(TCHAR_TO_UTF8(*PomodoroPaths::GetUserRuntimeFile(TEXT("lock"))), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if(Descriptor == -1)
+	{
+		// Without lock file there is no way to share the timer, run a separate one
+		return true;
+	}
+
+	// The lock is released by the system when the leading editor exits, even when it crashes
+	if(flock(Descriptor, LOCK_EX | LOCK_NB) == -1)
+	{
+		close(Descriptor);
+		return false;
+	}
+
+	LockDescriptor = Descriptor;
+	return true;
+}
+
+bool FPomodoroInstanceCoordinator::ConnectToLeader()
+{
+	sockaddr_un Address;
+	FMemory::Memzero(Address);
+	Address.sun_family = AF_UNIX;
+
+	const FTCHARToUTF8 Path(*FPomodoroIpcServer::GetDefaultSocketPath());
+	if(Path.Length() >= static_cast<int32>(sizeof(Address.sun_path)))
+	{
+		return false;
+	}
+	FMemory::Memcpy(Address.sun_path, Path.Get(), Path.Length());
+
+	const int32 Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(Socket == -1)
+	{
+		return false;
+	}
+
+#if PLATFORM_MAC
+	const int32 NoSigPipe = 1;
+	setsockopt(Socket, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof(NoSigPipe));
+#endif
+
+	// The leading editor maps its status page before listening
+	if(connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == -1
+		|| !LeaderPage.OpenForReading(FPomodoroStatusPage::GetDefaultPagePath())
+		|| !PomodoroCoordinator::SendRequest(Socket, POMODORO_IPC_OP_SUBSCRIBE))
+	{
+		close(Socket);
+		LeaderPage.Close();
+		return false;
+	}
+
+	FScopeLock Lock(&LeaderSocketLock);
+	LeaderSocket = Socket;
+	return true;
+}
+
+void FPomodoroInstanceCoordinator::DisconnectFromLeader()
+{
+	FScopeLock Lock(&LeaderSocketLock);
+	if(LeaderSocket != -1)
+	{
+		close(LeaderSocket);
+		LeaderSocket = -1;
+	}
+}
+
+void FPomodoroInstanceCoordinator::FollowLeader()
+{
+	MirrorLeader();
+
+	// Frames are only used to wake up, the state itself is read from the status page
+	int32 PendingBytes = 0;
+	while(!bStopping)
+	{
+		pollfd Descriptors[2] = {{LeaderSocket, POLLIN, 0}, {WakePipe[0], POLLIN, 0}};
+		if(poll(Descriptors, 2, -1) == -1)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+
+		if(Descriptors[1].revents & POLLIN)
+		{
+			uint8 Buffer[64];
+			while(read(WakePipe[0], Buffer, sizeof(Buffer)) > 0)
+			{
+			}
+			continue;
+		}
+
+		if(Descriptors[0].revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			uint8 Buffer[POMODORO_IPC_FRAME_SIZE * 4];
+			const ssize_t Received = recv(LeaderSocket, Buffer, sizeof(Buffer), 0);
+			if(Received == -1 && errno == EINTR)
+			{
+				continue;
+			}
+			if(Received <= 0)
+			{
+				// The leading editor closed
+				return;
+			}
+
+			PendingBytes += Received;
+			if(PendingBytes >= POMODORO_IPC_FRAME_SIZE)
+			{
+				PendingBytes %= POMODORO_IPC_FRAME_SIZE;
+				MirrorLeader();
+			}
+		}
+	}
+}
+
+void FPomodoroInstanceCoordinator::MirrorLeader()
+{
+	FPomodoroEngineSnapshot Snapshot;
+	if(!LeaderPage.Read(Snapshot))
+	{
+		return;
+	}
+
+	const TWeakPtr<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe> WeakThis = AsShared();
+	AsyncTask(ENamedThreads::GameThread, [WeakThis, Snapshot]()
+	{
+		const TSharedPtr<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe> This = WeakThis.Pin();
+		if(This.IsValid() && This->Engine.IsValid())
+		{
+			This->Engine->MirrorSnapshot(Snapshot);
+		}
+	});
+}
+
+void FPomodoroInstanceCoordinator::RequestState(const EPomodoroState RequestedState)
+{
+	uint8 Opcode;
+	switch (RequestedState)
+	{
+	case Running:
+		Opcode = POMODORO_IPC_OP_START;
+		break;
+
+	case Paused:
+		Opcode = POMODORO_IPC_OP_PAUSE;
+		break;
+
+	default:
+		Opcode = POMODORO_IPC_OP_STOP;
+		break;
+	}
+
+	// The leading editor pushes its new state once the command is applied
+	FScopeLock Lock(&LeaderSocketLock);
+	if(LeaderSocket != -1)
+	{
+		PomodoroCoordinator::SendRequest(LeaderSocket, Opcode);
+	}
+}
+
+void FPomodoroInstanceCoordinator::BecomeLeader()
+{
+	bLeader = true;
+	UE_LOG(LogPomodoro, Log, TEXT("This editor now owns the timer"));
+
+	if(Engine.IsValid())
+	{
+		Engine->Lead();
+	}
+	OnBecameLeader.ExecuteIfBound();
+}
+
+void FPomodoroInstanceCoordinator::WaitForWakeUp(const int32 TimeoutMilliseconds) const
+{
+	pollfd Descriptor = {WakePipe[0], POLLIN, 0};
+	if(poll(&Descriptor, 1, TimeoutMilliseconds) > 0)
+	{
+		uint8 Buffer[64];
+		while(read(WakePipe[0], Buffer, sizeof(Buffer)) > 0)
+		{
+		}
+	}
+}
+
+#endif
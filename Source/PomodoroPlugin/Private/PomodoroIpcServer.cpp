@@ -0,0 +1,524 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroIpcServer.h"
+
+#if WITH_POMODORO_IPC
+
+#include "PomodoroPlugin.h"
+#include "PomodoroPaths.h"
+#include "PomodoroIpcProtocol.h"
+#include "HAL/RunnableThread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if PLATFORM_MAC
+	#define POMODORO_SEND_FLAGS 0
+#else
+	#define POMODORO_SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+namespace PomodoroIpc
+{
+	/** A client not reading its pushed frames is dropped past this amount of pending bytes */
+	constexpr int32 MaxPendingBytes = 64 * 1024;
+
+	/** Maximum number of simultaneous clients */
+	constexpr int32 MaxClients = 64;
+
+	static bool SetNonBlocking(const int32 Descriptor)
+	{
+		const int32 Flags = fcntl(Descriptor, F_GETFL, 0);
+		return Flags != -1 && fcntl(Descriptor, F_SETFL, Flags | O_NONBLOCK) != -1;
+	}
+
+	static void EncodeFrame(const FPomodoroEngineSnapshot& Snapshot, const uint8 Kind, const uint8 Status,
+		const uint8 Opcode, pomodoro_ipc_frame& OutFrame)
+	{
+		FMemory::Memzero(OutFrame);
+		OutFrame.magic = POMODORO_IPC_MAGIC;
+		OutFrame.version = POMODORO_IPC_VERSION;
+		OutFrame.kind = Kind;
+		OutFrame.status = Status;
+		OutFrame.opcode = Opcode;
+		OutFrame.sequence = Snapshot.Version;
+		OutFrame.state = static_cast<uint8>(Snapshot.State);
+		OutFrame.phase = static_cast<uint8>(Snapshot.Phase);
+		OutFrame.current_cycle = Snapshot.CurrentCycle;
+		OutFrame.cycle_count = Snapshot.CycleCount;
+		OutFrame.phase_length_s = static_cast<int32>(Snapshot.PhaseLength.GetTotalSeconds());
+		OutFrame.remaining_ms = Snapshot.GetRemaining(FDateTime::UtcNow()).GetTicks() / ETimespan::TicksPerMillisecond;
+		OutFrame.deadline_unix_ms = Snapshot.State == Running ? PomodoroTime::ToUnixMilliseconds(Snapshot.DeadlineUtc) : 0;
+	}
+
+	static void AppendFrame(TArray<uint8>& Output, const pomodoro_ipc_frame& Frame)
+	{
+		Output.Append(reinterpret_cast<const uint8*>(&Frame), POMODORO_IPC_FRAME_SIZE);
+	}
+}
+
+FPomodoroIpcServer::FPomodoroIpcServer(TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> InSnapshotChannel,
+	FPomodoroIpcCommandHandler InCommandHandler)
+	: SnapshotChannel(MoveTemp(InSnapshotChannel))
+	, CommandHandler(MoveTemp(InCommandHandler))
+	, WakeUp(MakeShared<FWakeUp, ESPMode::ThreadSafe>())
+{
+}
+
+FPomodoroIpcServer::~FPomodoroIpcServer()
+{
+	Close();
+}
+
+bool FPomodoroIpcServer::Listen(const FString& InSocketPath)
+{
+	sockaddr_un Address;
+	FMemory::Memzero(Address);
+	Address.sun_family = AF_UNIX;
+
+	const FTCHARToUTF8 Path(*InSocketPath);
+	if(Path.Length() >= static_cast<int32>(sizeof(Address.sun_path)))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("IPC socket path is too long : %s"), *InSocketPath);
+		return false;
+	}
+	FMemory::Memcpy(Address.sun_path, Path.Get(), Path.Length());
+
+	ListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(ListenSocket == -1)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't create IPC socket (errno %d)"), errno);
+		return false;
+	}
+
+	if(bind(ListenSocket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == -1)
+	{
+		// The socket may be left over by a crashed editor, but never steal it from a living one
+		bool bStale = false;
+		if(errno == EADDRINUSE)
+		{
+			const int32 Probe = socket(AF_UNIX, SOCK_STREAM, 0);
+			if(Probe != -1)
+			{
+				bStale = connect(Probe, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == -1 && errno == ECONNREFUSED;
+				close(Probe);
+			}
+		}
+
+		if(!bStale || unlink(Path.Get()) == -1
+			|| bind(ListenSocket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == -1)
+		{
+			UE_LOG(LogPomodoro, Log, TEXT("IPC socket %s is not available, the endpoint is disabled"), *InSocketPath);
+			CloseSockets();
+			return false;
+		}
+	}
+	SocketPath = InSocketPath;
+
+	// Only the current user can talk to the editor
+	chmod(Path.Get(), S_IRUSR | S_IWUSR);
+
+	if(listen(ListenSocket, 16) == -1 || !PomodoroIpc::SetNonBlocking(ListenSocket)
+		|| pipe(WakePipe) == -1 || !PomodoroIpc::SetNonBlocking(WakePipe[0]) || !PomodoroIpc::SetNonBlocking(WakePipe[1]))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't listen on IPC socket %s (errno %d)"), *SocketPath, errno);
+		CloseSockets();
+		return false;
+	}
+
+	{
+		FScopeLock ScopeLock(&WakeUp->Lock);
+		WakeUp->Descriptor = WakePipe[1];
+	}
+
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("PomodoroIpcServer"), 0, TPri_BelowNormal);
+	if(Thread == nullptr)
+	{
+		CloseSockets();
+		return false;
+	}
+
+	UE_LOG(LogPomodoro, Log, TEXT("IPC endpoint listening on %s"), *SocketPath);
+	return true;
+}
+
+void FPomodoroIpcServer::Close()
+{
+	if(Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	CloseSockets();
+}
+
+void FPomodoroIpcServer::NotifySnapshotChanged()
+{
+	if(WakePipe[1] != -1)
+	{
+		// A full pipe already guarantees a wake up
+		const uint8 Byte = 0;
+		const ssize_t Ignored = write(WakePipe[1], &Byte, 1);
+		(void)Ignored;
+	}
+}
+
+FString FPomodoroIpcServer::GetDefaultSocketPath()
+{
+	return PomodoroPaths::GetUserRuntimeFile(TEXT("sock"));
+}
+
+uint32 FPomodoroIpcServer::Run()
+{
+	TArray<pollfd> PollDescriptors;
+
+	while(!bStopping)
+	{
+		PollDescriptors.Reset();
+		PollDescriptors.Add({ListenSocket, POLLIN, 0});
+		PollDescriptors.Add({WakePipe[0], POLLIN, 0});
+		for(const FClient& Client : Clients)
+		{
+			PollDescriptors.Add({Client.Socket, static_cast<int16>(Client.Output.Num() > 0 ? POLLIN | POLLOUT : POLLIN), 0});
+		}
+
+		// Sleep until something happens, there is no periodic work
+		if(poll(PollDescriptors.GetData(), PollDescriptors.Num(), -1) == -1)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			UE_LOG(LogPomodoro, Warning, TEXT("IPC endpoint stopped (errno %d)"), errno);
+			break;
+		}
+
+		if(PollDescriptors[1].revents & POLLIN)
+		{
+			uint8 Buffer[64];
+			while(read(WakePipe[0], Buffer, sizeof(Buffer)) > 0)
+			{
+			}
+		}
+
+		if(bStopping)
+		{
+			break;
+		}
+
+		// Handle clients before accepting new ones, so the indices still match the poll descriptors
+		for(int32 Index = Clients.Num() - 1; Index >= 0; --Index)
+		{
+			const int16 Events = PollDescriptors[Index + 2].revents;
+			bool bKeep = (Events & (POLLERR | POLLNVAL)) == 0;
+			if(bKeep && (Events & (POLLIN | POLLHUP)))
+			{
+				bKeep = ReadClient(Clients[Index]);
+			}
+			if(bKeep)
+			{
+				bKeep = AnswerRequests(Clients[Index]);
+			}
+			if(bKeep && Clients[Index].Output.Num() > 0)
+			{
+				bKeep = FlushClient(Clients[Index]);
+			}
+			if(!bKeep)
+			{
+				close(Clients[Index].Socket);
+				Clients.RemoveAtSwap(Index);
+			}
+		}
+
+		PushSnapshot();
+
+		if(PollDescriptors[0].revents & POLLIN)
+		{
+			AcceptClients();
+		}
+	}
+	return 0;
+}
+
+void FPomodoroIpcServer::Stop()
+{
+	bStopping = true;
+	NotifySnapshotChanged();
+}
+
+void FPomodoroIpcServer::AcceptClients()
+{
+	for(;;)
+	{
+		const int32 Socket = accept(ListenSocket, nullptr, nullptr);
+		if(Socket == -1)
+		{
+			return;
+		}
+
+		if(Clients.Num() >= PomodoroIpc::MaxClients || !PomodoroIpc::SetNonBlocking(Socket))
+		{
+			close(Socket);
+			continue;
+		}
+
+#if PLATFORM_MAC
+		const int32 NoSigPipe = 1;
+		setsockopt(Socket, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof(NoSigPipe));
+#endif
+
+		FClient& Client = Clients.AddDefaulted_GetRef();
+		Client.Socket = Socket;
+	}
+}
+
+bool FPomodoroIpcServer::ReadClient(FClient& Client)
+{
+	uint8 Buffer[256];
+	for(;;)
+	{
+		const ssize_t Received = recv(Client.Socket, Buffer, sizeof(Buffer), 0);
+		if(Received > 0)
+		{
+			Client.Input.Append(Buffer, Received);
+			continue;
+		}
+		if(Received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+		{
+			// Closed by the client
+			return false;
+		}
+		break;
+	}
+
+	// Requests wait while a command runs, a client sending too many of them meanwhile is dropped
+	return Client.Input.Num() <= PomodoroIpc::MaxPendingBytes;
+}
+
+bool FPomodoroIpcServer::AnswerRequests(FClient& Client)
+{
+	pomodoro_ipc_frame Frame;
+
+	// The reply of a command carries the state it led to
+	if(Client.PendingCommand.IsValid())
+	{
+		if(!Client.PendingCommand->bDone)
+		{
+			return true;
+		}
+		const uint8 Status = Client.PendingCommand->bAccepted ? POMODORO_IPC_STATUS_OK : POMODORO_IPC_STATUS_UNAVAILABLE;
+		PomodoroIpc::EncodeFrame(SnapshotChannel->Read(), POMODORO_IPC_FRAME_REPLY, Status, Client.PendingOpcode, Frame);
+		PomodoroIpc::AppendFrame(Client.Output, Frame);
+		Client.PendingCommand.Reset();
+	}
+
+	int32 Consumed = 0;
+	if(Client.Input.Num() >= POMODORO_IPC_REQUEST_SIZE)
+	{
+		const FPomodoroEngineSnapshot Snapshot = SnapshotChannel->Read();
+
+		for(; Consumed + POMODORO_IPC_REQUEST_SIZE <= Client.Input.Num() && !Client.PendingCommand.IsValid(); Consumed += POMODORO_IPC_REQUEST_SIZE)
+		{
+			pomodoro_ipc_request Request;
+			FMemory::Memcpy(&Request, Client.Input.GetData() + Consumed, POMODORO_IPC_REQUEST_SIZE);
+
+			if(Request.magic != POMODORO_IPC_MAGIC || Request.version != POMODORO_IPC_VERSION)
+			{
+				return false;
+			}
+
+			uint8 Status = POMODORO_IPC_STATUS_OK;
+			switch (Request.opcode)
+			{
+			case POMODORO_IPC_OP_GET_STATE:
+				break;
+
+			case POMODORO_IPC_OP_SUBSCRIBE:
+				Client.bSubscribed = true;
+				break;
+
+			case POMODORO_IPC_OP_UNSUBSCRIBE:
+				Client.bSubscribed = false;
+				break;
+
+			case POMODORO_IPC_OP_START:
+			case POMODORO_IPC_OP_PAUSE:
+			case POMODORO_IPC_OP_STOP:
+				{
+					TFuture<bool> Result = CommandHandler.IsBound() ? CommandHandler.Execute(Request.opcode) : TFuture<bool>();
+					if(!Result.IsValid())
+					{
+						Status = POMODORO_IPC_STATUS_UNAVAILABLE;
+						break;
+					}
+
+					// Answered once the game thread ran it, the server keeps serving the other clients meanwhile
+					const TSharedRef<FCommandOutcome, ESPMode::ThreadSafe> Outcome = MakeShared<FCommandOutcome, ESPMode::ThreadSafe>();
+					Client.PendingCommand = Outcome;
+					Client.PendingOpcode = Request.opcode;
+					Result.Then([Outcome, WakeUp = WakeUp](TFuture<bool> Accepted)
+					{
+						Outcome->bAccepted = Accepted.Get();
+						Outcome->bDone = true;
+
+						FScopeLock ScopeLock(&WakeUp->Lock);
+						if(WakeUp->Descriptor != -1)
+						{
+							const uint8 Byte = 0;
+							const ssize_t Ignored = write(WakeUp->Descriptor, &Byte, 1);
+							(void)Ignored;
+						}
+					});
+				}
+				continue;
+
+			default:
+				Status = POMODORO_IPC_STATUS_BAD_REQUEST;
+				break;
+			}
+
+			PomodoroIpc::EncodeFrame(Snapshot, POMODORO_IPC_FRAME_REPLY, Status, Request.opcode, Frame);
+			PomodoroIpc::AppendFrame(Client.Output, Frame);
+		}
+		Client.Input.RemoveAt(0, Consumed, false);
+	}
+
+	return Client.Output.Num() <= PomodoroIpc::MaxPendingBytes;
+}
+
+bool FPomodoroIpcServer::FlushClient(FClient& Client) const
+{
+	int32 Sent = 0;
+	while(Sent < Client.Output.Num())
+	{
+		const ssize_t Result = send(Client.Socket, Client.Output.GetData() + Sent, Client.Output.Num() - Sent, POMODORO_SEND_FLAGS);
+		if(Result > 0)
+		{
+			Sent += Result;
+			continue;
+		}
+		if(Result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			break;
+		}
+		return false;
+	}
+	Client.Output.RemoveAt(0, Sent, false);
+	return true;
+}
+
+void FPomodoroIpcServer::PushSnapshot()
+{
+	if(SnapshotChannel->GetVersion() == PushedVersion)
+	{
+		return;
+	}
+
+	// Encode once for every subscriber
+	const FPomodoroEngineSnapshot Snapshot = SnapshotChannel->Read();
+	PushedVersion = Snapshot.Version;
+
+	pomodoro_ipc_frame Frame;
+	PomodoroIpc::EncodeFrame(Snapshot, POMODORO_IPC_FRAME_PUSH, POMODORO_IPC_STATUS_OK, 0, Frame);
+
+	for(int32 Index = Clients.Num() - 1; Index >= 0; --Index)
+	{
+		FClient& Client = Clients[Index];
+		if(!Client.bSubscribed)
+		{
+			continue;
+		}
+
+		PomodoroIpc::AppendFrame(Client.Output, Frame);
+		if(Client.Output.Num() > PomodoroIpc::MaxPendingBytes || !FlushClient(Client))
+		{
+			close(Client.Socket);
+			Clients.RemoveAtSwap(Index);
+		}
+	}
+}
+
+void FPomodoroIpcServer::CloseSockets()
+{
+	for(const FClient& Client : Clients)
+	{
+		close(Client.Socket);
+	}
+	Clients.Empty();
+
+	if(ListenSocket != -1)
+	{
+		close(ListenSocket);
+		ListenSocket = -1;
+	}
+
+	if(!SocketPath.IsEmpty())
+	{
+		unlink(TCHAR_TO_UTF8(*SocketPath));
+		SocketPath.Empty();
+	}
+
+	{
+		FScopeLock ScopeLock(&WakeUp->Lock);
+		WakeUp->Descriptor = -1;
+	}
+	for(int32& Descriptor : WakePipe)
+	{
+		if(Descriptor != -1)
+		{
+			close(Descriptor);
+			Descriptor = -1;
+		}
+	}
+}
+
+#else
+
+FPomodoroIpcServer::FPomodoroIpcServer(TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> InSnapshotChannel,
+	FPomodoroIpcCommandHandler InCommandHandler)
+	: SnapshotChannel(MoveTemp(InSnapshotChannel))
+	, CommandHandler(MoveTemp(InCommandHandler))
+	, WakeUp(MakeShared<FWakeUp, ESPMode::ThreadSafe>())
+{
+}
+
+FPomodoroIpcServer::~FPomodoroIpcServer()
+{
+}
+
+bool FPomodoroIpcServer::Listen(const FString& InSocketPath)
+{
+	return false;
+}
+
+void FPomodoroIpcServer::Close()
+{
+}
+
+void FPomodoroIpcServer::NotifySnapshotChanged()
+{
+}
+
+FString FPomodoroIpcServer::GetDefaultSocketPath()
+{
+	return FString();
+}
+
+uint32 FPomodoroIpcServer::Run()
+{
+	return 0;
+}
+
+void FPomodoroIpcServer::Stop()
+{
+}
+
+#endif
@@ -0,0 +1,141 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroNotificationPipeline.h"
+
+#include "Async/Async.h"
+
+FPomodoroNotificationPipeline::FPomodoroNotificationPipeline()
+	: Sinks(MakeShared<TArray<FSink>, ESPMode::ThreadSafe>())
+{
+	ElapsedTimespanHandleDelegate.BindRaw(this, &FPomodoroNotificationPipeline::Enqueue);
+}
+
+FPomodoroNotificationPipeline::~FPomodoroNotificationPipeline()
+{
+}
+
+FDelegateHandle FPomodoroNotificationPipeline::AddSink(const EPomodoroSinkThread Thread, FPomodoroNotificationSinkDelegate Sink)
+{
+	const FDelegateHandle Handle = Sink.GetHandle();
+
+	FScopeLock Lock(&SinksLock);
+	TSharedRef<TArray<FSink>, ESPMode::ThreadSafe> NewSinks = MakeShared<TArray<FSink>, ESPMode::ThreadSafe>(*Sinks);
+	NewSinks->Add({Thread, MoveTemp(Sink)});
+	Sinks = NewSinks;
+	return Handle;
+}
+
+void FPomodoroNotificationPipeline::RemoveSink(const FDelegateHandle Handle)
+{
+	{
+		FScopeLock Lock(&SinksLock);
+		TSharedRef<TArray<FSink>, ESPMode::ThreadSafe> NewSinks = MakeShared<TArray<FSink>, ESPMode::ThreadSafe>(*Sinks);
+		NewSinks->RemoveAll([Handle](const FSink& Sink)
+		{
+			return Sink.Delegate.GetHandle() == Handle;
+		});
+		Sinks = NewSinks;
+	}
+
+	// The draining task may still hold the previous list, let it finish with it
+	if(IsInGameThread() && DispatchTask.IsValid())
+	{
+		DispatchTask.Wait();
+	}
+}
+
+void FPomodoroNotificationPipeline::Enqueue(const bool bWorkingTime)
+{
+	if(bShutdown)
+	{
+		return;
+	}
+
+	FPomodoroBoundaryEvent Event;
+	Event.Sequence = ++LastSequence;
+	Event.bWorkingTime = bWorkingTime;
+	Event.TimeUtc = FDateTime::UtcNow();
+
+	// Game thread sinks run once the engine is done with the timespan end
+	const TWeakPtr<FPomodoroNotificationPipeline, ESPMode::ThreadSafe> WeakThis = AsShared();
+	AsyncTask(ENamedThreads::GameThread, [WeakThis, Event]()
+	{
+		const TSharedPtr<FPomodoroNotificationPipeline, ESPMode::ThreadSafe> This = WeakThis.Pin();
+		if(This.IsValid() && !This->bShutdown)
+		{
+			This->CallSinks(EPomodoroSinkThread::GameThread, Event);
+		}
+	});
+
+	PendingEvents.Enqueue(Event);
+	ScheduleDispatch();
+}
+
+void FPomodoroNotificationPipeline::Shutdown()
+{
+	bShutdown = true;
+	if(DispatchTask.IsValid())
+	{
+		DispatchTask.Wait();
+	}
+
+	FScopeLock Lock(&SinksLock);
+	Sinks = MakeShared<TArray<FSink>, ESPMode::ThreadSafe>();
+}
+
+TSharedPtr<const TArray<FPomodoroNotificationPipeline::FSink>, ESPMode::ThreadSafe> FPomodoroNotificationPipeline::GetSinks() const
+{
+	FScopeLock Lock(&SinksLock);
+	return Sinks;
+}
+
+void FPomodoroNotificationPipeline::CallSinks(const EPomodoroSinkThread Thread, const FPomodoroBoundaryEvent& Event) const
+{
+	const TSharedPtr<const TArray<FSink>, ESPMode::ThreadSafe> CurrentSinks = GetSinks();
+	for(const FSink& Sink : *CurrentSinks)
+	{
+		if(Sink.Thread == Thread)
+		{
+			Sink.Delegate.ExecuteIfBound(Event);
+		}
+	}
+}
+
+void FPomodoroNotificationPipeline::ScheduleDispatch()
+{
+	bool bExpected = false;
+	if(!bDispatching.compare_exchange_strong(bExpected, true))
+	{
+		// The running task will see the new event before it stops
+		return;
+	}
+
+	// The task keeps the pipeline alive, even past the point a newer task replaced it
+	const TSharedRef<FPomodoroNotificationPipeline, ESPMode::ThreadSafe> This = AsShared();
+	DispatchTask = Async(EAsyncExecution::TaskGraph, [This]()
+	{
+		This->Dispatch();
+	});
+}
+
+void FPomodoroNotificationPipeline::Dispatch()
+{
+	while(true)
+	{
+		FPomodoroBoundaryEvent Event;
+		while(!bShutdown && PendingEvents.Dequeue(Event))
+		{
+			CallSinks(EPomodoroSinkThread::AnyThread, Event);
+		}
+
+		bDispatching = false;
+
+		// An event enqueued after the last dequeue but before the flag was cleared would be left behind
+		bool bExpected = false;
+		if(bShutdown || PendingEvents.IsEmpty() || !bDispatching.compare_exchange_strong(bExpected, true))
+		{
+			return;
+		}
+	}
+}
@@ -6,9 +6,23 @@
 #include "PomodoroConfig.h"
 #include "Framework/Notifications/NotificationManager.h"
 #include "Widgets/Notifications/SNotificationList.h"
+#include "UObject/UObjectGlobals.h"
+#include "PomodoroDeferredWork.h"
 
 #define LOCTEXT_NAMESPACE "FPomodoroNotifier"
 
+namespace PomodoroNotifier
+{
+	static const TCHAR* SoundPackage = TEXT("/PomodoroPlugin/BellRinging_Cue");
+	static const TCHAR* SoundPath = TEXT("/PomodoroPlugin/BellRinging_Cue.BellRinging_Cue");
+
+	/** Key of the deferred toast */
+	static const FName ToastKey(TEXT("PomodoroNotifierToast"));
+
+	/** The toast shows at the latest after this delay, the sound already rang */
+	constexpr double ToastDelaySeconds = 0.5;
+}
+
 FPomodoroNotifier::FPomodoroNotifier()
 {
 	WorkingMessages = TArray<FText>();
@@ -20,25 +34,23 @@ FPomodoroNotifier::FPomodoroNotifier()
 	RestingMessages.Add(LOCTEXT("RestingMessage1", "Take some rest !"));
 	RestingMessages.Add(LOCTEXT("RestingMessage2", "Remember to drink !"));
 	RestingMessages.Add(LOCTEXT("RestingMessage3", "You should go out !"));
-
-	ElapsedTimespanHandleDelegate.BindRaw(this, &FPomodoroNotifier::Notify);
 }
 
 FPomodoroNotifier::~FPomodoroNotifier()
 {
 }
 
-void FPomodoroNotifier::Notify(const bool bWorkingTime)
+void FPomodoroNotifier::Notify(const FPomodoroBoundaryEvent& Event)
 {
 	// Play Sound
 	if (ActivateSound == ECheckBoxState::Checked && GEditor)
 	{
-		GEditor->PlayEditorSound(TEXT("/PomodoroPlugin/BellRinging_Cue.BellRinging_Cue"));
+		GEditor->PlayEditorSound(PomodoroNotifier::SoundPath);
 	}
 	
 	// Prepare text to display depending on the parameter 
 	FText TextToDisplay;
-	if(bWorkingTime)
+	if(Event.bWorkingTime)
 	{
 		TextToDisplay = RestingMessages[FMath::RandRange(0, RestingMessages.Num() - 1)];
 	}
@@ -47,7 +59,15 @@ void FPomodoroNotifier::Notify(const bool bWorkingTime)
 		TextToDisplay = WorkingMessages[FMath::RandRange(0, WorkingMessages.Num() - 1)];
 	}
 
-	// Display the notification 
+	// Display the notification once the frame has time for it
+	FPomodoroDeferredWork::Enqueue(PomodoroNotifier::ToastKey, EPomodoroWorkPriority::High, PomodoroNotifier::ToastDelaySeconds, [TextToDisplay]()
+	{
+		ShowToast(TextToDisplay);
+	});
+}
+
+void FPomodoroNotifier::ShowToast(const FText& TextToDisplay)
+{
 	FNotificationInfo Info(TextToDisplay);
 	Info.FadeInDuration = 0.1f;
 	Info.FadeOutDuration = 0.5f;
@@ -72,6 +92,25 @@ ECheckBoxState FPomodoroNotifier::GetNotificationSoundState() const
 	return ActivateSound;
 }
 
+void FPomodoroNotifier::PreloadSound()
+{
+	if(Sound.IsValid())
+	{
+		return;
+	}
+
+	const TWeakPtr<FPomodoroNotifier> WeakThis = AsShared();
+	LoadPackageAsync(PomodoroNotifier::SoundPackage, FLoadPackageAsyncDelegate::CreateLambda(
+		[WeakThis](const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+		{
+			const TSharedPtr<FPomodoroNotifier> This = WeakThis.Pin();
+			if(This.IsValid() && Result == EAsyncLoadingResult::Succeeded)
+			{
+				This->Sound.Reset(FindObject<UObject>(nullptr, PomodoroNotifier::SoundPath));
+			}
+		}));
+}
+
 void FPomodoroNotifier::ResetConfig()
 {
 	ActivateSound = ECheckBoxState::Checked;
@@ -3,33 +3,52 @@
 #include "PomodoroPlugin.h"
 #include "PomodoroPluginStyle.h"
 #include "PomodoroPluginCommands.h"
+#include "SPomodoroCountdown.h"
+#include "SPomodoroProgressRing.h"
+#include "SPomodoroHeatmap.h"
+#include "SPomodoroTrendChart.h"
 #include "LevelEditor.h"
+#include "Editor.h"
+#include "Framework/Application/SlateApplication.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "Widgets/Layout/SBox.h"
+#include "Widgets/Layout/SExpandableArea.h"
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Input/SEditableTextBox.h"
+#include "Widgets/Input/SSearchBox.h"
+#include "Widgets/Views/SListView.h"
+#include "Widgets/SInvalidationPanel.h"
+#include "Styling/CoreStyle.h"
 #include "ToolMenus.h"
 #include "Misc/FileHelper.h"
 #include "Widgets/Notifications/SNotificationList.h"
+#include "Async/Async.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/CoreDelegates.h"
+#include "PomodoroConfig.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "PomodoroIpcProtocol.h"
+#include "PomodoroPhaseImporter.h"
 
 static const FName PomodoroPluginTabName("PomodoroPlugin");
 
+/** A remote command not run within this delay is rejected, the game thread may be stalled */
+static constexpr double RemoteCommandTimeoutSeconds = 2.0;
+
 #define LOCTEXT_NAMESPACE "FPomodoroPluginModule"
 
 void FPomodoroPluginModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-	
+	TRACE_CPUPROFILER_EVENT_SCOPE(PomodoroStartupModule);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// Only the entry points are registered while the editor boots, the timer starts once it is up
 	FPomodoroPluginStyle::Initialize();
-	FPomodoroPluginStyle::ReloadTextures();
 
 	FPomodoroPluginCommands::Register();
 	
-	Engine = MakeShared<FPomodoroEngine>();
-
-	Notifier = MakeShared<FPomodoroNotifier>();
-	Engine->BindOnTimeSpanElapsed(Notifier->ElapsedTimespanHandleDelegate);
-	
 	PluginCommands = MakeShareable(new FUICommandList);
 
 	PluginCommands->MapAction(
@@ -42,16 +61,85 @@ void FPomodoroPluginModule::StartupModule()
 	FGlobalTabmanager::Get()->RegisterNomadTabSpawner(PomodoroPluginTabName, FOnSpawnTab::CreateRaw(this, &FPomodoroPluginModule::OnSpawnPluginTab))
 		.SetDisplayName(LOCTEXT("FPomodoroPluginTabTitle", "PomodoroPlugin"))
 		.SetMenuType(ETabSpawnerMenuType::Hidden);
+
+	// Loaded after the engine, when the plugin is enabled while the editor runs
+	if(GEngine != nullptr && GEngine->IsInitialized())
+	{
+		OnPostEngineInit();
+	}
+	else
+	{
+		FCoreDelegates::OnPostEngineInit.AddRaw(this, &FPomodoroPluginModule::OnPostEngineInit);
+	}
+
+	StartupSeconds = FPlatformTime::Seconds() - StartSeconds;
 }
 
 void FPomodoroPluginModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	bShuttingDown = true;
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+	if(ConfigPrefetch.IsValid())
+	{
+		ConfigPrefetch.Wait();
+	}
+
+	if(SyncClient.IsValid())
+	{
+		SyncClient->Shutdown();
+		SyncClient.Reset();
+	}
+
+	if(Coordinator.IsValid())
+	{
+		Coordinator->Shutdown();
+		Coordinator.Reset();
+	}
+
+	if(IpcServer.IsValid())
+	{
+		Engine->OnSnapshotPublished().RemoveAll(IpcServer.Get());
+		IpcServer->Close();
+		IpcServer.Reset();
+	}
+
+	if(HttpServer.IsValid())
+	{
+		Engine->OnSnapshotPublished().RemoveAll(HttpServer.Get());
+		HttpServer->Close();
+		HttpServer.Reset();
+	}
+
+	if(Engine.IsValid())
+	{
+		Engine->OnSnapshotPublished().RemoveAll(this);
+		Engine->SetSessionLog(nullptr);
+		NotificationPipeline->Shutdown();
+	}
+	SessionLog.Reset();
+	StatusPage.Reset();
+	Planner.Reset();
+	AdaptiveDurations.Reset();
+	TaskTracker.Reset();
+	FocusHistory.Reset();
+	if(Percentiles.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().GetLastUserInteractionTimeUpdateEvent().RemoveAll(Percentiles.Get());
+	}
+	Percentiles.Reset();
+	PhaseNotes.Reset();
+	PhaseHistory.Reset();
+
+	// Run what is still pending, the components flushed their own work when destroyed
+	DeferredWork.Reset();
 	
 	UToolMenus::UnRegisterStartupCallback(this);
 
 	UToolMenus::UnregisterOwner(this);
+	Countdown.Reset();
 
 	FPomodoroPluginStyle::Shutdown();
 
@@ -60,9 +148,151 @@ void FPomodoroPluginModule::ShutdownModule()
 	FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(PomodoroPluginTabName);
 }
 
+void FPomodoroPluginModule::OnPostEngineInit()
+{
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+
+	// The config and data files are read and parsed on a worker, the game thread only hands them over to the components
+	const FString ConfigPath = UPomodoroConfig::GetConfigFilePath();
+	const FString ConfigSection = UPomodoroConfig::StaticClass()->GetPathName();
+	ConfigPrefetch = Async(EAsyncExecution::ThreadPool, [ConfigPath, ConfigSection]()
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(PomodoroPrefetchConfig);
+		const double StartSeconds = FPlatformTime::Seconds();
+
+		const TSharedRef<FPomodoroStartupFiles, ESPMode::ThreadSafe> Files = MakeShared<FPomodoroStartupFiles, ESPMode::ThreadSafe>();
+		Files->ConfigPath = ConfigPath;
+		if(FPaths::FileExists(ConfigPath))
+		{
+			Files->ConfigFile = MakeShared<FConfigFile, ESPMode::ThreadSafe>();
+			Files->ConfigFile->Read(ConfigPath);
+
+			FString TaskFile;
+			if(Files->ConfigFile->GetString(*ConfigSection, TEXT("TaskFile"), TaskFile) && !TaskFile.IsEmpty())
+			{
+				Files->bTasksRead = FPomodoroTaskTracker::ReadTaskFile(TaskFile, Files->Tasks);
+			}
+		}
+		Files->PhaseHistory = FPomodoroPhaseHistory::ReadHistoryFile();
+		Files->Percentiles = FPomodoroPercentiles::ReadPercentilesFile();
+		Files->PhaseNotes = FPomodoroPhaseNotes::ReadNotesFile();
+
+		// A log is written each time the editor starts, the old ones go before the new one is created
+		FPomodoroSessionLog::PruneSessions();
+
+		Files->ReadSeconds = FPlatformTime::Seconds() - StartSeconds;
+		AsyncTask(ENamedThreads::GameThread, [Files]()
+		{
+			// The module may have been unloaded in between
+			FPomodoroPluginModule* Module = FModuleManager::GetModulePtr<FPomodoroPluginModule>("PomodoroPlugin");
+			if(Module != nullptr && !Module->bShuttingDown)
+			{
+				Module->CompleteStartup(Files.Get());
+			}
+		});
+	});
+}
+
+void FPomodoroPluginModule::CompleteStartup(FPomodoroStartupFiles& Files)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(PomodoroCompleteStartup);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// Every component loading its config now finds the file in the cache
+	if(Files.ConfigFile.IsValid() && GConfig != nullptr && GConfig->FindConfigFile(Files.ConfigPath) == nullptr)
+	{
+		GConfig->SetFile(Files.ConfigPath, Files.ConfigFile.Get());
+	}
+
+	// The timer and the deferred work run on the core ticker, the configuration lives in the project config
+	const TSharedRef<FPomodoroClock> Clock = MakeShared<FPomodoroTickerClock>();
+	const TSharedRef<IPomodoroConfigStore> ConfigStore = MakeShared<FPomodoroConfigStore>();
+
+	// Created first, the components postpone their saves through it
+	DeferredWork = MakeUnique<FPomodoroDeferredWork>(Clock, FPomodoroIsBusyDelegate::CreateLambda([]()
+	{
+		return GEditor != nullptr && GEditor->IsPlayingSessionInEditor();
+	}));
+
+	Engine = MakeShared<FPomodoroEngine>(Clock, ConfigStore);
+
+	// Recorded from the restored state, so the session can be replayed later by the PomodoroReplay commandlet
+	SessionLog = MakeShared<FPomodoroSessionLog>(FPomodoroSessionLog::MakeSessionPath());
+	Engine->SetSessionLog(SessionLog);
+
+	Notifier = MakeShared<FPomodoroNotifier>();
+	Notifier->PreloadSound();
+	NotificationPipeline = MakeShared<FPomodoroNotificationPipeline, ESPMode::ThreadSafe>();
+	NotificationPipeline->AddSink(EPomodoroSinkThread::GameThread,
+		FPomodoroNotificationSinkDelegate::CreateSP(Notifier.ToSharedRef(), &FPomodoroNotifier::Notify));
+	NotificationPipeline->AddSink(EPomodoroSinkThread::AnyThread,
+		FPomodoroNotificationSinkDelegate::CreateLambda([](const FPomodoroBoundaryEvent& Event)
+		{
+			UE_LOG(LogPomodoro, Log, TEXT("%s timespan ended at %s"),
+				Event.bWorkingTime ? TEXT("Working") : TEXT("Resting"), *Event.TimeUtc.ToIso8601());
+		}));
+	Engine->BindOnTimeSpanElapsed(NotificationPipeline->ElapsedTimespanHandleDelegate);
+
+	SyncClient = MakeShared<FPomodoroSyncClient, ESPMode::ThreadSafe>(Engine.ToSharedRef());
+
+	Planner = MakeShared<FPomodoroDayPlanner>(ConfigStore);
+	ReplanDay();
+
+	AdaptiveDurations = MakeShared<FPomodoroAdaptiveDurations>(Engine.ToSharedRef());
+	TaskTracker = MakeShared<FPomodoroTaskTracker, ESPMode::ThreadSafe>(Engine.ToSharedRef());
+	if(Files.bTasksRead && Files.Tasks.Path == TaskTracker->GetImportPath())
+	{
+		TaskTracker->ApplyTaskList(MoveTemp(Files.Tasks));
+	}
+	else if(!TaskTracker->GetImportPath().IsEmpty())
+	{
+		TaskTracker->ImportTasks(TaskTracker->GetImportPath());
+	}
+	FocusHistory = MakeShared<FPomodoroFocusHistory>(Engine.ToSharedRef());
+	Percentiles = MakeShared<FPomodoroPercentiles>(Engine.ToSharedRef(), MoveTemp(Files.Percentiles));
+	if(FSlateApplication::IsInitialized())
+	{
+		// The overruns last as long as the user keeps using the editor
+		FSlateApplication::Get().GetLastUserInteractionTimeUpdateEvent().AddSP(Percentiles.ToSharedRef(), &FPomodoroPercentiles::AddUserActivity);
+	}
+	PhaseHistory = MakeShared<FPomodoroPhaseHistory>(Engine.ToSharedRef(), MoveTemp(Files.PhaseHistory));
+	PhaseNotes = MakeShared<FPomodoroPhaseNotes>(PhaseHistory.ToSharedRef(), MoveTemp(Files.PhaseNotes));
+
+	// Only the editor owning the timer serves it to other processes
+#if WITH_POMODORO_IPC
+	Coordinator = MakeShared<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe>(Engine.ToSharedRef(),
+		FSimpleDelegate::CreateRaw(this, &FPomodoroPluginModule::StartLeaderServices));
+	Coordinator->Start();
+#else
+	StartLeaderServices();
+#endif
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroPluginModule::OnEngineSnapshotPublished);
+
+	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &FPomodoroPluginModule::RegisterCountdown));
+
+	const double CompleteSeconds = FPlatformTime::Seconds() - StartSeconds;
+	UE_LOG(LogPomodoro, Log, TEXT("Started in %.2f ms at boot and %.2f ms after engine init on the game thread, config and data files read in %.2f ms on a worker"),
+		StartupSeconds * 1000.0, CompleteSeconds * 1000.0, Files.ReadSeconds * 1000.0);
+}
+
 TSharedRef<SDockTab> FPomodoroPluginModule::OnSpawnPluginTab(const FSpawnTabArgs& SpawnTabArgs) const
 {
-	return SNew(SDockTab)
+	TRACE_CPUPROFILER_EVENT_SCOPE(PomodoroSpawnPluginTab);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	if(!Engine.IsValid())
+	{
+		return SNew(SDockTab)
+			.TabRole(NomadTab)
+			[
+				SNew(STextBlock)
+				.Margin(FMargin(10))
+				.Text(LOCTEXT("StartingLabel", "The timer is still starting, open this tab again in a moment."))
+			];
+	}
+
+	// Only the timer control is built now, the other sections are built when first expanded
+	const TSharedRef<SDockTab> Tab = SNew(SDockTab)
 		.TabRole(NomadTab)
 		.ShouldAutosize(true)
 		[
@@ -84,88 +314,157 @@ TSharedRef<SDockTab> FPomodoroPluginModule::OnSpawnPluginTab(const FSpawnTabArgs
 				.HAlign(HAlign_Fill)
 				.Padding(FMargin(0, 5))
 				[
-					SNew(SBorder)
-					.Padding(FMargin(10))
-					[
-						SNew(SVerticalBox)
-
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						.Padding(0.0f, 0.0f, 0.0f, 5.0f)
-						[
-							SNew(STextBlock)
-							.Text(LOCTEXT("ControlLabel","Timer control"))
-						]
-						
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						[
-							SpawnButtons()
-						]
-					]
+					SpawnSection(LOCTEXT("ControlLabel","Timer control"), false, [this]()
+					{
+						return SpawnButtons();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("TaskLabel","Current task"), true, [this]()
+					{
+						return SpawnTaskPicker();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("FocusHistoryLabel","Focus history"), true, [this]()
+					{
+						return SNew(SPomodoroHeatmap, FocusHistory.ToSharedRef());
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("TrendsLabel","Focus trends"), true, [this]()
+					{
+						return SpawnTrends();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("NotesLabel","Notes"), true, [this]()
+					{
+						return SpawnNotes();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("EngineOptionLabel","Timer options"), true, [this]()
+					{
+						return SpawnTimerConfig();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("AdaptiveOptionLabel","Adaptive timespans"), true, [this]()
+					{
+						return SpawnAdaptiveDurations();
+					})
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.HAlign(HAlign_Fill)
+				.Padding(FMargin(0, 5))
+				[
+					SpawnSection(LOCTEXT("NotificationOptionLabel","Notification options"), true, [this]()
+					{
+						return SpawnNotificationConfig();
+					})
 				]
 
 				+ SVerticalBox::Slot()
 				.AutoHeight()
 				.HAlign(HAlign_Fill)
-				.VAlign(VAlign_Fill)
 				.Padding(FMargin(0, 5))
 				[
-					SNew(SBorder)
-					.Padding(FMargin(10))
-					[
-						SNew(SVerticalBox)
-
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						.Padding(0.0f, 0.0f, 0.0f, 5.0f)
-						[
-							SNew(STextBlock)
-							.Text(LOCTEXT("EngineOptionLabel","Timer options"))
-						]
-						
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						[
-							SpawnTimerConfig()
-						]
-					]
+					SpawnSection(LOCTEXT("SyncOptionLabel","Team sync options"), true, [this]()
+					{
+						return SpawnSyncConfig();
+					})
 				]
 
 				+ SVerticalBox::Slot()
 				.AutoHeight()
 				.HAlign(HAlign_Fill)
-				.VAlign(VAlign_Fill)
 				.Padding(FMargin(0, 5))
 				[
-					SNew(SBorder)
-					.Padding(FMargin(10))
-					[
-						SNew(SVerticalBox)
-
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						.Padding(0.0f, 0.0f, 0.0f, 5.0f)
-						[
-							SNew(STextBlock)
-							.Text(LOCTEXT("NotificationOptionLabel","Notification options"))
-						]
-						
-						+ SVerticalBox::Slot()
-						.AutoHeight()
-						.HAlign(HAlign_Center)
-						[
-							SpawnNotificationConfig()
-						]
-					]
+					SpawnSection(LOCTEXT("PlannerLabel","Day planner"), true, [this]()
+					{
+						return SpawnDayPlanner();
+					})
 				]
 			]
 		];
+
+	UE_LOG(LogPomodoro, Verbose, TEXT("Plugin tab built in %.3f ms"), (FPlatformTime::Seconds() - StartSeconds) * 1000.0);
+	return Tab;
+}
+
+TSharedRef<SWidget> FPomodoroPluginModule::SpawnSection(const FText& Title, const bool bInitiallyCollapsed, TFunction<TSharedRef<SWidget>()> SpawnBody) const
+{
+	const TSharedRef<SBox> Body = SNew(SBox);
+	const TSharedRef<TFunction<TSharedRef<SWidget>()>> PendingBody = MakeShared<TFunction<TSharedRef<SWidget>()>>(MoveTemp(SpawnBody));
+
+	// Build the body once, the first time the section is expanded
+	const auto BuildBody = [Body, PendingBody, Title]()
+	{
+		if(!*PendingBody)
+		{
+			return;
+		}
+
+		TRACE_CPUPROFILER_EVENT_SCOPE(PomodoroSpawnSection);
+		const double StartSeconds = FPlatformTime::Seconds();
+		Body->SetContent((*PendingBody)());
+		*PendingBody = nullptr;
+		UE_LOG(LogPomodoro, Verbose, TEXT("Section %s built in %.3f ms"), *Title.ToString(), (FPlatformTime::Seconds() - StartSeconds) * 1000.0);
+	};
+
+	if(!bInitiallyCollapsed)
+	{
+		BuildBody();
+	}
+
+	return SNew(SExpandableArea)
+		.AreaTitle(Title)
+		.InitiallyCollapsed(bInitiallyCollapsed)
+		.Padding(FMargin(10))
+		.OnAreaExpansionChanged_Lambda([BuildBody](const bool bExpanded)
+		{
+			if(bExpanded)
+			{
+				BuildBody();
+			}
+		})
+		.BodyContent()
+		[
+			Body
+		];
 }
 
 TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnInfo() const
@@ -176,6 +475,7 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnInfo() const
 	.AutoWidth()
 	.Padding(10,0)
 	.HAlign(HAlign_Left)
+	.VAlign(VAlign_Center)
 	[
 		SNew(STextBlock)
 		.Text_Lambda([this]()
@@ -198,10 +498,20 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnInfo() const
 		})
 	]
 	
+	+SHorizontalBox::Slot()
+	.AutoWidth()
+	.Padding(10,0,0,0)
+	.VAlign(VAlign_Center)
+	[
+		SNew(SPomodoroProgressRing, Engine.ToSharedRef())
+		.Diameter(32.0f)
+	]
+
 	+SHorizontalBox::Slot()
 	.AutoWidth()
 	.Padding(10,0)
 	.HAlign(HAlign_Center)
+	.VAlign(VAlign_Center)
 	[
 		SNew(STextBlock)
 		.Text_Lambda([this]()
@@ -218,6 +528,7 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnInfo() const
 	.AutoWidth()
 	.Padding(10,0)
 	.HAlign(HAlign_Right)
+	.VAlign(VAlign_Center)
 	[
 		SNew(STextBlock)
 		.Text_Lambda([this]()
@@ -319,472 +630,1050 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnButtons() const
 	];
 }
 
-TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTaskPicker() const
 {
-	return SNew(SVerticalBox)
-	
-		// Cycle Length parameter
-		+SVerticalBox::Slot()
-		.AutoHeight()
-		.HAlign(HAlign_Fill)
-		.Padding(0,5)
-		[
-			SNew(SHorizontalBox)
+	// Positions of the tasks found and the list showing them, shared by the search box and the list
+	const TSharedRef<TArray<TSharedPtr<int32>>> FoundTasks = MakeShared<TArray<TSharedPtr<int32>>>();
+	const TSharedRef<TSharedPtr<SListView<TSharedPtr<int32>>>> TaskList = MakeShared<TSharedPtr<SListView<TSharedPtr<int32>>>>();
 
-			+ SHorizontalBox::Slot()
-			.FillWidth(1)
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(0,3,10,3))
-				.Text(LOCTEXT("CycleLength","Cycle length"))
-			]
+	TSharedRef<SVerticalBox> Panel = SNew(SVerticalBox)
 
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
-				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetCycleCount();
-					}
-					return 0;
-				})
-				.MinValue(1)
-				.MaxValue(99)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
-				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+	// Current task and its focus time
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Center)
+	.Padding(0,5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this]()
+		{
+			const FString& TaskId = TaskTracker->GetCurrentTask();
+			if(TaskId.IsEmpty())
+			{
+				return LOCTEXT("NoTask", "No task, the focus time isn't attributed");
+			}
+			const FTimespan FocusTime = TaskTracker->GetFocusTime(TaskId);
+			return FText::Format(FTextFormat::FromString(TEXT("{0} {1} : {2}h {3}m")),
+				FText::FromString(TaskId), FText::FromString(TaskTracker->GetTaskTitle(TaskId)),
+				static_cast<int32>(FocusTime.GetTotalHours()), FocusTime.GetMinutes());
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SNew(SSearchBox)
+		.HintText(LOCTEXT("TaskSearchHint", "Search a task by identifier or title"))
+		.OnTextChanged_Lambda([this, FoundTasks, TaskList](const FText& Text)
+		{
+			TArray<int32> Positions;
+			TaskTracker->FindTasks(Text.ToString(), 20, Positions);
+			FoundTasks->Reset(Positions.Num());
+			for(const int32 Position : Positions)
+			{
+				FoundTasks->Add(MakeShared<int32>(Position));
+			}
+			if(TaskList->IsValid())
+			{
+				(*TaskList)->RequestListRefresh();
+			}
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SNew(SBox)
+		.MaxDesiredHeight(150.0f)
+		[
+			SAssignNew(*TaskList, SListView<TSharedPtr<int32>>)
+			.ListItemsSource(&FoundTasks.Get())
+			.SelectionMode(ESelectionMode::Single)
+			.OnGenerateRow_Lambda([this, FoundTasks](const TSharedPtr<int32> Position, const TSharedRef<STableViewBase>& OwnerTable)
+			{
+				const FPomodoroTask& Task = TaskTracker->GetTask(*Position);
+				return SNew(STableRow<TSharedPtr<int32>>, OwnerTable)
+				[
+					SNew(STextBlock)
+					.Text(FText::FromString(Task.Id + TEXT("  ") + Task.Title))
+				];
+			})
+			.OnSelectionChanged_Lambda([this](const TSharedPtr<int32> Position, ESelectInfo::Type)
+			{
+				if(Position.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						Engine->SetCycleCount(NewValue);
-					}
-				})
-			]
+					TaskTracker->SetCurrentTask(TaskTracker->GetTask(*Position).Id);
+				}
+			})
 		]
+	]
 
-		// Working timespan parameter
-		+SVerticalBox::Slot()
-		.AutoHeight()
-		.Padding(0,5)
+	// Task export file
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.FillWidth(1)
 		[
-			SNew(SHorizontalBox)
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Left)
-			.FillWidth(1)
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(0,3,10,3))
-				.Text(LOCTEXT("WorkingTimeSpanLength","Working Timespan Length"))
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
-				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetWorkingTimespan().GetHours();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(23)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+			SNew(SEditableTextBox)
+			.HintText(LOCTEXT("TaskFileHint", "Task export file, one \"ID, title\" per line"))
+			.Text_Lambda([this]()
+			{
+				return FText::FromString(TaskTracker->GetImportPath());
+			})
+			.OnTextCommitted_Lambda([this](const FText& Value, ETextCommit::Type CommitType)
+			{
+				if(CommitType == ETextCommit::OnEnter)
 				{
-					if(Engine.IsValid())
+					// Saved once read, an unreadable file keeps the previous tasks
+					TaskTracker->ImportTasks(Value.ToString(), [this](const bool bImported)
 					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+						if(bImported && TaskTracker.IsValid())
+						{
+							TaskTracker->SaveConfig();
+						}
+					});
+				}
+			})
+		]
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("ClearTaskButton", "Clear Task"))
+			.OnClicked_Lambda([this]()
+			{
+				if(TaskTracker.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetWorkingTimespan();
-						Engine->SetWorkingTimespan(NewValue, Timespan.GetMinutes(), Timespan.GetSeconds());
-					}
-				})
-			]
+					TaskTracker->SetCurrentTask(FString());
+					return FReply::Handled();
+				}
+				return FReply::Unhandled();
+			})
+		]
+	];
 
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
+	return Panel;
+}
+
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTrends() const
+{
+	const TSharedRef<SPomodoroTrendChart> Chart = SNew(SPomodoroTrendChart, PhaseHistory.ToSharedRef());
+
+	// Import started from this section, polled by its status line
+	const TSharedRef<TFuture<FPomodoroImportResult>> Import = MakeShared<TFuture<FPomodoroImportResult>>();
+
+	// Radio buttons choosing the value and the time a point covers
+	const TSharedRef<SHorizontalBox> Choices = SNew(SHorizontalBox);
+	const auto AddChoice = [&Choices](const FText& Label, TFunction<bool()> IsChosen, TFunction<void()> Choose)
+	{
+		Choices->AddSlot()
+		.AutoWidth()
+		.Padding(0, 0, 10, 0)
+		[
+			SNew(SCheckBox)
+			.Style(FCoreStyle::Get(), "RadioButton")
+			.IsChecked_Lambda([IsChosen]()
+			{
+				return IsChosen() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+			})
+			.OnCheckStateChanged_Lambda([Choose](const ECheckBoxState Value)
+			{
+				if(Value == ECheckBoxState::Checked)
+				{
+					Choose();
+				}
+			})
 			[
 				SNew(STextBlock)
-				.Margin(FMargin(5,3,5,3))
-				.Text(FText::FromString(TEXT(" : ")))
+				.Text(Label)
 			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
-				{
-					if(Engine.IsValid())
+		];
+	};
+
+	const TPair<EPomodoroTrendMetric, FText> Metrics[] =
+	{
+		{EPomodoroTrendMetric::Focus, LOCTEXT("TrendFocusLabel", "Focus")},
+		{EPomodoroTrendMetric::Pause, LOCTEXT("TrendPauseLabel", "Pauses")},
+		{EPomodoroTrendMetric::Interruptions, LOCTEXT("TrendInterruptionsLabel", "Interruptions")},
+	};
+	for(const TPair<EPomodoroTrendMetric, FText>& Metric : Metrics)
+	{
+		const EPomodoroTrendMetric Value = Metric.Key;
+		AddChoice(Metric.Value, [Chart, Value]() { return Chart->GetMetric() == Value; }, [Chart, Value]() { Chart->SetMetric(Value); });
+	}
+
+	const TPair<EPomodoroTrendBucket, FText> Buckets[] =
+	{
+		{EPomodoroTrendBucket::Day, LOCTEXT("TrendDayLabel", "Per day")},
+		{EPomodoroTrendBucket::Week, LOCTEXT("TrendWeekLabel", "Per week")},
+	};
+	for(const TPair<EPomodoroTrendBucket, FText>& Bucket : Buckets)
+	{
+		const EPomodoroTrendBucket Value = Bucket.Key;
+		AddChoice(Bucket.Value, [Chart, Value]() { return Chart->GetBucket() == Value; }, [Chart, Value]() { Chart->SetBucket(Value); });
+	}
+
+	// The text is read on every paint, the sketches are only merged again once a value is added or the day changes
+	struct FPercentileText
+	{
+		uint32 Version = 0;
+		int32 Day = INDEX_NONE;
+		FText Text;
+	};
+	const TSharedRef<FPercentileText> PercentileText = MakeShared<FPercentileText>();
+
+	return SNew(SVerticalBox)
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0, 5)
+	[
+		Choices
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	[
+		Chart
+	]
+
+	// Percentiles of the last seven days, merged from the daily sketches
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0, 5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this, PercentileText]()
+		{
+			const int32 Today = FPomodoroFocusHistory::GetDay(FDateTime::Now());
+			const FPomodoroPercentileSet& Set = Percentiles->GetSet();
+			if(PercentileText->Day == Today && PercentileText->Version == Set.GetVersion())
+			{
+				return PercentileText->Text;
+			}
+
+			const auto Describe = [&Set, Today](const EPomodoroPercentileMetric Metric, const FText& Label)
+			{
+				const FPomodoroQuantileSketch Sketch = Set.Query(Metric, TOptional<EPomodoroPhase>(), Today - 6, Today);
+				return FText::Format(LOCTEXT("PercentileRow", "{0} : p50 {1} s, p95 {2} s, p99 {3} s ({4} samples)"), Label,
+					FText::AsNumber(FMath::RoundToInt(Sketch.GetQuantile(0.5))),
+					FText::AsNumber(FMath::RoundToInt(Sketch.GetQuantile(0.95))),
+					FText::AsNumber(FMath::RoundToInt(Sketch.GetQuantile(0.99))),
+					FText::AsNumber(Sketch.GetCount()));
+			};
+
+			TArray<FText> Lines;
+			Lines.Add(LOCTEXT("PercentileTitle", "Last 7 days"));
+			Lines.Add(Describe(EPomodoroPercentileMetric::Pause, LOCTEXT("PercentilePauseLabel", "Pause length")));
+			Lines.Add(Describe(EPomodoroPercentileMetric::Overrun, LOCTEXT("PercentileOverrunLabel", "Work past the end")));
+			Lines.Add(Describe(EPomodoroPercentileMetric::Interruption, LOCTEXT("PercentileInterruptionLabel", "Run before interruption")));
+
+			PercentileText->Day = Today;
+			PercentileText->Version = Set.GetVersion();
+			PercentileText->Text = FText::Join(FText::FromString(TEXT("\n")), Lines);
+			return PercentileText->Text;
+		})
+	]
+
+	// History exported by another timer
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0, 5)
+	[
+		SNew(SEditableTextBox)
+		.HintText(LOCTEXT("ImportHint", "CSV or JSON export of another timer, imported on Enter"))
+		.IsEnabled_Lambda([Import]()
+		{
+			return !Import->IsValid() || Import->IsReady();
+		})
+		.OnTextCommitted_Lambda([this, Import](const FText& Value, ETextCommit::Type CommitType)
+		{
+			if(CommitType == ETextCommit::OnEnter && !Value.IsEmpty() && (!Import->IsValid() || Import->IsReady()))
+			{
+				// The heatmap and the percentiles count the imported timespans too, the trends read them back from the history
+				const TWeakPtr<FPomodoroFocusHistory> WeakFocusHistory = FocusHistory;
+				const TWeakPtr<FPomodoroPercentiles> WeakPercentiles = Percentiles;
+				*Import = FPomodoroPhaseImporter::ImportFile(Value.ToString(), PhaseHistory.ToSharedRef(),
+					[WeakFocusHistory, WeakPercentiles](const TArray<FPomodoroPhaseRecord>& Added)
 					{
-						return Engine->GetWorkingTimespan().GetMinutes();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+						const TSharedPtr<FPomodoroFocusHistory> PinnedFocusHistory = WeakFocusHistory.Pin();
+						if(PinnedFocusHistory.IsValid())
+						{
+							PinnedFocusHistory->AddRecords(Added);
+						}
+						const TSharedPtr<FPomodoroPercentiles> PinnedPercentiles = WeakPercentiles.Pin();
+						if(PinnedPercentiles.IsValid())
+						{
+							PinnedPercentiles->AddRecords(Added);
+						}
+					});
+			}
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	[
+		SNew(STextBlock)
+		.Text_Lambda([Import]()
+		{
+			if(!Import->IsValid())
+			{
+				return FText::GetEmpty();
+			}
+			if(!Import->IsReady())
+			{
+				return LOCTEXT("ImportRunning", "Importing...");
+			}
+			const FPomodoroImportResult& Result = Import->Get();
+			if(!Result.Error.IsEmpty())
+			{
+				return FText::Format(LOCTEXT("ImportFailed", "Import failed : {0}"), FText::FromString(Result.Error));
+			}
+			return FText::Format(LOCTEXT("ImportDone", "{0} timespans read in {1} ms, {2} added, {3} already recorded, {4} records skipped."),
+				Result.ParsedCount, FMath::RoundToInt(Result.ParseSeconds * 1000.0), Result.AddedCount, Result.DuplicateCount, Result.SkippedCount);
+		})
+	];
+}
+
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotes() const
+{
+	// Numbers of the notes found and the list showing them, shared by the search box and the list
+	const TSharedRef<TArray<TSharedPtr<int32>>> FoundNotes = MakeShared<TArray<TSharedPtr<int32>>>();
+	const TSharedRef<TSharedPtr<SListView<TSharedPtr<int32>>>> NoteList = MakeShared<TSharedPtr<SListView<TSharedPtr<int32>>>>();
+	const TSharedRef<TSharedPtr<SEditableTextBox>> NoteBox = MakeShared<TSharedPtr<SEditableTextBox>>();
+
+	// The query is run again once a note is added, the new note may match it
+	const TSharedRef<FString> NoteQuery = MakeShared<FString>();
+	const auto RunNoteQuery = [this, NoteQuery, FoundNotes, NoteList]()
+	{
+		TArray<int32> Notes;
+		PhaseNotes->Search(*NoteQuery, 50, Notes);
+		FoundNotes->Reset(Notes.Num());
+		for(const int32 Note : Notes)
+		{
+			FoundNotes->Add(MakeShared<int32>(Note));
+		}
+		if(NoteList->IsValid())
+		{
+			(*NoteList)->RequestListRefresh();
+		}
+	};
+
+	return SNew(SVerticalBox)
+
+	// Timespan the next note goes to
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Center)
+	.Padding(0,5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this]()
+		{
+			const TOptional<FPomodoroPhaseRecord>& LastPhase = PhaseNotes->GetLastPhase();
+			if(!LastPhase.IsSet())
+			{
+				return LOCTEXT("NoNotePhase", "No timespan ended yet, the notes go to the last one");
+			}
+			const FDateTime StartLocal = FDateTime::FromUnixTimestamp(LastPhase->StartSeconds) + (FDateTime::Now() - FDateTime::UtcNow());
+			return FText::Format(LOCTEXT("NotePhase", "Note for the {0} timespan started at {1}"),
+				LastPhase->Phase == EPomodoroPhase::Working ? LOCTEXT("NoteWorking", "working") : LOCTEXT("NoteResting", "resting"),
+				FText::AsTime(StartLocal, EDateTimeStyle::Short, FText::GetInvariantTimeZone()));
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SAssignNew(*NoteBox, SEditableTextBox)
+		.HintText(LOCTEXT("NoteHint", "What was done, saved on Enter"))
+		.IsEnabled_Lambda([this]()
+		{
+			return PhaseNotes->GetLastPhase().IsSet();
+		})
+		.OnTextCommitted_Lambda([this, NoteBox, RunNoteQuery](const FText& Value, ETextCommit::Type CommitType)
+		{
+			if(CommitType == ETextCommit::OnEnter && PhaseNotes->AddNoteToLastPhase(Value.ToString()))
+			{
+				(*NoteBox)->SetText(FText::GetEmpty());
+				RunNoteQuery();
+			}
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SNew(SSearchBox)
+		.HintText(LOCTEXT("NoteSearchHint", "Search the notes, a word ending with * matches as a prefix"))
+		.OnTextChanged_Lambda([NoteQuery, RunNoteQuery](const FText& Text)
+		{
+			*NoteQuery = Text.ToString();
+			RunNoteQuery();
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.Padding(0,5)
+	[
+		SNew(SBox)
+		.MaxDesiredHeight(150.0f)
+		[
+			SAssignNew(*NoteList, SListView<TSharedPtr<int32>>)
+			.ListItemsSource(&FoundNotes.Get())
+			.SelectionMode(ESelectionMode::None)
+			.OnGenerateRow_Lambda([this](const TSharedPtr<int32> Number, const TSharedRef<STableViewBase>& OwnerTable)
+			{
+				const FPomodoroPhaseNote& Note = PhaseNotes->GetNote(*Number);
+				const FDateTime StartLocal = FDateTime::FromUnixTimestamp(Note.StartSeconds) + (FDateTime::Now() - FDateTime::UtcNow());
+				return SNew(STableRow<TSharedPtr<int32>>, OwnerTable)
+				[
+					SNew(STextBlock)
+					.Text(FText::FromString(StartLocal.ToString(TEXT("%Y-%m-%d %H:%M  ")) + Note.Text))
+				];
+			})
+		]
+	];
+}
+
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
+{
+	return SNew(SVerticalBox)
+	
+		// Cycle Length parameter, edits are only committed to the engine once released
+		+SVerticalBox::Slot()
+		.AutoHeight()
+		.HAlign(HAlign_Fill)
+		.Padding(0,5)
+		[
+			SpawnDraftRow(LOCTEXT("CycleLength","Cycle length"), 1, 99,
+				[this](int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					Values[0] = Engine->GetCycleCount();
+				},
+				[this](const int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetWorkingTimespan();
-						Engine->SetWorkingTimespan(Timespan.GetHours(), NewValue, Timespan.GetSeconds());
-					}
+					Engine->SetCycleCount(Values[0]);
 				})
-			]
+		]
 
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(5,3,5,3))
-				.Text(FText::FromString(TEXT(" : ")))
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
+		// Working timespan parameter
+		+SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(0,5)
+		[
+			SpawnDraftRow(LOCTEXT("WorkingTimeSpanLength","Working Timespan Length"), 3, 23,
+				[this](int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetWorkingTimespan().GetSeconds();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+					const FTimespan Timespan = Engine->GetWorkingTimespan();
+					Values[0] = Timespan.GetHours();
+					Values[1] = Timespan.GetMinutes();
+					Values[2] = Timespan.GetSeconds();
+				},
+				[this](const int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
+					Engine->SetWorkingTimespan(Values[0], Values[1], Values[2]);
 				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+		]
+
+		// Short resting timespan parameter
+		+SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(0,5)
+		[
+			SpawnDraftRow(LOCTEXT("ShortRestingTimeSpanLength","Short Resting Timespan Length"), 3, 23,
+				[this](int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetWorkingTimespan();
-						Engine->SetWorkingTimespan(Timespan.GetHours(), Timespan.GetMinutes(), NewValue);
-					}
+					const FTimespan Timespan = Engine->GetShortRestingTimespan();
+					Values[0] = Timespan.GetHours();
+					Values[1] = Timespan.GetMinutes();
+					Values[2] = Timespan.GetSeconds();
+				},
+				[this](const int32* Values)
+				{
+					Engine->SetShortRestingTimespan(Values[0], Values[1], Values[2]);
 				})
-			]
 		]
 
-		// Short resting timespan parameter
+		// Long Resting Timespan Length
 		+SVerticalBox::Slot()
 		.AutoHeight()
 		.Padding(0,5)
 		[
-			SNew(SHorizontalBox)
-		
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Left)
-			.FillWidth(1)
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(0,3,10,3))
-				.Text(LOCTEXT("ShortRestingTimeSpanLength","Short Resting Timespan Length"))
-			]
-		
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
+			SpawnDraftRow(LOCTEXT("LongRestingTimeSpanLength","Long Resting Timespan Length"), 3, 23,
+				[this](int32* Values)
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetShortRestingTimespan().GetHours();
-					}
-					return 0;
+					const FTimespan Timespan = Engine->GetLongRestingTimespan();
+					Values[0] = Timespan.GetHours();
+					Values[1] = Timespan.GetMinutes();
+					Values[2] = Timespan.GetSeconds();
+				},
+				[this](const int32* Values)
+				{
+					Engine->SetLongRestingTimespan(Values[0], Values[1], Values[2]);
 				})
-				.MinValue(0)
-				.MaxValue(23)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+		]
+
+	+SVerticalBox::Slot()
+	.AutoHeight()
+	[
+		SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.OnClicked_Lambda([this]()
+			{
+				FMessageDialog Dialog;
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro configuration from save ?")) == EAppReturnType::Yes)
 				{
 					if(Engine.IsValid())
 					{
-						return Engine->GetState() == Stopped;
+						Engine->ReloadConfig();
+						return FReply::Handled();
 					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
-				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetShortRestingTimespan();
-						Engine->SetShortRestingTimespan(NewValue, Timespan.GetMinutes(), Timespan.GetSeconds());
-					}
-				})
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(5,3,5,3))
-				.Text(FText::FromString(TEXT(" : ")))
-			]
+					return FReply::Unhandled();
+				}
+				return FReply::Handled();
+			})
+			.Text(LOCTEXT("ReloadConfigButton", "Reload Configuration"))
+		]
 		
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("ResetConfigButton", "Reset Configuration"))
+			.OnClicked_Lambda([this]()
+			{
+				FMessageDialog Dialog;
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro configuration ?")) == EAppReturnType::Yes)
 				{
 					if(Engine.IsValid())
 					{
-						return Engine->GetShortRestingTimespan().GetMinutes();
+						Engine->ResetConfig();
+						return FReply::Handled();
 					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+					return FReply::Unhandled();
+				}
+				return FReply::Handled();
+			})
+		]
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("SaveConfigButton", "Save Configuration"))
+			.OnClicked_Lambda([this]()
+			{
+				if(Engine.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					Engine->SaveConfig();
+					return FReply::Handled();
+				}
+				return FReply::Unhandled();
+			})
+		]
+	];
+}
+
+TSharedRef<SWidget> FPomodoroPluginModule::SpawnDraftRow(const FText& Label, const int32 FieldCount, const int32 FirstMaxValue,
+	TFunction<void(int32*)> ReadValues, TFunction<void(const int32*)> CommitValues) const
+{
+	// Values being edited, the engine keeps its own until the edit is committed
+	struct FDraft
+	{
+		bool bEditing = false;
+		int32 Values[3] = {0, 0, 0};
+		TArray<TWeakPtr<SWidget>, TInlineAllocator<3>> Fields;
+
+		// A drag that lost its capture without a commit is forgotten
+		bool IsAbandoned() const
+		{
+			for(const TWeakPtr<SWidget>& Field : Fields)
+			{
+				const TSharedPtr<SWidget> Widget = Field.Pin();
+				if(Widget.IsValid() && (Widget->HasMouseCapture() || Widget->HasKeyboardFocus() || Widget->HasFocusedDescendants()))
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetShortRestingTimespan();
-						Engine->SetShortRestingTimespan(Timespan.GetHours(), NewValue, Timespan.GetSeconds());
-					}
-				})
-			]
-	
-			+ SHorizontalBox::Slot()
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	const TSharedRef<FDraft> Draft = MakeShared<FDraft>();
+	const TSharedRef<TFunction<void(int32*)>> Read = MakeShared<TFunction<void(int32*)>>(MoveTemp(ReadValues));
+	const TSharedRef<TFunction<void(const int32*)>> Commit = MakeShared<TFunction<void(const int32*)>>(MoveTemp(CommitValues));
+
+	TSharedRef<SHorizontalBox> Row = SNew(SHorizontalBox)
+
+	+ SHorizontalBox::Slot()
+	.HAlign(HAlign_Left)
+	.FillWidth(1)
+	[
+		SNew(STextBlock)
+		.Margin(FMargin(0,3,10,3))
+		.Text(Label)
+	];
+
+	for(int32 Field = 0; Field < FieldCount; ++Field)
+	{
+		if(Field > 0)
+		{
+			Row->AddSlot()
 			.HAlign(HAlign_Right)
 			.AutoWidth()
 			[
 				SNew(STextBlock)
 				.Margin(FMargin(5,3,5,3))
 				.Text(FText::FromString(TEXT(" : ")))
-			]
-		
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
+			];
+		}
+
+		TSharedPtr<SSpinBox<int32>> SpinBox;
+		Row->AddSlot()
+		.HAlign(HAlign_Right)
+		.AutoWidth()
+		[
+			SAssignNew(SpinBox, SSpinBox<int32>)
+			.Value_Lambda([this, Draft, Read, Field]()
+			{
+				if(Draft->bEditing && Draft->IsAbandoned())
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetShortRestingTimespan().GetSeconds();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+					Draft->bEditing = false;
+				}
+				if(Draft->bEditing)
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					return Draft->Values[Field];
+				}
+				int32 Values[3] = {0, 0, 0};
+				if(Engine.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetShortRestingTimespan();
-						Engine->SetShortRestingTimespan(Timespan.GetHours(), Timespan.GetMinutes(), NewValue);
-					}
-				})
-			]
+					(*Read)(Values);
+				}
+				return Values[Field];
+			})
+			.MinValue(Field == 0 && FieldCount == 1 ? 1 : 0)
+			.MaxValue(Field == 0 ? FirstMaxValue : 59)
+			.MinDesiredWidth(27)
+			.IsEnabled_Lambda([this]()
+			{
+				if(Engine.IsValid())
+				{
+					return Engine->GetState() == Stopped;
+				}
+				return false;
+			})
+			.OnValueChanged_Lambda([this, Draft, Read, Field](const int32 NewValue)
+			{
+				// Dragging only touches the draft
+				if(!Draft->bEditing && Engine.IsValid())
+				{
+					(*Read)(Draft->Values);
+					Draft->bEditing = true;
+				}
+				Draft->Values[Field] = NewValue;
+			})
+			.OnValueCommitted_Lambda([this, Draft, Read, Commit, Field](const int32 NewValue, const ETextCommit::Type CommitType)
+			{
+				// Escape cancels the edit, the engine values are shown again, leaving the field commits it
+				if(!Engine.IsValid() || CommitType == ETextCommit::OnCleared)
+				{
+					Draft->bEditing = false;
+					return;
+				}
+				if(!Draft->bEditing)
+				{
+					(*Read)(Draft->Values);
+				}
+				Draft->Values[Field] = NewValue;
+				Draft->bEditing = false;
+				(*Commit)(Draft->Values);
+			})
+		];
+		Draft->Fields.Add(SpinBox);
+	}
+
+	return Row;
+}
+
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnAdaptiveDurations() const
+{
+	return SNew(SVerticalBox)
+
+	// Learn from the completed timespans
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		[
+			SNew(STextBlock)
+			.Text(LOCTEXT("AdaptiveSuggestLabel","Suggest timespans from my sessions"))
+		]
+		+SHorizontalBox::Slot()
+		[
+			SNew(SCheckBox)
+			.IsChecked_Lambda([this]()
+			{
+				return AdaptiveDurations->GetMode() != EPomodoroAdaptiveMode::Off ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+			})
+			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			{
+				AdaptiveDurations->SetMode(Value == ECheckBoxState::Checked ? EPomodoroAdaptiveMode::Suggest : EPomodoroAdaptiveMode::Off);
+			})
 		]
+	]
 
-		// Long Resting Timespan Length
-		+SVerticalBox::Slot()
-		.AutoHeight()
-		.Padding(0,5)
+	// Apply the suggestion at each cycle boundary
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
 		[
-			SNew(SHorizontalBox)
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Left)
-			.FillWidth(1)
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(0,3,10,3))
-				.Text(LOCTEXT("LongRestingTimeSpanLength","Long Resting Timespan Length"))
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
-				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetLongRestingTimespan().GetHours();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(23)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+			SNew(STextBlock)
+			.Text(LOCTEXT("AdaptiveApplyLabel","Apply them at each cycle end"))
+		]
+		+SHorizontalBox::Slot()
+		[
+			SNew(SCheckBox)
+			.IsEnabled_Lambda([this]()
+			{
+				return AdaptiveDurations->GetMode() != EPomodoroAdaptiveMode::Off;
+			})
+			.IsChecked_Lambda([this]()
+			{
+				return AdaptiveDurations->GetMode() == EPomodoroAdaptiveMode::Apply ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+			})
+			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			{
+				AdaptiveDurations->SetMode(Value == ECheckBoxState::Checked ? EPomodoroAdaptiveMode::Apply : EPomodoroAdaptiveMode::Suggest);
+			})
+		]
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Left)
+	.Padding(0,5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this]()
+		{
+			return AdaptiveDurations->GetSummaryText();
+		})
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	[
+		SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("ApplySuggestionButton", "Apply Suggestion"))
+			.IsEnabled_Lambda([this]()
+			{
+				FTimespan Working, ShortResting, LongResting;
+				return AdaptiveDurations->GetSuggestion(Working, ShortResting, LongResting);
+			})
+			.OnClicked_Lambda([this]()
+			{
+				if(AdaptiveDurations.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					AdaptiveDurations->ApplySuggestion();
+					return FReply::Handled();
+				}
+				return FReply::Unhandled();
+			})
+		]
+		
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("ResetStatisticsButton", "Reset Statistics"))
+			.OnClicked_Lambda([this]()
+			{
+				FMessageDialog Dialog;
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetStatisticsMessage", "Do you want to forget what was learned from your sessions ?")) == EAppReturnType::Yes)
 				{
-					if(Engine.IsValid())
+					if(AdaptiveDurations.IsValid())
 					{
-						const FTimespan Timespan = Engine->GetLongRestingTimespan();
-						Engine->SetLongRestingTimespan(NewValue, Timespan.GetMinutes(), Timespan.GetSeconds());
+						AdaptiveDurations->ResetStatistics();
+						return FReply::Handled();
 					}
-				})
-			]
+					return FReply::Unhandled();
+				}
+				return FReply::Handled();
+			})
+		]
 
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(5,3,5,3))
-				.Text(FText::FromString(TEXT(" : ")))
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
-				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetLongRestingTimespan().GetMinutes();
-					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("SaveConfigButton", "Save Configuration"))
+			.OnClicked_Lambda([this]()
+			{
+				if(AdaptiveDurations.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						return Engine->GetState() == Stopped;
-					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					AdaptiveDurations->SaveConfig();
+					return FReply::Handled();
+				}
+				return FReply::Unhandled();
+			})
+		]
+	];
+}
+
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
+{
+	return SNew(SVerticalBox)
+
+	// Cycle Length parameter
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		[
+			SNew(STextBlock)
+			.Text(LOCTEXT("ActivateSoundLabel","Activate notification sound"))
+		]
+		+SHorizontalBox::Slot()
+		[
+			SNew(SCheckBox)
+			.IsChecked_Lambda([this]()
+			{
+				return Notifier->GetNotificationSoundState();
+			})
+			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			{
+				Notifier->SetNotificationSoundState(Value);
+			})
+		]
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		[
+			SNew(STextBlock)
+			.Text(LOCTEXT("CountdownTenthsLabel","Show tenths of a second in the toolbar countdown"))
+		]
+		+SHorizontalBox::Slot()
+		[
+			SNew(SCheckBox)
+			.IsChecked(NewObject<UPomodoroConfig>()->LoadCountdownConfig().Get<0>())
+			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			{
+				NewObject<UPomodoroConfig>()->SaveCountdownConfig(Value);
+				if(Countdown.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetLongRestingTimespan();
-						Engine->SetLongRestingTimespan(Timespan.GetHours(), NewValue, Timespan.GetSeconds());
-					}
-				})
-			]
+					Countdown->SetShowTenths(Value == ECheckBoxState::Checked);
+				}
+			})
+		]
+	]
 
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(STextBlock)
-				.Margin(FMargin(5,3,5,3))
-				.Text(FText::FromString(TEXT(" : ")))
-			]
-	
-			+ SHorizontalBox::Slot()
-			.HAlign(HAlign_Right)
-			.AutoWidth()
-			[
-				SNew(SSpinBox<int32>)
-				.Value_Lambda([this]()
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	[
+		SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.OnClicked_Lambda([this]()
+			{
+				FMessageDialog Dialog;
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro notifier configuration from save ?")) == EAppReturnType::Yes)
 				{
-					if(Engine.IsValid())
+					if(Notifier.IsValid())
 					{
-						return Engine->GetLongRestingTimespan().GetSeconds();
+						Notifier->ReloadConfig();
+						return FReply::Handled();
 					}
-					return 0;
-				})
-				.MinValue(0)
-				.MaxValue(59)
-				.MinDesiredWidth(27)
-				.IsEnabled_Lambda([this]()
+					return FReply::Unhandled();
+				}
+				return FReply::Handled();
+			})
+			.Text(LOCTEXT("ReloadConfigButton", "Reload Configuration"))
+		]
+		
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("ResetConfigButton", "Reset Configuration"))
+			.OnClicked_Lambda([this]()
+			{
+				FMessageDialog Dialog;
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro notifier configuration ?")) == EAppReturnType::Yes)
 				{
-					if(Engine.IsValid())
+					if(Notifier.IsValid())
 					{
-						return Engine->GetState() == Stopped;
+						Notifier->ResetConfig();
+						return FReply::Handled();
 					}
-					return false;
-				})
-				.OnValueChanged_Lambda([this](const int32 NewValue)
+					return FReply::Unhandled();
+				}
+				return FReply::Handled();
+			})
+		]
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("SaveConfigButton", "Save Configuration"))
+			.OnClicked_Lambda([this]()
+			{
+				if(Notifier.IsValid())
 				{
-					if(Engine.IsValid())
-					{
-						const FTimespan Timespan = Engine->GetLongRestingTimespan();
-						Engine->SetLongRestingTimespan(Timespan.GetHours(), Timespan.GetMinutes(), NewValue);	
-					}
-				})
-			]
-			
+					Notifier->SaveConfig();
+					return FReply::Handled();
+				}
+				return FReply::Unhandled();
+			})
 		]
+	];
+}
 
-	+SVerticalBox::Slot()
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnSyncConfig() const
+{
+	return SNew(SVerticalBox)
+
+	// Activation of the team sync
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		[
+			SNew(STextBlock)
+			.Text(LOCTEXT("ActivateSyncLabel","Share the timer with a team"))
+		]
+		+SHorizontalBox::Slot()
+		[
+			SNew(SCheckBox)
+			.IsChecked_Lambda([this]()
+			{
+				return SyncClient->GetSyncState();
+			})
+			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			{
+				SyncClient->SetSyncState(Value);
+			})
+		]
+	]
+
+	// Relay address
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(STextBlock)
+			.Margin(FMargin(0,3,10,3))
+			.Text(LOCTEXT("RelayAddressLabel","Relay address"))
+		]
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(SEditableTextBox)
+			.Text_Lambda([this]()
+			{
+				return FText::FromString(SyncClient->GetRelayAddress());
+			})
+			.OnTextCommitted_Lambda([this](const FText& Value, ETextCommit::Type)
+			{
+				SyncClient->SetRelayAddress(Value.ToString());
+			})
+		]
+	]
+
+	// Group name
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(STextBlock)
+			.Margin(FMargin(0,3,10,3))
+			.Text(LOCTEXT("GroupNameLabel","Group name"))
+		]
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(SEditableTextBox)
+			.Text_Lambda([this]()
+			{
+				return FText::FromString(SyncClient->GetGroupName());
+			})
+			.OnTextCommitted_Lambda([this](const FText& Value, ETextCommit::Type)
+			{
+				SyncClient->SetGroupName(Value.ToString());
+			})
+		]
+	]
+
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Center)
+	.Padding(0,5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this]()
+		{
+			if(SyncClient->IsConnected())
+			{
+				return LOCTEXT("SyncConnected", "Connected to the relay");
+			}
+			return LOCTEXT("SyncDisconnected", "Not connected");
+		})
+	]
+
+	+ SVerticalBox::Slot()
 	.AutoHeight()
 	[
 		SNew(SHorizontalBox)
@@ -796,11 +1685,12 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
 			.OnClicked_Lambda([this]()
 			{
 				FMessageDialog Dialog;
-				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro configuration from save ?")) == EAppReturnType::Yes)
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro team sync configuration from save ?")) == EAppReturnType::Yes)
 				{
-					if(Engine.IsValid())
+					if(SyncClient.IsValid())
 					{
-						Engine->ReloadConfig();
+						SyncClient->ReloadConfig();
+						SyncClient->Restart();
 						return FReply::Handled();
 					}
 					return FReply::Unhandled();
@@ -818,11 +1708,11 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
 			.OnClicked_Lambda([this]()
 			{
 				FMessageDialog Dialog;
-				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro configuration ?")) == EAppReturnType::Yes)
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro team sync configuration ?")) == EAppReturnType::Yes)
 				{
-					if(Engine.IsValid())
+					if(SyncClient.IsValid())
 					{
-						Engine->ResetConfig();
+						SyncClient->ResetConfig();
 						return FReply::Handled();
 					}
 					return FReply::Unhandled();
@@ -838,9 +1728,11 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
 			.Text(LOCTEXT("SaveConfigButton", "Save Configuration"))
 			.OnClicked_Lambda([this]()
 			{
-				if(Engine.IsValid())
+				// The connection only follows the saved configuration
+				if(SyncClient.IsValid())
 				{
-					Engine->SaveConfig();
+					SyncClient->SaveConfig();
+					SyncClient->Restart();
 					return FReply::Handled();
 				}
 				return FReply::Unhandled();
@@ -849,11 +1741,11 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnTimerConfig() const
 	];
 }
 
-TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
+TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnDayPlanner() const
 {
 	return SNew(SVerticalBox)
 
-	// Cycle Length parameter
+	// Working hours
 	+ SVerticalBox::Slot()
 	.AutoHeight()
 	.HAlign(HAlign_Fill)
@@ -861,24 +1753,79 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
 	[
 		SNew(SHorizontalBox)
 		+SHorizontalBox::Slot()
+		.FillWidth(1)
 		[
 			SNew(STextBlock)
-			.Text(LOCTEXT("ActivateSoundLabel","Activate notification sound"))
+			.Margin(FMargin(0,3,10,3))
+			.Text(LOCTEXT("WorkingHoursLabel","Working hours"))
 		]
 		+SHorizontalBox::Slot()
+		.FillWidth(1)
 		[
-			SNew(SCheckBox)
-			.IsChecked_Lambda([this]()
+			SNew(SEditableTextBox)
+			.Text_Lambda([this]()
 			{
-				return Notifier->GetNotificationSoundState();
+				return FText::FromString(FPomodoroDayPlanner::FormatTimeRanges({Planner->GetWorkingHours()}));
 			})
-			.OnCheckStateChanged_Lambda([this](const ECheckBoxState Value)
+			.OnTextCommitted_Lambda([this](const FText& Value, ETextCommit::Type)
 			{
-				Notifier->SetNotificationSoundState(Value);
+				TArray<FPomodoroTimeRange> Ranges;
+				if(FPomodoroDayPlanner::ParseTimeRanges(Value.ToString(), Ranges) && Ranges.Num() == 1)
+				{
+					Planner->SetWorkingHours(Ranges[0]);
+					ReplanDay();
+				}
+			})
+		]
+	]
+
+	// Fixed commitments
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Fill)
+	.Padding(0,5)
+	[
+		SNew(SHorizontalBox)
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(STextBlock)
+			.Margin(FMargin(0,3,10,3))
+			.Text(LOCTEXT("CommitmentsLabel","Commitments"))
+		]
+		+SHorizontalBox::Slot()
+		.FillWidth(1)
+		[
+			SNew(SEditableTextBox)
+			.HintText(LOCTEXT("CommitmentsHint", "10:00-10:30, 14:00-15:00"))
+			.Text_Lambda([this]()
+			{
+				return FText::FromString(FPomodoroDayPlanner::FormatTimeRanges(Planner->GetCommitments()));
+			})
+			.OnTextCommitted_Lambda([this](const FText& Value, ETextCommit::Type)
+			{
+				TArray<FPomodoroTimeRange> Ranges;
+				if(FPomodoroDayPlanner::ParseTimeRanges(Value.ToString(), Ranges))
+				{
+					Planner->SetCommitments(Ranges);
+					ReplanDay();
+				}
 			})
 		]
 	]
 
+	+ SVerticalBox::Slot()
+	.AutoHeight()
+	.HAlign(HAlign_Left)
+	.Padding(0,5)
+	[
+		SNew(STextBlock)
+		.Text_Lambda([this]()
+		{
+			return Planner->GetPlanText();
+		})
+	]
+
 	+ SVerticalBox::Slot()
 	.AutoHeight()
 	[
@@ -891,11 +1838,12 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
 			.OnClicked_Lambda([this]()
 			{
 				FMessageDialog Dialog;
-				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro notifier configuration from save ?")) == EAppReturnType::Yes)
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ReloadConfigMessage", "Do you want to reload the pomodoro day planner configuration from save ?")) == EAppReturnType::Yes)
 				{
-					if(Notifier.IsValid())
+					if(Planner.IsValid())
 					{
-						Notifier->ReloadConfig();
+						Planner->ReloadConfig();
+						ReplanDay();
 						return FReply::Handled();
 					}
 					return FReply::Unhandled();
@@ -913,11 +1861,12 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
 			.OnClicked_Lambda([this]()
 			{
 				FMessageDialog Dialog;
-				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro notifier configuration ?")) == EAppReturnType::Yes)
+				if(Dialog.Open(EAppMsgType::YesNo, LOCTEXT("ResetConfigMessage", "Do you want to reset the pomodoro day planner configuration ?")) == EAppReturnType::Yes)
 				{
-					if(Notifier.IsValid())
+					if(Planner.IsValid())
 					{
-						Notifier->ResetConfig();
+						Planner->ResetConfig();
+						ReplanDay();
 						return FReply::Handled();
 					}
 					return FReply::Unhandled();
@@ -933,9 +1882,9 @@ TSharedRef<SBoxPanel> FPomodoroPluginModule::SpawnNotificationConfig() const
 			.Text(LOCTEXT("SaveConfigButton", "Save Configuration"))
 			.OnClicked_Lambda([this]()
 			{
-				if(Notifier.IsValid())
+				if(Planner.IsValid())
 				{
-					Notifier->SaveConfig();
+					Planner->SaveConfig();
 					return FReply::Handled();
 				}
 				return FReply::Unhandled();
@@ -950,6 +1899,127 @@ void FPomodoroPluginModule::PluginButtonClicked()
 	FGlobalTabmanager::Get()->TryInvokeTab(PomodoroPluginTabName);
 }
 
+void FPomodoroPluginModule::StartLeaderServices()
+{
+	// The page is mapped first, following editors read it as soon as they can connect
+	StatusPage = MakeUnique<FPomodoroStatusPage>();
+	if(StatusPage->Open(FPomodoroStatusPage::GetDefaultPagePath()))
+	{
+		StatusPage->Write(Engine->GetSnapshotChannel()->Read());
+	}
+
+#if WITH_POMODORO_IPC
+	IpcServer = MakeUnique<FPomodoroIpcServer>(Engine->GetSnapshotChannel(),
+		FPomodoroIpcCommandHandler::CreateRaw(this, &FPomodoroPluginModule::HandleIpcCommand));
+	if(IpcServer->Listen(FPomodoroIpcServer::GetDefaultSocketPath()))
+	{
+		Engine->OnSnapshotPublished().AddRaw(IpcServer.Get(), &FPomodoroIpcServer::NotifySnapshotChanged);
+	}
+	else
+	{
+		IpcServer.Reset();
+	}
+#endif
+
+	// A negative port disables the HTTP endpoint, zero picks the default one
+	const int32 HttpPort = NewObject<UPomodoroConfig>()->LoadHttpConfig().Get<0>();
+	if(HttpPort >= 0)
+	{
+		HttpServer = MakeUnique<FPomodoroHttpServer>(Engine->GetSnapshotChannel(),
+			FPomodoroHttpCommandHandler::CreateRaw(this, &FPomodoroPluginModule::HandleHttpCommand));
+		if(HttpServer->Listen(HttpPort > 0 ? HttpPort : FPomodoroHttpServer::DefaultPort))
+		{
+			Engine->OnSnapshotPublished().AddRaw(HttpServer.Get(), &FPomodoroHttpServer::NotifySnapshotChanged);
+		}
+		else
+		{
+			HttpServer.Reset();
+		}
+	}
+
+	SyncClient->Restart();
+}
+
+TFuture<bool> FPomodoroPluginModule::HandleIpcCommand(const uint8 Opcode)
+{
+	FPomodoroEngineCommand EngineCommand;
+	switch (Opcode)
+	{
+	case POMODORO_IPC_OP_START:
+		EngineCommand.Kind = EPomodoroEngineCommand::Start;
+		break;
+
+	case POMODORO_IPC_OP_PAUSE:
+		EngineCommand.Kind = EPomodoroEngineCommand::Pause;
+		break;
+
+	case POMODORO_IPC_OP_STOP:
+		EngineCommand.Kind = EPomodoroEngineCommand::Stop;
+		break;
+
+	default:
+		return MakeFulfilledPromise<bool>(false).GetFuture();
+	}
+
+	// Run at the next tick of the game thread, the server answers once it ran and keeps serving meanwhile
+	EngineCommand.ExpireSeconds = FPlatformTime::Seconds() + RemoteCommandTimeoutSeconds;
+	return Engine->Post(EngineCommand);
+}
+
+TFuture<bool> FPomodoroPluginModule::HandleHttpCommand(const FPomodoroHttpCommand& Command)
+{
+	FPomodoroEngineCommand EngineCommand;
+	switch (Command.Kind)
+	{
+	case EPomodoroHttpCommand::Start:
+		EngineCommand.Kind = EPomodoroEngineCommand::Start;
+		break;
+
+	case EPomodoroHttpCommand::Pause:
+		EngineCommand.Kind = EPomodoroEngineCommand::Pause;
+		break;
+
+	case EPomodoroHttpCommand::Stop:
+		EngineCommand.Kind = EPomodoroEngineCommand::Stop;
+		break;
+
+	case EPomodoroHttpCommand::Configure:
+		EngineCommand.Kind = EPomodoroEngineCommand::Configure;
+		EngineCommand.CycleCount = Command.CycleCount;
+		EngineCommand.WorkingTimespan = Command.WorkingTimespan;
+		EngineCommand.ShortRestingTimespan = Command.ShortRestingTimespan;
+		EngineCommand.LongRestingTimespan = Command.LongRestingTimespan;
+		break;
+
+	default:
+		return MakeFulfilledPromise<bool>(false).GetFuture();
+	}
+
+	// Run at the next tick of the game thread, the server answers once it ran and keeps serving meanwhile
+	EngineCommand.ExpireSeconds = FPlatformTime::Seconds() + RemoteCommandTimeoutSeconds;
+	return Engine->Post(EngineCommand);
+}
+
+void FPomodoroPluginModule::OnEngineSnapshotPublished() const
+{
+	// Only written on transitions, readers compute the countdown from the deadline
+	if(StatusPage.IsValid() && StatusPage->IsOpen())
+	{
+		StatusPage->Write(Engine->GetSnapshotChannel()->Read());
+	}
+
+	// Any change of the timer, an interruption included, moves the rest of the day
+	ReplanDay();
+}
+
+void FPomodoroPluginModule::ReplanDay() const
+{
+	if(Planner.IsValid())
+	{
+		Planner->Replan(Engine->GetSnapshotChannel()->Read(), FDateTime::Now());
+	}
+}
+
 void FPomodoroPluginModule::RegisterMenus()
 {
 	// Owner will be used for cleanup in call to UToolMenus::UnregisterOwner
@@ -969,6 +2039,32 @@ void FPomodoroPluginModule::RegisterMenus()
 	}
 }
 
+void FPomodoroPluginModule::RegisterCountdown()
+{
+	// Owner will be used for cleanup in call to UToolMenus::UnregisterOwner
+	FToolMenuOwnerScoped OwnerScoped(this);
+
+	UToolMenu* ToolbarMenu = UToolMenus::Get()->ExtendMenu("LevelEditor.LevelEditorToolBar");
+	FToolMenuSection& Section = ToolbarMenu->FindOrAddSection("Settings");
+
+	// Cached by the invalidation panel, only repainted when the displayed second changes
+	Section.AddEntry(FToolMenuEntry::InitWidget("PomodoroCountdown",
+		SNew(SInvalidationPanel)
+		[
+			SNew(SBox)
+			.VAlign(VAlign_Center)
+			.Padding(FMargin(4, 0))
+			.ToolTipText(LOCTEXT("CountdownToolTip", "Remaining time of the current timespan"))
+			[
+				SAssignNew(Countdown, SPomodoroCountdown, Engine.ToSharedRef())
+				.ShowTenths(NewObject<UPomodoroConfig>()->LoadCountdownConfig().Get<0>() == ECheckBoxState::Checked)
+			]
+		],
+		FText::GetEmpty(), true));
+
+	UToolMenus::Get()->RefreshAllWidgets();
+}
+
 #undef LOCTEXT_NAMESPACE
 	
 IMPLEMENT_MODULE(FPomodoroPluginModule, PomodoroPlugin)
\ No newline at end of file
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroReplayCommandlet.h"
+
+#include "PomodoroPlugin.h"
+#include "PomodoroSessionLog.h"
+#include "HAL/FileManager.h"
+
+UPomodoroReplayCommandlet::UPomodoroReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPomodoroReplayCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Paths;
+	FString LogPath;
+	if(FParse::Value(*Params, TEXT("Log="), LogPath))
+	{
+		Paths.Add(LogPath);
+	}
+	else
+	{
+		const FString Directory = FPomodoroSessionLog::GetSessionDirectory();
+		IFileManager::Get().FindFiles(Paths, *FPaths::Combine(Directory, TEXT("*.bin")), true, false);
+		for(FString& Path : Paths)
+		{
+			Path = FPaths::Combine(Directory, Path);
+		}
+		Paths.Sort();
+	}
+
+	if(Paths.Num() == 0)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("No session log to replay"));
+		return 0;
+	}
+
+	int32 Failures = 0;
+	for(const FString& Path : Paths)
+	{
+		const FPomodoroReplayResult Result = FPomodoroSessionReplay::ReplayFile(Path);
+		if(!Result.Error.IsEmpty())
+		{
+			UE_LOG(LogPomodoro, Error, TEXT("%s : %s"), *Path, *Result.Error);
+			++Failures;
+			continue;
+		}
+
+		UE_LOG(LogPomodoro, Display, TEXT("%s : %d inputs, %d timespan ends, replayed in %.2f ms"),
+			*Path, Result.InputCount, Result.ReplayedElapsed.Num(), Result.ReplaySeconds * 1000.0);
+		if(Result.IsReproduced())
+		{
+			UE_LOG(LogPomodoro, Display, TEXT("%s : reproduced"), *Path);
+		}
+		else
+		{
+			UE_LOG(LogPomodoro, Error, TEXT("%s : diverged at input %d (%d of %d recorded timespan ends reproduced)"),
+				*Path, Result.DivergedInput, Result.ReplayedElapsed.Num(), Result.RecordedElapsed.Num());
+			++Failures;
+		}
+	}
+	return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSockets.h"
+
+#if PLATFORM_WINDOWS
+	#include "SocketSubsystem.h"
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <arpa/inet.h>
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+#endif
+
+namespace PomodoroSockets
+{
+#if PLATFORM_WINDOWS
+	using FPollDescriptor = WSAPOLLFD;
+	using FAddressLength = int;
+	constexpr int32 SendFlags = 0;
+
+	static int32 GetSocketError()
+	{
+		return WSAGetLastError();
+	}
+
+	static bool IsWouldBlock(const int32 Error)
+	{
+		return Error == WSAEWOULDBLOCK;
+	}
+
+	static bool IsInterrupted(const int32 Error)
+	{
+		return Error == WSAEINTR;
+	}
+
+	static bool SetNonBlocking(const FHandle Handle)
+	{
+		u_long NonBlocking = 1;
+		return ioctlsocket(Handle, FIONBIO, &NonBlocking) == 0;
+	}
+
+	static void CloseNative(const FHandle Handle)
+	{
+		closesocket(Handle);
+	}
+
+	static int32 PollNative(FPollDescriptor* Descriptors, const int32 Count, const int32 TimeoutMilliseconds)
+	{
+		return WSAPoll(Descriptors, Count, TimeoutMilliseconds);
+	}
+
+	static void InitializePlatform()
+	{
+		// Winsock is started by the platform socket subsystem
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	}
+#else
+	using FPollDescriptor = pollfd;
+	using FAddressLength = socklen_t;
+#if PLATFORM_MAC
+	constexpr int32 SendFlags = 0;
+#else
+	constexpr int32 SendFlags = MSG_NOSIGNAL;
+#endif
+
+	static int32 GetSocketError()
+	{
+		return errno;
+	}
+
+	static bool IsWouldBlock(const int32 Error)
+	{
+		return Error == EAGAIN || Error == EWOULDBLOCK;
+	}
+
+	static bool IsInterrupted(const int32 Error)
+	{
+		return Error == EINTR;
+	}
+
+	static bool SetNonBlocking(const FHandle Handle)
+	{
+		const int32 Flags = fcntl(Handle, F_GETFL, 0);
+		return Flags != -1 && fcntl(Handle, F_SETFL, Flags | O_NONBLOCK) != -1;
+	}
+
+	static void CloseNative(const FHandle Handle)
+	{
+		close(Handle);
+	}
+
+	static int32 PollNative(FPollDescriptor* Descriptors, const int32 Count, const int32 TimeoutMilliseconds)
+	{
+		return poll(Descriptors, Count, TimeoutMilliseconds);
+	}
+
+	static void InitializePlatform()
+	{
+	}
+#endif
+
+	static sockaddr_in MakeAddress(const bool bLoopbackOnly, const int32 Port)
+	{
+		sockaddr_in Address;
+		FMemory::Memzero(Address);
+		Address.sin_family = AF_INET;
+		Address.sin_port = htons(static_cast<uint16>(Port));
+		Address.sin_addr.s_addr = htonl(bLoopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+		return Address;
+	}
+
+	FHandle Listen(const int32 Port, const bool bLoopbackOnly, const bool bReusable, const int32 Backlog)
+	{
+		InitializePlatform();
+
+		const FHandle Handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if(Handle == InvalidHandle)
+		{
+			return InvalidHandle;
+		}
+
+		if(bReusable)
+		{
+			const int32 Reuse = 1;
+			setsockopt(Handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&Reuse), sizeof(Reuse));
+		}
+
+		const sockaddr_in Address = MakeAddress(bLoopbackOnly, Port);
+		if(bind(Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0
+			|| listen(Handle, Backlog) != 0 || !SetNonBlocking(Handle))
+		{
+			CloseNative(Handle);
+			return InvalidHandle;
+		}
+		return Handle;
+	}
+
+	FHandle Accept(const FHandle ListenHandle)
+	{
+		for(;;)
+		{
+			const FHandle Handle = accept(ListenHandle, nullptr, nullptr);
+			if(Handle == InvalidHandle)
+			{
+				return InvalidHandle;
+			}
+
+			if(!SetNonBlocking(Handle))
+			{
+				CloseNative(Handle);
+				continue;
+			}
+
+			const int32 NoDelay = 1;
+			setsockopt(Handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&NoDelay), sizeof(NoDelay));
+#if PLATFORM_MAC
+			const int32 NoSigPipe = 1;
+			setsockopt(Handle, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof(NoSigPipe));
+#endif
+			return Handle;
+		}
+	}
+
+	int32 Recv(const FHandle Handle, uint8* Data, const int32 Size)
+	{
+		for(;;)
+		{
+			const int32 Received = static_cast<int32>(recv(Handle, reinterpret_cast<char*>(Data), Size, 0));
+			if(Received > 0)
+			{
+				return Received;
+			}
+			if(Received == 0)
+			{
+				// Closed by the peer
+				return -1;
+			}
+
+			const int32 Error = GetSocketError();
+			if(!IsInterrupted(Error))
+			{
+				return IsWouldBlock(Error) ? 0 : -1;
+			}
+		}
+	}
+
+	int32 Send(const FHandle Handle, const uint8* Data, const int32 Size)
+	{
+		for(;;)
+		{
+			const int32 Sent = static_cast<int32>(send(Handle, reinterpret_cast<const char*>(Data), Size, SendFlags));
+			if(Sent >= 0)
+			{
+				return Sent;
+			}
+
+			const int32 Error = GetSocketError();
+			if(!IsInterrupted(Error))
+			{
+				return IsWouldBlock(Error) ? 0 : -1;
+			}
+		}
+	}
+
+	void Close(FHandle& Handle)
+	{
+		if(Handle != InvalidHandle)
+		{
+			CloseNative(Handle);
+			Handle = InvalidHandle;
+		}
+	}
+
+	bool Poll(TArray<FPollEntry>& Entries, const int32 TimeoutMilliseconds)
+	{
+		// Reused from one poll to the next, every server polls from its own thread
+		static thread_local TArray<FPollDescriptor> Descriptors;
+		Descriptors.Reset();
+		for(const FPollEntry& Entry : Entries)
+		{
+			FPollDescriptor& Descriptor = Descriptors.AddZeroed_GetRef();
+			Descriptor.fd = Entry.Handle;
+			Descriptor.events = static_cast<short>(Entry.bWrite ? POLLIN | POLLOUT : POLLIN);
+		}
+
+		const int32 Result = PollNative(Descriptors.GetData(), Descriptors.Num(), TimeoutMilliseconds < 0 ? -1 : TimeoutMilliseconds);
+		for(int32 Index = 0; Index < Entries.Num(); ++Index)
+		{
+			// Closed and failed sockets are ready too, reading them tells what happened
+			Entries[Index].bReady = Result > 0 && Descriptors[Index].revents != 0;
+		}
+		return Result >= 0 || IsInterrupted(GetSocketError());
+	}
+
+	FHandle OpenWakeSocket()
+	{
+		InitializePlatform();
+
+		const FHandle Handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if(Handle == InvalidHandle)
+		{
+			return InvalidHandle;
+		}
+
+		// Bound to a free loopback port, then connected to it so it only receives its own datagrams
+		sockaddr_in Address = MakeAddress(true, 0);
+		FAddressLength AddressLength = sizeof(Address);
+		if(bind(Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0
+			|| getsockname(Handle, reinterpret_cast<sockaddr*>(&Address), &AddressLength) != 0
+			|| connect(Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0
+			|| !SetNonBlocking(Handle))
+		{
+			CloseNative(Handle);
+			return InvalidHandle;
+		}
+		return Handle;
+	}
+
+	void Wake(const FHandle WakeHandle)
+	{
+		// A full socket is readable already, the datagram can be lost
+		const char Byte = 0;
+		send(WakeHandle, &Byte, 1, 0);
+	}
+
+	void DrainWake(const FHandle WakeHandle)
+	{
+		char Buffer[64];
+		while(recv(WakeHandle, Buffer, sizeof(Buffer), 0) > 0)
+		{
+		}
+	}
+}
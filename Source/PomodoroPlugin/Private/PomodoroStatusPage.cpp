@@ -0,0 +1,255 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroStatusPage.h"
+
+#include "PomodoroPlugin.h"
+#include "PomodoroPaths.h"
+#include "PomodoroStatusPageLayout.h"
+
+#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <windows.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <sys/file.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+FPomodoroStatusPage::FPomodoroStatusPage()
+	: Page(nullptr)
+	, bWritable(false)
+#if PLATFORM_WINDOWS
+	, FileHandle(nullptr)
+	, MappingHandle(nullptr)
+#else
+	, FileDescriptor(-1)
+#endif
+{
+}
+
+FPomodoroStatusPage::~FPomodoroStatusPage()
+{
+	Close();
+}
+
+bool FPomodoroStatusPage::Open(const FString& PagePath)
+{
+	Close();
+
+#if PLATFORM_WINDOWS
+	// Readers must open the file with FILE_SHARE_READ | FILE_SHARE_WRITE, a second writer is refused
+	HANDLE File = CreateFileW(*PagePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(File == INVALID_HANDLE_VALUE)
+	{
+		UE_LOG(LogPomodoro, Log, TEXT("Status page %s is not available (error %u)"), *PagePath, GetLastError());
+		return false;
+	}
+	FileHandle = File;
+
+	HANDLE Mapping = CreateFileMappingW(File, nullptr, PAGE_READWRITE, 0, POMODORO_STATUS_PAGE_FILE_SIZE, nullptr);
+	if(Mapping == nullptr)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't map status page %s (error %u)"), *PagePath, GetLastError());
+		Close();
+		return false;
+	}
+	MappingHandle = Mapping;
+
+	Page = static_cast<pomodoro_status_page*>(MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, POMODORO_STATUS_PAGE_FILE_SIZE));
+#else
+	FileDescriptor = open(TCHAR_TO_UTF8(*PagePath), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if(FileDescriptor == -1)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't open status page %s (errno %d)"), *PagePath, errno);
+		return false;
+	}
+
+	// Readers never lock the file, only a second writer is refused
+	if(flock(FileDescriptor, LOCK_EX | LOCK_NB) == -1)
+	{
+		UE_LOG(LogPomodoro, Log, TEXT("Status page %s is already written by another editor"), *PagePath);
+		Close();
+		return false;
+	}
+
+	if(ftruncate(FileDescriptor, POMODORO_STATUS_PAGE_FILE_SIZE) == -1)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't resize status page %s (errno %d)"), *PagePath, errno);
+		Close();
+		return false;
+	}
+
+	void* Mapped = mmap(nullptr, POMODORO_STATUS_PAGE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0);
+	Page = Mapped == MAP_FAILED ? nullptr : static_cast<pomodoro_status_page*>(Mapped);
+#endif
+
+	if(Page == nullptr)
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't map status page %s"), *PagePath);
+		Close();
+		return false;
+	}
+
+	// The sequence is kept as is, readers of a previous writer may still be copying.
+	// A writer that died in the middle of a write left it odd, round it up or readers spin forever.
+	const uint64 Sequence = POMODORO_STATUS_PAGE_LOAD(&Page->sequence);
+	if(Sequence & 1)
+	{
+		UE_LOG(LogPomodoro, Log, TEXT("Status page %s was left in the middle of a write, discarding it"), *PagePath);
+		POMODORO_STATUS_PAGE_STORE(&Page->sequence, Sequence + 1);
+	}
+
+	Page->writer_pid = FPlatformProcess::GetCurrentProcessId();
+	Page->layout = POMODORO_STATUS_PAGE_LAYOUT;
+	POMODORO_STATUS_PAGE_RELEASE();
+	Page->magic = POMODORO_STATUS_PAGE_MAGIC;
+
+	bWritable = true;
+	return true;
+}
+
+bool FPomodoroStatusPage::OpenForReading(const FString& PagePath)
+{
+	Close();
+
+#if PLATFORM_WINDOWS
+	HANDLE File = CreateFileW(*PagePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	FileHandle = File;
+
+	HANDLE Mapping = CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, POMODORO_STATUS_PAGE_FILE_SIZE, nullptr);
+	if(Mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	MappingHandle = Mapping;
+
+	Page = static_cast<pomodoro_status_page*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, POMODORO_STATUS_PAGE_FILE_SIZE));
+#else
+	FileDescriptor = open(TCHAR_TO_UTF8(*PagePath), O_RDONLY | O_CLOEXEC);
+	if(FileDescriptor == -1)
+	{
+		return false;
+	}
+
+	struct stat FileStatus;
+	if(fstat(FileDescriptor, &FileStatus) == -1 || FileStatus.st_size < POMODORO_STATUS_PAGE_FILE_SIZE)
+	{
+		Close();
+		return false;
+	}
+
+	void* Mapped = mmap(nullptr, POMODORO_STATUS_PAGE_FILE_SIZE, PROT_READ, MAP_SHARED, FileDescriptor, 0);
+	Page = Mapped == MAP_FAILED ? nullptr : static_cast<pomodoro_status_page*>(Mapped);
+#endif
+
+	if(Page == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FPomodoroStatusPage::Close()
+{
+#if PLATFORM_WINDOWS
+	if(Page != nullptr)
+	{
+		UnmapViewOfFile(Page);
+	}
+	if(MappingHandle != nullptr)
+	{
+		CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+	if(FileHandle != nullptr)
+	{
+		CloseHandle(FileHandle);
+		FileHandle = nullptr;
+	}
+#else
+	if(Page != nullptr)
+	{
+		munmap(Page, POMODORO_STATUS_PAGE_FILE_SIZE);
+	}
+	if(FileDescriptor != -1)
+	{
+		// Closing the descriptor also releases the lock
+		close(FileDescriptor);
+		FileDescriptor = -1;
+	}
+#endif
+	Page = nullptr;
+	bWritable = false;
+}
+
+bool FPomodoroStatusPage::IsOpen() const
+{
+	return Page != nullptr;
+}
+
+void FPomodoroStatusPage::Write(const FPomodoroEngineSnapshot& Snapshot)
+{
+	if(Page == nullptr || !bWritable)
+	{
+		return;
+	}
+
+	const FDateTime Now = FDateTime::UtcNow();
+
+	pomodoro_status Status;
+	FMemory::Memzero(Status);
+	Status.version = Snapshot.Version;
+	Status.state = static_cast<uint8>(Snapshot.State);
+	Status.phase = static_cast<uint8>(Snapshot.Phase);
+	Status.current_cycle = Snapshot.CurrentCycle;
+	Status.cycle_count = Snapshot.CycleCount;
+	Status.phase_length_s = static_cast<int32>(Snapshot.PhaseLength.GetTotalSeconds());
+	Status.remaining_ms = Snapshot.GetRemaining(Now).GetTicks() / ETimespan::TicksPerMillisecond;
+	Status.deadline_unix_ms = Snapshot.State == Running ? PomodoroTime::ToUnixMilliseconds(Snapshot.DeadlineUtc) : 0;
+	Status.written_unix_ms = PomodoroTime::ToUnixMilliseconds(Now);
+
+	pomodoro_status_page_write(Page, &Status);
+}
+
+bool FPomodoroStatusPage::Read(FPomodoroEngineSnapshot& OutSnapshot) const
+{
+	pomodoro_status Status;
+	if(Page == nullptr || !pomodoro_status_page_read(Page, &Status))
+	{
+		return false;
+	}
+
+	OutSnapshot = FPomodoroEngineSnapshot();
+	OutSnapshot.Version = Status.version;
+	OutSnapshot.State = static_cast<EPomodoroState>(Status.state);
+	OutSnapshot.Phase = static_cast<EPomodoroPhase>(Status.phase);
+	OutSnapshot.CurrentCycle = Status.current_cycle;
+	OutSnapshot.CycleCount = Status.cycle_count;
+	OutSnapshot.PhaseLength = FTimespan::FromSeconds(Status.phase_length_s);
+	OutSnapshot.Remaining = FTimespan(Status.remaining_ms * ETimespan::TicksPerMillisecond);
+
+	if(OutSnapshot.State == Running)
+	{
+		const FDateTime Now = FDateTime::UtcNow();
+		OutSnapshot.DeadlineUtc = PomodoroTime::FromUnixMilliseconds(Status.deadline_unix_ms);
+		OutSnapshot.DeadlineSeconds = FPlatformTime::Seconds() + (OutSnapshot.DeadlineUtc - Now).GetTotalSeconds();
+		OutSnapshot.Remaining = OutSnapshot.GetRemaining(Now);
+	}
+	return true;
+}
+
+FString FPomodoroStatusPage::GetDefaultPagePath()
+{
+	return PomodoroPaths::GetUserRuntimeFile(TEXT("status"));
+}
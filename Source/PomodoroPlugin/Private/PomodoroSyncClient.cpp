@@ -0,0 +1,456 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSyncClient.h"
+
+#include "PomodoroPlugin.h"
+#include "PomodoroConfig.h"
+#include "Async/Async.h"
+#include "HAL/RunnableThread.h"
+#include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace PomodoroSyncClient
+{
+	/** Time between two connection attempts */
+	constexpr uint32 ReconnectDelayMilliseconds = 5000;
+
+	/** Time to wait for the relay to accept the connection */
+	const FTimespan ConnectTimeout = FTimespan::FromSeconds(3);
+
+	/** Time to wait for messages before checking whether the clock offset must be refreshed */
+	const FTimespan ReceiveTimeout = FTimespan::FromMilliseconds(500);
+
+	/** Number of pings of a burst */
+	constexpr int32 PingBurstLength = 5;
+
+	/** Time between two ping bursts, the clocks drift slowly */
+	constexpr double PingBurstInterval = 300.0;
+
+	static FString GetDefaultRelayAddress()
+	{
+		return FString::Printf(TEXT("127.0.0.1:%d"), PomodoroSync::DefaultPort);
+	}
+}
+
+FPomodoroSyncClient::FPomodoroSyncClient(TSharedRef<FPomodoroEngine> InEngine)
+	: Engine(InEngine)
+	, SenderId(FGuid::NewGuid().A)
+{
+	ReloadConfig();
+}
+
+FPomodoroSyncClient::~FPomodoroSyncClient()
+{
+	Shutdown();
+}
+
+void FPomodoroSyncClient::Restart()
+{
+	Shutdown();
+
+	// A following editor shares the timer of the leading one, which connects for both
+	if(SyncState != ECheckBoxState::Checked || !Engine.IsValid() || Engine->IsFollowing())
+	{
+		return;
+	}
+
+	ConnectedAddress = RelayAddress.IsEmpty() ? PomodoroSyncClient::GetDefaultRelayAddress() : RelayAddress;
+	Group = PomodoroSync::HashGroupName(GroupName);
+	LastSnapshot = Engine->GetSnapshotChannel()->Read();
+	SnapshotPublishedHandle = Engine->OnSnapshotPublished().AddSP(AsShared(), &FPomodoroSyncClient::OnEngineSnapshotPublished);
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("PomodoroSyncClient"), 0, TPri_BelowNormal);
+}
+
+void FPomodoroSyncClient::Shutdown()
+{
+	if(SnapshotPublishedHandle.IsValid())
+	{
+		if(Engine.IsValid())
+		{
+			Engine->OnSnapshotPublished().Remove(SnapshotPublishedHandle);
+		}
+		SnapshotPublishedHandle.Reset();
+	}
+
+	if(Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if(WakeEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+
+	Disconnect();
+}
+
+bool FPomodoroSyncClient::IsConnected() const
+{
+	return bConnected;
+}
+
+void FPomodoroSyncClient::SetSyncState(const ECheckBoxState NewValue)
+{
+	SyncState = NewValue;
+}
+
+ECheckBoxState FPomodoroSyncClient::GetSyncState() const
+{
+	return SyncState;
+}
+
+void FPomodoroSyncClient::SetRelayAddress(const FString& NewValue)
+{
+	RelayAddress = NewValue.TrimStartAndEnd();
+}
+
+const FString& FPomodoroSyncClient::GetRelayAddress() const
+{
+	return RelayAddress;
+}
+
+void FPomodoroSyncClient::SetGroupName(const FString& NewValue)
+{
+	GroupName = NewValue.TrimStartAndEnd();
+}
+
+const FString& FPomodoroSyncClient::GetGroupName() const
+{
+	return GroupName;
+}
+
+void FPomodoroSyncClient::ResetConfig()
+{
+	SyncState = ECheckBoxState::Unchecked;
+	RelayAddress = PomodoroSyncClient::GetDefaultRelayAddress();
+	GroupName.Empty();
+}
+
+void FPomodoroSyncClient::ReloadConfig()
+{
+	TTuple<ECheckBoxState, FString, FString> Data = NewObject<UPomodoroConfig>()->LoadSyncConfig();
+	SyncState = Data.Get<0>();
+	RelayAddress = Data.Get<1>().IsEmpty() ? PomodoroSyncClient::GetDefaultRelayAddress() : Data.Get<1>();
+	GroupName = Data.Get<2>();
+}
+
+void FPomodoroSyncClient::SaveConfig() const
+{
+	NewObject<UPomodoroConfig>()->SaveSyncConfig(SyncState, RelayAddress, GroupName);
+}
+
+uint32 FPomodoroSyncClient::Run()
+{
+	while(!bStopping)
+	{
+		if(Connect())
+		{
+			UE_LOG(LogPomodoro, Log, TEXT("Connected to the team sync relay %s"), *ConnectedAddress);
+			bConnected = true;
+			ReceiveMessages();
+			bConnected = false;
+			bJoined = false;
+			Disconnect();
+			UE_LOG(LogPomodoro, Log, TEXT("Disconnected from the team sync relay"));
+		}
+
+		if(!bStopping)
+		{
+			WakeEvent->Wait(PomodoroSyncClient::ReconnectDelayMilliseconds);
+		}
+	}
+	return 0;
+}
+
+void FPomodoroSyncClient::Stop()
+{
+	bStopping = true;
+	if(WakeEvent != nullptr)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+bool FPomodoroSyncClient::Connect()
+{
+	FString Host = ConnectedAddress;
+	int32 Port = PomodoroSync::DefaultPort;
+	FString PortText;
+	if(ConnectedAddress.Split(TEXT(":"), &Host, &PortText, ESearchCase::IgnoreCase, ESearchDir::FromEnd) && PortText.IsNumeric())
+	{
+		Port = FCString::Atoi(*PortText);
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	const FAddressInfoResult Resolved = SocketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None, SOCKTYPE_Streaming);
+	if(Resolved.ReturnCode != SE_NO_ERROR || Resolved.Results.Num() == 0)
+	{
+		UE_LOG(LogPomodoro, Verbose, TEXT("Can't resolve the team sync relay %s"), *Host);
+		return false;
+	}
+
+	const TSharedRef<FInternetAddr> Address = Resolved.Results[0].Address;
+	Address->SetPort(Port);
+
+	FSocket* NewSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("PomodoroSyncClient"), Address->GetProtocolType());
+	if(NewSocket == nullptr)
+	{
+		return false;
+	}
+	NewSocket->SetNonBlocking(true);
+	NewSocket->SetNoDelay(true);
+
+	// Connecting without blocking keeps the thread responsive to shutdown
+	if(!NewSocket->Connect(*Address)
+		|| !NewSocket->Wait(ESocketWaitConditions::WaitForWrite, PomodoroSyncClient::ConnectTimeout)
+		|| NewSocket->GetConnectionState() != SCS_Connected)
+	{
+		NewSocket->Close();
+		SocketSubsystem->DestroySocket(NewSocket);
+		return false;
+	}
+
+	{
+		FScopeLock Lock(&SocketLock);
+		Socket = NewSocket;
+	}
+
+	// The group is joined once the clock offset is known, so its state can be converted right away
+	StartPingBurst();
+	return true;
+}
+
+void FPomodoroSyncClient::Disconnect()
+{
+	FScopeLock Lock(&SocketLock);
+	if(Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+void FPomodoroSyncClient::ReceiveMessages()
+{
+	TArray<uint8> Input;
+	double NextPingBurst = FPlatformTime::Seconds() + PomodoroSyncClient::PingBurstInterval;
+
+	while(!bStopping)
+	{
+		if(!Socket->Wait(ESocketWaitConditions::WaitForRead, PomodoroSyncClient::ReceiveTimeout))
+		{
+			if(Socket->GetConnectionState() == SCS_ConnectionError)
+			{
+				return;
+			}
+			if(FPlatformTime::Seconds() >= NextPingBurst)
+			{
+				StartPingBurst();
+				NextPingBurst = FPlatformTime::Seconds() + PomodoroSyncClient::PingBurstInterval;
+			}
+			continue;
+		}
+
+		uint8 Buffer[PomodoroSync::MessageSize * 16];
+		int32 BytesRead = 0;
+		do
+		{
+			// False when the relay closed the connection, would block only reads nothing
+			if(!Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+			{
+				return;
+			}
+			Input.Append(Buffer, BytesRead);
+		}
+		while(BytesRead == sizeof(Buffer));
+
+		int32 Offset = 0;
+		for(; Offset + PomodoroSync::MessageSize <= Input.Num(); Offset += PomodoroSync::MessageSize)
+		{
+			HandleMessage(PomodoroSync::DecodeMessage(Input.GetData() + Offset));
+		}
+		Input.RemoveAt(0, Offset, false);
+	}
+}
+
+void FPomodoroSyncClient::HandleMessage(const PomodoroSync::FMessage& Message)
+{
+	if(Message.Magic != PomodoroSync::Magic || Message.Version != PomodoroSync::Version)
+	{
+		return;
+	}
+
+	switch (Message.Type)
+	{
+	case PomodoroSync::EMessageType::Pong:
+		{
+			// The relay clock is assumed read halfway through the round trip, the fastest one bounds the error best
+			const int64 Now = PomodoroSync::NowMilliseconds();
+			const int64 RoundTrip = Now - Message.TimeA;
+			if(RoundTrip >= 0 && RoundTrip <= BestRoundTrip)
+			{
+				BestRoundTrip = RoundTrip;
+				ClockOffset = Message.TimeB - (Message.TimeA + Now) / 2;
+			}
+
+			if(--BurstPingsLeft > 0)
+			{
+				SendPing();
+			}
+			else if(!bJoined)
+			{
+				PomodoroSync::FMessage Hello;
+				Hello.Type = PomodoroSync::EMessageType::Hello;
+				Hello.Group = Group;
+				Hello.SenderId = SenderId;
+				bJoined = SendMessage(Hello);
+			}
+		}
+		break;
+
+	case PomodoroSync::EMessageType::State:
+		{
+			if(Message.State > Running || Message.Phase > static_cast<uint8>(EPomodoroPhase::LongResting))
+			{
+				return;
+			}
+
+			// The state may have been sent timespans ago, members moved past them by themselves
+			const PomodoroSync::FMessage Current = PomodoroSync::FastForward(Message, PomodoroSync::NowMilliseconds() + ClockOffset);
+
+			FPomodoroEngineSnapshot Snapshot;
+			Snapshot.State = static_cast<EPomodoroState>(Current.State);
+			Snapshot.Phase = static_cast<EPomodoroPhase>(Current.Phase);
+			Snapshot.CurrentCycle = Current.CurrentCycle;
+			Snapshot.CycleCount = Current.CycleCount;
+			Snapshot.WorkingLength = FTimespan::FromSeconds(Current.WorkingSeconds);
+			Snapshot.ShortRestingLength = FTimespan::FromSeconds(Current.ShortRestingSeconds);
+			Snapshot.LongRestingLength = FTimespan::FromSeconds(Current.LongRestingSeconds);
+			Snapshot.Remaining = FTimespan::FromMilliseconds(Current.RemainingMilliseconds);
+
+			switch (Snapshot.Phase)
+			{
+			case EPomodoroPhase::Working:
+				Snapshot.PhaseLength = Snapshot.WorkingLength;
+				break;
+
+			case EPomodoroPhase::ShortResting:
+				Snapshot.PhaseLength = Snapshot.ShortRestingLength;
+				break;
+
+			case EPomodoroPhase::LongResting:
+				Snapshot.PhaseLength = Snapshot.LongRestingLength;
+				break;
+			}
+
+			if(Snapshot.State == Running)
+			{
+				Snapshot.DeadlineUtc = PomodoroTime::FromUnixMilliseconds(Current.TimeA - ClockOffset);
+				Snapshot.Remaining = Snapshot.GetRemaining(FDateTime::UtcNow());
+			}
+
+			const TWeakPtr<FPomodoroSyncClient, ESPMode::ThreadSafe> WeakThis = AsShared();
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Snapshot]()
+			{
+				if(const TSharedPtr<FPomodoroSyncClient, ESPMode::ThreadSafe> This = WeakThis.Pin())
+				{
+					This->ApplyGroupState(Snapshot);
+				}
+			});
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool FPomodoroSyncClient::SendMessage(const PomodoroSync::FMessage& Message)
+{
+	uint8 Bytes[PomodoroSync::MessageSize];
+	PomodoroSync::EncodeMessage(Message, Bytes);
+
+	FScopeLock Lock(&SocketLock);
+	int32 BytesSent = 0;
+	return Socket != nullptr
+		&& Socket->Send(Bytes, PomodoroSync::MessageSize, BytesSent)
+		&& BytesSent == PomodoroSync::MessageSize;
+}
+
+void FPomodoroSyncClient::SendPing()
+{
+	PomodoroSync::FMessage Ping;
+	Ping.Type = PomodoroSync::EMessageType::Ping;
+	Ping.SenderId = SenderId;
+	Ping.TimeA = PomodoroSync::NowMilliseconds();
+	SendMessage(Ping);
+}
+
+void FPomodoroSyncClient::StartPingBurst()
+{
+	BestRoundTrip = MAX_int64;
+	BurstPingsLeft = PomodoroSyncClient::PingBurstLength;
+	SendPing();
+}
+
+void FPomodoroSyncClient::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+	const FPomodoroEngineSnapshot Previous = LastSnapshot;
+	LastSnapshot = Snapshot;
+
+	if(bApplyingRemoteState || !bJoined || Engine->IsFollowing())
+	{
+		return;
+	}
+
+	// Every member reaches the end of a running timespan by itself
+	if(Previous.State == Running && Snapshot.State == Running
+		&& (Previous.Phase != Snapshot.Phase || Previous.CurrentCycle != Snapshot.CurrentCycle))
+	{
+		return;
+	}
+
+	const int64 Offset = ClockOffset;
+	PomodoroSync::FMessage Message;
+	Message.Type = PomodoroSync::EMessageType::State;
+	Message.State = static_cast<uint8>(Snapshot.State);
+	Message.Phase = static_cast<uint8>(Snapshot.Phase);
+	Message.Group = Group;
+	Message.SenderId = SenderId;
+	Message.CurrentCycle = Snapshot.CurrentCycle;
+	Message.CycleCount = Snapshot.CycleCount;
+	Message.WorkingSeconds = static_cast<int32>(Snapshot.WorkingLength.GetTotalSeconds());
+	Message.ShortRestingSeconds = static_cast<int32>(Snapshot.ShortRestingLength.GetTotalSeconds());
+	Message.LongRestingSeconds = static_cast<int32>(Snapshot.LongRestingLength.GetTotalSeconds());
+	Message.RemainingMilliseconds = static_cast<int64>(Snapshot.Remaining.GetTotalMilliseconds());
+	Message.TimeB = PomodoroSync::NowMilliseconds() + Offset;
+	if(Snapshot.State == Running)
+	{
+		Message.TimeA = PomodoroTime::ToUnixMilliseconds(Snapshot.DeadlineUtc) + Offset;
+	}
+	SendMessage(Message);
+}
+
+void FPomodoroSyncClient::ApplyGroupState(const FPomodoroEngineSnapshot& Snapshot)
+{
+	// The state may have been received just before the sync was turned off
+	if(!Engine.IsValid() || Thread == nullptr)
+	{
+		return;
+	}
+
+	bApplyingRemoteState = true;
+	Engine->Synchronize(Snapshot);
+	bApplyingRemoteState = false;
+}
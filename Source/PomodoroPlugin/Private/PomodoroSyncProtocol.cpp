@@ -0,0 +1,126 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSyncProtocol.h"
+
+#include "PomodoroSnapshot.h"
+#include "Hash/CityHash.h"
+
+namespace PomodoroSync
+{
+	template <typename ValueType>
+	static void WriteLittleEndian(uint8*& Cursor, const ValueType Value)
+	{
+		const uint64 Bits = static_cast<uint64>(Value);
+		for(int32 Index = 0; Index < static_cast<int32>(sizeof(ValueType)); ++Index)
+		{
+			*Cursor++ = static_cast<uint8>(Bits >> (8 * Index));
+		}
+	}
+
+	template <typename ValueType>
+	static ValueType ReadLittleEndian(const uint8*& Cursor)
+	{
+		uint64 Bits = 0;
+		for(int32 Index = 0; Index < static_cast<int32>(sizeof(ValueType)); ++Index)
+		{
+			Bits |= static_cast<uint64>(*Cursor++) << (8 * Index);
+		}
+		return static_cast<ValueType>(Bits);
+	}
+}
+
+uint64 PomodoroSync::HashGroupName(const FString& GroupName)
+{
+	const FTCHARToUTF8 Name(*GroupName.TrimStartAndEnd().ToLower());
+	return CityHash64(Name.Get(), Name.Length());
+}
+
+int64 PomodoroSync::NowMilliseconds()
+{
+	return PomodoroTime::ToUnixMilliseconds(FDateTime::UtcNow());
+}
+
+void PomodoroSync::EncodeMessage(const FMessage& Message, uint8* OutBytes)
+{
+	uint8* Cursor = OutBytes;
+	WriteLittleEndian(Cursor, Message.Magic);
+	WriteLittleEndian(Cursor, Message.Version);
+	WriteLittleEndian(Cursor, static_cast<uint8>(Message.Type));
+	WriteLittleEndian(Cursor, Message.State);
+	WriteLittleEndian(Cursor, Message.Phase);
+	WriteLittleEndian(Cursor, Message.Group);
+	WriteLittleEndian(Cursor, Message.TimeA);
+	WriteLittleEndian(Cursor, Message.TimeB);
+	WriteLittleEndian(Cursor, Message.RemainingMilliseconds);
+	WriteLittleEndian(Cursor, Message.SenderId);
+	WriteLittleEndian(Cursor, Message.CurrentCycle);
+	WriteLittleEndian(Cursor, Message.CycleCount);
+	WriteLittleEndian(Cursor, Message.WorkingSeconds);
+	WriteLittleEndian(Cursor, Message.ShortRestingSeconds);
+	WriteLittleEndian(Cursor, Message.LongRestingSeconds);
+	check(Cursor == OutBytes + MessageSize);
+}
+
+PomodoroSync::FMessage PomodoroSync::DecodeMessage(const uint8* Bytes)
+{
+	const uint8* Cursor = Bytes;
+	FMessage Message;
+	Message.Magic = ReadLittleEndian<uint32>(Cursor);
+	Message.Version = ReadLittleEndian<uint8>(Cursor);
+	Message.Type = static_cast<EMessageType>(ReadLittleEndian<uint8>(Cursor));
+	Message.State = ReadLittleEndian<uint8>(Cursor);
+	Message.Phase = ReadLittleEndian<uint8>(Cursor);
+	Message.Group = ReadLittleEndian<uint64>(Cursor);
+	Message.TimeA = ReadLittleEndian<int64>(Cursor);
+	Message.TimeB = ReadLittleEndian<int64>(Cursor);
+	Message.RemainingMilliseconds = ReadLittleEndian<int64>(Cursor);
+	Message.SenderId = ReadLittleEndian<uint32>(Cursor);
+	Message.CurrentCycle = ReadLittleEndian<int32>(Cursor);
+	Message.CycleCount = ReadLittleEndian<int32>(Cursor);
+	Message.WorkingSeconds = ReadLittleEndian<int32>(Cursor);
+	Message.ShortRestingSeconds = ReadLittleEndian<int32>(Cursor);
+	Message.LongRestingSeconds = ReadLittleEndian<int32>(Cursor);
+	check(Cursor == Bytes + MessageSize);
+	return Message;
+}
+
+PomodoroSync::FMessage PomodoroSync::FastForward(const FMessage& Message, const int64 Now)
+{
+	FMessage Result = Message;
+	if(Result.State != static_cast<uint8>(Running) || Result.TimeA > Now
+		|| Result.CycleCount <= 0 || Result.WorkingSeconds <= 0 || Result.ShortRestingSeconds <= 0 || Result.LongRestingSeconds <= 0)
+	{
+		return Result;
+	}
+
+	const int64 WorkingMilliseconds = Result.WorkingSeconds * 1000ll;
+	const int64 ShortRestingMilliseconds = Result.ShortRestingSeconds * 1000ll;
+	const int64 LongRestingMilliseconds = Result.LongRestingSeconds * 1000ll;
+
+	// A whole cycle brings the timer back to the same timespan, skip them at once for old states
+	const int64 CycleMilliseconds = Result.CycleCount * WorkingMilliseconds
+		+ (Result.CycleCount - 1) * ShortRestingMilliseconds + LongRestingMilliseconds;
+	Result.TimeA += (Now - Result.TimeA) / CycleMilliseconds * CycleMilliseconds;
+
+	// Same transitions as the engine at the end of a timespan
+	while(Result.TimeA <= Now)
+	{
+		if(Result.Phase == static_cast<uint8>(EPomodoroPhase::Working))
+		{
+			const bool bLastCycle = Result.CurrentCycle >= Result.CycleCount;
+			Result.Phase = static_cast<uint8>(bLastCycle ? EPomodoroPhase::LongResting : EPomodoroPhase::ShortResting);
+			Result.TimeA += bLastCycle ? LongRestingMilliseconds : ShortRestingMilliseconds;
+		}
+		else
+		{
+			Result.CurrentCycle = Result.CurrentCycle % Result.CycleCount + 1;
+			Result.Phase = static_cast<uint8>(EPomodoroPhase::Working);
+			Result.TimeA += WorkingMilliseconds;
+		}
+	}
+
+	Result.TimeB = Now;
+	Result.RemainingMilliseconds = Result.TimeA - Now;
+	return Result;
+}
@@ -0,0 +1,236 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSyncRelay.h"
+
+#include "PomodoroPlugin.h"
+#include "HAL/RunnableThread.h"
+
+namespace PomodoroSyncRelay
+{
+	/** Longest sleep of the relay loop, only a safety net since the stop wakes it up */
+	constexpr int32 IdleWaitMilliseconds = 60 * 1000;
+
+	/** Maximum number of connected clients */
+	constexpr int32 MaxClients = 256;
+}
+
+FPomodoroSyncRelay::FPomodoroSyncRelay()
+	: ListenSocket(PomodoroSockets::InvalidHandle)
+	, WakeSocket(PomodoroSockets::InvalidHandle)
+	, Thread(nullptr)
+{
+}
+
+FPomodoroSyncRelay::~FPomodoroSyncRelay()
+{
+	Close();
+}
+
+bool FPomodoroSyncRelay::Listen(const int32 Port)
+{
+	Close();
+
+	ListenSocket = PomodoroSockets::Listen(Port, false, true, 64);
+	WakeSocket = PomodoroSockets::OpenWakeSocket();
+	if(ListenSocket == PomodoroSockets::InvalidHandle || WakeSocket == PomodoroSockets::InvalidHandle)
+	{
+		UE_LOG(LogPomodoro, Error, TEXT("Can't listen on port %d for the team sync relay"), Port);
+		Close();
+		return false;
+	}
+
+	UE_LOG(LogPomodoro, Log, TEXT("Team sync relay listening on port %d"), Port);
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("PomodoroSyncRelay"), 0, TPri_Normal);
+	return true;
+}
+
+void FPomodoroSyncRelay::Close()
+{
+	if(Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	for(FClient& Client : Clients)
+	{
+		Disconnect(Client);
+	}
+	Clients.Empty();
+	GroupStates.Empty();
+
+	PomodoroSockets::Close(ListenSocket);
+	PomodoroSockets::Close(WakeSocket);
+}
+
+uint32 FPomodoroSyncRelay::Run()
+{
+	while(!bStopping)
+	{
+		PollEntries.Reset();
+		PollEntries.Add({ListenSocket});
+		PollEntries.Add({WakeSocket});
+		for(const FClient& Client : Clients)
+		{
+			PollEntries.Add({Client.Socket});
+		}
+
+		// Sleep until a connection or a message comes in, there is no periodic work
+		if(!PomodoroSockets::Poll(PollEntries, PomodoroSyncRelay::IdleWaitMilliseconds))
+		{
+			UE_LOG(LogPomodoro, Error, TEXT("Team sync relay stopped, its sockets can't be waited for"));
+			break;
+		}
+
+		if(PollEntries[1].bReady)
+		{
+			PomodoroSockets::DrainWake(WakeSocket);
+		}
+		if(bStopping)
+		{
+			break;
+		}
+
+		// Clients are removed once all are read, so the indices still match the poll entries
+		for(int32 Index = 0; Index < Clients.Num(); ++Index)
+		{
+			if(PollEntries[Index + 2].bReady && !Clients[Index].bDropped && !ReadClient(Clients[Index]))
+			{
+				Clients[Index].bDropped = true;
+			}
+		}
+
+		// Forwarded states may have dropped clients read before their sender
+		for(int32 Index = Clients.Num() - 1; Index >= 0; --Index)
+		{
+			if(Clients[Index].bDropped)
+			{
+				Disconnect(Clients[Index]);
+				Clients.RemoveAtSwap(Index);
+			}
+		}
+
+		if(PollEntries[0].bReady)
+		{
+			AcceptClients();
+		}
+	}
+	return 0;
+}
+
+void FPomodoroSyncRelay::Stop()
+{
+	bStopping = true;
+	PomodoroSockets::Wake(WakeSocket);
+}
+
+void FPomodoroSyncRelay::AcceptClients()
+{
+	for(;;)
+	{
+		PomodoroSockets::FHandle Socket = PomodoroSockets::Accept(ListenSocket);
+		if(Socket == PomodoroSockets::InvalidHandle)
+		{
+			return;
+		}
+
+		if(Clients.Num() >= PomodoroSyncRelay::MaxClients)
+		{
+			UE_LOG(LogPomodoro, Warning, TEXT("Team sync relay is full, connection refused"));
+			PomodoroSockets::Close(Socket);
+			continue;
+		}
+
+		FClient& Client = Clients.AddDefaulted_GetRef();
+		Client.Socket = Socket;
+	}
+}
+
+bool FPomodoroSyncRelay::ReadClient(FClient& Client)
+{
+	uint8 Buffer[PomodoroSync::MessageSize * 16];
+	int32 BytesRead = 0;
+	do
+	{
+		// Negative when the client closed the connection, would block only reads nothing
+		BytesRead = PomodoroSockets::Recv(Client.Socket, Buffer, sizeof(Buffer));
+		if(BytesRead < 0)
+		{
+			return false;
+		}
+		Client.Input.Append(Buffer, BytesRead);
+	}
+	while(BytesRead == sizeof(Buffer));
+
+	int32 Offset = 0;
+	for(; Offset + PomodoroSync::MessageSize <= Client.Input.Num(); Offset += PomodoroSync::MessageSize)
+	{
+		if(!HandleMessage(Client, PomodoroSync::DecodeMessage(Client.Input.GetData() + Offset)))
+		{
+			return false;
+		}
+	}
+	Client.Input.RemoveAt(0, Offset, false);
+	return true;
+}
+
+bool FPomodoroSyncRelay::HandleMessage(FClient& Client, const PomodoroSync::FMessage& Message)
+{
+	if(Message.Magic != PomodoroSync::Magic || Message.Version != PomodoroSync::Version)
+	{
+		return false;
+	}
+
+	switch (Message.Type)
+	{
+	case PomodoroSync::EMessageType::Hello:
+		{
+			// Newcomers start from the current state of their group, members moved past the timespans ended since it was sent
+			Client.Group = Message.Group;
+			const PomodoroSync::FMessage* GroupState = GroupStates.Find(Client.Group);
+			return GroupState == nullptr || SendMessage(Client, PomodoroSync::FastForward(*GroupState, PomodoroSync::NowMilliseconds()));
+		}
+
+	case PomodoroSync::EMessageType::Ping:
+		{
+			PomodoroSync::FMessage Pong = Message;
+			Pong.Type = PomodoroSync::EMessageType::Pong;
+			Pong.TimeB = PomodoroSync::NowMilliseconds();
+			return SendMessage(Client, Pong);
+		}
+
+	case PomodoroSync::EMessageType::State:
+		if(Client.Group == 0 || Message.Group != Client.Group)
+		{
+			return false;
+		}
+
+		GroupStates.Add(Client.Group, Message);
+		for(FClient& Other : Clients)
+		{
+			if(&Other != &Client && !Other.bDropped && Other.Group == Client.Group && !SendMessage(Other, Message))
+			{
+				Other.bDropped = true;
+			}
+		}
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool FPomodoroSyncRelay::SendMessage(const FClient& Client, const PomodoroSync::FMessage& Message)
+{
+	uint8 Bytes[PomodoroSync::MessageSize];
+	PomodoroSync::EncodeMessage(Message, Bytes);
+	return PomodoroSockets::Send(Client.Socket, Bytes, PomodoroSync::MessageSize) == PomodoroSync::MessageSize;
+}
+
+void FPomodoroSyncRelay::Disconnect(FClient& Client)
+{
+	PomodoroSockets::Close(Client.Socket);
+}
@@ -0,0 +1,35 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroSyncRelayCommandlet.h"
+
+#include "PomodoroSyncRelay.h"
+
+UPomodoroSyncRelayCommandlet::UPomodoroSyncRelayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPomodoroSyncRelayCommandlet::Main(const FString& Params)
+{
+	int32 Port = PomodoroSync::DefaultPort;
+	FParse::Value(*Params, TEXT("Port="), Port);
+
+	FPomodoroSyncRelay Relay;
+	if(!Relay.Listen(Port))
+	{
+		return 1;
+	}
+
+	// The relay runs on its own thread, this one only waits for Ctrl+C
+	while(!IsEngineExitRequested())
+	{
+		FPlatformProcess::Sleep(0.5f);
+	}
+
+	Relay.Close();
+	return 0;
+}
@@ -0,0 +1,172 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroTaskIndex.h"
+
+namespace PomodoroTaskIndex
+{
+	/** Longer keys are cut, a prefix this long already finds the task */
+	constexpr int32 MaxKeyLength = 32;
+
+	/** Shorter title words aren't indexed */
+	constexpr int32 MinWordLength = 2;
+
+	static void AddKey(TArray<TPair<FString, int32>>& Keys, const FString& Text, const int32 Task)
+	{
+		if(Text.Len() >= MinWordLength)
+		{
+			Keys.Emplace(Text.Left(MaxKeyLength).ToLower(), Task);
+		}
+	}
+}
+
+void FPomodoroTaskIndex::Build(const TArray<FPomodoroTask>& Tasks)
+{
+	Reset();
+
+	TArray<TPair<FString, int32>> Keys;
+	Keys.Reserve(Tasks.Num() * 4);
+	for(int32 Task = 0; Task < Tasks.Num(); ++Task)
+	{
+		PomodoroTaskIndex::AddKey(Keys, Tasks[Task].Id, Task);
+
+		TArray<FString> Words;
+		Tasks[Task].Title.ParseIntoArrayWS(Words, TEXT(",;:()[]\"'"));
+		for(const FString& Word : Words)
+		{
+			PomodoroTaskIndex::AddKey(Keys, Word, Task);
+		}
+	}
+
+	// Case sensitive order, the keys are already lower case
+	Keys.Sort([](const TPair<FString, int32>& A, const TPair<FString, int32>& B)
+	{
+		const int32 Order = A.Key.Compare(B.Key, ESearchCase::CaseSensitive);
+		return Order < 0 || (Order == 0 && A.Value < B.Value);
+	});
+
+	KeyTasks.Reserve(Keys.Num());
+	for(const TPair<FString, int32>& Key : Keys)
+	{
+		KeyTasks.Add(Key.Value);
+	}
+
+	FNode& Root = Nodes.AddDefaulted_GetRef();
+	Root.End = Keys.Num();
+	BuildChildren(Keys, 0, 0);
+
+	Nodes.Shrink();
+	Labels.Shrink();
+}
+
+void FPomodoroTaskIndex::Reset()
+{
+	Nodes.Empty();
+	Labels.Empty();
+	KeyTasks.Empty();
+}
+
+void FPomodoroTaskIndex::FindPrefix(const FString& Prefix, const int32 MaxResults, TArray<int32>& OutTasks) const
+{
+	OutTasks.Reset();
+	if(Nodes.Num() == 0)
+	{
+		return;
+	}
+
+	const FString Key = Prefix.TrimStartAndEnd().ToLower();
+	const int32 KeyLength = FMath::Min(Key.Len(), PomodoroTaskIndex::MaxKeyLength);
+	int32 NodeIndex = 0;
+	int32 Depth = 0;
+	while(Depth < KeyLength)
+	{
+		const FNode& Node = Nodes[NodeIndex];
+		const TCHAR Character = Key[Depth];
+
+		// Children are sorted by the first character of their label
+		int32 Low = Node.FirstChild;
+		int32 High = Node.FirstChild + Node.ChildCount;
+		while(Low < High)
+		{
+			const int32 Middle = (Low + High) / 2;
+			if(Labels[Nodes[Middle].LabelStart] < Character)
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+
+		if(Low == Node.FirstChild + Node.ChildCount || Labels[Nodes[Low].LabelStart] != Character)
+		{
+			return;
+		}
+
+		// The prefix may end inside the label, the node still covers every key starting with it
+		const FNode& Child = Nodes[Low];
+		const int32 Length = FMath::Min<int32>(Child.LabelLength, KeyLength - Depth);
+		for(int32 Offset = 1; Offset < Length; ++Offset)
+		{
+			if(Labels[Child.LabelStart + Offset] != Key[Depth + Offset])
+			{
+				return;
+			}
+		}
+		Depth += Child.LabelLength;
+		NodeIndex = Low;
+	}
+
+	const FNode& Node = Nodes[NodeIndex];
+	for(int32 Index = Node.Begin; Index < Node.End && OutTasks.Num() < MaxResults; ++Index)
+	{
+		OutTasks.AddUnique(KeyTasks[Index]);
+	}
+}
+
+void FPomodoroTaskIndex::BuildChildren(const TArray<TPair<FString, int32>>& Keys, const int32 NodeIndex, const int32 Depth)
+{
+	// Keys ending at this node sort first
+	int32 Index = Nodes[NodeIndex].Begin;
+	const int32 End = Nodes[NodeIndex].End;
+	while(Index < End && Keys[Index].Key.Len() == Depth)
+	{
+		++Index;
+	}
+
+	// Children are created together so they are contiguous
+	const int32 FirstChild = Nodes.Num();
+	while(Index < End)
+	{
+		const FString& First = Keys[Index].Key;
+		const TCHAR Character = First[Depth];
+		FNode& Child = Nodes.AddDefaulted_GetRef();
+		Child.Begin = Index;
+		while(Index < End && Keys[Index].Key[Depth] == Character)
+		{
+			++Index;
+		}
+		Child.End = Index;
+
+		// The keys are sorted, the prefix common to the first and the last one is common to all of them
+		const FString& Last = Keys[Index - 1].Key;
+		int32 Length = 1;
+		while(Depth + Length < Last.Len() && Depth + Length < First.Len() && First[Depth + Length] == Last[Depth + Length])
+		{
+			++Length;
+		}
+		Child.LabelStart = Labels.Num();
+		Child.LabelLength = static_cast<uint16>(Length);
+		Labels.Append(*First + Depth, Length);
+	}
+
+	Nodes[NodeIndex].FirstChild = FirstChild;
+	Nodes[NodeIndex].ChildCount = static_cast<uint16>(Nodes.Num() - FirstChild);
+
+	const int32 LastChild = Nodes.Num();
+	for(int32 Child = FirstChild; Child < LastChild; ++Child)
+	{
+		BuildChildren(Keys, Child, Depth + Nodes[Child].LabelLength);
+	}
+}
@@ -0,0 +1,257 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PomodoroTaskTracker.h"
+
+#include "PomodoroPlugin.h"
+#include "PomodoroConfig.h"
+#include "PomodoroDeferredWork.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+
+namespace PomodoroTaskTracker
+{
+	/** Key of the deferred config save */
+	static const FName SaveKey(TEXT("PomodoroTaskTracker"));
+
+	/** The focus times are saved at the latest after this delay */
+	constexpr double SaveDelaySeconds = 30.0;
+
+	static FString Unquote(const FString& Text)
+	{
+		FString Result = Text.TrimStartAndEnd();
+		if(Result.Len() >= 2 && Result.StartsWith(TEXT("\"")) && Result.EndsWith(TEXT("\"")))
+		{
+			Result = Result.Mid(1, Result.Len() - 2).Replace(TEXT("\"\""), TEXT("\""));
+		}
+		return Result;
+	}
+}
+
+FPomodoroTaskTracker::FPomodoroTaskTracker(TSharedRef<FPomodoroEngine> InEngine)
+	: Engine(InEngine)
+{
+	Engine->OnSnapshotPublished().AddRaw(this, &FPomodoroTaskTracker::OnEngineSnapshotPublished);
+	ReloadConfig();
+}
+
+FPomodoroTaskTracker::~FPomodoroTaskTracker()
+{
+	Engine->OnSnapshotPublished().RemoveAll(this);
+	FPomodoroDeferredWork::Flush(PomodoroTaskTracker::SaveKey);
+}
+
+bool FPomodoroTaskTracker::ReadTaskFile(const FString& FilePath, FPomodoroTaskList& OutList)
+{
+	TArray<FString> Lines;
+	if(!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+	{
+		UE_LOG(LogPomodoro, Warning, TEXT("Can't read the task file %s"), *FilePath);
+		return false;
+	}
+
+	OutList.Path = FilePath;
+	OutList.Tasks.Reset(Lines.Num());
+	OutList.TaskPositions.Reset();
+
+	for(const FString& Line : Lines)
+	{
+		if(Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		// The identifier ends at the first comma or tab outside quotes, the title may hold more
+		int32 Separator = INDEX_NONE;
+		bool bQuoted = false;
+		for(int32 Character = 0; Character < Line.Len(); ++Character)
+		{
+			// Doubled quotes inside a quoted field flip the state twice
+			if(Line[Character] == TEXT('"'))
+			{
+				bQuoted = !bQuoted;
+			}
+			else if(!bQuoted && (Line[Character] == TEXT(',') || Line[Character] == TEXT('\t')))
+			{
+				Separator = Character;
+				break;
+			}
+		}
+
+		FPomodoroTask Task;
+		Task.Id = PomodoroTaskTracker::Unquote(Separator == INDEX_NONE ? Line : Line.Left(Separator));
+		Task.Title = Separator == INDEX_NONE ? FString() : PomodoroTaskTracker::Unquote(Line.Mid(Separator + 1));
+
+		// Skip the header of spreadsheet exports and the duplicated identifiers
+		if(Task.Id.IsEmpty() || (OutList.Tasks.Num() == 0 && Task.Id.Equals(TEXT("id"), ESearchCase::IgnoreCase)) || OutList.TaskPositions.Contains(Task.Id))
+		{
+			continue;
+		}
+
+		OutList.TaskPositions.Add(Task.Id, OutList.Tasks.Num());
+		OutList.Tasks.Add(MoveTemp(Task));
+	}
+
+	OutList.Index.Build(OutList.Tasks);
+	return true;
+}
+
+void FPomodoroTaskTracker::ImportTasks(const FString& FilePath, TUniqueFunction<void(bool)> OnImported)
+{
+	const uint32 Serial = ++ImportSerial;
+	const TWeakPtr<FPomodoroTaskTracker, ESPMode::ThreadSafe> WeakThis = AsShared();
+	Async(EAsyncExecution::ThreadPool, [FilePath, Serial, WeakThis, OnImported = MoveTemp(OnImported)]() mutable
+	{
+		FPomodoroTaskList List;
+		const bool bRead = ReadTaskFile(FilePath, List);
+
+		AsyncTask(ENamedThreads::GameThread, [Serial, WeakThis, bRead, List = MoveTemp(List), OnImported = MoveTemp(OnImported)]() mutable
+		{
+			const TSharedPtr<FPomodoroTaskTracker, ESPMode::ThreadSafe> This = WeakThis.Pin();
+
+			// A later import was requested meanwhile, it replaces this one
+			if(!This.IsValid() || Serial != This->ImportSerial)
+			{
+				return;
+			}
+
+			if(bRead)
+			{
+				This->ApplyTaskList(MoveTemp(List));
+			}
+			if(OnImported)
+			{
+				OnImported(bRead);
+			}
+		});
+	});
+}
+
+void FPomodoroTaskTracker::ApplyTaskList(FPomodoroTaskList&& List)
+{
+	check(IsInGameThread());
+
+	ImportPath = MoveTemp(List.Path);
+	Tasks = MoveTemp(List.Tasks);
+	TaskPositions = MoveTemp(List.TaskPositions);
+	Index = MoveTemp(List.Index);
+	UE_LOG(LogPomodoro, Log, TEXT("Imported %d tasks from %s"), Tasks.Num(), *ImportPath);
+}
+
+const FString& FPomodoroTaskTracker::GetImportPath() const
+{
+	return ImportPath;
+}
+
+int32 FPomodoroTaskTracker::GetTaskCount() const
+{
+	return Tasks.Num();
+}
+
+const FPomodoroTask& FPomodoroTaskTracker::GetTask(const int32 Position) const
+{
+	return Tasks[Position];
+}
+
+void FPomodoroTaskTracker::FindTasks(const FString& Prefix, const int32 MaxResults, TArray<int32>& OutTasks) const
+{
+	Index.FindPrefix(Prefix, MaxResults, OutTasks);
+}
+
+void FPomodoroTaskTracker::SetCurrentTask(const FString& TaskId)
+{
+	if(TaskId == CurrentTask)
+	{
+		return;
+	}
+
+	// The time spent so far belongs to the previous task
+	const bool bWasOpen = bSegmentOpen;
+	const double NowSeconds = FPlatformTime::Seconds();
+	CloseSegment(NowSeconds);
+
+	CurrentTask = TaskId;
+	if(bWasOpen)
+	{
+		bSegmentOpen = true;
+		SegmentStartSeconds = NowSeconds;
+	}
+	RequestSave();
+}
+
+const FString& FPomodoroTaskTracker::GetCurrentTask() const
+{
+	return CurrentTask;
+}
+
+FString FPomodoroTaskTracker::GetTaskTitle(const FString& TaskId) const
+{
+	const int32* Position = TaskPositions.Find(TaskId);
+	return Position != nullptr ? Tasks[*Position].Title : FString();
+}
+
+FTimespan FPomodoroTaskTracker::GetFocusTime(const FString& TaskId) const
+{
+	const FTimespan* FocusTime = FocusTimes.Find(TaskId);
+	FTimespan Result = FocusTime != nullptr ? *FocusTime : FTimespan::Zero();
+	if(bSegmentOpen && TaskId == CurrentTask)
+	{
+		Result += FTimespan::FromSeconds(FPlatformTime::Seconds() - SegmentStartSeconds);
+	}
+	return Result;
+}
+
+void FPomodoroTaskTracker::ReloadConfig()
+{
+	TTuple<FString, FString, TMap<FString, FTimespan>> Data = NewObject<UPomodoroConfig>()->LoadTaskConfig();
+
+	ImportPath = Data.Get<0>();
+	CurrentTask = Data.Get<1>();
+	FocusTimes = Data.Get<2>();
+	bSegmentOpen = false;
+}
+
+void FPomodoroTaskTracker::SaveConfig() const
+{
+	NewObject<UPomodoroConfig>()->SaveTaskConfig(ImportPath, CurrentTask, FocusTimes);
+}
+
+void FPomodoroTaskTracker::OnEngineSnapshotPublished()
+{
+	const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+
+	// The leading editor counts for every editor of this machine
+	const bool bFocusing = Snapshot.State == Running && Snapshot.Phase == EPomodoroPhase::Working && !Engine->IsFollowing();
+	if(bFocusing && !bSegmentOpen)
+	{
+		bSegmentOpen = true;
+		SegmentStartSeconds = FPlatformTime::Seconds();
+	}
+	else if(!bFocusing && bSegmentOpen)
+	{
+		CloseSegment(FPlatformTime::Seconds());
+	}
+}
+
+void FPomodoroTaskTracker::CloseSegment(const double NowSeconds)
+{
+	if(!bSegmentOpen)
+	{
+		return;
+	}
+
+	bSegmentOpen = false;
+	if(!CurrentTask.IsEmpty())
+	{
+		FocusTimes.FindOrAdd(CurrentTask) += FTimespan::FromSeconds(NowSeconds - SegmentStartSeconds);
+		RequestSave();
+	}
+}
+
+void FPomodoroTaskTracker::RequestSave()
+{
+	FPomodoroDeferredWork::Enqueue(PomodoroTaskTracker::SaveKey, EPomodoroWorkPriority::Low, PomodoroTaskTracker::SaveDelaySeconds, [this]()
+	{
+		SaveConfig();
+	});
+}
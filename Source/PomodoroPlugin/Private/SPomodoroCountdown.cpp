@@ -0,0 +1,220 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SPomodoroCountdown.h"
+
+#include "Fonts/FontCache.h"
+#include "Fonts/FontMeasure.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+
+namespace PomodoroCountdown
+{
+	/** Time between two refreshes while running, short enough to never skip a second */
+	constexpr float RefreshPeriod = 0.25f;
+
+	/** Time between two refreshes while running with the tenths shown, short enough to never skip a tenth */
+	constexpr float TenthsRefreshPeriod = 0.05f;
+
+	/** Longest remaining time displayed, in seconds */
+	constexpr int32 MaxSeconds = 999 * 3600 + 3599;
+
+	/** Characters of the glyphs, in glyph order */
+	static const TCHAR GlyphCharacters[] = TEXT("0123456789:.");
+}
+
+SPomodoroCountdown::~SPomodoroCountdown()
+{
+	if(Engine.IsValid())
+	{
+		Engine->OnSnapshotPublished().RemoveAll(this);
+	}
+	if(FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().GetRenderer()->GetFontCache()->OnReleaseResources().RemoveAll(this);
+	}
+}
+
+void SPomodoroCountdown::Construct(const FArguments& InArgs, const TSharedRef<FPomodoroEngine> InEngine)
+{
+	Engine = InEngine;
+	Font = InArgs._Font;
+	ColorAndOpacity = InArgs._ColorAndOpacity;
+	bShowTenths = InArgs._ShowTenths;
+
+	// Measured once, every digit gets the cell of the widest one so the countdown never moves
+	const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+	for(int32 Glyph = 0; Glyph < ColonGlyph; ++Glyph)
+	{
+		DigitWidth = FMath::Max(DigitWidth, FontMeasure->Measure(&PomodoroCountdown::GlyphCharacters[Glyph], 0, 1, Font).X);
+	}
+	ColonWidth = FontMeasure->Measure(&PomodoroCountdown::GlyphCharacters[ColonGlyph], 0, 1, Font).X;
+	DotWidth = FontMeasure->Measure(&PomodoroCountdown::GlyphCharacters[DotGlyph], 0, 1, Font).X;
+	LineHeight = FontMeasure->GetMaxCharacterHeight(Font);
+
+	FSlateApplication::Get().GetRenderer()->GetFontCache()->OnReleaseResources().AddSP(this, &SPomodoroCountdown::OnFontResourcesReleased);
+	Engine->OnSnapshotPublished().AddSP(this, &SPomodoroCountdown::OnEngineSnapshotPublished);
+	OnEngineSnapshotPublished();
+}
+
+void SPomodoroCountdown::SetShowTenths(const bool bInShowTenths)
+{
+	if(bShowTenths == bInShowTenths)
+	{
+		return;
+	}
+	bShowTenths = bInShowTenths;
+	DisplayedValue = -1;
+
+	// Registered again at the period of the new display
+	if(RefreshTimer.IsValid())
+	{
+		UnRegisterActiveTimer(RefreshTimer.ToSharedRef());
+		RefreshTimer.Reset();
+	}
+	OnEngineSnapshotPublished();
+}
+
+int32 SPomodoroCountdown::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, const int32 LayerId, const FWidgetStyle& InWidgetStyle, const bool bParentEnabled) const
+{
+	if(GlyphScale != AllottedGeometry.Scale || Glyphs.Num() == 0)
+	{
+		ShapeGlyphs(AllottedGeometry.Scale);
+	}
+
+	const ESlateDrawEffect DrawEffects = ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const FLinearColor Tint = InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacity.GetColor(InWidgetStyle);
+	const float Top = FMath::Max(0.0f, (AllottedGeometry.GetLocalSize().Y - LineHeight) * 0.5f);
+
+	float Left = 0.0f;
+	for(int32 Cell = 0; Cell < CellCount; ++Cell)
+	{
+		const int32 Glyph = Cells[Cell];
+		const float CellWidth = GetCellWidth(Glyph);
+
+		// Center the glyph in its cell, measured widths are in drawn pixels
+		const float GlyphWidth = Glyphs[Glyph]->GetMeasuredWidth() / GlyphScale;
+		FSlateDrawElement::MakeShapedText(OutDrawElements, LayerId,
+			AllottedGeometry.ToPaintGeometry(FVector2D(Left + (CellWidth - GlyphWidth) * 0.5f, Top), FVector2D(GlyphWidth, LineHeight)),
+			Glyphs[Glyph].ToSharedRef(), DrawEffects, Tint, FLinearColor::Transparent);
+		Left += CellWidth;
+	}
+	return LayerId;
+}
+
+FVector2D SPomodoroCountdown::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	float Width = 0.0f;
+	for(int32 Cell = 0; Cell < CellCount; ++Cell)
+	{
+		Width += GetCellWidth(Cells[Cell]);
+	}
+	return FVector2D(Width, LineHeight);
+}
+
+void SPomodoroCountdown::OnEngineSnapshotPublished()
+{
+	// The engine only publishes on changes, the countdown itself is followed by the timer
+	if(UpdateCells() && !RefreshTimer.IsValid())
+	{
+		RefreshTimer = RegisterActiveTimer(bShowTenths ? PomodoroCountdown::TenthsRefreshPeriod : PomodoroCountdown::RefreshPeriod,
+			FWidgetActiveTimerDelegate::CreateSP(this, &SPomodoroCountdown::OnRefreshTimer));
+	}
+}
+
+EActiveTimerReturnType SPomodoroCountdown::OnRefreshTimer(double CurrentTime, float DeltaTime)
+{
+	if(UpdateCells())
+	{
+		return EActiveTimerReturnType::Continue;
+	}
+	RefreshTimer.Reset();
+	return EActiveTimerReturnType::Stop;
+}
+
+bool SPomodoroCountdown::UpdateCells()
+{
+	Engine->GetSnapshotChannel()->ReadIfChanged(Snapshot);
+	const bool bRunning = Snapshot.State == Running;
+
+	// Round up like the engine, which shows the full timespan during its first second
+	const double RemainingSeconds = bRunning ? Snapshot.DeadlineSeconds - FPlatformTime::Seconds() : Snapshot.Remaining.GetTotalSeconds();
+	const int32 Value = bShowTenths
+		? FMath::Clamp(FMath::CeilToInt(RemainingSeconds * 10.0), 0, PomodoroCountdown::MaxSeconds * 10 + 9)
+		: FMath::Clamp(FMath::CeilToInt(RemainingSeconds), 0, PomodoroCountdown::MaxSeconds);
+	if(Value == DisplayedValue)
+	{
+		return bRunning;
+	}
+	DisplayedValue = Value;
+
+	// Written backward : tenths when shown, seconds, minutes, then hours only when needed
+	uint8 Reversed[MaxCells];
+	int32 Count = 0;
+	if(bShowTenths)
+	{
+		Reversed[Count++] = Value % 10;
+		Reversed[Count++] = DotGlyph;
+	}
+	const int32 Seconds = bShowTenths ? Value / 10 : Value;
+	Reversed[Count++] = Seconds % 10;
+	Reversed[Count++] = Seconds / 10 % 6;
+	Reversed[Count++] = ColonGlyph;
+	Reversed[Count++] = Seconds / 60 % 10;
+	Reversed[Count++] = Seconds / 600 % 6;
+	int32 Hours = Seconds / 3600;
+	if(Hours > 0)
+	{
+		Reversed[Count++] = ColonGlyph;
+		for(; Hours > 0; Hours /= 10)
+		{
+			Reversed[Count++] = Hours % 10;
+		}
+	}
+
+	const bool bResized = Count != CellCount;
+	CellCount = Count;
+	for(int32 Cell = 0; Cell < Count; ++Cell)
+	{
+		Cells[Cell] = Reversed[Count - 1 - Cell];
+	}
+
+	Invalidate(bResized ? EInvalidateWidgetReason::Layout : EInvalidateWidgetReason::Paint);
+	return bRunning;
+}
+
+float SPomodoroCountdown::GetCellWidth(const int32 Glyph) const
+{
+	switch (Glyph)
+	{
+	case ColonGlyph:
+		return ColonWidth;
+
+	case DotGlyph:
+		return DotWidth;
+
+	default:
+		return DigitWidth;
+	}
+}
+
+void SPomodoroCountdown::ShapeGlyphs(const float FontScale) const
+{
+	const TSharedRef<FSlateFontCache> FontCache = FSlateApplication::Get().GetRenderer()->GetFontCache();
+
+	Glyphs.Reset();
+	for(int32 Glyph = 0; Glyph <= DotGlyph; ++Glyph)
+	{
+		Glyphs.Add(FontCache->ShapeUnidirectionalText(PomodoroCountdown::GlyphCharacters, Glyph, 1, Font, FontScale,
+			TextBiDi::ETextDirection::LeftToRight, GetDefaultTextShapingMethod()));
+	}
+	GlyphScale = FontScale;
+}
+
+void SPomodoroCountdown::OnFontResourcesReleased(const FSlateFontCache& FontCache)
+{
+	Glyphs.Reset();
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
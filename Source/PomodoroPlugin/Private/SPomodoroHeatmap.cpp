@@ -0,0 +1,180 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SPomodoroHeatmap.h"
+
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+#include "Styling/CoreStyle.h"
+
+#define LOCTEXT_NAMESPACE "SPomodoroHeatmap"
+
+namespace PomodoroHeatmap
+{
+	/** Colors from no focus to the busiest days */
+	static const FColor LevelColors[] =
+	{
+		FColor(255, 255, 255, 20),
+		FColor(14, 68, 41),
+		FColor(0, 109, 50),
+		FColor(38, 166, 65),
+		FColor(57, 211, 83),
+	};
+
+	/** Number of weeks shown before the widget is arranged */
+	constexpr int32 DesiredWeeks = 53;
+
+	/** Weeks scrolled by a mouse wheel step */
+	constexpr int32 WheelWeeks = 4;
+}
+
+void SPomodoroHeatmap::Construct(const FArguments& InArgs, const TSharedRef<FPomodoroFocusHistory> InHistory)
+{
+	History = InHistory;
+	CellSize = InArgs._CellSize;
+	CellGap = InArgs._CellGap;
+	WhiteHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*FCoreStyle::Get().GetBrush("GenericWhiteBox"));
+
+	SetToolTipText(TAttribute<FText>::CreateSP(this, &SPomodoroHeatmap::GetHoveredText));
+}
+
+int32 SPomodoroHeatmap::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, const int32 LayerId, const FWidgetStyle& InWidgetStyle, const bool bParentEnabled) const
+{
+	const int32 Today = FPomodoroFocusHistory::GetDay(FDateTime::Now());
+	if(Today != BuiltToday || WeekOffset != BuiltWeekOffset || History->GetVersion() != BuiltVersion
+		|| BuiltSize != AllottedGeometry.GetLocalSize() || BuiltTransform != AllottedGeometry.GetAccumulatedRenderTransform())
+	{
+		BuildBatch(AllottedGeometry, Today);
+	}
+
+	if(Indices.Num() > 0)
+	{
+		FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, WhiteHandle, Vertices, Indices, nullptr, 0, 0,
+			ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect);
+	}
+	return LayerId;
+}
+
+FVector2D SPomodoroHeatmap::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	const float Pitch = CellSize + CellGap;
+	return FVector2D(PomodoroHeatmap::DesiredWeeks * Pitch - CellGap, 7 * Pitch - CellGap);
+}
+
+FReply SPomodoroHeatmap::OnMouseWheel(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	// Scrolling up goes back in time, never past the first recorded week
+	const int32 Today = FPomodoroFocusHistory::GetDay(FDateTime::Now());
+	const int32 RecordedWeeks = (Today - Today % 7 - (History->GetFirstDay() - History->GetFirstDay() % 7)) / 7 + 1;
+	const int32 MaxOffset = FMath::Max(0, RecordedWeeks - GetVisibleWeeks(MyGeometry.GetLocalSize().X));
+
+	const int32 NewOffset = FMath::Clamp(WeekOffset + (MouseEvent.GetWheelDelta() > 0 ? 1 : -1) * PomodoroHeatmap::WheelWeeks, 0, MaxOffset);
+	if(NewOffset == WeekOffset)
+	{
+		return FReply::Unhandled();
+	}
+
+	WeekOffset = NewOffset;
+	HoveredDay = INDEX_NONE;
+	Invalidate(EInvalidateWidgetReason::Paint);
+	return FReply::Handled();
+}
+
+FReply SPomodoroHeatmap::OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	const float Pitch = CellSize + CellGap;
+	const FVector2D Local = MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition());
+	const int32 Column = FMath::FloorToInt(Local.X / Pitch);
+	const int32 Row = FMath::FloorToInt(Local.Y / Pitch);
+	const int32 VisibleWeeks = GetVisibleWeeks(MyGeometry.GetLocalSize().X);
+
+	HoveredDay = INDEX_NONE;
+	if(Column >= 0 && Column < VisibleWeeks && Row >= 0 && Row < 7)
+	{
+		const int32 Today = FPomodoroFocusHistory::GetDay(FDateTime::Now());
+		const int32 Day = GetLastMonday(Today) - (VisibleWeeks - 1 - Column) * 7 + Row;
+		HoveredDay = Day <= Today ? Day : INDEX_NONE;
+	}
+	return FReply::Unhandled();
+}
+
+void SPomodoroHeatmap::OnMouseLeave(const FPointerEvent& MouseEvent)
+{
+	SLeafWidget::OnMouseLeave(MouseEvent);
+	HoveredDay = INDEX_NONE;
+}
+
+int32 SPomodoroHeatmap::GetVisibleWeeks(const float Width) const
+{
+	return FMath::Max(1, FMath::FloorToInt((Width + CellGap) / (CellSize + CellGap)));
+}
+
+int32 SPomodoroHeatmap::GetLastMonday(const int32 Today) const
+{
+	// Day 0, 0001-01-01, is a Monday
+	return Today - Today % 7 - WeekOffset * 7;
+}
+
+void SPomodoroHeatmap::BuildBatch(const FGeometry& Geometry, const int32 Today) const
+{
+	using namespace PomodoroHeatmap;
+
+	const FSlateRenderTransform& Transform = Geometry.GetAccumulatedRenderTransform();
+	const float Pitch = CellSize + CellGap;
+	const int32 VisibleWeeks = GetVisibleWeeks(Geometry.GetLocalSize().X);
+	const int32 FirstMonday = GetLastMonday(Today) - (VisibleWeeks - 1) * 7;
+	const int32 PeakSeconds = FMath::Max(1, History->GetPeakSeconds());
+
+	const int32 CellCount = FMath::Min(VisibleWeeks * 7, Today - FirstMonday + 1);
+	Vertices.Reset(CellCount * 4);
+	Indices.Reset(CellCount * 6);
+
+	for(int32 Week = 0; Week < VisibleWeeks; ++Week)
+	{
+		for(int32 Weekday = 0; Weekday < 7; ++Weekday)
+		{
+			const int32 Day = FirstMonday + Week * 7 + Weekday;
+			if(Day > Today)
+			{
+				break;
+			}
+
+			// Levels split the focus time in quarters of the busiest day
+			const int32 Seconds = History->GetFocusSeconds(Day);
+			const int32 Level = Seconds > 0 ? FMath::Clamp(FMath::CeilToInt(4.0f * Seconds / PeakSeconds), 1, 4) : 0;
+			const FColor& Color = LevelColors[Level];
+
+			const FVector2D TopLeft(Week * Pitch, Weekday * Pitch);
+			const SlateIndex First = Vertices.Num();
+			Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, TopLeft, FVector2D::ZeroVector, Color));
+			Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, TopLeft + FVector2D(CellSize, 0.0f), FVector2D::ZeroVector, Color));
+			Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, TopLeft + FVector2D(0.0f, CellSize), FVector2D::ZeroVector, Color));
+			Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, TopLeft + FVector2D(CellSize, CellSize), FVector2D::ZeroVector, Color));
+			Indices.Append({First, static_cast<SlateIndex>(First + 1), static_cast<SlateIndex>(First + 2)});
+			Indices.Append({static_cast<SlateIndex>(First + 1), static_cast<SlateIndex>(First + 3), static_cast<SlateIndex>(First + 2)});
+		}
+	}
+
+	BuiltTransform = Transform;
+	BuiltSize = Geometry.GetLocalSize();
+	BuiltWeekOffset = WeekOffset;
+	BuiltToday = Today;
+	BuiltVersion = History->GetVersion();
+}
+
+FText SPomodoroHeatmap::GetHoveredText() const
+{
+	if(HoveredDay == INDEX_NONE)
+	{
+		return LOCTEXT("HeatmapHint", "Focus time of each day, scroll to go back in time");
+	}
+
+	const FDateTime Date(static_cast<int64>(HoveredDay) * ETimespan::TicksPerDay);
+	const int32 Minutes = History->GetFocusSeconds(HoveredDay) / 60;
+	return FText::Format(LOCTEXT("HeatmapDay", "{0} : {1}h {2}m"),
+		FText::AsDate(Date, EDateTimeStyle::Medium, FText::GetInvariantTimeZone()), Minutes / 60, Minutes % 60);
+}
+
+#undef LOCTEXT_NAMESPACE
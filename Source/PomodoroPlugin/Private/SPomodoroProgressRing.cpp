@@ -0,0 +1,236 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SPomodoroProgressRing.h"
+
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+#include "Styling/CoreStyle.h"
+
+namespace PomodoroProgressRing
+{
+	/** Radii of the ring and of the circle the pips are centered on, relative to the diameter */
+	constexpr float OuterRadius = 0.40f;
+	constexpr float InnerRadius = 0.32f;
+	constexpr float PipOrbit = 0.46f;
+	constexpr float PipRadius = 0.035f;
+
+	/** Colors of the ring */
+	static const FColor TrackColor(255, 255, 255, 32);
+	static const FColor WorkingColor(230, 80, 60);
+	static const FColor ShortRestingColor(90, 190, 100);
+	static const FColor LongRestingColor(70, 140, 230);
+
+	static FColor GetPhaseColor(const EPomodoroPhase Phase)
+	{
+		switch (Phase)
+		{
+		case EPomodoroPhase::ShortResting:
+			return ShortRestingColor;
+
+		case EPomodoroPhase::LongResting:
+			return LongRestingColor;
+
+		default:
+			return WorkingColor;
+		}
+	}
+}
+
+SPomodoroProgressRing::~SPomodoroProgressRing()
+{
+	if(Engine.IsValid())
+	{
+		Engine->OnSnapshotPublished().RemoveAll(this);
+	}
+}
+
+void SPomodoroProgressRing::Construct(const FArguments& InArgs, const TSharedRef<FPomodoroEngine> InEngine)
+{
+	Engine = InEngine;
+	Diameter = InArgs._Diameter;
+	WhiteHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*FCoreStyle::Get().GetBrush("GenericWhiteBox"));
+
+	Directions.SetNumUninitialized(Segments + 1);
+	for(int32 Segment = 0; Segment <= Segments; ++Segment)
+	{
+		const float Angle = 2.0f * PI * Segment / Segments;
+		Directions[Segment] = FVector2D(FMath::Sin(Angle), -FMath::Cos(Angle));
+	}
+
+	Engine->OnSnapshotPublished().AddSP(this, &SPomodoroProgressRing::OnEngineSnapshotPublished);
+	OnEngineSnapshotPublished();
+}
+
+int32 SPomodoroProgressRing::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, const int32 LayerId, const FWidgetStyle& InWidgetStyle, const bool bParentEnabled) const
+{
+	Engine->GetSnapshotChannel()->ReadIfChanged(Snapshot);
+
+	// Pips follow the cycle count, the batch is rebuilt when it changes
+	const int32 PipCount = Vertices.Num() > PipVertex ? (Vertices.Num() - PipVertex) / (PipSides + 1) : 0;
+	if(Indices.Num() == 0 || PipCount != FMath::Max(Snapshot.CycleCount, 0) || BuiltSize != AllottedGeometry.GetLocalSize()
+		|| BuiltTransform != AllottedGeometry.GetAccumulatedRenderTransform())
+	{
+		BuildBatch(AllottedGeometry);
+	}
+	if(ColoredVersion != Snapshot.Version)
+	{
+		UpdateColors();
+	}
+	UpdateSweep(AllottedGeometry, GetProgress());
+
+	FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, WhiteHandle, Vertices, Indices, nullptr, 0, 0,
+		ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect);
+	return LayerId;
+}
+
+FVector2D SPomodoroProgressRing::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(Diameter, Diameter);
+}
+
+void SPomodoroProgressRing::OnEngineSnapshotPublished()
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	if(Engine->GetState() == Running && !AnimationTimer.IsValid())
+	{
+		AnimationTimer = RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SPomodoroProgressRing::OnAnimationTimer));
+	}
+}
+
+EActiveTimerReturnType SPomodoroProgressRing::OnAnimationTimer(double CurrentTime, float DeltaTime)
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	if(Engine->GetState() == Running)
+	{
+		return EActiveTimerReturnType::Continue;
+	}
+	AnimationTimer.Reset();
+	return EActiveTimerReturnType::Stop;
+}
+
+void SPomodoroProgressRing::BuildBatch(const FGeometry& Geometry) const
+{
+	using namespace PomodoroProgressRing;
+
+	const FSlateRenderTransform& Transform = Geometry.GetAccumulatedRenderTransform();
+	const FVector2D Size = Geometry.GetLocalSize();
+	const FVector2D Center = Size * 0.5f;
+	const float Scale = FMath::Min(Size.X, Size.Y);
+	const int32 PipCount = FMath::Max(Snapshot.CycleCount, 0);
+
+	// Track and progress arc are both strips of quads, the progress one is only moved afterward
+	Vertices.SetNumUninitialized(PipVertex + PipCount * (PipSides + 1));
+	for(int32 Arc = 0; Arc < 2; ++Arc)
+	{
+		const int32 First = Arc * ProgressVertex;
+		for(int32 Segment = 0; Segment <= Segments; ++Segment)
+		{
+			const FVector2D& Direction = Directions[Segment];
+			Vertices[First + Segment * 2] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform,
+				Center + Direction * (OuterRadius * Scale), FVector2D::ZeroVector, TrackColor);
+			Vertices[First + Segment * 2 + 1] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform,
+				Center + Direction * (InnerRadius * Scale), FVector2D::ZeroVector, TrackColor);
+		}
+	}
+
+	// Pips are small fans, evenly spread clockwise from the top
+	for(int32 Pip = 0; Pip < PipCount; ++Pip)
+	{
+		const float Angle = 2.0f * PI * Pip / PipCount;
+		const FVector2D PipCenter = Center + FVector2D(FMath::Sin(Angle), -FMath::Cos(Angle)) * (PipOrbit * Scale);
+		const int32 First = PipVertex + Pip * (PipSides + 1);
+		Vertices[First] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, PipCenter, FVector2D::ZeroVector, TrackColor);
+		for(int32 Side = 0; Side < PipSides; ++Side)
+		{
+			const float SideAngle = 2.0f * PI * Side / PipSides;
+			Vertices[First + 1 + Side] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform,
+				PipCenter + FVector2D(FMath::Cos(SideAngle), FMath::Sin(SideAngle)) * (PipRadius * Scale), FVector2D::ZeroVector, TrackColor);
+		}
+	}
+
+	Indices.Reset(Segments * 12 + PipCount * PipSides * 3);
+	for(int32 Arc = 0; Arc < 2; ++Arc)
+	{
+		const int32 First = Arc * ProgressVertex;
+		for(int32 Segment = 0; Segment < Segments; ++Segment)
+		{
+			const SlateIndex Outer = First + Segment * 2;
+			Indices.Append({Outer, static_cast<SlateIndex>(Outer + 1), static_cast<SlateIndex>(Outer + 2)});
+			Indices.Append({static_cast<SlateIndex>(Outer + 1), static_cast<SlateIndex>(Outer + 3), static_cast<SlateIndex>(Outer + 2)});
+		}
+	}
+	for(int32 Pip = 0; Pip < PipCount; ++Pip)
+	{
+		const SlateIndex First = PipVertex + Pip * (PipSides + 1);
+		for(int32 Side = 0; Side < PipSides; ++Side)
+		{
+			Indices.Append({First, static_cast<SlateIndex>(First + 1 + Side), static_cast<SlateIndex>(First + 1 + (Side + 1) % PipSides)});
+		}
+	}
+
+	BuiltTransform = Transform;
+	BuiltSize = Size;
+	ColoredVersion = 0;
+}
+
+void SPomodoroProgressRing::UpdateColors() const
+{
+	using namespace PomodoroProgressRing;
+
+	const int32 PipCount = (Vertices.Num() - PipVertex) / (PipSides + 1);
+	const FColor PhaseColor = GetPhaseColor(Snapshot.Phase);
+
+	// Done cycles are filled, the current one shows the phase
+	for(int32 Pip = 0; Pip < PipCount; ++Pip)
+	{
+		const FColor Color = Pip + 1 < Snapshot.CurrentCycle ? WorkingColor : Pip + 1 == Snapshot.CurrentCycle ? PhaseColor : TrackColor;
+		const int32 First = PipVertex + Pip * (PipSides + 1);
+		for(int32 Vertex = First; Vertex <= First + PipSides; ++Vertex)
+		{
+			Vertices[Vertex].Color = Color;
+		}
+	}
+	ColoredVersion = Snapshot.Version;
+}
+
+void SPomodoroProgressRing::UpdateSweep(const FGeometry& Geometry, const float Progress) const
+{
+	using namespace PomodoroProgressRing;
+
+	const FSlateRenderTransform& Transform = Geometry.GetAccumulatedRenderTransform();
+	const FVector2D Center = Geometry.GetLocalSize() * 0.5f;
+	const float Scale = FMath::Min(Geometry.GetLocalSize().X, Geometry.GetLocalSize().Y);
+	const FColor PhaseColor = GetPhaseColor(Snapshot.Phase);
+
+	// Boundaries past the sweep collapse onto it, the arc ends exactly at the sweep angle
+	const float SweepAngle = 2.0f * PI * Progress;
+	const FVector2D SweepDirection(FMath::Sin(SweepAngle), -FMath::Cos(SweepAngle));
+	const float SweepSegment = Progress * Segments;
+	for(int32 Segment = 0; Segment <= Segments; ++Segment)
+	{
+		const FVector2D& Direction = Segment <= SweepSegment ? Directions[Segment] : SweepDirection;
+		Vertices[ProgressVertex + Segment * 2] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform,
+			Center + Direction * (OuterRadius * Scale), FVector2D::ZeroVector, PhaseColor);
+		Vertices[ProgressVertex + Segment * 2 + 1] = FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform,
+			Center + Direction * (InnerRadius * Scale), FVector2D::ZeroVector, PhaseColor);
+	}
+}
+
+float SPomodoroProgressRing::GetProgress() const
+{
+	const double Length = Snapshot.PhaseLength.GetTotalSeconds();
+	if(Length <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	const double Remaining = Snapshot.State == Running
+		? Snapshot.DeadlineSeconds - FPlatformTime::Seconds()
+		: Snapshot.Remaining.GetTotalSeconds();
+	return FMath::Clamp(static_cast<float>(1.0 - Remaining / Length), 0.0f, 1.0f);
+}
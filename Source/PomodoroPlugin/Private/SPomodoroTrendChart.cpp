@@ -0,0 +1,283 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SPomodoroTrendChart.h"
+
+#include "Framework/Application/SlateApplication.h"
+#include "InputCoreTypes.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+#include "Styling/CoreStyle.h"
+
+#define LOCTEXT_NAMESPACE "SPomodoroTrendChart"
+
+namespace PomodoroTrendChart
+{
+	/** Outline color of each metric, the area uses it translucent */
+	static const FColor MetricColors[] =
+	{
+		FColor(57, 211, 83),
+		FColor(255, 179, 71),
+		FColor(229, 83, 75),
+	};
+
+	/** Alpha of the area under the outline */
+	constexpr uint8 AreaAlpha = 70;
+
+	/** Width a downsampled point takes at most */
+	constexpr float PixelsPerPoint = 3.0f;
+
+	/** Buckets shown at first, about three months of days or a year of weeks */
+	constexpr int32 DefaultVisibleBuckets[] = {91, 52};
+
+	/** Fewest buckets a zoom shows */
+	constexpr int32 MinVisibleBuckets = 7;
+
+	/** Space kept above the highest point */
+	constexpr float TopMargin = 4.0f;
+}
+
+void SPomodoroTrendChart::Construct(const FArguments& InArgs, const TSharedRef<FPomodoroPhaseHistory> InHistory)
+{
+	Trends = MakeShared<FPomodoroTrends>(InHistory);
+	Metric = InArgs._Metric;
+	Bucket = InArgs._Bucket;
+	for(int32 Index = 0; Index < FPomodoroTrends::BucketCount; ++Index)
+	{
+		VisibleBuckets[Index] = PomodoroTrendChart::DefaultVisibleBuckets[Index];
+	}
+	WhiteHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*FCoreStyle::Get().GetBrush("GenericWhiteBox"));
+
+	SetClipping(EWidgetClipping::ClipToBounds);
+	SetToolTipText(TAttribute<FText>::CreateSP(this, &SPomodoroTrendChart::GetHoveredText));
+}
+
+void SPomodoroTrendChart::SetMetric(const EPomodoroTrendMetric InMetric)
+{
+	Metric = InMetric;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+EPomodoroTrendMetric SPomodoroTrendChart::GetMetric() const
+{
+	return Metric;
+}
+
+void SPomodoroTrendChart::SetBucket(const EPomodoroTrendBucket InBucket)
+{
+	Bucket = InBucket;
+	HoveredBucket = INDEX_NONE;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+EPomodoroTrendBucket SPomodoroTrendChart::GetBucket() const
+{
+	return Bucket;
+}
+
+int32 SPomodoroTrendChart::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, const int32 LayerId, const FWidgetStyle& InWidgetStyle, const bool bParentEnabled) const
+{
+	// The history is decoded on the thread pool, taken once done
+	Trends->Update();
+
+	const int32 Current = FPomodoroTrends::GetCurrentBucket(Bucket);
+	if(Metric != BuiltMetric || Bucket != BuiltBucket || Current != BuiltCurrent || Trends->GetVersion() != BuiltVersion
+		|| VisibleBuckets[static_cast<int32>(Bucket)] != BuiltVisibleBuckets || EndOffsets[static_cast<int32>(Bucket)] != BuiltEndOffset
+		|| BuiltSize != AllottedGeometry.GetLocalSize() || BuiltTransform != AllottedGeometry.GetAccumulatedRenderTransform())
+	{
+		BuildBatch(AllottedGeometry, Current);
+	}
+
+	const ESlateDrawEffect DrawEffect = ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	if(Indices.Num() > 0)
+	{
+		FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, WhiteHandle, Vertices, Indices, nullptr, 0, 0, DrawEffect);
+	}
+	if(LinePoints.Num() > 1)
+	{
+		FSlateDrawElement::MakeLines(OutDrawElements, LayerId + 1, AllottedGeometry.ToPaintGeometry(), LinePoints, DrawEffect,
+			PomodoroTrendChart::MetricColors[static_cast<int32>(Metric)], true, 1.5f);
+	}
+	return LayerId + 1;
+}
+
+FVector2D SPomodoroTrendChart::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(400.0f, 120.0f);
+}
+
+FReply SPomodoroTrendChart::OnMouseWheel(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	// Scrolling up zooms in, never past the whole history
+	int32& Visible = VisibleBuckets[static_cast<int32>(Bucket)];
+	const int32 Recorded = FPomodoroTrends::GetCurrentBucket(Bucket) - Trends->GetFirstBucket(Bucket) + 1;
+	const int32 MaxVisible = FMath::Max(PomodoroTrendChart::MinVisibleBuckets, static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(Recorded))));
+	const int32 NewVisible = FMath::Clamp(MouseEvent.GetWheelDelta() > 0 ? Visible / 2 : Visible * 2, PomodoroTrendChart::MinVisibleBuckets, MaxVisible);
+	if(NewVisible == Visible)
+	{
+		return FReply::Unhandled();
+	}
+
+	Visible = NewVisible;
+	int32& EndOffset = EndOffsets[static_cast<int32>(Bucket)];
+	EndOffset = FMath::Min(EndOffset, GetMaxEndOffset());
+	HoveredBucket = INDEX_NONE;
+	Invalidate(EInvalidateWidgetReason::Paint);
+	return FReply::Handled();
+}
+
+FReply SPomodoroTrendChart::OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	if(MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	{
+		return FReply::Unhandled();
+	}
+
+	bDragging = true;
+	DragStartX = MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition()).X;
+	DragStartOffset = EndOffsets[static_cast<int32>(Bucket)];
+	return FReply::Handled().CaptureMouse(SharedThis(this));
+}
+
+FReply SPomodoroTrendChart::OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	if(!bDragging || MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	{
+		return FReply::Unhandled();
+	}
+
+	bDragging = false;
+	return FReply::Handled().ReleaseMouseCapture();
+}
+
+FReply SPomodoroTrendChart::OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	const FVector2D Local = MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition());
+	const float Width = FMath::Max(1.0f, MyGeometry.GetLocalSize().X);
+	const int32 Visible = VisibleBuckets[static_cast<int32>(Bucket)];
+
+	// Dragging to the right goes back in time
+	if(bDragging)
+	{
+		const int32 NewOffset = FMath::Clamp(DragStartOffset + FMath::RoundToInt((Local.X - DragStartX) * Visible / Width), 0, GetMaxEndOffset());
+		if(NewOffset != EndOffsets[static_cast<int32>(Bucket)])
+		{
+			EndOffsets[static_cast<int32>(Bucket)] = NewOffset;
+			Invalidate(EInvalidateWidgetReason::Paint);
+		}
+		return FReply::Handled();
+	}
+
+	HoveredBucket = INDEX_NONE;
+	if(Local.X >= 0.0f && Local.X < Width)
+	{
+		const int32 Current = FPomodoroTrends::GetCurrentBucket(Bucket);
+		const int32 Hovered = GetStartBucket(Current) + FMath::FloorToInt(Local.X / Width * Visible);
+		HoveredBucket = Hovered <= Current ? Hovered : INDEX_NONE;
+	}
+	return FReply::Unhandled();
+}
+
+void SPomodoroTrendChart::OnMouseLeave(const FPointerEvent& MouseEvent)
+{
+	SLeafWidget::OnMouseLeave(MouseEvent);
+	HoveredBucket = INDEX_NONE;
+}
+
+int32 SPomodoroTrendChart::GetStartBucket(const int32 Current) const
+{
+	return Current - EndOffsets[static_cast<int32>(Bucket)] - VisibleBuckets[static_cast<int32>(Bucket)] + 1;
+}
+
+int32 SPomodoroTrendChart::GetMaxEndOffset() const
+{
+	const int32 Recorded = FPomodoroTrends::GetCurrentBucket(Bucket) - Trends->GetFirstBucket(Bucket) + 1;
+	return FMath::Max(0, Recorded - VisibleBuckets[static_cast<int32>(Bucket)]);
+}
+
+void SPomodoroTrendChart::BuildBatch(const FGeometry& Geometry, const int32 Current) const
+{
+	using namespace PomodoroTrendChart;
+
+	const FSlateRenderTransform& Transform = Geometry.GetAccumulatedRenderTransform();
+	const FVector2D Size = Geometry.GetLocalSize();
+	const int32 Visible = VisibleBuckets[static_cast<int32>(Bucket)];
+	const int32 StartBucket = GetStartBucket(Current);
+	const int32 EndBucket = Current - EndOffsets[static_cast<int32>(Bucket)];
+
+	// A point every few pixels, the buckets just outside keep the outline going to the edges
+	const int32 MaxPoints = FMath::Max(3, FMath::FloorToInt(Size.X / PixelsPerPoint));
+	const int32 FromBucket = FMath::Max(StartBucket - 1, Trends->GetFirstBucket(Bucket));
+	const int32 ToBucket = FMath::Min(EndBucket + 1, Current);
+	Trends->GetDownsampled(Metric, Bucket, FromBucket, ToBucket, MaxPoints, Points);
+
+	float Peak = 1.0f;
+	for(const FPomodoroTrendPoint& Point : Points)
+	{
+		Peak = FMath::Max(Peak, Point.Value);
+	}
+
+	const int32 PointCount = Points.Num();
+	Vertices.Reset(PointCount * 2);
+	Indices.Reset(FMath::Max(0, PointCount - 1) * 6);
+	LinePoints.Reset(PointCount);
+
+	const FColor& LineColor = MetricColors[static_cast<int32>(Metric)];
+	const FColor AreaColor(LineColor.R, LineColor.G, LineColor.B, AreaAlpha);
+	const float BucketWidth = Size.X / Visible;
+	const float Height = FMath::Max(0.0f, Size.Y - TopMargin);
+	for(int32 Index = 0; Index < PointCount; ++Index)
+	{
+		const FPomodoroTrendPoint& Point = Points[Index];
+		const FVector2D Top((Point.Bucket - StartBucket + 0.5f) * BucketWidth, Size.Y - Point.Value / Peak * Height);
+		LinePoints.Add(Top);
+
+		// Each point adds a quad down to the baseline
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, Top, FVector2D::ZeroVector, AreaColor));
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(Transform, FVector2D(Top.X, Size.Y), FVector2D::ZeroVector, AreaColor));
+		if(Index > 0)
+		{
+			const SlateIndex Base = static_cast<SlateIndex>(Vertices.Num() - 4);
+			Indices.Append({Base, static_cast<SlateIndex>(Base + 2), static_cast<SlateIndex>(Base + 1)});
+			Indices.Append({static_cast<SlateIndex>(Base + 1), static_cast<SlateIndex>(Base + 2), static_cast<SlateIndex>(Base + 3)});
+		}
+	}
+
+	BuiltTransform = Transform;
+	BuiltSize = Size;
+	BuiltMetric = Metric;
+	BuiltBucket = Bucket;
+	BuiltVisibleBuckets = Visible;
+	BuiltEndOffset = EndOffsets[static_cast<int32>(Bucket)];
+	BuiltCurrent = Current;
+	BuiltVersion = Trends->GetVersion();
+}
+
+FText SPomodoroTrendChart::GetHoveredText() const
+{
+	if(Trends->IsDecoding())
+	{
+		return LOCTEXT("TrendDecoding", "Reading the phase history...");
+	}
+	if(HoveredBucket == INDEX_NONE)
+	{
+		return LOCTEXT("TrendHint", "Scroll to zoom, drag to go back in time");
+	}
+
+	const FDateTime Date(static_cast<int64>(FPomodoroTrends::GetFirstDayOfBucket(Bucket, HoveredBucket)) * ETimespan::TicksPerDay);
+	const FText DateText = Bucket == EPomodoroTrendBucket::Week
+		? FText::Format(LOCTEXT("TrendWeek", "Week of {0}"), FText::AsDate(Date, EDateTimeStyle::Medium, FText::GetInvariantTimeZone()))
+		: FText::AsDate(Date, EDateTimeStyle::Medium, FText::GetInvariantTimeZone());
+
+	const float Value = Trends->GetValue(Metric, Bucket, HoveredBucket);
+	if(Metric == EPomodoroTrendMetric::Interruptions)
+	{
+		return FText::Format(LOCTEXT("TrendCount", "{0} : {1} interruptions"), DateText, FMath::RoundToInt(Value));
+	}
+
+	const int32 Minutes = FMath::RoundToInt(Value);
+	return FText::Format(LOCTEXT("TrendTime", "{0} : {1}h {2}m"), DateText, Minutes / 60, Minutes % 60);
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "PomodoroAdaptiveDurations.h"
+#include "PomodoroClock.h"
+#include "PomodoroEngine.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PomodoroAdaptiveDurationsTests
+{
+	/**
+	 * @brief Clock only moving when the test steps it.
+	 */
+	class FSteppedClock final : public FPomodoroClock
+	{
+	public:
+		virtual double GetSeconds() const override
+		{
+			return Seconds;
+		}
+
+		virtual FDateTime GetUtcNow() const override
+		{
+			return Utc;
+		}
+
+		/**
+		 * @brief Move the time forward and run the due timers.
+		 */
+		void Step(const double DeltaSeconds)
+		{
+			Seconds += DeltaSeconds;
+			Utc += FTimespan::FromSeconds(DeltaSeconds);
+			Advance();
+		}
+
+	private:
+		double Seconds = 1000.0;
+		FDateTime Utc = FDateTime(2024, 1, 1, 9, 0, 0);
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroAdaptiveStopInApplyModeTest, "Pomodoro.Plugin.AdaptiveDurations.StopInApplyMode",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroAdaptiveStopInApplyModeTest::RunTest(const FString& Parameters)
+{
+	using namespace PomodoroAdaptiveDurationsTests;
+
+	const TSharedRef<FSteppedClock> Clock = MakeShared<FSteppedClock>();
+	const TSharedRef<FPomodoroEngine> Engine = MakeShared<FPomodoroEngine>(Clock, nullptr);
+	int32 WorkingElapsed = 0;
+	Engine->BindOnTimeSpanElapsed(FElapsedTimespanHandleDelegate::CreateLambda([&WorkingElapsed](const bool bWorkingTime)
+	{
+		WorkingElapsed += bWorkingTime ? 1 : 0;
+	}));
+	Engine->SetCycleCount(2);
+	Engine->SetWorkingTimespan(0, 0, 5);
+	Engine->SetShortRestingTimespan(0, 0, 3);
+	Engine->SetLongRestingTimespan(0, 0, 4);
+
+	FPomodoroAdaptiveDurations Adaptive(Engine);
+	Adaptive.ResetStatistics();
+	Adaptive.SetMode(EPomodoroAdaptiveMode::Apply);
+
+	// Enough uninterrupted working timespans for a suggestion, then stop inside the next one
+	Engine->Start();
+	for(int32 Step = 0; Step < 100; ++Step)
+	{
+		Clock->Step(1.0);
+		const FPomodoroEngineSnapshot Snapshot = Engine->GetSnapshotChannel()->Read();
+		if(WorkingElapsed >= 3 && Snapshot.Phase == EPomodoroPhase::Working)
+		{
+			break;
+		}
+	}
+	TestEqual(TEXT("Working timespans completed"), WorkingElapsed, 3);
+
+	FTimespan Working, ShortResting, LongResting;
+	TestTrue(TEXT("Suggestion before stop"), Adaptive.GetSuggestion(Working, ShortResting, LongResting));
+
+	// Applying the suggestion to the stopped engine publishes again, the stopped timespan must be learned once
+	Engine->Stop();
+	TestTrue(TEXT("Engine is stopped"), Engine->GetSnapshotChannel()->Read().State == Stopped);
+	TestTrue(TEXT("Suggestion after stop"), Adaptive.GetSuggestion(Working, ShortResting, LongResting));
+	TestTrue(TEXT("Suggestion is applied"), Engine->GetSnapshotChannel()->Read().WorkingLength == Working);
+
+	// Interruptions of 0, 0, 0 then 1 for the stop, weighted mean 1 / 3.439
+	TestTrue(TEXT("Stop is learned once"), Adaptive.GetSummaryText().ToString().Contains(TEXT("Interruptions per timespan : 0.3")));
+
+	// Back to the saved configuration, the save flushed on destruction writes it unchanged
+	Adaptive.ReloadConfig();
+	return true;
+}
+
+#endif
@@ -0,0 +1,60 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "PomodoroSyncProtocol.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPomodoroSyncProtocolEncodingTest, "Pomodoro.Plugin.SyncProtocol.Encoding",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPomodoroSyncProtocolEncodingTest::RunTest(const FString& Parameters)
+{
+	PomodoroSync::FMessage Message;
+	Message.Type = PomodoroSync::EMessageType::State;
+	Message.State = 2;
+	Message.Phase = 1;
+	Message.Group = 0x0102030405060708ull;
+	Message.TimeA = 1700000000123ll;
+	Message.TimeB = -2;
+	Message.RemainingMilliseconds = 1500;
+	Message.SenderId = 0xA1B2C3D4;
+	Message.CurrentCycle = 3;
+	Message.CycleCount = 4;
+	Message.WorkingSeconds = 1500;
+	Message.ShortRestingSeconds = 300;
+	Message.LongRestingSeconds = -1;
+
+	uint8 Bytes[PomodoroSync::MessageSize];
+	PomodoroSync::EncodeMessage(Message, Bytes);
+
+	// Same bytes on every machine, the least significant byte of each field first
+	TestTrue(TEXT("Magic reads PMSY"), FMemory::Memcmp(Bytes, "PMSY", 4) == 0);
+	TestEqual(TEXT("Version"), Bytes[4], PomodoroSync::Version);
+	TestEqual(TEXT("Type"), Bytes[5], static_cast<uint8>(PomodoroSync::EMessageType::State));
+	TestEqual(TEXT("Group low byte"), Bytes[8], static_cast<uint8>(0x08));
+	TestEqual(TEXT("Group high byte"), Bytes[15], static_cast<uint8>(0x01));
+	TestEqual(TEXT("Negative TimeB"), Bytes[24], static_cast<uint8>(0xFE));
+	TestEqual(TEXT("Negative TimeB high byte"), Bytes[31], static_cast<uint8>(0xFF));
+	TestEqual(TEXT("SenderId low byte"), Bytes[40], static_cast<uint8>(0xD4));
+	TestEqual(TEXT("LongRestingSeconds last byte"), Bytes[63], static_cast<uint8>(0xFF));
+
+	const PomodoroSync::FMessage Decoded = PomodoroSync::DecodeMessage(Bytes);
+	TestEqual(TEXT("Magic"), Decoded.Magic, PomodoroSync::Magic);
+	TestTrue(TEXT("Type"), Decoded.Type == Message.Type);
+	TestEqual(TEXT("State"), Decoded.State, Message.State);
+	TestEqual(TEXT("Phase"), Decoded.Phase, Message.Phase);
+	TestEqual(TEXT("Group"), Decoded.Group, Message.Group);
+	TestEqual(TEXT("TimeA"), Decoded.TimeA, Message.TimeA);
+	TestEqual(TEXT("TimeB"), Decoded.TimeB, Message.TimeB);
+	TestEqual(TEXT("RemainingMilliseconds"), Decoded.RemainingMilliseconds, Message.RemainingMilliseconds);
+	TestEqual(TEXT("SenderId"), Decoded.SenderId, Message.SenderId);
+	TestEqual(TEXT("CurrentCycle"), Decoded.CurrentCycle, Message.CurrentCycle);
+	TestEqual(TEXT("CycleCount"), Decoded.CycleCount, Message.CycleCount);
+	TestEqual(TEXT("WorkingSeconds"), Decoded.WorkingSeconds, Message.WorkingSeconds);
+	TestEqual(TEXT("ShortRestingSeconds"), Decoded.ShortRestingSeconds, Message.ShortRestingSeconds);
+	TestEqual(TEXT("LongRestingSeconds"), Decoded.LongRestingSeconds, Message.LongRestingSeconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,217 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+
+/**
+ * What the adaptive timespans do with what they learned.
+ */
+enum class EPomodoroAdaptiveMode : uint8
+{
+	/** Nothing is learned */
+	Off = 0,
+
+	/** New timespan lengths are suggested */
+	Suggest = 1,
+
+	/** New timespan lengths are applied at each cycle boundary */
+	Apply = 2,
+};
+
+/**
+ * Running mean and variance where older values weigh less, updated in constant time.
+ *
+ * Welford update with exponentially decayed weights : each value added multiplies the weight
+ * of the previous ones by the decay.
+ */
+struct POMODOROPLUGIN_API FPomodoroRunningStatistics
+{
+	/** Sum of the decayed weights of the values */
+	double Weight = 0.0;
+
+	/** Weighted mean of the values */
+	double Mean = 0.0;
+
+	/** Weighted sum of the squared deviations from the mean */
+	double SquaredDeviations = 0.0;
+
+	/**
+	 * @brief Add a value.
+	 * @param Value The value to add.
+	 * @param Decay Factor applied to the weight of the previous values, between 0 and 1.
+	 */
+	void Add(double Value, double Decay);
+
+	/**
+	 * @brief Used to get the weighted variance of the values.
+	 * @return The variance, zero without values.
+	 */
+	double GetVariance() const;
+
+	/**
+	 * @brief Used to get the weighted standard deviation of the values.
+	 * @return The standard deviation, zero without values.
+	 */
+	double GetStandardDeviation() const;
+};
+
+/**
+ * Learn the timespan lengths suiting the user from the completed timespans.
+ *
+ * Each completed timespan updates streaming statistics once : how long the focus lasts before the first
+ * interruption, how often working timespans complete, how many pauses and early stops they get, and how long
+ * the resting timespans really last, overruns included. New lengths are suggested from them, or applied
+ * by the engine at the next cycle boundary.
+ */
+class POMODOROPLUGIN_API FPomodoroAdaptiveDurations final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroAdaptiveDurations, load the last saved configuration and statistics.
+	 * @param InEngine Engine to observe.
+	 */
+	explicit FPomodoroAdaptiveDurations(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Standard destructor for FPomodoroAdaptiveDurations.
+	 */
+	~FPomodoroAdaptiveDurations();
+
+	/**
+	 * @brief Set what is done with the statistics.
+	 * @param NewMode The new mode.
+	 */
+	void SetMode(EPomodoroAdaptiveMode NewMode);
+
+	/**
+	 * @brief Used to get what is done with the statistics.
+	 * @return The current mode.
+	 */
+	EPomodoroAdaptiveMode GetMode() const;
+
+	/**
+	 * @brief Used to get the suggested timespan lengths.
+	 * @param OutWorkingTimespan Suggested working timespan.
+	 * @param OutShortRestingTimespan Suggested short resting timespan.
+	 * @param OutLongRestingTimespan Suggested long resting timespan.
+	 * @return False while not enough timespans are completed.
+	 */
+	bool GetSuggestion(FTimespan& OutWorkingTimespan, FTimespan& OutShortRestingTimespan, FTimespan& OutLongRestingTimespan) const;
+
+	/**
+	 * @brief Give the suggested timespan lengths to the engine, applied at the next cycle boundary.
+	 */
+	void ApplySuggestion() const;
+
+	/**
+	 * @brief Used to get the statistics and the suggestion, formatted for display.
+	 * @return The summary text.
+	 */
+	const FText& GetSummaryText() const;
+
+	/**
+	 * @brief Forget everything learned.
+	 */
+	void ResetStatistics();
+
+	/**
+	 * @brief Reload the mode and the statistics to the last ones saved.
+	 */
+	void ReloadConfig();
+
+	/**
+	 * @brief Save the mode and the statistics.
+	 */
+	void SaveConfig() const;
+
+private:
+	/**
+	 * @brief Engine observed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief What is done with the statistics.
+	 */
+	EPomodoroAdaptiveMode Mode;
+
+	/**
+	 * @brief Longest working timespan suggested, in minutes, from the configuration.
+	 */
+	int32 MaxWorkingMinutes;
+
+	/**
+	 * @brief Minutes of focus before the first interruption of a working timespan.
+	 */
+	FPomodoroRunningStatistics FocusRun;
+
+	/**
+	 * @brief One for working timespans completed without interruption, zero otherwise.
+	 */
+	FPomodoroRunningStatistics Completion;
+
+	/**
+	 * @brief Pauses and early stops of a working timespan.
+	 */
+	FPomodoroRunningStatistics Interruptions;
+
+	/**
+	 * @brief Minutes really spent in short and long resting timespans, pauses included.
+	 */
+	FPomodoroRunningStatistics ShortRest;
+	FPomodoroRunningStatistics LongRest;
+
+	/**
+	 * @brief Last snapshot of the engine, to detect its transitions.
+	 */
+	FPomodoroEngineSnapshot LastSnapshot;
+
+	/**
+	 * @brief Tracking of the current timespan, in FPlatformTime seconds.
+	 */
+	bool bTrackingPhase = false;
+	double PhaseStartSeconds = 0.0;
+	double FocusRunSeconds = 0.0;
+	bool bInterrupted = false;
+	int32 PauseCount = 0;
+
+	/**
+	 * @brief Last suggestion.
+	 */
+	bool bHasSuggestion = false;
+	FTimespan SuggestedWorkingTimespan;
+	FTimespan SuggestedShortRestingTimespan;
+	FTimespan SuggestedLongRestingTimespan;
+
+	/**
+	 * @brief Statistics and suggestion, formatted for display.
+	 */
+	FText SummaryText;
+
+	/**
+	 * @brief Follow the transitions of the engine.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Start tracking a new timespan.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 */
+	void BeginPhase(double NowSeconds);
+
+	/**
+	 * @brief Add the tracked timespan to the statistics.
+	 * @param Phase Phase of the timespan.
+	 * @param PhaseLength Configured length of the timespan.
+	 * @param bStopped Was the timespan stopped before its end.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 */
+	void CompletePhase(EPomodoroPhase Phase, FTimespan PhaseLength, bool bStopped, double NowSeconds);
+
+	/**
+	 * @brief Compute the suggestion and the summary from the statistics.
+	 */
+	void UpdateSuggestion();
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "PomodoroSettings.h"
 #include "PomodoroConfig.generated.h"
 
 /**
@@ -59,10 +60,119 @@ class POMODOROPLUGIN_API UPomodoroConfig : public UObject
 	* - Activation of notification sound
 	*/
 	TTuple<ECheckBoxState> LoadNotificationConfig() const;
+
+	
+	/**
+	 * @brief Save the given team sync configuration into config file.
+	 * @param ActivateSync Activation of the team sync
+	 * @param NewRelayAddress Address of the relay, host and optional port
+	 * @param NewGroupName Name of the group sharing the timer
+	 */
+	void SaveSyncConfig(ECheckBoxState ActivateSync, const FString& NewRelayAddress, const FString& NewGroupName);
+
+	/**
+	* Used to get the team sync current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - Activation of the team sync
+	* - Address of the relay
+	* - Name of the group
+	*/
+	TTuple<ECheckBoxState, FString, FString> LoadSyncConfig() const;
+
+	
+	/**
+	 * @brief Save the given day planner configuration into config file.
+	 * @param NewDayStart Start of the working hours, as a time of day
+	 * @param NewDayEnd End of the working hours, as a time of day
+	 * @param NewCommitments Fixed commitments of the day, formatted as "09:00-10:30, 14:00-15:00"
+	 */
+	void SavePlannerConfig(FTimespan NewDayStart, FTimespan NewDayEnd, const FString& NewCommitments);
+
+	/**
+	* Used to get the day planner current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - Start of the working hours
+	* - End of the working hours
+	* - Fixed commitments of the day
+	*/
+	TTuple<FTimespan, FTimespan, FString> LoadPlannerConfig() const;
+
+	
+	/**
+	 * @brief Save the given adaptive timespans configuration into config file.
+	 * @param NewAdaptiveMode What is done with the statistics, see EPomodoroAdaptiveMode
+	 * @param NewAdaptiveStatistics Statistics learned from the completed timespans
+	 */
+	void SaveAdaptiveConfig(int32 NewAdaptiveMode, const TArray<float>& NewAdaptiveStatistics);
+
+	/**
+	* Used to get the adaptive timespans current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - What is done with the statistics
+	* - Statistics learned from the completed timespans
+	* - Longest working timespan ever suggested, in minutes
+	*/
+	TTuple<int32, TArray<float>, int32> LoadAdaptiveConfig() const;
+
+	
+	/**
+	 * @brief Save the given task attribution configuration into config file.
+	 * @param NewTaskFile Path of the imported task export file
+	 * @param NewCurrentTask Identifier of the task the focus time is attributed to
+	 * @param NewTaskFocusTimes Focus time of each task
+	 */
+	void SaveTaskConfig(const FString& NewTaskFile, const FString& NewCurrentTask, const TMap<FString, FTimespan>& NewTaskFocusTimes);
+
+	/**
+	* Used to get the task attribution current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - Path of the imported task export file
+	* - Identifier of the current task
+	* - Focus time of each task
+	*/
+	TTuple<FString, FString, TMap<FString, FTimespan>> LoadTaskConfig() const;
+
+	/**
+	 * @brief Save the given HTTP endpoint configuration into config file.
+	 * @param NewHttpPort Loopback port of the HTTP endpoint, 0 for the default one, negative to disable it
+	 */
+	void SaveHttpConfig(int32 NewHttpPort);
+
+	/**
+	* Used to get the HTTP endpoint current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - Loopback port of the HTTP endpoint, 0 for the default one, negative when disabled
+	*/
+	TTuple<int32> LoadHttpConfig() const;
+
+	/**
+	 * @brief Save the given countdown configuration into config file.
+	 * @param ShowTenths Display of the tenths of a second in the toolbar countdown
+	 */
+	void SaveCountdownConfig(ECheckBoxState ShowTenths);
+
+	/**
+	* Used to get the countdown current configuration.
+	* 
+	* @return A tuple containing all the data in the given order :
+	* - Display of the tenths of a second in the toolbar countdown
+	*/
+	TTuple<ECheckBoxState> LoadCountdownConfig() const;
+
+	/**
+	 * @brief Give the path of the file used to save the config.
+	 * @return Path of the file in the project Config directory.
+	 */
+	static FString GetConfigFilePath();
 	
 	private:
 	/** Path of the file used to save the config */
-	const FString ConfigPath = (FPaths::ProjectConfigDir() + TEXT("PomodoroConfig.ini"));
+	const FString ConfigPath = GetConfigFilePath();
 
 	/** Working time span */
 	UPROPERTY(Config)
@@ -83,4 +193,73 @@ class POMODOROPLUGIN_API UPomodoroConfig : public UObject
 	/** Allowing the notification sound */
 	UPROPERTY(config)
 	bool NotificationSound;
+
+	/** Sharing the timer with a team through a relay */
+	UPROPERTY(Config)
+	bool SyncEnabled;
+
+	/** Address of the team sync relay */
+	UPROPERTY(Config)
+	FString SyncRelayAddress;
+
+	/** Name of the group sharing the timer */
+	UPROPERTY(Config)
+	FString SyncGroup;
+
+	/** Start of the working hours */
+	UPROPERTY(Config)
+	FTimespan DayStart;
+
+	/** End of the working hours */
+	UPROPERTY(Config)
+	FTimespan DayEnd;
+
+	/** Fixed commitments of the day */
+	UPROPERTY(Config)
+	FString Commitments;
+
+	/** What is done with the adaptive timespans statistics */
+	UPROPERTY(Config)
+	int32 AdaptiveMode;
+
+	/** Statistics learned from the completed timespans */
+	UPROPERTY(Config)
+	TArray<float> AdaptiveStatistics;
+
+	/** Longest working timespan the adaptive timespans suggest, in minutes */
+	UPROPERTY(Config)
+	int32 AdaptiveMaxWorkingMinutes;
+
+	/** Path of the imported task export file */
+	UPROPERTY(Config)
+	FString TaskFile;
+
+	/** Task the focus time is attributed to */
+	UPROPERTY(Config)
+	FString CurrentTask;
+
+	/** Focus time of each task */
+	UPROPERTY(Config)
+	TMap<FString, FTimespan> TaskFocusTimes;
+
+	/** Loopback port of the HTTP endpoint, 0 for the default one, negative when disabled */
+	UPROPERTY(Config)
+	int32 HttpPort;
+
+	/** Showing the tenths of a second in the toolbar countdown */
+	UPROPERTY(Config)
+	bool CountdownTenths;
+};
+
+/**
+ * Give the core components access to the pomodoro configuration file.
+ */
+class POMODOROPLUGIN_API FPomodoroConfigStore final : public IPomodoroConfigStore
+{
+public:
+	// IPomodoroConfigStore interface
+	virtual FPomodoroEngineSettings LoadEngineSettings() const override;
+	virtual void SaveEngineSettings(const FPomodoroEngineSettings& Settings) override;
+	virtual FPomodoroPlannerSettings LoadPlannerSettings() const override;
+	virtual void SavePlannerSettings(const FPomodoroPlannerSettings& Settings) override;
 };
@@ -0,0 +1,256 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/Runnable.h"
+#include "PomodoroSnapshot.h"
+#include "PomodoroSockets.h"
+#include <atomic>
+
+/**
+ * @brief Kind of a control request received over HTTP
+ */
+enum class EPomodoroHttpCommand : uint8
+{
+	Start,
+	Pause,
+	Stop,
+
+	/** Change the timespan lengths and the cycle count, only while stopped */
+	Configure,
+};
+
+/**
+ * @brief A control request received over HTTP
+ */
+struct FPomodoroHttpCommand
+{
+	EPomodoroHttpCommand Kind = EPomodoroHttpCommand::Start;
+
+	/** New configuration, zero values are left unchanged */
+	int32 CycleCount = 0;
+	FTimespan WorkingTimespan;
+	FTimespan ShortRestingTimespan;
+	FTimespan LongRestingTimespan;
+};
+
+/**
+ * Called on the server thread when a client sends a control request, the returned future tells if it is accepted.
+ */
+DECLARE_DELEGATE_RetVal_OneParam(TFuture<bool>, FPomodoroHttpCommandHandler, const FPomodoroHttpCommand&)
+
+/**
+ * Serve the engine state and control endpoints over HTTP on the loopback interface, for browser dashboards and scripts.
+ *
+ * GET /state and GET /config answer JSON, POST /start, /pause and /stop control the timer and
+ * POST /config?working_s=&short_resting_s=&long_resting_s=&cycle_count= changes the configuration.
+ * GET /events is a Server-Sent Events stream pushing the state on every transition, clients compute
+ * the countdown from deadline_unix_ms instead of polling.
+ *
+ * The server runs on its own thread, sleeping in a single poll on the listen socket, the clients and a wake
+ * socket, and only reads the engine through its snapshot channel. The answers
+ * are serialized once per snapshot into buffers reused from one snapshot to the next, then copied to every
+ * client, so subscribers only cost a copy and a send per transition. Requests are accepted from loopback
+ * host names only, and control requests from loopback origins only.
+ */
+class POMODOROPLUGIN_API FPomodoroHttpServer final : public FRunnable
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroHttpServer.
+	 * @param InSnapshotChannel Channel the served state is read from.
+	 * @param InCommandHandler Handler for control requests, called on the server thread.
+	 */
+	FPomodoroHttpServer(TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> InSnapshotChannel,
+		FPomodoroHttpCommandHandler InCommandHandler);
+
+	/**
+	 * @brief Standard destructor for FPomodoroHttpServer, close the server if needed.
+	 */
+	virtual ~FPomodoroHttpServer() override;
+
+	/**
+	 * @brief Bind the loopback port and start the server thread.
+	 * @param Port Port to listen on.
+	 * @return True if the server is listening.
+	 */
+	bool Listen(int32 Port);
+
+	/**
+	 * @brief Stop the server thread and disconnect all clients.
+	 */
+	void Close();
+
+	/**
+	 * @brief Wake the server up so it pushes the last snapshot to subscribers.
+	 *
+	 * Can be called from any thread, never blocks.
+	 */
+	void NotifySnapshotChanged();
+
+	/** Port used when nothing else is configured */
+	static constexpr int32 DefaultPort = 8421;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/**
+	 * @brief Socket waking the server thread up, shared with the command continuations that may outlive the server
+	 */
+	struct FWakeUp
+	{
+		FCriticalSection Lock;
+		PomodoroSockets::FHandle Socket = PomodoroSockets::InvalidHandle;
+	};
+
+	/**
+	 * @brief Outcome of a control request, set on the game thread once it ran
+	 */
+	struct FCommandOutcome
+	{
+		bool bAccepted = false;
+		std::atomic<bool> bDone{false};
+	};
+
+	/**
+	 * @brief State of a connected client
+	 */
+	struct FClient
+	{
+		/** Client socket */
+		PomodoroSockets::FHandle Socket = PomodoroSockets::InvalidHandle;
+
+		/** Received bytes not forming a full request yet */
+		TArray<uint8> Input;
+
+		/** Bytes waiting for the socket to be writable */
+		TArray<uint8> Output;
+
+		/** Is the client an event stream */
+		bool bSubscribed = false;
+
+		/** Is the connection closed once the output is sent */
+		bool bCloseWhenFlushed = false;
+
+		/** Control request waited for before answering */
+		TSharedPtr<FCommandOutcome, ESPMode::ThreadSafe> PendingCommand;
+
+		/** FPlatformTime seconds of the connection, and of the last bytes sent */
+		double ConnectedSeconds = 0.0;
+		double SentSeconds = 0.0;
+	};
+
+	/**
+	 * @brief Channel the served state is read from.
+	 */
+	TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> SnapshotChannel;
+
+	/**
+	 * @brief Handler for control requests.
+	 */
+	FPomodoroHttpCommandHandler CommandHandler;
+
+	/**
+	 * @brief Listening socket.
+	 */
+	PomodoroSockets::FHandle ListenSocket = PomodoroSockets::InvalidHandle;
+
+	/**
+	 * @brief Connected clients, only used by the server thread.
+	 */
+	TArray<FClient> Clients;
+
+	/**
+	 * @brief Sockets waited for by the server thread, kept to reuse the allocation.
+	 */
+	TArray<PomodoroSockets::FPollEntry> PollEntries;
+
+	/**
+	 * @brief Snapshot the answers were serialized from.
+	 */
+	FPomodoroEngineSnapshot Snapshot;
+
+	/**
+	 * @brief Answers serialized from the snapshot, only used by the server thread.
+	 */
+	TArray<uint8> StateJson;
+	TArray<uint8> StateResponse;
+	TArray<uint8> ConfigResponse;
+	TArray<uint8> EventFrame;
+
+	/**
+	 * @brief Readable when a snapshot is published, a control request ran or the server stops.
+	 */
+	PomodoroSockets::FHandle WakeSocket = PomodoroSockets::InvalidHandle;
+
+	/**
+	 * @brief The same socket, for the command continuations.
+	 */
+	TSharedRef<FWakeUp, ESPMode::ThreadSafe> WakeUp;
+
+	/**
+	 * @brief Server thread.
+	 */
+	FRunnableThread* Thread = nullptr;
+
+	/**
+	 * @brief Set when the server thread must exit.
+	 */
+	std::atomic<bool> bStopping{false};
+
+	/**
+	 * @brief Accept all pending connections.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 */
+	void AcceptClients(double NowSeconds);
+
+	/**
+	 * @brief Serialize the answers again if a new snapshot was published.
+	 * @return True if the snapshot changed.
+	 */
+	bool UpdateAnswers();
+
+	/**
+	 * @brief Read the request of a client and answer it once complete.
+	 * @param Client The client to read from.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 * @return False if the client must be disconnected.
+	 */
+	bool ReadClient(FClient& Client, double NowSeconds);
+
+	/**
+	 * @brief Answer a complete request.
+	 * @param Client The client to answer.
+	 * @param Method Request method.
+	 * @param Target Request path and query.
+	 * @param Host Host header, empty when missing.
+	 * @param Origin Origin header, empty when missing.
+	 */
+	void HandleRequest(FClient& Client, const FString& Method, const FString& Target, const FString& Host, const FString& Origin);
+
+	/**
+	 * @brief Parse and forward a configuration request.
+	 * @param Query Query string of the request.
+	 * @param OutCommand The parsed request.
+	 * @return False if a value is invalid.
+	 */
+	static bool ParseConfigQuery(const FString& Query, FPomodoroHttpCommand& OutCommand);
+
+	/**
+	 * @brief Send as many pending bytes as the socket accepts.
+	 * @param Client The client to write to.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 * @return False if the client must be disconnected.
+	 */
+	static bool FlushClient(FClient& Client, double NowSeconds);
+
+	/**
+	 * @brief Close and destroy the socket of a client.
+	 * @param Client The client to disconnect.
+	 */
+	static void Disconnect(FClient& Client);
+};
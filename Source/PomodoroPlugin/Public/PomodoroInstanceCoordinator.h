@@ -0,0 +1,156 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "PomodoroEngine.h"
+#include "PomodoroIpcServer.h"
+#include "PomodoroStatusPage.h"
+#include <atomic>
+
+/**
+ * Share a single timer between the editors running on this machine.
+ *
+ * The editor holding the leader lock file owns the clock, serves the IPC endpoint and writes the status page.
+ * The other editors follow it : they subscribe to its IPC endpoint, which only wakes them up on changes,
+ * and mirror the state written in the status page. Their commands are forwarded to the leading editor.
+ * When the leading editor closes, its lock is released, the followers see their connection closed
+ * and the first one taking the lock becomes the new leader.
+ *
+ * Only available where the IPC endpoint is, see WITH_POMODORO_IPC.
+ */
+class POMODOROPLUGIN_API FPomodoroInstanceCoordinator final
+	: public FRunnable
+	, public TSharedFromThis<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroInstanceCoordinator.
+	 * @param InEngine Engine of this editor, only used on the game thread.
+	 * @param InOnBecameLeader Called on the game thread when this editor becomes the leading one.
+	 */
+	FPomodoroInstanceCoordinator(TSharedRef<FPomodoroEngine> InEngine, FSimpleDelegate InOnBecameLeader);
+
+	/**
+	 * @brief Standard destructor for FPomodoroInstanceCoordinator, release the leadership if needed.
+	 */
+	virtual ~FPomodoroInstanceCoordinator() override;
+
+	/**
+	 * @brief Take the leadership if no other editor has it, otherwise follow the leading editor.
+	 *
+	 * When the leadership is taken, OnBecameLeader is called before returning.
+	 */
+	void Start();
+
+	/**
+	 * @brief Stop following and release the leadership.
+	 */
+	void Shutdown();
+
+	/**
+	 * @brief Indicate if this editor owns the timer.
+	 * @return True if this editor is the leading one.
+	 */
+	bool IsLeader() const;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/**
+	 * @brief Engine of this editor, only used on the game thread.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Called when this editor becomes the leading one.
+	 */
+	FSimpleDelegate OnBecameLeader;
+
+	/**
+	 * @brief Status page of the leading editor, mapped read only.
+	 */
+	FPomodoroStatusPage LeaderPage;
+
+	/**
+	 * @brief Descriptor of the leader lock file, only valid once the leadership is taken.
+	 */
+	int32 LockDescriptor = -1;
+
+	/**
+	 * @brief Connection to the leading editor IPC endpoint.
+	 */
+	int32 LeaderSocket = -1;
+
+	/**
+	 * @brief Guard the connection, commands are sent from the game thread.
+	 */
+	FCriticalSection LeaderSocketLock;
+
+	/**
+	 * @brief Self pipe used to wake the follower thread up.
+	 */
+	int32 WakePipe[2] = {-1, -1};
+
+	/**
+	 * @brief Thread following the leading editor.
+	 */
+	FRunnableThread* Thread = nullptr;
+
+	/**
+	 * @brief Set when the follower thread must exit.
+	 */
+	std::atomic<bool> bStopping{false};
+
+	/**
+	 * @brief Set once this editor is the leading one.
+	 */
+	std::atomic<bool> bLeader{false};
+
+	/**
+	 * @brief Try to take the leader lock without waiting.
+	 * @return True if this editor now holds the lock.
+	 */
+	bool TryLock();
+
+	/**
+	 * @brief Connect to the leading editor and subscribe to its changes.
+	 * @return True if connected.
+	 */
+	bool ConnectToLeader();
+
+	/**
+	 * @brief Close the connection to the leading editor.
+	 */
+	void DisconnectFromLeader();
+
+	/**
+	 * @brief Wait for the leading editor to push changes, until it goes away.
+	 */
+	void FollowLeader();
+
+	/**
+	 * @brief Read the leader status page and hand the state over to the game thread.
+	 */
+	void MirrorLeader();
+
+	/**
+	 * @brief Forward a requested state to the leading editor, called on the game thread.
+	 * @param RequestedState The state requested by the user.
+	 */
+	void RequestState(EPomodoroState RequestedState);
+
+	/**
+	 * @brief Turn this editor into the leading one, called on the game thread.
+	 */
+	void BecomeLeader();
+
+	/**
+	 * @brief Wait until the follower thread is woken up or the timeout expires.
+	 * @param TimeoutMilliseconds Maximum time to wait.
+	 */
+	void WaitForWakeUp(int32 TimeoutMilliseconds) const;
+};
@@ -0,0 +1,199 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/Runnable.h"
+#include "PomodoroSnapshot.h"
+#include <atomic>
+
+/** The IPC endpoint relies on Unix domain sockets */
+#define WITH_POMODORO_IPC (PLATFORM_LINUX || PLATFORM_MAC)
+
+/**
+ * Called on the server thread when a client sends a control command.
+ * The parameter is the POMODORO_IPC_OP_* opcode, the returned future tells if the command is accepted.
+ */
+DECLARE_DELEGATE_RetVal_OneParam(TFuture<bool>, FPomodoroIpcCommandHandler, uint8)
+
+/**
+ * Serve the engine state and control commands over a local Unix domain socket.
+ *
+ * The wire protocol is described in PomodoroIpcProtocol.h. The server runs on its own thread,
+ * only reads the engine through its snapshot channel and sleeps until a client talks,
+ * a new snapshot is published or a control command ran.
+ */
+class POMODOROPLUGIN_API FPomodoroIpcServer final : public FRunnable
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroIpcServer.
+	 * @param InSnapshotChannel Channel the served state is read from.
+	 * @param InCommandHandler Handler for control commands, called on the server thread.
+	 */
+	FPomodoroIpcServer(TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> InSnapshotChannel,
+		FPomodoroIpcCommandHandler InCommandHandler);
+
+	/**
+	 * @brief Standard destructor for FPomodoroIpcServer, close the server if needed.
+	 */
+	virtual ~FPomodoroIpcServer() override;
+
+	/**
+	 * @brief Bind the socket and start the server thread.
+	 * @param SocketPath Path of the Unix domain socket.
+	 * @return True if the server is listening, false if the socket can't be created
+	 * or is already served by another editor.
+	 */
+	bool Listen(const FString& SocketPath);
+
+	/**
+	 * @brief Stop the server thread, disconnect all clients and remove the socket.
+	 */
+	void Close();
+
+	/**
+	 * @brief Wake the server up so it pushes the last snapshot to subscribers.
+	 *
+	 * Can be called from any thread, never blocks.
+	 */
+	void NotifySnapshotChanged();
+
+	/**
+	 * @brief Give the socket path used when nothing else is configured.
+	 * @return Path of the socket in the user temporary directory.
+	 */
+	static FString GetDefaultSocketPath();
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/**
+	 * @brief Write end of the wake up pipe, shared with the command continuations that may outlive the server
+	 */
+	struct FWakeUp
+	{
+		FCriticalSection Lock;
+		int32 Descriptor = -1;
+	};
+
+	/**
+	 * @brief Outcome of a control command, set on the game thread once it ran
+	 */
+	struct FCommandOutcome
+	{
+		bool bAccepted = false;
+		std::atomic<bool> bDone{false};
+	};
+
+	/**
+	 * @brief State of a connected client
+	 */
+	struct FClient
+	{
+		/** Socket descriptor */
+		int32 Socket = -1;
+
+		/** Received bytes not forming a full request yet */
+		TArray<uint8> Input;
+
+		/** Bytes waiting for the socket to be writable */
+		TArray<uint8> Output;
+
+		/** Does the client want pushed frames */
+		bool bSubscribed = false;
+
+		/** Control command waited for and its opcode, the requests after it wait in Input */
+		TSharedPtr<FCommandOutcome, ESPMode::ThreadSafe> PendingCommand;
+		uint8 PendingOpcode = 0;
+	};
+
+	/**
+	 * @brief Channel the served state is read from.
+	 */
+	TSharedRef<const FPomodoroSnapshotChannel, ESPMode::ThreadSafe> SnapshotChannel;
+
+	/**
+	 * @brief Handler for control commands.
+	 */
+	FPomodoroIpcCommandHandler CommandHandler;
+
+	/**
+	 * @brief Path of the bound socket.
+	 */
+	FString SocketPath;
+
+	/**
+	 * @brief Listening socket descriptor.
+	 */
+	int32 ListenSocket = -1;
+
+	/**
+	 * @brief Self pipe used to wake the server thread up.
+	 */
+	int32 WakePipe[2] = {-1, -1};
+
+	/**
+	 * @brief Write end of the pipe, for the command continuations.
+	 */
+	TSharedRef<FWakeUp, ESPMode::ThreadSafe> WakeUp;
+
+	/**
+	 * @brief Connected clients, only used by the server thread.
+	 */
+	TArray<FClient> Clients;
+
+	/**
+	 * @brief Last snapshot version pushed to subscribers.
+	 */
+	uint64 PushedVersion = 0;
+
+	/**
+	 * @brief Server thread.
+	 */
+	FRunnableThread* Thread = nullptr;
+
+	/**
+	 * @brief Set when the server thread must exit.
+	 */
+	std::atomic<bool> bStopping{false};
+
+	/**
+	 * @brief Accept all pending connections.
+	 */
+	void AcceptClients();
+
+	/**
+	 * @brief Read the requests of a client.
+	 * @param Client The client to read from.
+	 * @return False if the client must be disconnected.
+	 */
+	bool ReadClient(FClient& Client);
+
+	/**
+	 * @brief Answer the requests of a client received so far, in order, up to a control command still running.
+	 * @param Client The client to answer.
+	 * @return False if the client must be disconnected.
+	 */
+	bool AnswerRequests(FClient& Client);
+
+	/**
+	 * @brief Send as many pending bytes as the socket accepts.
+	 * @param Client The client to write to.
+	 * @return False if the client must be disconnected.
+	 */
+	bool FlushClient(FClient& Client) const;
+
+	/**
+	 * @brief Push the last snapshot to every subscriber if it changed.
+	 */
+	void PushSnapshot();
+
+	/**
+	 * @brief Close every socket owned by the server.
+	 */
+	void CloseSockets();
+};
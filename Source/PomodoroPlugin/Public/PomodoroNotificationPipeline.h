@@ -0,0 +1,161 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+/**
+ * @brief Thread a notification sink must be called on
+ */
+enum class EPomodoroSinkThread : uint8
+{
+	/** Sink touching Slate, the editor or UObjects */
+	GameThread = 0,
+
+	/** Sink only doing its own work, called from a task graph worker */
+	AnyThread = 1,
+};
+
+/**
+ * @brief Timespan end handed over to the notification sinks
+ */
+struct FPomodoroBoundaryEvent
+{
+	/** Incremented for each timespan end, starting from 1 */
+	uint64 Sequence = 0;
+
+	/** Was the elapsed timespan a working timespan */
+	bool bWorkingTime = false;
+
+	/** UTC time at which the timespan ended */
+	FDateTime TimeUtc;
+};
+
+DECLARE_DELEGATE_OneParam(FPomodoroNotificationSinkDelegate, const FPomodoroBoundaryEvent&)
+
+/**
+ * Deliver the timespan ends to the notification sinks, outside of the engine broadcast.
+ *
+ * The engine only enqueues the event, which costs a copy and a queue push.
+ * Sinks bound to the game thread are called on the next game thread task, in the order they were added.
+ * Sinks bound to any thread are called from a single task graph task draining the queue,
+ * so a given sink always sees the events in order and never concurrently.
+ * Sinks are added, removed and events enqueued on the game thread.
+ */
+class POMODOROPLUGIN_API FPomodoroNotificationPipeline final : public TSharedFromThis<FPomodoroNotificationPipeline, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * @brief Delegate to bind to the engine timespan end.
+	 */
+	FElapsedTimespanHandleDelegate ElapsedTimespanHandleDelegate;
+
+	/**
+	 * @brief Standard constructor for FPomodoroNotificationPipeline.
+	 */
+	FPomodoroNotificationPipeline();
+
+	/**
+	 * @brief Standard destructor for FPomodoroNotificationPipeline.
+	 *
+	 * Dispatch tasks hold the pipeline, so it is only destroyed once none is running.
+	 */
+	~FPomodoroNotificationPipeline();
+
+	/**
+	 * @brief Add a sink called on each timespan end.
+	 * @param Thread Thread the sink must be called on.
+	 * @param Sink The sink, it must stay valid until removed or until the pipeline is shut down.
+	 * @return Handle used to remove the sink.
+	 */
+	FDelegateHandle AddSink(EPomodoroSinkThread Thread, FPomodoroNotificationSinkDelegate Sink);
+
+	/**
+	 * @brief Remove a sink, once this returns it isn't called anymore.
+	 * @param Handle Handle returned when the sink was added.
+	 */
+	void RemoveSink(FDelegateHandle Handle);
+
+	/**
+	 * @brief Enqueue a timespan end for the sinks, returns without calling any of them.
+	 * @param bWorkingTime Was the elapsed timespan a working timespan.
+	 */
+	void Enqueue(bool bWorkingTime);
+
+	/**
+	 * @brief Stop delivering events and wait for the sinks currently called.
+	 */
+	void Shutdown();
+
+private:
+	/**
+	 * @brief Registered sink.
+	 */
+	struct FSink
+	{
+		EPomodoroSinkThread Thread;
+		FPomodoroNotificationSinkDelegate Delegate;
+	};
+
+	/**
+	 * @brief Sinks, replaced as a whole on change so callers read a stable list without holding the lock.
+	 */
+	TSharedPtr<const TArray<FSink>, ESPMode::ThreadSafe> Sinks;
+
+	/**
+	 * @brief Guard the sink list.
+	 */
+	mutable FCriticalSection SinksLock;
+
+	/**
+	 * @brief Events waiting for the any thread sinks, only pushed from the game thread.
+	 */
+	TQueue<FPomodoroBoundaryEvent, EQueueMode::Spsc> PendingEvents;
+
+	/**
+	 * @brief Set while a task drains PendingEvents.
+	 */
+	std::atomic<bool> bDispatching{false};
+
+	/**
+	 * @brief Set once the pipeline doesn't deliver anymore.
+	 */
+	std::atomic<bool> bShutdown{false};
+
+	/**
+	 * @brief Last task draining PendingEvents, only used on the game thread.
+	 */
+	TFuture<void> DispatchTask;
+
+	/**
+	 * @brief Sequence number of the last event.
+	 */
+	uint64 LastSequence = 0;
+
+	/**
+	 * @brief Give the current sink list.
+	 * @return The sink list.
+	 */
+	TSharedPtr<const TArray<FSink>, ESPMode::ThreadSafe> GetSinks() const;
+
+	/**
+	 * @brief Call the sinks of a thread for an event.
+	 * @param Thread Thread the sinks are called on.
+	 * @param Event The event.
+	 */
+	void CallSinks(EPomodoroSinkThread Thread, const FPomodoroBoundaryEvent& Event) const;
+
+	/**
+	 * @brief Start a task draining PendingEvents if none is running.
+	 */
+	void ScheduleDispatch();
+
+	/**
+	 * @brief Call the any thread sinks for every pending event, run by the task graph.
+	 */
+	void Dispatch();
+};
@@ -3,7 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "PomodoroEngine.h"
+#include "PomodoroNotificationPipeline.h"
+#include "UObject/StrongObjectPtr.h"
 
 /**
  * Notifier used to announce when a timespan has ended
@@ -12,11 +13,6 @@ class POMODOROPLUGIN_API FPomodoroNotifier final : public TSharedFromThis<FPomod
 {
 public:
 
-	/**
-	 * @brief Delegate used to detect when timespan is elapsed
-	 */
-	FElapsedTimespanHandleDelegate ElapsedTimespanHandleDelegate;	
-	
 	/**
 	 * @brief Standard constructor for FPomodoroNotifier
 	 */
@@ -29,10 +25,10 @@ public:
 	
 	/**
 	 * @brief Launch a notification indicating that the timespan
-	 * has ended with a message and a sound
-	 * @param bWorkingTime Was the timespan a working timespan 
+	 * has ended with a message and a sound, called by the notification pipeline on the game thread
+	 * @param Event The timespan end
 	 */
-	void Notify(const bool bWorkingTime);
+	void Notify(const FPomodoroBoundaryEvent& Event);
 	
 	/**
 	 * @brief Set the state of sound notification
@@ -52,6 +48,11 @@ public:
 	 */
 	ECheckBoxState GetNotificationSoundState() const;
 
+	/**
+	 * @brief Start streaming the notification sound, so the first notification doesn't load it
+	 */
+	void PreloadSound();
+
 	/**
 	 * @brief Reset the current configuration of this notifier
 	 */
@@ -69,6 +70,12 @@ public:
 	
 private:
 	
+	/**
+	 * @brief Build and show the notification toast
+	 * @param TextToDisplay Message of the toast
+	 */
+	static void ShowToast(const FText& TextToDisplay);
+
 	/**
 	 * @brief Some cheering message to go back to work.
 	 */
@@ -83,4 +90,9 @@ private:
 	 * @brief Used to know if the sound is activated for notifications
 	 */
 	ECheckBoxState ActivateSound = ECheckBoxState::Checked;
+
+	/**
+	 * @brief Notification sound, kept loaded once streamed
+	 */
+	TStrongObjectPtr<UObject> Sound;
 };
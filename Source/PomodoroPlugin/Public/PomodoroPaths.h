@@ -0,0 +1,23 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace PomodoroPaths
+{
+	/**
+	 * @brief Give the path of a per user file shared by the editors of this machine and by external tools.
+	 * @param Extension Extension of the file, telling what it is used for.
+	 * @return Path of the file in the user runtime directory, or in the user temporary directory.
+	 */
+	inline FString GetUserRuntimeFile(const TCHAR* Extension)
+	{
+		FString Directory = FPlatformMisc::GetEnvironmentVariable(TEXT("XDG_RUNTIME_DIR"));
+		if(Directory.IsEmpty())
+		{
+			Directory = FPlatformProcess::UserTempDir();
+		}
+		return FPaths::Combine(Directory, FString::Printf(TEXT("pomodoro-%s.%s"), FPlatformProcess::UserName(), Extension));
+	}
+}
@@ -3,11 +3,49 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "PomodoroCore.h"
 #include "PomodoroEngine.h"
 #include "PomodoroNotifier.h"
+#include "PomodoroIpcServer.h"
+#include "PomodoroHttpServer.h"
+#include "PomodoroStatusPage.h"
+#include "PomodoroInstanceCoordinator.h"
+#include "PomodoroSyncClient.h"
+#include "PomodoroDayPlanner.h"
+#include "PomodoroAdaptiveDurations.h"
+#include "PomodoroTaskTracker.h"
+#include "PomodoroFocusHistory.h"
+#include "PomodoroPhaseHistory.h"
+#include "PomodoroPercentiles.h"
+#include "PomodoroPhaseNotes.h"
+#include "PomodoroDeferredWork.h"
 
 class FToolBarBuilder;
 class FMenuBuilder;
+class FConfigFile;
+
+/**
+ * Files read on a worker once the editor is up, handed over to the module on the game thread.
+ */
+struct FPomodoroStartupFiles
+{
+	/** Path of the config file and its content, null when there is none yet */
+	FString ConfigPath;
+	TSharedPtr<FConfigFile, ESPMode::ThreadSafe> ConfigFile;
+
+	/** Tasks of the export file named by the config, if it could be read */
+	bool bTasksRead = false;
+	FPomodoroTaskList Tasks;
+
+	/** Saved phase history, percentiles and indexed notes */
+	FPomodoroPhaseHistoryFile PhaseHistory;
+	FPomodoroPercentileSet Percentiles;
+	FPomodoroPhaseNotesFile PhaseNotes;
+
+	/** Time spent reading them on the worker */
+	double ReadSeconds = 0.0;
+};
 
 class FPomodoroPluginModule final : public IModuleInterface
 {
@@ -21,19 +59,163 @@ public:
 	
 private:
 
+	/**
+	 * @brief Run the work the components postpone, when the editor has time to spare.
+	 */
+	TUniquePtr<FPomodoroDeferredWork> DeferredWork;
+
 	/**
 	 * @brief Pomodoro engine that will run the timer
 	 */
 	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Record the engine inputs, for the sessions to be replayed.
+	 */
+	TSharedPtr<FPomodoroSessionLog> SessionLog;
 	
 	/**
 	 * @brief Notifier that will display information related to Pomodoro Engine.
 	 */
 	TSharedPtr<FPomodoroNotifier> Notifier;
 
+	/**
+	 * @brief Deliver the timespan ends to the notifier and the other sinks, outside of the engine.
+	 */
+	TSharedPtr<FPomodoroNotificationPipeline, ESPMode::ThreadSafe> NotificationPipeline;
+
+	/**
+	 * @brief Local endpoint serving the engine state to external tools.
+	 */
+	TUniquePtr<FPomodoroIpcServer> IpcServer;
+
+	/**
+	 * @brief Loopback HTTP endpoint serving the engine state to browser dashboards and scripts.
+	 */
+	TUniquePtr<FPomodoroHttpServer> HttpServer;
+
+	/**
+	 * @brief Shared memory page publishing the engine state to other processes.
+	 */
+	TUniquePtr<FPomodoroStatusPage> StatusPage;
+
+	/**
+	 * @brief Share the timer with the other editors running on this machine.
+	 */
+	TSharedPtr<FPomodoroInstanceCoordinator, ESPMode::ThreadSafe> Coordinator;
+
+	/**
+	 * @brief Share the timer with a team through a relay.
+	 */
+	TSharedPtr<FPomodoroSyncClient, ESPMode::ThreadSafe> SyncClient;
+
+	/**
+	 * @brief Plan the timespans of the day around the fixed commitments.
+	 */
+	TSharedPtr<FPomodoroDayPlanner> Planner;
+
+	/**
+	 * @brief Learn the timespan lengths suiting the user.
+	 */
+	TSharedPtr<FPomodoroAdaptiveDurations> AdaptiveDurations;
+
+	/**
+	 * @brief Attribute the focus time to tasks.
+	 */
+	TSharedPtr<FPomodoroTaskTracker, ESPMode::ThreadSafe> TaskTracker;
+
+	/**
+	 * @brief Focus time of every day.
+	 */
+	TSharedPtr<FPomodoroFocusHistory> FocusHistory;
+
+	/**
+	 * @brief Every timespan run, kept compacted over the years.
+	 */
+	TSharedPtr<FPomodoroPhaseHistory> PhaseHistory;
+
+	/**
+	 * @brief Notes attached to the timespans, and their search index.
+	 */
+	TSharedPtr<FPomodoroPhaseNotes> PhaseNotes;
+
+	/**
+	 * @brief Percentiles of the pauses, overruns and interruptions of each day.
+	 */
+	TSharedPtr<FPomodoroPercentiles> Percentiles;
+
+	/**
+	 * @brief Countdown added to the level editor toolbar.
+	 */
+	TSharedPtr<class SPomodoroCountdown> Countdown;
+
 	TSharedPtr<class FUICommandList> PluginCommands;
+
+	/**
+	 * @brief Config and data files read on a worker after the engine init.
+	 */
+	TFuture<void> ConfigPrefetch;
+
+	/**
+	 * @brief Time spent in StartupModule, while the editor boots.
+	 */
+	double StartupSeconds = 0.0;
+
+	/**
+	 * @brief Set once the module is shutting down, the deferred startup must not run anymore.
+	 */
+	bool bShuttingDown = false;
 	
 	void RegisterMenus();
+
+	/**
+	 * @brief Add the countdown to the level editor toolbar, once the engine exists.
+	 */
+	void RegisterCountdown();
+
+	/**
+	 * @brief Start reading the config and the data files on a worker, once the editor is up.
+	 */
+	void OnPostEngineInit();
+
+	/**
+	 * @brief Create the engine and its components, on the game thread once the files are read.
+	 * @param Files The files read on the worker, moved into the components.
+	 */
+	void CompleteStartup(FPomodoroStartupFiles& Files);
+
+	/**
+	 * @brief Start serving the engine state to other processes, once this editor owns the timer.
+	 */
+	void StartLeaderServices();
+
+	/**
+	 * @brief Forward a control command received by the IPC endpoint to the engine.
+	 *
+	 * Called on the IPC server thread, the command is run on the game thread unless it is stalled for too long.
+	 * @param Opcode The POMODORO_IPC_OP_* command.
+	 * @return Future set to true if the command was applied in time, false if rejected, timed out, or unknown.
+	 */
+	TFuture<bool> HandleIpcCommand(uint8 Opcode);
+
+	/**
+	 * @brief Forward a control request received by the HTTP endpoint to the engine.
+	 *
+	 * Called on the HTTP server thread, the request is run on the game thread unless it is stalled for too long.
+	 * @param Command The control request.
+	 * @return Future set to true if the request was applied in time, false if rejected, timed out, or unknown.
+	 */
+	TFuture<bool> HandleHttpCommand(const FPomodoroHttpCommand& Command);
+
+	/**
+	 * @brief Called each time the engine publishes a new snapshot.
+	 */
+	void OnEngineSnapshotPublished() const;
+
+	/**
+	 * @brief Plan the rest of the day again, from the current engine state.
+	 */
+	void ReplanDay() const;
 	
 	/**
 	 * @brief Function triggered when the plugin tab is spawned.
@@ -42,6 +224,27 @@ private:
 	 */
 	TSharedRef<class SDockTab> OnSpawnPluginTab(const class FSpawnTabArgs& SpawnTabArgs) const;
 	
+	/**
+	 * @brief Used to generate a collapsible section of the plugin tab
+	 * @param Title Title of the section
+	 * @param bInitiallyCollapsed Is the section collapsed when the tab opens
+	 * @param SpawnBody Generate the content of the section, called the first time it is expanded
+	 * @return The section
+	 */
+	TSharedRef<class SWidget> SpawnSection(const FText& Title, bool bInitiallyCollapsed, TFunction<TSharedRef<SWidget>()> SpawnBody) const;
+
+	/**
+	 * @brief Used to generate a row of spin boxes editing a draft, committed to the engine once the edit ends
+	 * @param Label Label of the row
+	 * @param FieldCount Number of spin boxes, up to 3 : a count, or hours, minutes and seconds
+	 * @param FirstMaxValue Maximum value of the first spin box, the others go up to 59
+	 * @param ReadValues Read the current values from the engine
+	 * @param CommitValues Commit the edited values to the engine
+	 * @return The row
+	 */
+	TSharedRef<class SWidget> SpawnDraftRow(const FText& Label, int32 FieldCount, int32 FirstMaxValue,
+		TFunction<void(int32*)> ReadValues, TFunction<void(const int32*)> CommitValues) const;
+
 	/**
 	 * @brief Used to generate the informational part of plugin tab  
 	 * @return The information part of the tab
@@ -53,6 +256,24 @@ private:
 	 * @return The button part of the tab
 	 */
 	TSharedRef<class SBoxPanel> SpawnButtons() const;
+
+	/**
+	 * @brief Used to generate the task picker part of plugin tab  
+	 * @return The task picker part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnTaskPicker() const;
+
+	/**
+	 * @brief Used to generate the focus trends part of plugin tab  
+	 * @return The focus trends part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnTrends() const;
+
+	/**
+	 * @brief Used to generate the notes part of plugin tab  
+	 * @return The notes part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnNotes() const;
 	
 	/**
 	 * @brief Used to generate the engine configuration part of plugin tab  
@@ -65,4 +286,22 @@ private:
 	 * @return The notifier configuration part of the tab
 	 */
 	TSharedRef<class SBoxPanel> SpawnNotificationConfig() const;
+
+	/**
+	 * @brief Used to generate the team sync configuration part of plugin tab  
+	 * @return The team sync configuration part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnSyncConfig() const;
+
+	/**
+	 * @brief Used to generate the day planner part of plugin tab  
+	 * @return The day planner part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnDayPlanner() const;
+
+	/**
+	 * @brief Used to generate the adaptive timespans part of plugin tab  
+	 * @return The adaptive timespans part of the tab
+	 */
+	TSharedRef<class SBoxPanel> SpawnAdaptiveDurations() const;
 };
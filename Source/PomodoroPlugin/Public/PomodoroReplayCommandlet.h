@@ -0,0 +1,28 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PomodoroReplayCommandlet.generated.h"
+
+/**
+ * Replay recorded engine sessions and check they lead to the recorded timespan ends.
+ *
+ * Usage : UnrealEditor-Cmd <Project> -run=PomodoroReplay [-Log=<Path>]
+ * Without -Log, every session recorded in Saved/Pomodoro/Sessions is replayed.
+ */
+UCLASS()
+class POMODOROPLUGIN_API UPomodoroReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	public:
+	/**
+	 * @brief Standard constructor for UPomodoroReplayCommandlet.
+	 */
+	UPomodoroReplayCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,108 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Thin layer over the platform TCP sockets for the servers waiting on many connections at once.
+ *
+ * FSocket can only wait on itself, a server blocking on it has to poll its other connections. These
+ * functions expose the native handles instead, so a server thread sleeps in a single poll on its
+ * listen socket, its clients and a wake socket until one of them is ready.
+ */
+namespace PomodoroSockets
+{
+#if PLATFORM_WINDOWS
+	/** Native socket, a SOCKET */
+	using FHandle = UPTRINT;
+	constexpr FHandle InvalidHandle = ~static_cast<UPTRINT>(0);
+#else
+	/** Native socket, a file descriptor */
+	using FHandle = int32;
+	constexpr FHandle InvalidHandle = -1;
+#endif
+
+	/**
+	 * @brief A socket waited for by Poll.
+	 */
+	struct FPollEntry
+	{
+		FHandle Handle = InvalidHandle;
+
+		/** Wait for the socket to be writable as well as readable */
+		bool bWrite = false;
+
+		/** Set by Poll when the socket is readable, writable, closed or in error */
+		bool bReady = false;
+	};
+
+	/**
+	 * @brief Create a non blocking TCP socket listening on a port.
+	 * @param Port Port to listen on.
+	 * @param bLoopbackOnly Bind the loopback interface only instead of every interface.
+	 * @param bReusable Allow binding a port left in TIME_WAIT by a previous process.
+	 * @param Backlog Maximum number of connections waiting to be accepted.
+	 * @return The listening socket, InvalidHandle on failure.
+	 */
+	FHandle Listen(int32 Port, bool bLoopbackOnly, bool bReusable, int32 Backlog);
+
+	/**
+	 * @brief Accept a pending connection as a non blocking socket without Nagle's algorithm.
+	 * @param ListenHandle The listening socket.
+	 * @return The connection, InvalidHandle when none is pending.
+	 */
+	FHandle Accept(FHandle ListenHandle);
+
+	/**
+	 * @brief Receive the available bytes of a non blocking socket.
+	 * @param Handle The socket to read.
+	 * @param Data Buffer receiving the bytes.
+	 * @param Size Size of the buffer.
+	 * @return Number of bytes received, 0 when none is available, -1 when the connection is closed.
+	 */
+	int32 Recv(FHandle Handle, uint8* Data, int32 Size);
+
+	/**
+	 * @brief Send bytes on a non blocking socket.
+	 * @param Handle The socket to write.
+	 * @param Data Bytes to send.
+	 * @param Size Number of bytes to send.
+	 * @return Number of bytes sent, 0 when the socket is full, -1 when the connection is closed.
+	 */
+	int32 Send(FHandle Handle, const uint8* Data, int32 Size);
+
+	/**
+	 * @brief Close a socket and reset its handle.
+	 * @param Handle The socket to close, left untouched when invalid.
+	 */
+	void Close(FHandle& Handle);
+
+	/**
+	 * @brief Block until one of the sockets is ready or the timeout runs out.
+	 * @param Entries Sockets to wait for, their bReady flag is updated.
+	 * @param TimeoutMilliseconds Longest wait, negative to wait until a socket is ready.
+	 * @return False if the wait failed, interrupted waits are not failures.
+	 */
+	bool Poll(TArray<FPollEntry>& Entries, int32 TimeoutMilliseconds);
+
+	/**
+	 * @brief Create a loopback datagram socket connected to itself, readable once woken up.
+	 *
+	 * Added to the polls of a server thread so other threads can wake it up.
+	 * @return The wake socket, InvalidHandle on failure.
+	 */
+	FHandle OpenWakeSocket();
+
+	/**
+	 * @brief Make a wake socket readable, can be called from any thread and never blocks.
+	 * @param WakeHandle The wake socket.
+	 */
+	void Wake(FHandle WakeHandle);
+
+	/**
+	 * @brief Read the pending wake ups so the wake socket is no longer readable.
+	 * @param WakeHandle The wake socket.
+	 */
+	void DrainWake(FHandle WakeHandle);
+}
@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroSnapshot.h"
+
+struct pomodoro_status_page;
+
+/**
+ * Publish the engine state to a small memory mapped file other processes can read without system calls.
+ *
+ * The page layout and the reader side are described in PomodoroStatusPageLayout.h.
+ * The page file is locked while mapped for writing, so a single editor writes it at a time.
+ * Other editors can map it for reading to mirror the state of the writing one.
+ */
+class POMODOROPLUGIN_API FPomodoroStatusPage final
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroStatusPage.
+	 */
+	FPomodoroStatusPage();
+
+	/**
+	 * @brief Standard destructor for FPomodoroStatusPage, close the page if needed.
+	 */
+	~FPomodoroStatusPage();
+
+	/**
+	 * @brief Create or open the page file, lock it and map it.
+	 * @param PagePath Path of the page file.
+	 * @return True if the page is mapped, false if it can't be created or is written by another editor.
+	 */
+	bool Open(const FString& PagePath);
+
+	/**
+	 * @brief Open an existing page file and map it read only, without locking it.
+	 * @param PagePath Path of the page file.
+	 * @return True if the page is mapped.
+	 */
+	bool OpenForReading(const FString& PagePath);
+
+	/**
+	 * @brief Unmap and unlock the page file.
+	 */
+	void Close();
+
+	/**
+	 * @brief Indicate if the page is mapped.
+	 * @return True if the page is mapped.
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * @brief Write a snapshot into the page.
+	 * @param Snapshot The snapshot to write.
+	 */
+	void Write(const FPomodoroEngineSnapshot& Snapshot);
+
+	/**
+	 * @brief Read the last snapshot written into the page.
+	 * @param OutSnapshot The snapshot read.
+	 * @return True if the page holds a snapshot.
+	 */
+	bool Read(FPomodoroEngineSnapshot& OutSnapshot) const;
+
+	/**
+	 * @brief Give the page path used when nothing else is configured.
+	 * @return Path of the page in the user temporary directory.
+	 */
+	static FString GetDefaultPagePath();
+
+private:
+	/**
+	 * @brief Mapped page, null when closed.
+	 */
+	pomodoro_status_page* Page;
+
+	/**
+	 * @brief Was the page opened for writing.
+	 */
+	bool bWritable;
+
+#if PLATFORM_WINDOWS
+	/**
+	 * @brief Handles of the page file and of its mapping.
+	 */
+	void* FileHandle;
+	void* MappingHandle;
+#else
+	/**
+	 * @brief Descriptor of the page file.
+	 */
+	int32 FileDescriptor;
+#endif
+};
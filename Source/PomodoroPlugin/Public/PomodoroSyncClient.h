@@ -0,0 +1,250 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "PomodoroEngine.h"
+#include "PomodoroSyncProtocol.h"
+#include <atomic>
+
+class FSocket;
+
+/**
+ * Share the timer of this editor with a team, through a relay.
+ *
+ * Only user changes are sent : starting, pausing, stopping or configuring the timer. Every member then computes
+ * the end of the timespans locally from the shared deadline, so the relay sees no traffic while the timer runs.
+ * The clock offset to the relay is estimated from the round trip of pings, keeping the fastest one, and the deadlines
+ * are converted between the relay and the local clocks.
+ *
+ * Only the editor owning the timer on this machine connects, the other ones follow it.
+ */
+class POMODOROPLUGIN_API FPomodoroSyncClient final
+	: public FRunnable
+	, public TSharedFromThis<FPomodoroSyncClient, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroSyncClient, load the last saved configuration.
+	 * @param InEngine Engine of this editor, only used on the game thread.
+	 */
+	explicit FPomodoroSyncClient(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Standard destructor for FPomodoroSyncClient, disconnect if needed.
+	 */
+	virtual ~FPomodoroSyncClient() override;
+
+	/**
+	 * @brief Connect to the relay when the team sync is activated, disconnect otherwise.
+	 *
+	 * Called once this editor owns the timer, and after each configuration change.
+	 */
+	void Restart();
+
+	/**
+	 * @brief Disconnect from the relay.
+	 */
+	void Shutdown();
+
+	/**
+	 * @brief Indicate if the relay is connected.
+	 * @return True if connected to the relay.
+	 */
+	bool IsConnected() const;
+
+	/**
+	 * @brief Set the activation of the team sync, applied on next restart.
+	 * @param NewValue Checked to share the timer.
+	 */
+	void SetSyncState(ECheckBoxState NewValue);
+
+	/**
+	 * @brief Used to get the activation of the team sync.
+	 * @return Checked if the timer is shared.
+	 */
+	ECheckBoxState GetSyncState() const;
+
+	/**
+	 * @brief Set the address of the relay, applied on next restart.
+	 * @param NewValue Host name or IP address, optionally followed by a colon and the port.
+	 */
+	void SetRelayAddress(const FString& NewValue);
+
+	/**
+	 * @brief Used to get the address of the relay.
+	 * @return The address of the relay.
+	 */
+	const FString& GetRelayAddress() const;
+
+	/**
+	 * @brief Set the name of the group sharing the timer, applied on next restart.
+	 * @param NewValue Name of the group, case insensitive.
+	 */
+	void SetGroupName(const FString& NewValue);
+
+	/**
+	 * @brief Used to get the name of the group sharing the timer.
+	 * @return The name of the group.
+	 */
+	const FString& GetGroupName() const;
+
+	/**
+	 * @brief Reset the current configuration of the team sync.
+	 */
+	void ResetConfig();
+
+	/**
+	 * @brief Reload the current configuration of the team sync to the last one saved.
+	 */
+	void ReloadConfig();
+
+	/**
+	 * @brief Save the current configuration of the team sync.
+	 */
+	void SaveConfig() const;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/**
+	 * @brief Engine of this editor, only used on the game thread.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Configuration, only used on the game thread.
+	 */
+	ECheckBoxState SyncState = ECheckBoxState::Unchecked;
+	FString RelayAddress;
+	FString GroupName;
+
+	/**
+	 * @brief Address and group of the running connection, set before the thread starts.
+	 */
+	FString ConnectedAddress;
+	uint64 Group = 0;
+
+	/**
+	 * @brief Random identifier of this client, to recognize its own messages.
+	 */
+	uint32 SenderId;
+
+	/**
+	 * @brief Connection to the relay.
+	 */
+	FSocket* Socket = nullptr;
+
+	/**
+	 * @brief Guard the connection, states are sent from the game thread.
+	 */
+	FCriticalSection SocketLock;
+
+	/**
+	 * @brief Relay clock minus local clock, in milliseconds.
+	 */
+	std::atomic<int64> ClockOffset{0};
+
+	/**
+	 * @brief Round trip of the ping the clock offset comes from, only used by the client thread.
+	 */
+	int64 BestRoundTrip = MAX_int64;
+
+	/**
+	 * @brief Pings left in the current burst, only used by the client thread.
+	 */
+	int32 BurstPingsLeft = 0;
+
+	/**
+	 * @brief Last snapshot published by the engine, only used on the game thread.
+	 */
+	FPomodoroEngineSnapshot LastSnapshot;
+
+	/**
+	 * @brief Set while a remote state is applied, to not send it back.
+	 */
+	bool bApplyingRemoteState = false;
+
+	/**
+	 * @brief Handle of the binding to the engine snapshots.
+	 */
+	FDelegateHandle SnapshotPublishedHandle;
+
+	/**
+	 * @brief Thread receiving the messages of the relay.
+	 */
+	FRunnableThread* Thread = nullptr;
+
+	/**
+	 * @brief Wake the client thread up while it waits before reconnecting.
+	 */
+	FEvent* WakeEvent = nullptr;
+
+	/**
+	 * @brief Set when the client thread must exit.
+	 */
+	std::atomic<bool> bStopping{false};
+
+	/**
+	 * @brief Set while the relay is connected.
+	 */
+	std::atomic<bool> bConnected{false};
+
+	/**
+	 * @brief Set once the group is joined, states are only sent after that.
+	 */
+	std::atomic<bool> bJoined{false};
+
+	/**
+	 * @brief Resolve the relay address and connect to it.
+	 * @return True if connected.
+	 */
+	bool Connect();
+
+	/**
+	 * @brief Close the connection to the relay.
+	 */
+	void Disconnect();
+
+	/**
+	 * @brief Receive the messages of the relay until the connection is closed.
+	 */
+	void ReceiveMessages();
+
+	/**
+	 * @brief Handle a message received from the relay, on the client thread.
+	 * @param Message The message received.
+	 */
+	void HandleMessage(const PomodoroSync::FMessage& Message);
+
+	/**
+	 * @brief Send a message to the relay, from any thread.
+	 * @param Message The message to send.
+	 * @return True if the whole message is sent.
+	 */
+	bool SendMessage(const PomodoroSync::FMessage& Message);
+
+	/**
+	 * @brief Send a ping carrying the local clock.
+	 */
+	void SendPing();
+
+	/**
+	 * @brief Send a few pings one after the other, the fastest round trip gives the clock offset.
+	 */
+	void StartPingBurst();
+
+	/**
+	 * @brief Send the engine state when a user changed it, called on the game thread.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Apply the state of the group to the engine, called on the game thread.
+	 * @param Snapshot The state of the group, deadline in the local clock.
+	 */
+	void ApplyGroupState(const FPomodoroEngineSnapshot& Snapshot);
+};
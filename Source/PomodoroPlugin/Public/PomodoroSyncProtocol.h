@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Messages exchanged between the team sync clients and the relay, over TCP.
+ *
+ * Every message has the same fixed size, its fields are written one after the other in declaration order,
+ * little endian, whatever the byte order of the machine. A state message is only sent when a user
+ * starts, pauses or stops the timer or changes its configuration : timespan ends are computed locally
+ * by every editor from the shared deadline and configuration, so nothing is streamed while the timer counts down.
+ * Times are milliseconds since the Unix epoch, deadlines are expressed in the relay clock.
+ */
+namespace PomodoroSync
+{
+	constexpr uint32 Magic = 0x59534D50; // "PMSY"
+	constexpr uint8 Version = 1;
+
+	/** Port the relay listens on by default */
+	constexpr int32 DefaultPort = 47250;
+
+	/** Kind of message */
+	enum class EMessageType : uint8
+	{
+		/** Client to relay : join the group */
+		Hello = 1,
+
+		/** Client to relay : ask for the relay clock, TimeA is the client clock */
+		Ping = 2,
+
+		/** Relay to client : TimeA is echoed, TimeB is the relay clock */
+		Pong = 3,
+
+		/** Both ways : new state of the group timer, TimeA is the deadline in relay clock */
+		State = 4,
+	};
+
+	/** Single message, the meaning of TimeA and TimeB depends on its type */
+	struct FMessage
+	{
+		uint32 Magic = PomodoroSync::Magic;
+		uint8 Version = PomodoroSync::Version;
+		EMessageType Type = EMessageType::Hello;
+		uint8 State = 0;
+		uint8 Phase = 0;
+		uint64 Group = 0;
+		int64 TimeA = 0;
+		int64 TimeB = 0;
+		int64 RemainingMilliseconds = 0;
+		uint32 SenderId = 0;
+		int32 CurrentCycle = 0;
+		int32 CycleCount = 0;
+		int32 WorkingSeconds = 0;
+		int32 ShortRestingSeconds = 0;
+		int32 LongRestingSeconds = 0;
+	};
+
+	/** Size of a message on the wire */
+	constexpr int32 MessageSize = 64;
+
+	/**
+	 * @brief Write a message in its wire layout.
+	 * @param Message The message to write.
+	 * @param OutBytes Receives the MessageSize bytes of the message.
+	 */
+	POMODOROPLUGIN_API void EncodeMessage(const FMessage& Message, uint8* OutBytes);
+
+	/**
+	 * @brief Read a message from its wire layout.
+	 * @param Bytes The MessageSize bytes of the message.
+	 * @return The message, its magic and version are not checked.
+	 */
+	POMODOROPLUGIN_API FMessage DecodeMessage(const uint8* Bytes);
+
+	/**
+	 * @brief Give the group identifier sent over the network for a group name.
+	 * @param GroupName Name of the group, case insensitive.
+	 * @return The group identifier.
+	 */
+	POMODOROPLUGIN_API uint64 HashGroupName(const FString& GroupName);
+
+	/**
+	 * @brief Give the current time as used in the messages.
+	 * @return Milliseconds since the Unix epoch.
+	 */
+	POMODOROPLUGIN_API int64 NowMilliseconds();
+
+	/**
+	 * @brief Move a running group state past the timespans that ended since it was sent, as every member did by itself.
+	 * @param Message The state message, its deadline in relay clock.
+	 * @param Now Current time in relay clock.
+	 * @return The state of the timespan running at Now, unchanged if the timer is not running or its deadline is ahead.
+	 */
+	POMODOROPLUGIN_API FMessage FastForward(const FMessage& Message, int64 Now);
+}
@@ -0,0 +1,134 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "PomodoroSockets.h"
+#include "PomodoroSyncProtocol.h"
+#include <atomic>
+
+/**
+ * Relay forwarding the timer state between the members of a team.
+ *
+ * Clients join a group, every state sent by a member is forwarded to the other members of its group
+ * and kept to be sent to the members joining later. The relay also answers the clock pings of the clients,
+ * its clock is the reference of the group. It runs on its own thread sleeping in a single poll on every
+ * connection, see UPomodoroSyncRelayCommandlet.
+ */
+class POMODOROPLUGIN_API FPomodoroSyncRelay final : public FRunnable
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroSyncRelay.
+	 */
+	FPomodoroSyncRelay();
+
+	/**
+	 * @brief Standard destructor for FPomodoroSyncRelay, close the relay if needed.
+	 */
+	virtual ~FPomodoroSyncRelay() override;
+
+	/**
+	 * @brief Listen on the given port on every interface and start the relay thread.
+	 * @param Port The TCP port to listen on.
+	 * @return True if the relay is listening.
+	 */
+	bool Listen(int32 Port);
+
+	/**
+	 * @brief Stop the relay thread and disconnect every client.
+	 */
+	void Close();
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/**
+	 * @brief A connected client.
+	 */
+	struct FClient
+	{
+		PomodoroSockets::FHandle Socket = PomodoroSockets::InvalidHandle;
+
+		/** Group joined by the client, zero until its hello is received */
+		uint64 Group = 0;
+
+		/** Bytes received but not yet forming a whole message */
+		TArray<uint8> Input;
+
+		/** Set when a message can't be sent or the connection is closed, the client is disconnected once all are read */
+		bool bDropped = false;
+	};
+
+	/**
+	 * @brief Socket accepting the clients.
+	 */
+	PomodoroSockets::FHandle ListenSocket;
+
+	/**
+	 * @brief Socket waking the relay thread up when it must stop.
+	 */
+	PomodoroSockets::FHandle WakeSocket;
+
+	/**
+	 * @brief Connected clients, only used by the relay thread.
+	 */
+	TArray<FClient> Clients;
+
+	/**
+	 * @brief Last state sent in each group, only used by the relay thread.
+	 */
+	TMap<uint64, PomodoroSync::FMessage> GroupStates;
+
+	/**
+	 * @brief Sockets waited for by the relay thread, kept to reuse the allocation.
+	 */
+	TArray<PomodoroSockets::FPollEntry> PollEntries;
+
+	/**
+	 * @brief Thread running the relay.
+	 */
+	FRunnableThread* Thread;
+
+	/**
+	 * @brief Set when the relay thread must exit.
+	 */
+	std::atomic<bool> bStopping{false};
+
+	/**
+	 * @brief Accept the pending connections.
+	 */
+	void AcceptClients();
+
+	/**
+	 * @brief Read and handle the messages received from a client.
+	 * @param Client The client to read.
+	 * @return False if the client must be disconnected.
+	 */
+	bool ReadClient(FClient& Client);
+
+	/**
+	 * @brief Handle a single message received from a client.
+	 * @param Client The sending client.
+	 * @param Message The message received.
+	 * @return False if the client must be disconnected.
+	 */
+	bool HandleMessage(FClient& Client, const PomodoroSync::FMessage& Message);
+
+	/**
+	 * @brief Send a message to a client.
+	 * @param Client The receiving client.
+	 * @param Message The message to send.
+	 * @return True if the whole message is sent.
+	 */
+	static bool SendMessage(const FClient& Client, const PomodoroSync::FMessage& Message);
+
+	/**
+	 * @brief Close the connection of a client.
+	 * @param Client The client to disconnect.
+	 */
+	static void Disconnect(FClient& Client);
+};
@@ -0,0 +1,27 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PomodoroSyncRelayCommandlet.generated.h"
+
+/**
+ * Run the team sync relay until the process is asked to exit.
+ *
+ * Usage : UnrealEditor-Cmd <Project> -run=PomodoroSyncRelay [-Port=47250]
+ */
+UCLASS()
+class POMODOROPLUGIN_API UPomodoroSyncRelayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	public:
+	/**
+	 * @brief Standard constructor for UPomodoroSyncRelayCommandlet.
+	 */
+	UPomodoroSyncRelayCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
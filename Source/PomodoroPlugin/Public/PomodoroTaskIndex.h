@@ -0,0 +1,85 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A task or ticket work can be attributed to.
+ */
+struct FPomodoroTask
+{
+	/** Identifier of the task, like a ticket ID */
+	FString Id;
+
+	/** Short description of the task */
+	FString Title;
+};
+
+/**
+ * Prefix search over the identifiers and the title words of tasks.
+ *
+ * The index is a static radix trie built once from the sorted keys : chains of nodes with a single child are
+ * collapsed into one node labelled with their characters. Nodes are stored in a flat array, the children of a
+ * node are contiguous and sorted by first character so a child is found by binary search. Because the keys are
+ * sorted, the keys below a node are a contiguous range of them : a search walks the prefix, then reads that range.
+ */
+class POMODOROPLUGIN_API FPomodoroTaskIndex final
+{
+public:
+	/**
+	 * @brief Build the index, replacing the previous one.
+	 * @param Tasks The tasks to index, referred to by their position.
+	 */
+	void Build(const TArray<FPomodoroTask>& Tasks);
+
+	/**
+	 * @brief Empty the index.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Find the tasks whose identifier or a title word starts with the given prefix, case insensitive.
+	 * @param Prefix The text typed by the user.
+	 * @param MaxResults Maximum number of tasks to find.
+	 * @param OutTasks Positions of the tasks found, each once.
+	 */
+	void FindPrefix(const FString& Prefix, int32 MaxResults, TArray<int32>& OutTasks) const;
+
+private:
+	/**
+	 * @brief A trie node, covering the keys [Begin, End) of the sorted keys.
+	 */
+	struct FNode
+	{
+		int32 FirstChild = 0;
+		int32 Begin = 0;
+		int32 End = 0;
+		int32 LabelStart = 0;
+		uint16 ChildCount = 0;
+		uint16 LabelLength = 0;
+	};
+
+	/**
+	 * @brief Nodes of the trie, the root first.
+	 */
+	TArray<FNode> Nodes;
+
+	/**
+	 * @brief Characters of the node labels, each node refers to its own span.
+	 */
+	TArray<TCHAR> Labels;
+
+	/**
+	 * @brief Task of each sorted key.
+	 */
+	TArray<int32> KeyTasks;
+
+	/**
+	 * @brief Create the children of a node, then theirs.
+	 * @param Keys The sorted keys.
+	 * @param NodeIndex Index of the node.
+	 * @param Depth Length of the prefix of the node, its label included.
+	 */
+	void BuildChildren(const TArray<TPair<FString, int32>>& Keys, int32 NodeIndex, int32 Depth);
+};
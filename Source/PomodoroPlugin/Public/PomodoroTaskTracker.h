@@ -0,0 +1,199 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "PomodoroTaskIndex.h"
+
+/**
+ * Tasks read from an export file and indexed, ready to be handed to FPomodoroTaskTracker.
+ */
+struct FPomodoroTaskList
+{
+	/** Path of the export file */
+	FString Path;
+
+	/** Tasks, in the order of the file */
+	TArray<FPomodoroTask> Tasks;
+
+	/** Position of each task, by identifier */
+	TMap<FString, int32> TaskPositions;
+
+	/** Prefix index over the tasks */
+	FPomodoroTaskIndex Index;
+};
+
+/**
+ * Attribute the focus time of the working timespans to the current task.
+ *
+ * Tasks are imported from a local export file, one task per line : its identifier, a comma or a tab, its title.
+ * The file is read and indexed on a worker thread, the tasks are swapped in on the game thread.
+ * Focus time is accumulated by segments : a segment opens when a working timespan runs and closes when it is paused,
+ * stopped or elapsed, adding its length to the task. Switching task closes the segment and opens a new one,
+ * so a working timespan is split between the tasks it was spent on.
+ */
+class POMODOROPLUGIN_API FPomodoroTaskTracker final
+	: public TSharedFromThis<FPomodoroTaskTracker, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * @brief Standard constructor for FPomodoroTaskTracker, load the last saved configuration.
+	 * The tasks of the configured export file are not imported yet, see ImportTasks and GetImportPath.
+	 * @param InEngine Engine to observe.
+	 */
+	explicit FPomodoroTaskTracker(TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Standard destructor for FPomodoroTaskTracker.
+	 */
+	~FPomodoroTaskTracker();
+
+	/**
+	 * @brief Read and index the tasks of an export file, on any thread.
+	 * @param FilePath Path of the export file.
+	 * @param OutList The tasks read.
+	 * @return False if the file can't be read.
+	 */
+	static bool ReadTaskFile(const FString& FilePath, FPomodoroTaskList& OutList);
+
+	/**
+	 * @brief Import the tasks of an export file on a worker thread, replacing the previous ones once read.
+	 * Only the last import requested is applied.
+	 * @param FilePath Path of the export file.
+	 * @param OnImported Called on the game thread once applied, with false if the file can't be read.
+	 */
+	void ImportTasks(const FString& FilePath, TUniqueFunction<void(bool)> OnImported = nullptr);
+
+	/**
+	 * @brief Replace the imported tasks by tasks already read, on the game thread.
+	 * @param List The tasks read by ReadTaskFile.
+	 */
+	void ApplyTaskList(FPomodoroTaskList&& List);
+
+	/**
+	 * @brief Used to get the path of the last imported export file.
+	 * @return The path of the export file.
+	 */
+	const FString& GetImportPath() const;
+
+	/**
+	 * @brief Used to get the number of imported tasks.
+	 * @return The number of tasks.
+	 */
+	int32 GetTaskCount() const;
+
+	/**
+	 * @brief Used to get an imported task.
+	 * @param Position Position of the task.
+	 * @return The task.
+	 */
+	const FPomodoroTask& GetTask(int32 Position) const;
+
+	/**
+	 * @brief Find the tasks whose identifier or a title word starts with the given prefix.
+	 * @param Prefix The text typed by the user.
+	 * @param MaxResults Maximum number of tasks to find.
+	 * @param OutTasks Positions of the tasks found.
+	 */
+	void FindTasks(const FString& Prefix, int32 MaxResults, TArray<int32>& OutTasks) const;
+
+	/**
+	 * @brief Attribute the focus time to another task from now on.
+	 * @param TaskId Identifier of the task, empty for none.
+	 */
+	void SetCurrentTask(const FString& TaskId);
+
+	/**
+	 * @brief Used to get the task the focus time is attributed to.
+	 * @return Identifier of the task, empty for none.
+	 */
+	const FString& GetCurrentTask() const;
+
+	/**
+	 * @brief Used to get the title of a task.
+	 * @param TaskId Identifier of the task.
+	 * @return The title, empty if the task isn't imported.
+	 */
+	FString GetTaskTitle(const FString& TaskId) const;
+
+	/**
+	 * @brief Used to get the focus time attributed to a task.
+	 * @param TaskId Identifier of the task.
+	 * @return The focus time, the running segment included.
+	 */
+	FTimespan GetFocusTime(const FString& TaskId) const;
+
+	/**
+	 * @brief Reload the current configuration and the focus times to the last ones saved
+	 */
+	void ReloadConfig();
+
+	/**
+	 * @brief Save the current configuration and the focus times
+	 */
+	void SaveConfig() const;
+
+private:
+	/**
+	 * @brief Engine observed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Path of the last imported export file.
+	 */
+	FString ImportPath;
+
+	/**
+	 * @brief Imported tasks.
+	 */
+	TArray<FPomodoroTask> Tasks;
+
+	/**
+	 * @brief Position of each imported task, by identifier.
+	 */
+	TMap<FString, int32> TaskPositions;
+
+	/**
+	 * @brief Prefix index over the imported tasks.
+	 */
+	FPomodoroTaskIndex Index;
+
+	/**
+	 * @brief Focus time of each task, kept across imports.
+	 */
+	TMap<FString, FTimespan> FocusTimes;
+
+	/**
+	 * @brief Task the focus time is attributed to.
+	 */
+	FString CurrentTask;
+
+	/**
+	 * @brief Incremented by each import, the tasks of an older one are dropped when read.
+	 */
+	uint32 ImportSerial = 0;
+
+	/**
+	 * @brief Start of the running segment in FPlatformTime seconds, while a working timespan runs.
+	 */
+	bool bSegmentOpen = false;
+	double SegmentStartSeconds = 0.0;
+
+	/**
+	 * @brief Open or close the segment following the engine state.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Add the running segment to the current task.
+	 * @param NowSeconds Current FPlatformTime seconds.
+	 */
+	void CloseSegment(double NowSeconds);
+
+	/**
+	 * @brief Save the configuration and the focus times when the editor has time to spare.
+	 */
+	void RequestSave();
+};
@@ -0,0 +1,169 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "Fonts/ShapedTextFwd.h"
+#include "Widgets/SLeafWidget.h"
+
+/**
+ * Compact countdown of the engine, meant to stay visible in the editor toolbar.
+ *
+ * The twelve glyphs it can show, the digits, the colon and the dot, are shaped once per font scale
+ * and drawn in fixed width cells, so nothing is measured or shaped when the value changes.
+ * The widget only repaints when the displayed second, or tenth of a second, changes : put it
+ * under an invalidation panel and a frame where the value is unchanged doesn't paint it at all.
+ * The value is computed from the deadline of the snapshot, the engine still ticks once a second.
+ */
+class POMODOROPLUGIN_API SPomodoroCountdown final : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPomodoroCountdown)
+		: _Font(FCoreStyle::GetDefaultFontStyle("Bold", 10))
+		, _ColorAndOpacity(FSlateColor::UseForeground())
+		, _ShowTenths(false)
+	{}
+		/** Font of the countdown */
+		SLATE_ARGUMENT(FSlateFontInfo, Font)
+
+		/** Color of the countdown */
+		SLATE_ARGUMENT(FSlateColor, ColorAndOpacity)
+
+		/** Show the tenths of a second after the seconds */
+		SLATE_ARGUMENT(bool, ShowTenths)
+	SLATE_END_ARGS()
+
+	/**
+	 * @brief Standard destructor for SPomodoroCountdown.
+	 */
+	virtual ~SPomodoroCountdown() override;
+
+	/**
+	 * @brief Construct the widget.
+	 * @param InArgs Declaration arguments.
+	 * @param InEngine Engine whose countdown is displayed.
+	 */
+	void Construct(const FArguments& InArgs, TSharedRef<FPomodoroEngine> InEngine);
+
+	/**
+	 * @brief Show or hide the tenths of a second after the seconds.
+	 * @param bInShowTenths Show the tenths of a second.
+	 */
+	void SetShowTenths(bool bInShowTenths);
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+	/** Glyph of the colon, after the ten digits */
+	static constexpr int32 ColonGlyph = 10;
+
+	/** Glyph of the dot, after the colon */
+	static constexpr int32 DotGlyph = 11;
+
+	/** Longest countdown displayed, "HHH:MM:SS.T" */
+	static constexpr int32 MaxCells = 11;
+
+	/**
+	 * @brief Engine whose countdown is displayed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Font of the countdown.
+	 */
+	FSlateFontInfo Font;
+
+	/**
+	 * @brief Color of the countdown.
+	 */
+	FSlateColor ColorAndOpacity;
+
+	/**
+	 * @brief Show the tenths of a second after the seconds.
+	 */
+	bool bShowTenths = false;
+
+	/**
+	 * @brief Width of a digit cell, of the colon cell and of the dot cell, and height of the line, at scale 1.
+	 */
+	float DigitWidth = 0.0f;
+	float ColonWidth = 0.0f;
+	float DotWidth = 0.0f;
+	float LineHeight = 0.0f;
+
+	/**
+	 * @brief Digits and colon shaped at GlyphScale, empty until first painted.
+	 */
+	mutable TArray<FShapedGlyphSequencePtr, TInlineAllocator<DotGlyph + 1>> Glyphs;
+
+	/**
+	 * @brief Font scale the glyphs were shaped at.
+	 */
+	mutable float GlyphScale = 0.0f;
+
+	/**
+	 * @brief Glyph of each displayed cell.
+	 */
+	uint8 Cells[MaxCells];
+
+	/**
+	 * @brief Number of displayed cells.
+	 */
+	int32 CellCount = 0;
+
+	/**
+	 * @brief Last snapshot of the engine, refreshed when a newer one is published.
+	 */
+	FPomodoroEngineSnapshot Snapshot;
+
+	/**
+	 * @brief Displayed remaining time in seconds, or in tenths of a second, -1 before the first update.
+	 */
+	int32 DisplayedValue = -1;
+
+	/**
+	 * @brief Timer refreshing the countdown while the engine runs.
+	 */
+	TSharedPtr<FActiveTimerHandle> RefreshTimer;
+
+	/**
+	 * @brief Called each time the engine publishes a new snapshot.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Refresh the countdown while the engine runs.
+	 * @param CurrentTime Current Slate time.
+	 * @param DeltaTime Time since the last call.
+	 * @return Continue while the engine runs.
+	 */
+	EActiveTimerReturnType OnRefreshTimer(double CurrentTime, float DeltaTime);
+
+	/**
+	 * @brief Compute the displayed cells from the last snapshot, and repaint if they changed.
+	 * @return True if the engine runs.
+	 */
+	bool UpdateCells();
+
+	/**
+	 * @brief Give the width of a cell at scale 1.
+	 * @param Glyph Glyph of the cell.
+	 * @return Width of the cell.
+	 */
+	float GetCellWidth(int32 Glyph) const;
+
+	/**
+	 * @brief Shape the glyphs for a font scale.
+	 * @param FontScale Scale the glyphs are drawn at.
+	 */
+	void ShapeGlyphs(float FontScale) const;
+
+	/**
+	 * @brief Drop the shaped glyphs, their font atlas entries are gone.
+	 */
+	void OnFontResourcesReleased(const class FSlateFontCache& FontCache);
+};
@@ -0,0 +1,115 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroFocusHistory.h"
+#include "Rendering/RenderingCommon.h"
+#include "Textures/SlateShaderResource.h"
+#include "Widgets/SLeafWidget.h"
+
+/**
+ * Calendar of the focus time of each day, one column per week, the current week on the right.
+ *
+ * Only the weeks fitting in the widget are built, from the daily aggregates of the history,
+ * and all their cells are drawn as a single custom vertex batch. The batch is only rebuilt when
+ * the geometry, the scrolled week, the day or the history change. The mouse wheel scrolls back in time.
+ */
+class POMODOROPLUGIN_API SPomodoroHeatmap final : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPomodoroHeatmap)
+		: _CellSize(10.0f)
+		, _CellGap(2.0f)
+	{}
+		/** Size of the cell of a day */
+		SLATE_ARGUMENT(float, CellSize)
+
+		/** Space between two cells */
+		SLATE_ARGUMENT(float, CellGap)
+	SLATE_END_ARGS()
+
+	/**
+	 * @brief Construct the widget.
+	 * @param InArgs Declaration arguments.
+	 * @param InHistory History displayed.
+	 */
+	void Construct(const FArguments& InArgs, TSharedRef<FPomodoroFocusHistory> InHistory);
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+	virtual FReply OnMouseWheel(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual void OnMouseLeave(const FPointerEvent& MouseEvent) override;
+
+private:
+	/**
+	 * @brief History displayed.
+	 */
+	TSharedPtr<FPomodoroFocusHistory> History;
+
+	/**
+	 * @brief Size of the cell of a day, and space between two cells.
+	 */
+	float CellSize = 10.0f;
+	float CellGap = 2.0f;
+
+	/**
+	 * @brief Number of weeks scrolled back from the current one.
+	 */
+	int32 WeekOffset = 0;
+
+	/**
+	 * @brief Day under the mouse, INDEX_NONE when none.
+	 */
+	int32 HoveredDay = INDEX_NONE;
+
+	/**
+	 * @brief Handle of the white texture the batch is drawn with.
+	 */
+	FSlateResourceHandle WhiteHandle;
+
+	/**
+	 * @brief Cells of the visible weeks, in window space.
+	 */
+	mutable TArray<FSlateVertex> Vertices;
+	mutable TArray<SlateIndex> Indices;
+
+	/**
+	 * @brief State the batch was built for.
+	 */
+	mutable FSlateRenderTransform BuiltTransform;
+	mutable FVector2D BuiltSize = FVector2D::ZeroVector;
+	mutable int32 BuiltWeekOffset = INDEX_NONE;
+	mutable int32 BuiltToday = INDEX_NONE;
+	mutable uint32 BuiltVersion = 0;
+
+	/**
+	 * @brief Give the number of weeks fitting in a width.
+	 * @param Width Width of the widget.
+	 * @return Number of visible weeks, at least one.
+	 */
+	int32 GetVisibleWeeks(float Width) const;
+
+	/**
+	 * @brief Give the Monday of the rightmost visible week.
+	 * @param Today Day number of today.
+	 * @return Day number of the Monday.
+	 */
+	int32 GetLastMonday(int32 Today) const;
+
+	/**
+	 * @brief Build the cells of the visible weeks.
+	 * @param Geometry Geometry the cells are built for.
+	 * @param Today Day number of today.
+	 */
+	void BuildBatch(const FGeometry& Geometry, int32 Today) const;
+
+	/**
+	 * @brief Give the tooltip of the hovered day.
+	 * @return The date and focus time of the hovered day.
+	 */
+	FText GetHoveredText() const;
+};
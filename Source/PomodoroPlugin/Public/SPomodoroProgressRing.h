@@ -0,0 +1,145 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroEngine.h"
+#include "Rendering/RenderingCommon.h"
+#include "Textures/SlateShaderResource.h"
+#include "Widgets/SLeafWidget.h"
+
+/**
+ * Ring showing the progress of the current timespan, colored by phase, with a pip per cycle around it.
+ *
+ * Everything is drawn as a single custom vertex batch. The vertices and indices are built when
+ * the geometry or the cycle count change, a frame then only moves the end of the progress arc
+ * to the sweep angle. The ring repaints every frame while the engine runs, and not at all otherwise.
+ */
+class POMODOROPLUGIN_API SPomodoroProgressRing final : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPomodoroProgressRing)
+		: _Diameter(48.0f)
+	{}
+		/** Diameter of the widget, pips included */
+		SLATE_ARGUMENT(float, Diameter)
+	SLATE_END_ARGS()
+
+	/**
+	 * @brief Standard destructor for SPomodoroProgressRing.
+	 */
+	virtual ~SPomodoroProgressRing() override;
+
+	/**
+	 * @brief Construct the widget.
+	 * @param InArgs Declaration arguments.
+	 * @param InEngine Engine whose progress is displayed.
+	 */
+	void Construct(const FArguments& InArgs, TSharedRef<FPomodoroEngine> InEngine);
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+	/** Number of segments of the ring */
+	static constexpr int32 Segments = 96;
+
+	/** Number of rim vertices of a pip */
+	static constexpr int32 PipSides = 8;
+
+	/** First vertex of the progress arc, after the track */
+	static constexpr int32 ProgressVertex = (Segments + 1) * 2;
+
+	/** First vertex of the pips, after the progress arc */
+	static constexpr int32 PipVertex = ProgressVertex * 2;
+
+	/**
+	 * @brief Engine whose progress is displayed.
+	 */
+	TSharedPtr<FPomodoroEngine> Engine;
+
+	/**
+	 * @brief Diameter of the widget, pips included.
+	 */
+	float Diameter = 48.0f;
+
+	/**
+	 * @brief Handle of the white texture the batch is drawn with.
+	 */
+	FSlateResourceHandle WhiteHandle;
+
+	/**
+	 * @brief Direction of each segment boundary, clockwise from the top.
+	 */
+	TArray<FVector2D> Directions;
+
+	/**
+	 * @brief Vertices of the track, the progress arc and the pips, in window space.
+	 */
+	mutable TArray<FSlateVertex> Vertices;
+
+	/**
+	 * @brief Indices of the batch, only change with the cycle count.
+	 */
+	mutable TArray<SlateIndex> Indices;
+
+	/**
+	 * @brief Render transform and size the vertices were built for.
+	 */
+	mutable FSlateRenderTransform BuiltTransform;
+	mutable FVector2D BuiltSize = FVector2D::ZeroVector;
+
+	/**
+	 * @brief Last snapshot read, only read again when its version changes.
+	 */
+	mutable FPomodoroEngineSnapshot Snapshot;
+
+	/**
+	 * @brief Version of the snapshot the colors were set for.
+	 */
+	mutable uint64 ColoredVersion = 0;
+
+	/**
+	 * @brief Timer repainting the ring while the engine runs.
+	 */
+	TSharedPtr<FActiveTimerHandle> AnimationTimer;
+
+	/**
+	 * @brief Called each time the engine publishes a new snapshot.
+	 */
+	void OnEngineSnapshotPublished();
+
+	/**
+	 * @brief Repaint the ring each frame while the engine runs.
+	 * @param CurrentTime Current Slate time.
+	 * @param DeltaTime Time since the last call.
+	 * @return Continue while the engine runs.
+	 */
+	EActiveTimerReturnType OnAnimationTimer(double CurrentTime, float DeltaTime);
+
+	/**
+	 * @brief Build the indices and the vertices of the track and the pips.
+	 * @param Geometry Geometry the vertices are built for.
+	 */
+	void BuildBatch(const FGeometry& Geometry) const;
+
+	/**
+	 * @brief Set the pip colors for the current snapshot.
+	 */
+	void UpdateColors() const;
+
+	/**
+	 * @brief Move the end of the progress arc, colored by the current phase.
+	 * @param Geometry Geometry the vertices are built for.
+	 * @param Progress Elapsed part of the current timespan, between 0 and 1.
+	 */
+	void UpdateSweep(const FGeometry& Geometry, float Progress) const;
+
+	/**
+	 * @brief Give the progress of the current timespan.
+	 * @return The elapsed part of the current timespan, between 0 and 1.
+	 */
+	float GetProgress() const;
+};
@@ -0,0 +1,158 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PomodoroTrends.h"
+#include "Rendering/RenderingCommon.h"
+#include "Textures/SlateShaderResource.h"
+#include "Widgets/SLeafWidget.h"
+
+/**
+ * Area chart of a trend of the phase history, per day or per week, the current bucket on the right.
+ *
+ * The visible window is downsampled by FPomodoroTrends to about one point every few pixels,
+ * so the vertices only depend on the width of the widget. The area is drawn as a
+ * single custom vertex batch and the outline as a single line element, both only rebuilt when the
+ * geometry, the range, the metric or the trends change. The mouse wheel zooms, dragging scrolls in time.
+ */
+class POMODOROPLUGIN_API SPomodoroTrendChart final : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPomodoroTrendChart)
+		: _Metric(EPomodoroTrendMetric::Focus)
+		, _Bucket(EPomodoroTrendBucket::Day)
+	{}
+		/** Value shown */
+		SLATE_ARGUMENT(EPomodoroTrendMetric, Metric)
+
+		/** Time a point covers */
+		SLATE_ARGUMENT(EPomodoroTrendBucket, Bucket)
+	SLATE_END_ARGS()
+
+	/**
+	 * @brief Construct the widget.
+	 * @param InArgs Declaration arguments.
+	 * @param InHistory History the trends are read from.
+	 */
+	void Construct(const FArguments& InArgs, TSharedRef<FPomodoroPhaseHistory> InHistory);
+
+	/**
+	 * @brief Change the value shown.
+	 * @param InMetric The value.
+	 */
+	void SetMetric(EPomodoroTrendMetric InMetric);
+
+	/**
+	 * @brief Give the value shown.
+	 * @return The value.
+	 */
+	EPomodoroTrendMetric GetMetric() const;
+
+	/**
+	 * @brief Change the time a point covers.
+	 * @param InBucket The time a point covers.
+	 */
+	void SetBucket(EPomodoroTrendBucket InBucket);
+
+	/**
+	 * @brief Give the time a point covers.
+	 * @return The time a point covers.
+	 */
+	EPomodoroTrendBucket GetBucket() const;
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+	virtual FReply OnMouseWheel(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual void OnMouseLeave(const FPointerEvent& MouseEvent) override;
+
+private:
+	/**
+	 * @brief Aggregates of the history, owned by the chart so they only live while it shows.
+	 */
+	TSharedPtr<FPomodoroTrends> Trends;
+
+	/**
+	 * @brief Value shown, and time a point covers.
+	 */
+	EPomodoroTrendMetric Metric = EPomodoroTrendMetric::Focus;
+	EPomodoroTrendBucket Bucket = EPomodoroTrendBucket::Day;
+
+	/**
+	 * @brief Number of buckets shown, and number of buckets scrolled back from the current one, for each bucket.
+	 */
+	int32 VisibleBuckets[FPomodoroTrends::BucketCount] = {};
+	int32 EndOffsets[FPomodoroTrends::BucketCount] = {};
+
+	/**
+	 * @brief Mouse position and offset a drag started from, while dragging.
+	 */
+	bool bDragging = false;
+	float DragStartX = 0.0f;
+	int32 DragStartOffset = 0;
+
+	/**
+	 * @brief Bucket under the mouse, INDEX_NONE when none.
+	 */
+	int32 HoveredBucket = INDEX_NONE;
+
+	/**
+	 * @brief Handle of the white texture the area is drawn with.
+	 */
+	FSlateResourceHandle WhiteHandle;
+
+	/**
+	 * @brief Downsampled points of the visible window.
+	 */
+	mutable TArray<FPomodoroTrendPoint> Points;
+
+	/**
+	 * @brief Area under the visible points, in window space, and their outline, in local space.
+	 */
+	mutable TArray<FSlateVertex> Vertices;
+	mutable TArray<SlateIndex> Indices;
+	mutable TArray<FVector2D> LinePoints;
+
+	/**
+	 * @brief State the batch was built for.
+	 */
+	mutable FSlateRenderTransform BuiltTransform;
+	mutable FVector2D BuiltSize = FVector2D::ZeroVector;
+	mutable EPomodoroTrendMetric BuiltMetric = EPomodoroTrendMetric::Focus;
+	mutable EPomodoroTrendBucket BuiltBucket = EPomodoroTrendBucket::Day;
+	mutable int32 BuiltVisibleBuckets = 0;
+	mutable int32 BuiltEndOffset = INDEX_NONE;
+	mutable int32 BuiltCurrent = INDEX_NONE;
+	mutable uint32 BuiltVersion = 0;
+
+	/**
+	 * @brief Give the first visible bucket.
+	 * @param Current Bucket number of today.
+	 * @return The bucket number at the left edge.
+	 */
+	int32 GetStartBucket(int32 Current) const;
+
+	/**
+	 * @brief Give the largest scroll back, the first recorded bucket then being at the left edge.
+	 * @return The largest offset.
+	 */
+	int32 GetMaxEndOffset() const;
+
+	/**
+	 * @brief Build the area and the outline of the visible points.
+	 * @param Geometry Geometry the batch is built for.
+	 * @param Current Bucket number of today.
+	 */
+	void BuildBatch(const FGeometry& Geometry, int32 Current) const;
+
+	/**
+	 * @brief Give the tooltip of the hovered bucket.
+	 * @return The date and value of the hovered bucket.
+	 */
+	FText GetHoveredText() const;
+};